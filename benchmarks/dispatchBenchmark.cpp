@@ -0,0 +1,80 @@
+/*
+	Written By Pradipna Nepal
+	www.pradsprojects.com
+
+	Copyright (C) 2013 Pradipna Nepal
+	Please read COPYING.txt included along with this source code for more detail.
+	If not included, see http://www.gnu.org/licenses/
+*/
+
+//Compares the block lookup done on every dispatch: the std::map the dynarec used to have against
+//X86BinBlockCache. It is the dispatchBenchmark target of the CMake build.
+
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <vector>
+#include <chrono>
+#include "x86BinBlockCache.h"
+using namespace std;
+
+#define CODE_SIZE			(1 << 20)	//1 MB of guest code
+#define BLOCK_COUNT			8192
+#define DISPATCH_COUNT		20000000
+
+template<typename Lookup>
+static double timeDispatches(const vector<int64> &trace, Lookup lookup, uint64 *checksum) {
+	chrono::high_resolution_clock::time_point start = chrono::high_resolution_clock::now();
+	uint64 sum = 0;
+
+	for (size_t i = 0; i < trace.size(); ++i) {
+		sum += (uint64)lookup(trace[i]);
+	}
+	chrono::high_resolution_clock::time_point end = chrono::high_resolution_clock::now();
+	*checksum = sum;
+
+	return chrono::duration<double, nano>(end - start).count() / trace.size();
+}
+
+int main() {
+	map<int64, X86BinBlock*> mapCache;
+	X86BinBlockCache tableCache(CODE_SIZE);
+	vector<int64> blockAddresses, trace;
+
+	//Blocks are never dereferenced, so any unique non null pointer will do
+	srand(1234);
+	for (int i = 0; i < BLOCK_COUNT; ++i) {
+		int64 address = ((int64)rand() * RAND_MAX + rand()) % CODE_SIZE;
+		X86BinBlock *binBlock = (X86BinBlock*)(uintptr_t)(address + 1);
+
+		if (mapCache.find(address) != mapCache.end()) continue;
+		blockAddresses.push_back(address);
+		mapCache[address] = binBlock;
+		tableCache.insert(address, binBlock, (uint8*)binBlock);
+	}
+
+	//Programs spend most of their time in a few loops, so most dispatches go to a small set of blocks
+	trace.reserve(DISPATCH_COUNT);
+	for (int i = 0; i < DISPATCH_COUNT; ++i) {
+		size_t index = (rand() % 8 == 0) ? rand() % blockAddresses.size() : rand() % 64;
+		trace.push_back(blockAddresses[index]);
+	}
+
+	uint64 mapChecksum, tableChecksum;
+	double mapTime = timeDispatches(trace, [&](int64 address) {
+		map<int64, X86BinBlock*>::const_iterator it = mapCache.find(address);
+		return (it == mapCache.end()) ? (X86BinBlock*)0 : it->second;
+	}, &mapChecksum);
+	double tableTime = timeDispatches(trace, [&](int64 address) {
+		return tableCache.find(address);
+	}, &tableChecksum);
+
+	printf("blocks: %d, dispatches: %d\n", (int)blockAddresses.size(), DISPATCH_COUNT);
+	printf("std::map          %6.2f ns/dispatch\n", mapTime);
+	printf("X86BinBlockCache  %6.2f ns/dispatch\n", tableTime);
+	if (mapChecksum != tableChecksum) {
+		printf("Lookups disagree\n");
+		return 1;
+	}
+	return 0;
+}
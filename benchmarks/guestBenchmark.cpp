@@ -0,0 +1,766 @@
+/*
+	Written By Pradipna Nepal
+	www.pradsprojects.com
+
+	Copyright (C) 2013 Pradipna Nepal
+	Please read COPYING.txt included along with this source code for more detail.
+	If not included, see http://www.gnu.org/licenses/
+*/
+
+//Guest programs that each stress one part of the VM. They are assembled here, written to the programs
+//folder with a valid header and signature, and run with the headless despairvm, which reports how long
+//they ran and what was translated. Every program knows how many guest instructions it runs, so the
+//result is in guest instructions per second. Each program adds up what it computed and folds the sum
+//into the 8 bits of its exit status, which are checked against the same sum worked out here, so a run
+//that computes the wrong thing fails. The results are written as JSON, and when a baseline written
+//by an earlier run is given, they are compared against it.
+//  guestBenchmark [--vm path] [--programs dir] [--runs n] [--only name] [--baseline file] [--output file] [-- despairvm options]
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <map>
+#include <limits>
+#include <functional>
+#ifdef _WIN32
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#include <sys/wait.h>
+#endif
+#include <xmmintrin.h>
+#include "build.h"
+#include "declarations.h"
+#include "despairHeader.h"
+#include "instructionsSet.h"
+#include "instructionsInfo.h"
+#include "portAddress.h"
+#include "stringManager.h"
+#include "fileManager.h"
+#include "sha256.h"
+using namespace std;
+using namespace DespairHeader;
+using namespace InstructionsInfo;
+
+#define DEFAULT_RUNS				3	//The fastest run counts
+#define FRAME_WIDTH					320
+#define FRAME_HEIGHT				240
+#define STACK_SIZE					(1 << 16)
+#define DATA_SIZE					(1 << 16)
+#define GLOBAL_DATA_SIZE			4096
+#define HEAP_SIZE					(1 << 16)
+#define FILE_BLOCK_SIZE				4096
+#define FILE_NAME					"bench.dat"	//Made in the programs folder before the programs run
+
+#define SCRATCH_REG					10	//Every loop compares its counter in it
+
+//Writes guest code with the operands in the order they are encoded, labels may be used before they
+//are placed. Every instruction is checked against its size in InstructionsInfo.
+class GuestAssembler {
+private:
+	vector<uint8> code;
+	map<string, uint32> labels;
+	vector<pair<uint32, string> > labelUses;	//Index of an absolute 32 bit address and its label
+	size_t instructionStart;
+	const InstructionInfo *instructionInfo;
+	uint64 instructionCount;
+
+	void checkInstruction() {
+		if (instructionInfo && code.size() - instructionStart != (size_t)getInstructionSize(instructionInfo)) {
+			fprintf(stderr, "%s at 0x%x has the wrong operands\n", instructionInfo->name, (unsigned int)instructionStart);
+			exit(1);
+		}
+	}
+
+	template<typename Type>
+	GuestAssembler &write(Type value) {
+		code.insert(code.end(), (const uint8*)&value, (const uint8*)&value + sizeof(Type));
+		return *this;
+	}
+
+public:
+	GuestAssembler() {
+		instructionStart = 0;
+		instructionInfo = 0;
+		instructionCount = 0;
+	}
+
+	GuestAssembler &op(uint16 opcode) {
+		checkInstruction();
+		instructionInfo = getInstructionInfo(opcode);
+		if (!instructionInfo) {
+			fprintf(stderr, "0x%x is not an instruction\n", opcode);
+			exit(1);
+		}
+		instructionStart = code.size();
+		++instructionCount;
+		return write<uint16>(opcode);
+	}
+
+	GuestAssembler &reg(uint8 reg) {
+		return write<uint8>(reg);
+	}
+
+	GuestAssembler &immi8(uint8 value) {
+		return write<uint8>(value);
+	}
+
+	GuestAssembler &immi32(uint32 value) {
+		return write<uint32>(value);
+	}
+
+	GuestAssembler &floatImmi(float32 value) {
+		return write<float32>(value);
+	}
+
+	GuestAssembler &address(const string &label) {
+		labelUses.push_back(make_pair((uint32)code.size(), label));
+		return write<uint32>(0);
+	}
+
+	void label(const string &name) {
+		labels[name] = (uint32)code.size();
+	}
+
+	uint32 getLabel(const string &name) {
+		if (labels.find(name) == labels.end()) {
+			fprintf(stderr, "Label %s is not placed\n", name.c_str());
+			exit(1);
+		}
+		return labels[name];
+	}
+
+	//Instructions written so far, each counted once
+	uint64 getInstructionCount() {
+		return instructionCount;
+	}
+
+	vector<uint8> finish() {
+		checkInstruction();
+		instructionInfo = 0;
+		for (size_t i = 0; i < labelUses.size(); ++i) {
+			*(uint32*)&code[labelUses[i].first] = getLabel(labelUses[i].second);
+		}
+		return code;
+	}
+};
+
+struct GuestBenchmark {
+	string name;
+	vector<uint8> code;
+	uint32 entry;
+	uint64 instructions;	//Guest instructions the program runs
+	uint64 result;			//What the program adds up in r0 before folding it
+};
+
+//Counter counts from 0 to iterations. Returns the instructions the loop runs, calledInstructions is what
+//the calls in one pass of body run on top of the instructions of body itself.
+static uint64 putLoop(GuestAssembler *a, const string &name, uint8 counter, uint32 iterations, function<void()> body, uint64 calledInstructions = 0) {
+	uint64 start = a->getInstructionCount();
+
+	a->op(_MOV_R_IMMI).reg(counter).immi32(0);
+	a->label(name);
+	body();
+	a->op(_ADD_R_IMMI).reg(counter).immi32(1);
+	a->op(_MOV_R_R).reg(SCRATCH_REG).reg(counter);
+	a->op(_CMPL_R_IMMI).reg(SCRATCH_REG).immi32(iterations);
+	a->op(_JC_R_IMMI).reg(SCRATCH_REG).address(name + "_done");	//Taken when the compare is false
+	a->op(_JMP_IMMI).address(name);
+	a->label(name + "_done");
+
+	//The jump back is not taken the last time
+	uint64 loopInstructions = a->getInstructionCount() - start - 1;
+	return 1 + (loopInstructions + calledInstructions) * iterations - 1;
+}
+
+//The exit status is only 8 bits, so every bit of the result is xored into them
+static uint8 foldResult(uint64 result) {
+	result ^= result >> 32;
+	result ^= result >> 16;
+	result ^= result >> 8;
+	return (uint8)result;
+}
+
+//The main thread returns the sum of the results registers folded like foldResult, returns the
+//instructions it takes
+static uint64 putExit(GuestAssembler *a, const vector<uint8> &results) {
+	a->op(_MOV_R_IMMI).reg(0).immi32(0);
+	for (size_t i = 0; i < results.size(); ++i) {
+		a->op(_ADD_R_R).reg(0).reg(results[i]);
+	}
+	for (uint8 shift = 32; shift >= 8; shift /= 2) {
+		a->op(_MOV_R_R).reg(SCRATCH_REG).reg(0);
+		a->op(_SHR_R_IMMI8).reg(SCRATCH_REG).immi8(shift);
+		a->op(_XOR_R_R).reg(0).reg(SCRATCH_REG);
+	}
+	a->op(_RET);
+	return 2 + results.size() + 9;
+}
+
+//FCON_R_FR, rounded to the nearest like the interpreter
+static uint64 toGuestInt(float32 value) {
+	return (uint32)_mm_cvtss_si32(_mm_set_ss(value));
+}
+
+//Bytes of FILE_NAME
+static vector<uint8> makeFileData() {
+	vector<uint8> data(FILE_BLOCK_SIZE);
+	for (size_t i = 0; i < data.size(); ++i) {
+		data[i] = (uint8)i;
+	}
+	return data;
+}
+
+//reg gets a heap of HEAP_SIZE bytes, returns the instructions it takes
+static uint64 putMakeHeap(GuestAssembler *a, uint8 reg) {
+	a->op(_MOV_R_IMMI).reg(reg).immi32(HEAP_SIZE);
+	a->op(_OUT_IMMI_R32).reg(reg).immi32(PORT_MEMORY_MAKE_HEAP);
+	a->op(_IN_R64_IMMI).reg(reg).immi32(PORT_MEMORY_MAKE_HEAP);
+	return 3;
+}
+
+static GuestBenchmark makeBenchmark(const string &name, GuestAssembler *a, uint64 instructions, uint64 result) {
+	GuestBenchmark benchmark;
+	benchmark.name = name;
+	benchmark.code = a->finish();
+	benchmark.entry = a->getLabel("main");
+	benchmark.instructions = instructions;
+	benchmark.result = result;
+	return benchmark;
+}
+
+static GuestBenchmark makeIntegerALU() {
+	const uint32 iterations = 50000000;
+	GuestAssembler a;
+	uint64 instructions = 0;
+
+	a.label("main");
+	a.op(_MOV_R_IMMI).reg(2).immi32(1);
+	a.op(_MOV_R_IMMI).reg(3).immi32(0x12345);
+	instructions += 2;
+	instructions += putLoop(&a, "loop", 1, iterations, [&]() {
+		a.op(_ADD_R_R).reg(2).reg(3);
+		a.op(_XOR_R_IMMI).reg(3).immi32(0x5A5A);
+		a.op(_SHL_R_IMMI8).reg(2).immi8(1);
+		a.op(_SHR_R_IMMI8).reg(3).immi8(3);
+		a.op(_SUB_R_R).reg(4).reg(2);
+		a.op(_AND_R_IMMI).reg(4).immi32(0xFFFF);
+		a.op(_OR_R_R).reg(5).reg(4);
+		a.op(_MUL_R_IMMI).reg(5).immi32(3);
+	});
+	instructions += putExit(&a, {2, 3, 4, 5});
+
+	uint64 r2 = 1, r3 = 0x12345, r4 = 0, r5 = 0;
+	for (uint32 i = 0; i < iterations; ++i) {
+		r2 += r3;
+		r3 ^= 0x5A5A;
+		r2 <<= 1;
+		r3 >>= 3;
+		r4 -= r2;
+		r4 &= 0xFFFF;
+		r5 |= r4;
+		r5 *= 3;
+	}
+
+	return makeBenchmark("integer_alu", &a, instructions, r2 + r3 + r4 + r5);
+}
+
+static GuestBenchmark makeFloatMath() {
+	const uint32 iterations = 30000000;
+	GuestAssembler a;
+	uint64 instructions = 0;
+
+	a.label("main");
+	a.op(_FMOV_FR_FIMMI).reg(0).floatImmi(1.0f);
+	a.op(_FMOV_FR_FIMMI).reg(1).floatImmi(0.25f);
+	a.op(_FMOV_FR_FIMMI).reg(2).floatImmi(3.0f);
+	instructions += 3;
+	instructions += putLoop(&a, "loop", 1, iterations, [&]() {
+		a.op(_FADD_FR_FR).reg(0).reg(1);
+		a.op(_FMUL_FR_FIMMI).reg(0).floatImmi(0.5f);
+		a.op(_FSUB_FR_FR).reg(2).reg(0);
+		a.op(_FDIV_FR_FIMMI).reg(2).floatImmi(1.0001f);
+		a.op(_FCON_FR_R).reg(1).reg(3);
+		a.op(_FADD_FR_FR).reg(2).reg(3);
+	});
+	//Scaled by powers of two so they are exact and fit in 32 bits
+	a.op(_FMUL_FR_FIMMI).reg(0).floatImmi(1024.0f);
+	a.op(_FMUL_FR_FIMMI).reg(2).floatImmi(1.0f / 1024.0f);
+	a.op(_FCON_R_FR).reg(2).reg(0);
+	a.op(_FCON_R_FR).reg(3).reg(2);
+	a.op(_FCON_R_FR).reg(4).reg(3);
+	instructions += 5;
+	instructions += putExit(&a, {2, 3, 4});
+
+	float32 f0 = 1.0f, f1 = 0.25f, f2 = 3.0f, f3 = 0.0f;
+	for (uint32 i = 0; i < iterations; ++i) {
+		f0 += f1;
+		f0 *= 0.5f;
+		f2 -= f0;
+		f2 /= 1.0001f;
+		f3 = (float32)(int32)i;
+		f2 += f3;
+	}
+	f0 *= 1024.0f;
+	f2 *= 1.0f / 1024.0f;
+
+	return makeBenchmark("float_math", &a, instructions, toGuestInt(f0) + toGuestInt(f2) + toGuestInt(f3));
+}
+
+//Loads and stores through MOV_MR_*, walking a heap 16 bytes at a time
+static GuestBenchmark makeMemoryMoves() {
+	const uint32 iterations = 20000000;
+	GuestAssembler a;
+	uint64 instructions = 0;
+
+	a.label("main");
+	instructions += putMakeHeap(&a, 7);
+	instructions += putLoop(&a, "loop", 1, iterations, [&]() {
+		a.op(_MOV_R_R).reg(8).reg(1);
+		a.op(_SHL_R_IMMI8).reg(8).immi8(4);
+		a.op(_AND_R_IMMI).reg(8).immi32(HEAP_SIZE - 32);
+		a.op(_ADD_R_R).reg(8).reg(7);
+		a.op(_MOV_MR_IMMI_R).reg(1).reg(8).immi32(0);
+		a.op(_MOV_R_MR_IMMI).reg(2).reg(8).immi32(0);
+		a.op(_MOV_MR_IMMI_MR_IMMI).reg(8).reg(8).immi32(16).immi32(0);
+		a.op(_MOV_MR_R).reg(2).reg(8);
+		a.op(_MOV_R_MR).reg(3).reg(8);
+		a.op(_ADD_R_R).reg(4).reg(3);
+	});
+	//The first and the last words the loop wrote
+	a.op(_MOV_R_MR_IMMI).reg(5).reg(7).immi32(0);
+	a.op(_MOV_R_MR_IMMI).reg(6).reg(7).immi32(HEAP_SIZE - 16);
+	instructions += 2;
+	instructions += putExit(&a, {2, 3, 4, 5, 6});
+
+	vector<uint32> heap(HEAP_SIZE / 4);
+	uint64 r2 = 0, r3 = 0, r4 = 0;
+	for (uint32 i = 0; i < iterations; ++i) {
+		uint32 *word = &heap[((i << 4) & (HEAP_SIZE - 32)) / 4];
+		word[0] = i;
+		r2 = word[0];
+		word[4] = word[0];
+		word[0] = (uint32)r2;
+		r3 = word[0];
+		r4 += r3;
+	}
+
+	return makeBenchmark("memory_moves", &a, instructions, r2 + r3 + r4 + heap[0] + heap[(HEAP_SIZE - 16) / 4]);
+}
+
+//Calls fib(fibN) over and over, every call that is not a leaf saves its argument and result on the stack
+static GuestBenchmark makeRecursion() {
+	const uint32 fibN = 20;
+	GuestAssembler a;
+	uint64 instructions = 0;
+
+	uint64 start = a.getInstructionCount();
+	//r2 is n, the result is in r3
+	a.label("fib");
+	a.op(_MOV_R_R).reg(SCRATCH_REG).reg(2);
+	a.op(_CMPL_R_IMMI).reg(SCRATCH_REG).immi32(2);
+	a.op(_JC_R_IMMI).reg(SCRATCH_REG).address("recurse");
+	uint64 testInstructions = a.getInstructionCount() - start;
+	a.op(_MOV_R_R).reg(3).reg(2);
+	a.op(_RET);
+	uint64 leafInstructions = a.getInstructionCount() - start;
+	start = a.getInstructionCount();
+	a.label("recurse");
+	a.op(_PUSH_R).reg(2);
+	a.op(_SUB_R_IMMI).reg(2).immi32(1);
+	a.op(_CALL_IMMI).address("fib");
+	a.op(_POP_R).reg(2);
+	a.op(_PUSH_R).reg(3);
+	a.op(_SUB_R_IMMI).reg(2).immi32(2);
+	a.op(_CALL_IMMI).address("fib");
+	a.op(_POP_R).reg(4);
+	a.op(_ADD_R_R).reg(3).reg(4);
+	a.op(_RET);
+	uint64 recurseInstructions = testInstructions + a.getInstructionCount() - start;
+
+	//Instructions fib(n) runs
+	vector<uint64> fibInstructions(fibN + 1);
+	for (uint32 n = 0; n <= fibN; ++n) {
+		fibInstructions[n] = (n < 2) ? leafInstructions : recurseInstructions + fibInstructions[n - 1] + fibInstructions[n - 2];
+	}
+
+	a.label("main");
+	instructions += putLoop(&a, "loop", 1, 400, [&]() {
+		a.op(_MOV_R_IMMI).reg(2).immi32(fibN);
+		a.op(_CALL_IMMI).address("fib");
+	}, fibInstructions[fibN]);
+	instructions += putExit(&a, {3});
+
+	uint64 fib = 0, nextFib = 1;
+	for (uint32 n = 0; n < fibN; ++n) {
+		nextFib += fib;
+		fib = nextFib - fib;
+	}
+
+	return makeBenchmark("call_recursion", &a, instructions, fib);
+}
+
+//Plain ports that translated code reads and writes directly, and the keyboard port that calls the VM
+static GuestBenchmark makePortIO() {
+	const uint32 iterations = 10000000;
+	GuestAssembler a;
+	uint64 instructions = 0;
+
+	a.label("main");
+	instructions += putLoop(&a, "loop", 1, iterations, [&]() {
+		a.op(_OUT_IMMI_R32).reg(1).immi32(PORT_FILE_IO_1);
+		a.op(_IN_R32_IMMI).reg(2).immi32(PORT_FILE_IO_1);
+		a.op(_OUT_IMMI_R64).reg(2).immi32(PORT_DMA_ADDR1);
+		a.op(_IN_R64_IMMI).reg(3).immi32(PORT_DMA_ADDR1);
+		a.op(_ADD_R_R).reg(4).reg(3);
+		a.op(_OUT_IMMI_IMMI8).immi32(PORT_KEYBOARD).immi8(0x26);
+		a.op(_IN_R8_IMMI).reg(5).immi32(PORT_KEYBOARD);
+	});
+	instructions += putExit(&a, {2, 3, 4, 5});
+
+	//No key is down in the headless VM
+	uint64 r4 = 0;
+	for (uint32 i = 0; i < iterations; ++i) {
+		r4 += i;
+	}
+
+	return makeBenchmark("port_io", &a, instructions, 2 * (uint64)(iterations - 1) + r4);
+}
+
+static GuestBenchmark makeStrings() {
+	const uint32 iterations = 1000000;
+	GuestAssembler a;
+	uint64 instructions = 0;
+
+	a.label("main");
+	a.op(_OUT_IMMI_IMMI8).immi32(PORT_STRING_COMMAND).immi8(STRING_MANAGER_CREATE_OBJ);
+	instructions += 1;
+	instructions += putLoop(&a, "loop", 1, iterations, [&]() {
+		a.op(_OUT_IMMI_R32).reg(1).immi32(PORT_STRING_IO_1);
+		a.op(_OUT_IMMI_IMMI8).immi32(PORT_STRING_COMMAND).immi8(STRING_MANAGER_APPEND_INTEGER);
+		a.op(_OUT_IMMI_IMMI8).immi32(PORT_STRING_COMMAND).immi8(STRING_MANAGER_APPEND_INTEGER);
+		a.op(_OUT_IMMI_IMMI8).immi32(PORT_STRING_COMMAND).immi8(STRING_MANAGER_GET_SIZE);
+		a.op(_IN_R64_IMMI).reg(2).immi32(PORT_STRING_IO_1);
+		a.op(_ADD_R_R).reg(3).reg(2);
+		a.op(_OUT_IMMI_IMMI8).immi32(PORT_STRING_COMMAND).immi8(STRING_MANAGER_CLEAR_STRING);
+	});
+	a.op(_OUT_IMMI_IMMI8).immi32(PORT_STRING_COMMAND).immi8(STRING_MANAGER_DESTROY_OBJ);
+	instructions += 1;
+	instructions += putExit(&a, {2, 3});
+
+	//The counter is appended twice
+	uint64 r2 = 0, r3 = 0;
+	for (uint32 i = 0; i < iterations; ++i) {
+		uint32 digits = 1;
+		for (uint32 value = i; value >= 10; value /= 10) {
+			++digits;
+		}
+		r2 = 2 * digits;
+		r3 += r2;
+	}
+
+	return makeBenchmark("strings", &a, instructions, r2 + r3);
+}
+
+//Reads FILE_NAME into a heap and writes it back, FILE_BLOCK_SIZE bytes at a time
+static GuestBenchmark makeFiles() {
+	const char *path = "/" FILE_NAME;	//Relative to the folder of the program
+	GuestAssembler a;
+	uint64 instructions = 0;
+
+	a.label("main");
+	instructions += putMakeHeap(&a, 7);
+	for (size_t i = 0; i <= strlen(path); ++i) {
+		a.op(_BMOV_BR_IMMI_IMMI8).reg(7).immi32((uint32)(HEAP_SIZE - 64 + i)).immi8((uint8)path[i]);
+		++instructions;
+	}
+	uint64 start = a.getInstructionCount();
+	//The path has to be a string object
+	a.op(_MOV_R_R).reg(8).reg(7);
+	a.op(_ADD_R_IMMI).reg(8).immi32(HEAP_SIZE - 64);
+	a.op(_OUT_IMMI_IMMI8).immi32(PORT_STRING_COMMAND).immi8(STRING_MANAGER_CREATE_OBJ);
+	a.op(_OUT_IMMI_R64).reg(8).immi32(PORT_STRING_IO_1);
+	a.op(_OUT_IMMI_IMMI8).immi32(PORT_STRING_COMMAND).immi8(STRING_MANAGER_APPEND_CHAR_ARRAY);
+	a.op(_IN_R64_IMMI).reg(9).immi32(PORT_STRING_OBJ);
+	a.op(_OUT_IMMI_IMMI8).immi32(PORT_FILE_COMMAND).immi8(FILE_MANAGER_CREATE_OBJ);
+	a.op(_OUT_IMMI_R64).reg(9).immi32(PORT_FILE_IO_1);
+	a.op(_OUT_IMMI_IMMI8).immi32(PORT_FILE_COMMAND).immi8(FILE_MANAGER_OPEN_BINARY);
+	a.op(_MOV_R_IMMI).reg(11).immi32(0);
+	a.op(_MOV_R_IMMI).reg(12).immi32(FILE_BLOCK_SIZE);
+	instructions += a.getInstructionCount() - start;
+	instructions += putLoop(&a, "loop", 1, 200000, [&]() {
+		a.op(_OUT_IMMI_R64).reg(11).immi32(PORT_FILE_IO_1);
+		a.op(_OUT_IMMI_IMMI8).immi32(PORT_FILE_COMMAND).immi8(FILE_MANAGER_SET_OFFSET);
+		a.op(_OUT_IMMI_R64).reg(7).immi32(PORT_FILE_IO_1);
+		a.op(_OUT_IMMI_R64).reg(12).immi32(PORT_FILE_IO_2);
+		a.op(_OUT_IMMI_IMMI8).immi32(PORT_FILE_COMMAND).immi8(FILE_MANAGER_READ_BINARY);
+		a.op(_OUT_IMMI_R64).reg(11).immi32(PORT_FILE_IO_1);
+		a.op(_OUT_IMMI_IMMI8).immi32(PORT_FILE_COMMAND).immi8(FILE_MANAGER_SET_OFFSET);
+		a.op(_OUT_IMMI_R64).reg(7).immi32(PORT_FILE_IO_1);
+		a.op(_OUT_IMMI_IMMI8).immi32(PORT_FILE_COMMAND).immi8(FILE_MANAGER_WRITE_BINARY);
+	});
+	start = a.getInstructionCount();
+	a.op(_OUT_IMMI_IMMI8).immi32(PORT_FILE_COMMAND).immi8(FILE_MANAGER_CLOSE);
+	a.op(_OUT_IMMI_IMMI8).immi32(PORT_FILE_COMMAND).immi8(FILE_MANAGER_DESTROY_OBJ);
+	a.op(_OUT_IMMI_IMMI8).immi32(PORT_STRING_COMMAND).immi8(STRING_MANAGER_DESTROY_OBJ);
+	//Words from the start, the middle and the end of what was read
+	a.op(_MOV_R_MR_IMMI).reg(2).reg(7).immi32(0);
+	a.op(_MOV_R_MR_IMMI).reg(3).reg(7).immi32(FILE_BLOCK_SIZE / 2);
+	a.op(_MOV_R_MR_IMMI).reg(4).reg(7).immi32(FILE_BLOCK_SIZE - 4);
+	instructions += a.getInstructionCount() - start;
+	instructions += putExit(&a, {2, 3, 4});
+
+	vector<uint8> data = makeFileData();
+	uint64 result = (uint64)*(uint32*)&data[0] + *(uint32*)&data[FILE_BLOCK_SIZE / 2] + *(uint32*)&data[FILE_BLOCK_SIZE - 4];
+
+	return makeBenchmark("files", &a, instructions, result);
+}
+
+//Draws an 8x8 sprite all over the frame buffer
+static GuestBenchmark makeSprites() {
+	const uint32 iterations = 2000000;
+	GuestAssembler a;
+	uint64 instructions = 0;
+
+	a.label("main");
+	instructions += putMakeHeap(&a, 7);
+	//Width and height come first, the pixels after five words
+	a.op(_MOV_MR_IMMI_IMMI).reg(7).immi32(0).immi32(8);
+	a.op(_MOV_MR_IMMI_IMMI).reg(7).immi32(4).immi32(8);
+	instructions += 2;
+	instructions += putLoop(&a, "loop", 1, iterations, [&]() {
+		a.op(_MOV_R_R).reg(2).reg(1);
+		a.op(_AND_R_IMMI).reg(2).immi32(255);
+		a.op(_MOV_R_R).reg(3).reg(1);
+		a.op(_SHR_R_IMMI8).reg(3).immi8(8);
+		a.op(_AND_R_IMMI).reg(3).immi32(127);
+		a.op(_DRW_R_R_MR).reg(2).reg(3).reg(7);
+	});
+	instructions += putExit(&a, {2, 3});
+
+	//Where the last sprite was drawn
+	uint32 last = iterations - 1;
+	return makeBenchmark("sprites", &a, instructions, (last & 255) + ((last >> 8) & 127));
+}
+
+static bool writeExecutable(const string &path, const GuestBenchmark &benchmark) {
+	HeaderPart1 header;
+	memset(&header, 0, sizeof(header));
+	header.magicNumber = 0x4450564D;
+	header.version = 1;
+	header.headerSize = sizeof(header);
+	header.codeSize = (uint32)benchmark.code.size();
+	header.codeOffset = benchmark.entry;
+	header.dataSize = DATA_SIZE;
+	header.stackSize = STACK_SIZE;
+	header.globalDataSize = GLOBAL_DATA_SIZE;
+	header.frameBufferWidth = FRAME_WIDTH;
+	header.frameBufferHeight = FRAME_HEIGHT;
+	SHA256::SHA_256_MessageDigest signature = SHA256::sha256((uint8*)benchmark.code.data(), header.codeSize);
+	memcpy(header.signature, signature.h, sizeof(header.signature));
+
+	FILE *exeFile = fopen(path.c_str(), "wb");
+	if (exeFile == 0) return false;
+
+	bool written = fwrite(&header, sizeof(header), 1, exeFile) == 1
+		&& fwrite(benchmark.code.data(), 1, benchmark.code.size(), exeFile) == benchmark.code.size();
+	if (fclose(exeFile) != 0) written = false;
+	return written;
+}
+
+static bool writeDataFile(const string &path) {
+	FILE *dataFile = fopen(path.c_str(), "wb");
+	if (dataFile == 0) return false;
+
+	vector<uint8> data = makeFileData();
+	bool written = fwrite(data.data(), 1, data.size(), dataFile) == data.size();
+	if (fclose(dataFile) != 0) written = false;
+	return written;
+}
+
+static bool readFile(const string &path, string *text) {
+	FILE *textFile = fopen(path.c_str(), "rb");
+	if (textFile == 0) return false;
+
+	char buffer[4096];
+	size_t readSize;
+	text->clear();
+	while ((readSize = fread(buffer, 1, sizeof(buffer), textFile)) > 0) {
+		text->append(buffer, readSize);
+	}
+	fclose(textFile);
+	return true;
+}
+
+//Reads "key": number from the JSON despairvm and this program write, between from and to
+static bool readNumber(const string &text, const string &key, double *value, size_t from = 0, size_t to = string::npos) {
+	size_t index = text.find("\"" + key + "\":", from);
+	if (index == string::npos || index >= to) return false;
+
+	*value = strtod(text.c_str() + index + key.size() + 3, 0);
+	return true;
+}
+
+static string quote(const string &str) {
+	return "\"" + str + "\"";
+}
+
+struct BenchmarkResult {
+	int exitStatus;		//-1 if despairvm didn't exit
+	double seconds, translatedBlocks, translationSeconds, translatedBytes;
+};
+
+static int runCommand(const string &command) {
+	int status = system(command.c_str());
+#ifndef _WIN32
+	if (status == -1 || !WIFEXITED(status)) return -1;
+	status = WEXITSTATUS(status);
+#endif
+	return status;
+}
+
+//Returns false if the program failed, exited with anything but exitStatus or did not write its stats
+static bool runBenchmark(const string &command, const string &statsPath, int exitStatus, BenchmarkResult *result) {
+	remove(statsPath.c_str());
+	result->exitStatus = runCommand(command);
+	if (result->exitStatus != exitStatus) return false;
+
+	string stats;
+	return readFile(statsPath, &stats) && readNumber(stats, "seconds", &result->seconds)
+		&& readNumber(stats, "translated_blocks", &result->translatedBlocks)
+		&& readNumber(stats, "translation_seconds", &result->translationSeconds)
+		&& readNumber(stats, "translated_bytes", &result->translatedBytes);
+}
+
+int main(int argc, char **argv) {
+	string vmPath, programFolder = "guestBenchmarks", baselinePath, outputPath, only, vmOptions;
+	int runs = DEFAULT_RUNS;
+
+	//despairvm is built next to this program
+	vmPath = argv[0];
+	size_t slash = vmPath.find_last_of("/\\");
+	vmPath = ((slash == string::npos) ? string("./") : vmPath.substr(0, slash + 1)) + "despairvm";
+
+	for (int i = 1; i < argc; ++i) {
+		string arg = argv[i];
+
+		if (arg == "--") {
+			for (++i; i < argc; ++i) {
+				vmOptions += string(" ") + argv[i];
+			}
+		} else if ((arg == "--vm" || arg == "--programs" || arg == "--runs" || arg == "--only" || arg == "--baseline" || arg == "--output") && i + 1 < argc) {
+			string value = argv[++i];
+			if (arg == "--vm") {
+				vmPath = value;
+			} else if (arg == "--programs") {
+				programFolder = value;
+			} else if (arg == "--runs") {
+				runs = max(atoi(value.c_str()), 1);
+			} else if (arg == "--only") {
+				only = value;
+			} else if (arg == "--baseline") {
+				baselinePath = value;
+			} else {
+				outputPath = value;
+			}
+		} else {
+			fprintf(stderr, "Usage: guestBenchmark [--vm path] [--programs dir] [--runs n] [--only name] [--baseline file] [--output file] [-- despairvm options]\n");
+			return 2;
+		}
+	}
+
+	string baseline;
+	if (!baselinePath.empty() && !readFile(baselinePath, &baseline)) {
+		fprintf(stderr, "Couldn't read baseline %s\n", baselinePath.c_str());
+		return 1;
+	}
+
+#ifdef _WIN32
+	_mkdir(programFolder.c_str());
+#else
+	mkdir(programFolder.c_str(), 0755);
+#endif
+	vector<GuestBenchmark> benchmarks;
+	benchmarks.push_back(makeIntegerALU());
+	benchmarks.push_back(makeFloatMath());
+	benchmarks.push_back(makeMemoryMoves());
+	benchmarks.push_back(makeRecursion());
+	benchmarks.push_back(makePortIO());
+	benchmarks.push_back(makeStrings());
+	benchmarks.push_back(makeFiles());
+	benchmarks.push_back(makeSprites());
+
+	string json = "{\n\t\"benchmarks\": [";
+	bool failed = false;
+	fprintf(stderr, "%-16s %14s %10s %10s %8s %14s %12s %10s\n", "benchmark", "instructions", "seconds", "MIPS", "blocks", "translation ms", "code bytes", "vs base");
+	for (size_t i = 0; i < benchmarks.size(); ++i) {
+		const GuestBenchmark &benchmark = benchmarks[i];
+		if (!only.empty() && benchmark.name != only) continue;
+
+		string programPath = programFolder + "/" + benchmark.name + ".dpx";
+		string statsPath = programFolder + "/" + benchmark.name + ".json";
+		if (!writeExecutable(programPath, benchmark) || !writeDataFile(programFolder + "/" FILE_NAME)) {
+			fprintf(stderr, "Couldn't write %s\n", programPath.c_str());
+			return 1;
+		}
+
+		string command = quote(vmPath) + vmOptions + " --stats " + quote(statsPath) + " " + quote(programPath);
+		int exitStatus = foldResult(benchmark.result);
+		BenchmarkResult best = BenchmarkResult(), result = BenchmarkResult();
+		char line[512];
+		int run;
+		best.seconds = numeric_limits<double>::max();
+		for (run = 0; run < runs && runBenchmark(command, statsPath, exitStatus, &result); ++run) {
+			if (result.seconds < best.seconds) best = result;
+		}
+		if (run < runs) {
+			if (result.exitStatus != exitStatus) {
+				fprintf(stderr, "%-16s failed with exit status %d instead of %d: %s\n", benchmark.name.c_str(), result.exitStatus, exitStatus, command.c_str());
+			} else {
+				fprintf(stderr, "%-16s failed: %s\n", benchmark.name.c_str(), command.c_str());
+			}
+			sprintf(line, "%s\n\t\t{\"name\": \"%s\", \"failed\": true, \"exit_status\": %d, \"expected_exit_status\": %d}",
+					(json[json.size() - 1] == '[') ? "" : ",", benchmark.name.c_str(), result.exitStatus, exitStatus);
+			json += line;
+			failed = true;
+			continue;
+		}
+
+		double mips = benchmark.instructions / best.seconds / 1e6;
+		sprintf(line, "%s\n\t\t{\"name\": \"%s\", \"instructions\": %llu, \"seconds\": %.6f, \"mips\": %.2f, \"translated_blocks\": %.0f, "
+				"\"translation_ms\": %.3f, \"translated_bytes\": %.0f", (json[json.size() - 1] == '[') ? "" : ",", benchmark.name.c_str(),
+				(unsigned long long)benchmark.instructions, best.seconds, mips, best.translatedBlocks, best.translationSeconds * 1e3, best.translatedBytes);
+		json += line;
+
+		//The baseline is an earlier output of this program
+		double baselineMIPS;
+		size_t baselineIndex = baseline.find("\"name\": \"" + benchmark.name + "\"");
+		string comparison = "-";
+		if (baselineIndex != string::npos && readNumber(baseline, "mips", &baselineMIPS, baselineIndex, baseline.find('}', baselineIndex))
+				&& baselineMIPS > 0) {
+			sprintf(line, ", \"baseline_mips\": %.2f, \"speedup\": %.3f", baselineMIPS, mips / baselineMIPS);
+			json += line;
+			sprintf(line, "%.3fx", mips / baselineMIPS);
+			comparison = line;
+		}
+		json += "}";
+
+		fprintf(stderr, "%-16s %14llu %10.3f %10.1f %8.0f %14.3f %12.0f %10s\n", benchmark.name.c_str(), (unsigned long long)benchmark.instructions,
+				best.seconds, mips, best.translatedBlocks, best.translationSeconds * 1e3, best.translatedBytes, comparison.c_str());
+	}
+	json += "\n\t]\n}\n";
+
+	if (outputPath.empty()) {
+		fputs(json.c_str(), stdout);
+	} else {
+		FILE *outputFile = fopen(outputPath.c_str(), "w");
+		if (outputFile == 0 || fputs(json.c_str(), outputFile) < 0 || fclose(outputFile) != 0) {
+			fprintf(stderr, "Couldn't write %s\n", outputPath.c_str());
+			return 1;
+		}
+	}
+
+	return (failed) ? 1 : 0;
+}
@@ -0,0 +1,279 @@
+/*
+	Written By Pradipna Nepal
+	www.pradsprojects.com
+
+	Copyright (C) 2013 Pradipna Nepal
+	Please read COPYING.txt included along with this source code for more detail.
+	If not included, see http://www.gnu.org/licenses/
+*/
+
+//Runs a program without a window so it can be used for batch jobs and benchmarks. The process exits
+//with the low 8 bits of r0 of the main thread once it returns.
+
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <chrono>
+#include <thread>
+#include "build.h"
+#include "despairVM.h"
+#include "despairHeader.h"
+using namespace std;
+using namespace DespairHeader;
+
+#define EXIT_STATUS_USAGE				2
+#define EXIT_STATUS_START_UP_FAILED		125
+
+#define POLL_INTERVAL					1	//Milliseconds between checks of the main thread
+
+struct KeyEvent {
+	uint64 time;	//Milliseconds since the program started
+	uint8 keyCode;
+	bool status;
+};
+
+static bool keyEventEarlier(const KeyEvent &a, const KeyEvent &b) {
+	return a.time < b.time;
+}
+
+static void printUsage() {
+	cerr << "Usage: despairvm [options] program" << endl
+		<< "  --frames dir           Write the frame buffer to dir/frame_NNNNNN.ppm while the program runs" << endl
+		<< "                         and once more after it returns" << endl
+		<< "  --frame-interval ms    Milliseconds between frames written with --frames (default 100)" << endl
+		<< "  --keys file            Key script, one \"time_ms down|up key_code\" per line, # starts a comment" << endl
+		<< "  --jit-threshold n      Times a block is interpreted before it is translated (default 8), 0" << endl
+		<< "                         translates every block the first time it runs" << endl
+		<< "  --translation-cache dir Keep translated code in dir so the next run of the same program skips" << endl
+		<< "                         translating it" << endl
+		<< "  --aot n                Translate all code reachable from the start of the program with n" << endl
+		<< "                         threads before it runs, 0 uses one thread per core" << endl
+		<< "  --compile-threads n    Translate hot code on n background threads while it keeps being" << endl
+		<< "                         interpreted, 0 uses one thread per core" << endl
+		<< "  --profile file         Count the entries, guest instructions and host cycles of every block and" << endl
+		<< "                         write them to file, and for flamegraph.pl to file.folded, when the" << endl
+		<< "                         program returns. Turns --translation-cache off" << endl
+		<< "  --sample file          Sample the guest instruction the program is at " << SAMPLER_FREQUENCY << " times a second of" << endl
+		<< "                         CPU time and write the samples for pprof to file when the program returns" << endl
+		<< "  --stats file           Write the seconds the program ran for, the blocks translated, the time it" << endl
+		<< "                         took and the bytes of code they take to file as JSON when it returns" << endl
+		<< "  --perf-map             Name the translated blocks for Linux perf in /tmp/perf-<pid>.map" << endl
+		<< "  --jitdump              Same as --perf-map, and write their code to /tmp/jit-<pid>.dump for" << endl
+		<< "                         perf inject --jit (record with perf record -k mono)" << endl
+		<< "Exits with the low 8 bits of r0 of the main thread, or " << EXIT_STATUS_START_UP_FAILED << " if the program could not start" << endl;
+}
+
+//Returns false and prints the line if the script is malformed
+static bool loadKeyScript(const string &path, vector<KeyEvent> *keyEvents) {
+	ifstream script(path.c_str());
+	if (!script) {
+		cerr << "Couldn't open key script " << path << endl;
+		return false;
+	}
+
+	string line;
+	for (int lineNumber = 1; getline(script, line); ++lineNumber) {
+		line = line.substr(0, line.find('#'));
+		istringstream fields(line);
+		string time, action, keyCode;
+
+		if (!(fields >> time)) continue;	//Blank line
+		fields >> action >> keyCode;
+
+		char *timeEnd, *keyCodeEnd;
+		KeyEvent keyEvent;
+		keyEvent.time = strtoull(time.c_str(), &timeEnd, 10);
+		unsigned long code = strtoul(keyCode.c_str(), &keyCodeEnd, 0);
+		keyEvent.keyCode = (uint8)code;
+		keyEvent.status = (action == "down");
+
+		if (*timeEnd || keyCode.empty() || *keyCodeEnd || code > 0xFF || (action != "down" && action != "up")) {
+			cerr << path << ":" << lineNumber << ": expected \"time_ms down|up key_code\"" << endl;
+			return false;
+		}
+		keyEvents->push_back(keyEvent);
+	}
+
+	stable_sort(keyEvents->begin(), keyEvents->end(), keyEventEarlier);
+	return true;
+}
+
+//Writes the frame buffer as a binary PPM, the frame buffer is X8R8G8B8
+static bool dumpFrame(const string &path, const uint32 *frameBuffer, int width, int height) {
+	FILE *frameFile = fopen(path.c_str(), "wb");
+	if (frameFile == 0) return false;
+
+	vector<uint8> row(width * 3);
+	fprintf(frameFile, "P6\n%d %d\n255\n", width, height);
+	for (int y = 0; y < height; ++y) {
+		for (int x = 0; x < width; ++x) {
+			uint32 pixel = frameBuffer[y * width + x];
+			row[x * 3] = (pixel >> 16) & 0xFF;
+			row[x * 3 + 1] = (pixel >> 8) & 0xFF;
+			row[x * 3 + 2] = pixel & 0xFF;
+		}
+		fwrite(&row[0], 1, row.size(), frameFile);
+	}
+
+	return fclose(frameFile) == 0;
+}
+
+static string getFramePath(const string &frameFolder, int frameNumber) {
+	char name[32];
+	sprintf(name, "frame_%06d.ppm", frameNumber);
+	return frameFolder + "/" + name;
+}
+
+//One JSON object with the time the program ran for, which includes ahead of time translation, and what
+//was translated meanwhile
+static bool saveStats(const string &path, DespairVM *vm, double seconds) {
+	FILE *statsFile = fopen(path.c_str(), "w");
+	if (statsFile == 0) return false;
+
+	fprintf(statsFile, "{\"seconds\": %.6f, \"translated_blocks\": %llu, \"translation_seconds\": %.6f, \"translated_bytes\": %llu}\n",
+			seconds, (unsigned long long)vm->getTranslatedBlockCount(), vm->getTranslationTime() / 1e9, (unsigned long long)vm->getTranslatedSize());
+	return fclose(statsFile) == 0;
+}
+
+DespairVM despairVM;
+
+int main(int argc, char **argv) {
+	string binPath, frameFolder, keyScriptPath, profilePath, samplesPath, statsPath;
+	uint64 frameInterval = 100;
+	bool perfMap = false, jitdump = false;
+
+	for (int i = 1; i < argc; ++i) {
+		string arg = argv[i];
+
+		if ((arg == "--frames" || arg == "--frame-interval" || arg == "--keys" || arg == "--jit-threshold"
+				|| arg == "--translation-cache" || arg == "--aot" || arg == "--compile-threads" || arg == "--profile" || arg == "--sample" || arg == "--stats") && i + 1 < argc) {
+			string value = argv[++i];
+			if (arg == "--frames") {
+				frameFolder = value;
+			} else if (arg == "--keys") {
+				keyScriptPath = value;
+			} else if (arg == "--jit-threshold") {
+				despairVM.setJITThreshold((uint32)strtoul(value.c_str(), 0, 10));
+			} else if (arg == "--translation-cache") {
+				despairVM.setTranslationCacheFolder(value);
+			} else if (arg == "--aot") {
+				uint32 threadCount = (uint32)strtoul(value.c_str(), 0, 10);
+				if (threadCount == 0) threadCount = max(thread::hardware_concurrency(), 1U);
+				despairVM.setAheadOfTimeThreads(threadCount);
+			} else if (arg == "--compile-threads") {
+				uint32 threadCount = (uint32)strtoul(value.c_str(), 0, 10);
+				if (threadCount == 0) threadCount = max(thread::hardware_concurrency(), 1U);
+				despairVM.setCompileThreads(threadCount);
+			} else if (arg == "--profile") {
+				profilePath = value;
+				despairVM.setProfiling(true);
+			} else if (arg == "--sample") {
+				samplesPath = value;
+				despairVM.setSampling(true);
+			} else if (arg == "--stats") {
+				statsPath = value;
+			} else {
+				frameInterval = strtoull(value.c_str(), 0, 10);
+				if (frameInterval == 0) frameInterval = 1;
+			}
+		} else if (arg == "--perf-map" || arg == "--jitdump") {
+			perfMap = true;
+			jitdump = jitdump || arg == "--jitdump";
+		} else if (arg == "--help" || arg == "-h") {
+			printUsage();
+			return 0;
+		} else if (arg.size() > 1 && arg[0] == '-') {
+			cerr << "Unknown option " << arg << endl;
+			printUsage();
+			return EXIT_STATUS_USAGE;
+		} else if (binPath.empty()) {
+			binPath = arg;
+		} else {
+			printUsage();
+			return EXIT_STATUS_USAGE;
+		}
+	}
+	if (binPath.empty()) {
+		printUsage();
+		return EXIT_STATUS_USAGE;
+	}
+
+	if (perfMap) despairVM.setPerfMap(jitdump);
+
+	vector<KeyEvent> keyEvents;
+	if (!keyScriptPath.empty() && !loadKeyScript(keyScriptPath, &keyEvents)) {
+		return EXIT_STATUS_USAGE;
+	}
+
+	srand((unsigned int)time(0));
+
+	chrono::steady_clock::time_point startUpTime = chrono::steady_clock::now();
+	int retVal = despairVM.startUpDespairVM(binPath);
+	if (retVal != DPVM_START_UP_OK) {
+		switch (retVal) {
+			case DPVM_START_UP_ERROR_BOOT_FAILED:
+				cerr << "DespairVM failed to boot up" << endl;
+				break;
+			case DPVM_START_UP_ERROR_FILE_CORRUPTED:
+				cerr << "Binary file is corrupted" << endl;
+				break;
+			case DPVM_START_UP_ERROR_FILE_IO:
+				cerr << "Couldn't open binary file" << endl;
+				break;
+			case DPVM_START_UP_ERROR_FILE_NOT_RECOGNIZED:
+				cerr << "Binary file is not recognized" << endl;
+		}
+		return EXIT_STATUS_START_UP_FAILED;
+	}
+
+	const ExecutableHeader *header = despairVM.getHeader();
+	int frameWidth = header->part1.frameBufferWidth, frameHeight = header->part1.frameBufferHeight;
+	chrono::steady_clock::time_point startTime = chrono::steady_clock::now();
+	uint64 nextFrameTime = 0;
+	int frameNumber = 0;
+	double runSeconds = 0;
+	size_t nextKeyEvent = 0;
+
+	while (true) {
+		bool running = despairVM.checkMainThreadStatus();
+		uint64 elapsed = chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now() - startTime).count();
+
+		for (; nextKeyEvent < keyEvents.size() && keyEvents[nextKeyEvent].time <= elapsed; ++nextKeyEvent) {
+			despairVM.setKeyboardKeyStatus(keyEvents[nextKeyEvent].keyCode, keyEvents[nextKeyEvent].status);
+		}
+
+		//The last frame is written after the program returned
+		if (!frameFolder.empty() && (!running || elapsed >= nextFrameTime)) {
+			string framePath = getFramePath(frameFolder, frameNumber++);
+			if (!dumpFrame(framePath, despairVM.getGPUFrameBuffer(), frameWidth, frameHeight)) {
+				cerr << "Couldn't write frame " << framePath << endl;
+				frameFolder.clear();
+			}
+			nextFrameTime = elapsed + frameInterval;
+		}
+
+		if (!running) {
+			runSeconds = chrono::duration<double>(chrono::steady_clock::now() - startUpTime).count();
+			break;
+		}
+		this_thread::sleep_for(chrono::milliseconds(POLL_INTERVAL));
+	}
+
+	if (!profilePath.empty() && !despairVM.saveProfile(profilePath)) {
+		cerr << "Couldn't write profile " << profilePath << endl;
+	}
+	if (!samplesPath.empty() && !despairVM.saveSamples(samplesPath)) {
+		cerr << "Couldn't write samples " << samplesPath << endl;
+	}
+	if (!statsPath.empty() && !saveStats(statsPath, &despairVM, runSeconds)) {
+		cerr << "Couldn't write stats " << statsPath << endl;
+	}
+
+	return (int)(despairVM.getExitStatus() & 0xFF);
+}
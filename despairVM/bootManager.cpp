@@ -8,7 +8,7 @@
 */
 
 #include <cstring>
-#include "BootManager.h"
+#include "bootManager.h"
 #include "memoryManager.h"
 #include "threadManager.h"
 #include "despairHeader.h"
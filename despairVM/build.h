@@ -11,11 +11,22 @@
 #define BUILD_H
 
 #define DEBUG_DESPAIR		//Define when building a debug version
+//#define DUMP_DYNAREC_IR	//Define to print the IR of each block before and after optimization
 
-//Define ONLY one of the below
-#define BUILD_FOR_WINDOWS	//Define ONLY when building for Windows OS
+//Define ONLY one of the below, otherwise it is picked from the compiler
+//#define BUILD_FOR_WINDOWS	//Define ONLY when building for Windows OS
 //#define BUILD_FOR_UNIX	//Define ONLY when building for Unix compliant OS
 
+#if !defined(BUILD_FOR_WINDOWS) && !defined(BUILD_FOR_UNIX)
+#ifdef _WIN32
+#define BUILD_FOR_WINDOWS
+#else
+#define BUILD_FOR_UNIX
+#endif
+#endif
+
+#ifdef _MSC_VER
 #define USING_MICROSOFT_COMPILER
+#endif
 
 #endif
\ No newline at end of file
@@ -17,13 +17,19 @@ using namespace std;
 void DespairThreads::thread(void *arg) {
 	ThreadParameter *params = (ThreadParameter*)arg;
 
+	//params may be gone once threadInitialized is set
 	volatile bool *threadStopped = params->threadStopped;
+	volatile int64 *exitStatus = params->exitStatus;
 	if (threadStopped) *threadStopped = false;
 
-	X86DynaRecCore core(params->codePtr, params->globalDataPtr, params->codeStartIndex, params->paramAddr, params->gpuCore, params->header, params->keyboardManager);
+	X86DynaRecCore core(params->codePtr, params->globalDataPtr, params->codeStartIndex, params->paramAddr, params->gpuCore, params->header, params->keyboardManager, params->sharedTranslation);
+	string translationCachePath = params->translationCachePath;
+	if (!translationCachePath.empty()) core.loadTranslationCache(translationCachePath);
 	params->threadInitialized = true;
 	
 	core.startCPULoop();
+	if (!translationCachePath.empty()) core.saveTranslationCache(translationCachePath);
 
+	if (exitStatus) *exitStatus = core.getRegister(0);
 	if (threadStopped) *threadStopped = true;
 }
\ No newline at end of file
@@ -13,17 +13,41 @@
 #include "bootManager.h"
 #include "despairThreads.h"
 #include "gpuCore.h"
+#include "x86DynaRecCore.h"
+#include "x86CompileQueue.h"
+#include "x86CodeCache.h"
 using namespace std;
 using namespace DespairHeader;
 using namespace SHA256;
 using namespace BootManager;
 
 DespairVM::DespairVM() {
+	mainThreadExitStatus = 0;
+	aheadOfTimeThreads = 0;
+	compileThreads = 0;
+	profiling = false;
+	profiler = 0;
+	perfMapEnabled = false;
+	jitdumpEnabled = false;
+	perfMap = 0;
+	sampling = false;
+	sampler = 0;
 	code = 0;
 	globalData = 0;
 }
 
 DespairVM::~DespairVM() {
+	delete sampler;
+	sampler = 0;
+	delete sharedTranslation.compileQueue;
+	sharedTranslation.compileQueue = 0;
+	delete sharedTranslation.codeCache;
+	sharedTranslation.codeCache = 0;
+	delete perfMap;
+	perfMap = 0;
+	X86DynaRecCore::setProfiler(0);
+	delete profiler;
+	profiler = 0;
 	delete [] code;
 	code = 0;
 	delete [] globalData;
@@ -84,6 +108,7 @@ int DespairVM::startUpDespairVM(std::string path) {
 	globalData = new uint8[header.part1.globalDataSize];
 
 	threadParameter.threadStopped = &mainThreadStopped;
+	threadParameter.exitStatus = &mainThreadExitStatus;
 	threadParameter.codeStartIndex = header.part1.codeOffset;
 	threadParameter.paramAddr = 0;
 	threadParameter.codePtr = code;
@@ -91,6 +116,33 @@ int DespairVM::startUpDespairVM(std::string path) {
 	threadParameter.gpuCore = &gpu;
 	threadParameter.keyboardManager = &keyboardManager;
 	threadParameter.header = &header;
+	//Blocks translated before the profiler is set would not be counted, so it comes first
+	if (profiling) {
+		profiler = new X86BlockProfiler;
+		X86DynaRecCore::setProfiler(profiler);
+	}
+	//Code translated up front does not stall the program the first time it runs
+	if (aheadOfTimeThreads) {
+		X86DynaRecCore::translateProgram(code, globalData, &gpu, &header, &keyboardManager, aheadOfTimeThreads, &sharedTranslation.image);
+	}
+	if (compileThreads) {
+		sharedTranslation.compileQueue = new X86CompileQueue(code, globalData, &gpu, &header, &keyboardManager, compileThreads);
+	}
+	//Threads of the program run the code the others translated
+	sharedTranslation.codeCache = new X86CodeCache(header.part1.codeSize);
+	if (perfMapEnabled) {
+		perfMap = new X86PerfMap(jitdumpEnabled);
+		sharedTranslation.codeCache->setPerfMap(perfMap);
+	}
+	if (sampling) {
+		sampler = new X86Sampler(sharedTranslation.codeCache);
+		sampler->start();
+	}
+	threadParameter.sharedTranslation = &sharedTranslation;
+	//Profiled code refers to the profiler of this run, it is neither saved nor replaced by saved code
+	if (!translationCacheFolder.empty() && !profiling) {
+		threadParameter.translationCachePath = translationCacheFolder + "/" + getSignatureName(signature.h) + ".dtc";
+	}
 	
 	if (!bootUpDespair(code, &threadParameter, &header)) {
 		return DPVM_START_UP_ERROR_BOOT_FAILED;
@@ -103,6 +155,10 @@ bool DespairVM::checkMainThreadStatus() {
 	return !mainThreadStopped;
 }
 
+int64 DespairVM::getExitStatus() {
+	return mainThreadExitStatus;
+}
+
 const uint32 *DespairVM::getGPUFrameBuffer() {
 	return gpu.getFrameBuffer();
 }
@@ -111,6 +167,69 @@ void DespairVM::setKeyboardKeyStatus(uint8 keyCode, bool status) {
 	keyboardManager.setKeyStatus(keyCode, status);	
 }
 
+void DespairVM::setJITThreshold(uint32 threshold) {
+	X86DynaRecCore::setJITThreshold(threshold);
+}
+
+void DespairVM::setTranslationCacheFolder(std::string folder) {
+	translationCacheFolder = folder;
+}
+
+void DespairVM::setAheadOfTimeThreads(uint32 threadCount) {
+	aheadOfTimeThreads = threadCount;
+}
+
+void DespairVM::setCompileThreads(uint32 threadCount) {
+	compileThreads = threadCount;
+}
+
+void DespairVM::setProfiling(bool profiling) {
+	this->profiling = profiling;
+}
+
+bool DespairVM::saveProfile(std::string path) {
+	if (!profiler) return false;
+
+	return profiler->saveReport(path) && profiler->saveFoldedStacks(path + ".folded");
+}
+
+void DespairVM::setPerfMap(bool jitdump) {
+	perfMapEnabled = true;
+	jitdumpEnabled = jitdump;
+}
+
+void DespairVM::setSampling(bool sampling) {
+	this->sampling = sampling;
+}
+
+bool DespairVM::saveSamples(std::string path) {
+	if (!sampler) return false;
+
+	sampler->stop();
+	return sampler->saveProfile(path);
+}
+
+uint64 DespairVM::getTranslatedBlockCount() {
+	return X86DynaRecCore::getTranslatedBlockCount();
+}
+
+uint64 DespairVM::getTranslationTime() {
+	return X86DynaRecCore::getTranslationTime();
+}
+
+uint64 DespairVM::getTranslatedSize() {
+	return (sharedTranslation.codeCache) ? sharedTranslation.codeCache->getTranslatedSize() : 0;
+}
+
+//Translated code is only valid for the code it was translated from, so its file is named after the signature
+string DespairVM::getSignatureName(const uint32 *signature) {
+	char name[65];
+	for (int i = 0; i < 8; ++i) {
+		sprintf(&name[i << 3], "%08x", signature[i]);
+	}
+	return name;
+}
+
 const ExecutableHeader *DespairVM::getHeader() {
 	return &header;
 }
\ No newline at end of file
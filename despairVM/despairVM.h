@@ -18,6 +18,9 @@
 #include "despairHeader.h"
 #include "threadParameter.h"
 #include "keyboardManager.h"
+#include "x86BlockProfiler.h"
+#include "x86PerfMap.h"
+#include "x86Sampler.h"
 
 #define DPVM_START_UP_OK								0
 #define DPVM_START_UP_ERROR_FILE_IO						1
@@ -30,10 +33,22 @@ class DespairVM {
 private:
 	GPUCore gpu;
 	volatile bool mainThreadStopped;
+	volatile int64 mainThreadExitStatus;
 	ThreadParameter threadParameter;
 	uint8 *code, *globalData;
 	DespairHeader::ExecutableHeader header;
 	KeyboardManager keyboardManager;
+	std::string translationCacheFolder;
+	uint32 aheadOfTimeThreads, compileThreads;
+	bool profiling;
+	X86BlockProfiler *profiler;
+	bool perfMapEnabled, jitdumpEnabled;
+	X86PerfMap *perfMap;
+	bool sampling;
+	X86Sampler *sampler;
+	X86SharedTranslation sharedTranslation;
+
+	static std::string getSignatureName(const uint32 *signature);
 
 public:
 	DespairVM();
@@ -41,8 +56,21 @@ public:
 
 	int startUpDespairVM(std::string path);	//Initialize despairVM and starts to execute the program
 	bool checkMainThreadStatus();	//Checks the status of main thread of the program that the VM is running
+	int64 getExitStatus();	//Gets r0 of the main thread after it has stopped
 	const uint32 *getGPUFrameBuffer();	//Gets frame buffer from GPU
 	void setKeyboardKeyStatus(uint8 keyCode, bool status);	//Sets keyboard key status
+	void setJITThreshold(uint32 threshold);	//Sets how many times a block is interpreted before it is translated
+	void setTranslationCacheFolder(std::string folder);	//Keeps translated code in folder, so the next run of the same program starts faster
+	void setAheadOfTimeThreads(uint32 threadCount);	//Translates all code that can be found before the program starts with threadCount threads, 0 turns it off
+	void setCompileThreads(uint32 threadCount);	//Translates hot code with threadCount threads while the program keeps running, 0 translates it on the thread that runs it
+	void setProfiling(bool profiling);	//Counts the entries, guest instructions and host cycles of every translated block, the translation cache is not used then
+	bool saveProfile(std::string path);	//Writes the sorted profile to path and its flamegraph input to path.folded
+	void setPerfMap(bool jitdump);	//Tells Linux perf where every translated block is, along with its code if jitdump is set
+	void setSampling(bool sampling);	//Samples the guest instruction the program is at SAMPLER_FREQUENCY times a second of CPU time
+	bool saveSamples(std::string path);	//Stops sampling and writes the samples to path for pprof
+	uint64 getTranslatedBlockCount();	//Blocks and traces translated so far by every thread
+	uint64 getTranslationTime();	//Nanoseconds the threads spent translating them
+	uint64 getTranslatedSize();	//Bytes of translated code in the code cache
 
 	const DespairHeader::ExecutableHeader *getHeader();	//Gets header file of program
 };
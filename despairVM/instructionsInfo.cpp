@@ -0,0 +1,211 @@
+/*
+	Written By Pradipna Nepal
+	www.pradsprojects.com
+
+	Copyright (C) 2013 Pradipna Nepal
+	Please read COPYING.txt included along with this source code for more detail.
+	If not included, see http://www.gnu.org/licenses/
+*/
+
+#include "instructionsInfo.h"
+
+//Indexed by opcode, see instructionsSet.h
+static const InstructionInfo instructionsInfo[] = {
+	{ "MOV_R_R", "wr", 0 },	//0x00
+	{ "MOV_MR_IMMI_R", "rri", 0 },	//0x01
+	{ "MOV_R_MR_IMMI", "wri", 0 },	//0x02
+	{ "MOV_MR_IMMI_MR_IMMI", "rrii", 0 },	//0x03
+	{ "MOV_R_IMMI", "wi", 0 },	//0x04
+	{ "MOV_MR_IMMI_IMMI", "rii", 0 },	//0x05
+	{ "MOV_R_M", "wi", 0 },	//0x06
+	{ "MOV_M_R", "ri", 0 },	//0x07
+	{ "MOV_M_M", "ii", 0 },	//0x08
+	{ "MOV_MR_R", "rr", 0 },	//0x09
+	{ "MOV_R_MR", "wr", 0 },	//0x0a
+	{ "MOV_MR_M", "ri", 0 },	//0x0b
+	{ "MOV_M_MR", "ri", 0 },	//0x0c
+	{ "MOV_MR_MR", "rr", 0 },	//0x0d
+	{ "MOV_M_IMMI", "ii", 0 },	//0x0e
+	{ "MOV_MR_IMMI", "ri", 0 },	//0x0f
+	{ "ADD_R_R", "xr", 0 },	//0x10
+	{ "ADD_R_IMMI", "xi", 0 },	//0x11
+	{ "SUB_R_R", "xr", 0 },	//0x12
+	{ "SUB_R_IMMI", "xi", 0 },	//0x13
+	{ "MUL_R_R", "xr", 0 },	//0x14
+	{ "MUL_R_IMMI", "xi", 0 },	//0x15
+	{ "DIV_R_R", "xr", 0 },	//0x16
+	{ "DIV_R_IMMI", "xi", 0 },	//0x17
+	{ "MOD_R_R", "xr", 0 },	//0x18
+	{ "MOD_R_IMMI", "xi", 0 },	//0x19
+	{ "AND_R_R", "xr", 0 },	//0x1a
+	{ "AND_R_IMMI", "xi", 0 },	//0x1b
+	{ "OR_R_R", "xr", 0 },	//0x1c
+	{ "OR_R_IMMI", "xi", 0 },	//0x1d
+	{ "XOR_R_R", "xr", 0 },	//0x1e
+	{ "XOR_R_IMMI", "xi", 0 },	//0x1f
+	{ "SHL_R_IMMI8", "xb", 0 },	//0x20
+	{ "SHL_R_R", "xr", 0 },	//0x21
+	{ "SHR_R_IMMI8", "xb", 0 },	//0x22
+	{ "SHR_R_R", "xr", 0 },	//0x23
+	{ "NOP", "", 0 },	//0x24
+	{ "JMP_IMMI", "i", INSTRUCTION_BRANCH },	//0x25
+	{ "JMPR_IMMI", "i", INSTRUCTION_BRANCH },	//0x26
+	{ "JC_R_IMMI", "ri", INSTRUCTION_BRANCH },	//0x27
+	{ "JCR_R_IMMI", "ri", INSTRUCTION_BRANCH },	//0x28
+	{ "MOVP_R_MR_IMMI", "wri", 0 },	//0x29
+	{ "MOVP_MR_IMMI_R", "rri", 0 },	//0x2a
+	{ "MOVP_MR_IMMI_MR_IMMI", "rrii", 0 },	//0x2b
+	{ "MOVP_R_M", "wi", 0 },	//0x2c
+	{ "MOVP_M_R", "ri", 0 },	//0x2d
+	{ "MOVP_R_MR", "wr", 0 },	//0x2e
+	{ "MOVP_MR_R", "rr", 0 },	//0x2f
+	{ "CALL_IMMI", "i", INSTRUCTION_BRANCH },	//0x30
+	{ "RET", "", INSTRUCTION_BRANCH },	//0x31
+	{ "PUSH_R", "r", 0 },	//0x32
+	{ "POP_R", "w", 0 },	//0x33
+	{ "DRW_R_R_MR", "rrr", INSTRUCTION_CALLS_HOST },	//0x34
+	{ "OUT_R_IMMI8", "rb", INSTRUCTION_CALLS_HOST },	//0x35
+	{ "OUT_R_IMMI16", "rh", INSTRUCTION_CALLS_HOST },	//0x36
+	{ "OUT_R_IMMI32", "ri", INSTRUCTION_CALLS_HOST },	//0x37
+	{ "OUT_R_IMMI64", "rq", INSTRUCTION_CALLS_HOST },	//0x38
+	{ "OUT_IMMI_R8", "ri", INSTRUCTION_CALLS_HOST },	//0x39
+	{ "OUT_IMMI_R16", "ri", INSTRUCTION_CALLS_HOST },	//0x3a
+	{ "OUT_IMMI_R32", "ri", INSTRUCTION_CALLS_HOST },	//0x3b
+	{ "OUT_IMMI_R64", "ri", INSTRUCTION_CALLS_HOST },	//0x3c
+	{ "OUT_R_R8", "rr", INSTRUCTION_CALLS_HOST },	//0x3d
+	{ "OUT_R_R16", "rr", INSTRUCTION_CALLS_HOST },	//0x3e
+	{ "OUT_R_R32", "rr", INSTRUCTION_CALLS_HOST },	//0x3f
+	{ "OUT_R_R64", "rr", INSTRUCTION_CALLS_HOST },	//0x40
+	{ "OUT_IMMI_IMMI8", "ib", INSTRUCTION_CALLS_HOST },	//0x41
+	{ "OUT_IMMI_IMMI16", "ih", INSTRUCTION_CALLS_HOST },	//0x42
+	{ "OUT_IMMI_IMMI32", "ii", INSTRUCTION_CALLS_HOST },	//0x43
+	{ "OUT_IMMI_IMMI64", "iq", INSTRUCTION_CALLS_HOST },	//0x44
+	{ "IN_R8_IMMI", "wi", INSTRUCTION_CALLS_HOST },	//0x45
+	{ "IN_R16_IMMI", "wi", INSTRUCTION_CALLS_HOST },	//0x46
+	{ "IN_R32_IMMI", "wi", INSTRUCTION_CALLS_HOST },	//0x47
+	{ "IN_R64_IMMI", "wi", INSTRUCTION_CALLS_HOST },	//0x48
+	{ "IN_R8_R", "wr", INSTRUCTION_CALLS_HOST },	//0x49
+	{ "IN_R16_R", "wr", INSTRUCTION_CALLS_HOST },	//0x4a
+	{ "IN_R32_R", "wr", INSTRUCTION_CALLS_HOST },	//0x4b
+	{ "IN_R64_R", "wr", INSTRUCTION_CALLS_HOST },	//0x4c
+	{ "FCON_R_FR", "wf", 0 },	//0x4d
+	{ "FCON_FR_R", "rg", 0 },	//0x4e
+	{ "FCON_FR_IMMI", "gi", 0 },	//0x4f
+	{ "FCON_R_FIMMI", "wi", 0 },	//0x50
+	{ "FMOV_FR_FR", "gf", 0 },	//0x51
+	{ "FMOV_FR_MFR_IMMI", "rgi", 0 },	//0x52
+	{ "FMOV_MFR_IMMI_FR", "rfi", 0 },	//0x53
+	{ "FMOV_MFR_IMMI_MFR_IMMI", "rrii", 0 },	//0x54
+	{ "FMOV_FR_FIMMI", "gi", 0 },	//0x55
+	{ "FMOV_MFR_IMMI_FIMMI", "rii", 0 },	//0x56
+	{ "FMOV_FR_FM", "gi", 0 },	//0x57
+	{ "FMOV_FM_FR", "fi", 0 },	//0x58
+	{ "FMOV_FR_MFR", "rg", 0 },	//0x59
+	{ "FMOV_MFR_FR", "rf", 0 },	//0x5a
+	{ "FMOV_FM_MFR", "ri", 0 },	//0x5b
+	{ "FMOV_MFR_FM", "ri", 0 },	//0x5c
+	{ "FMOV_MFR_MFR", "rr", 0 },	//0x5d
+	{ "FMOV_FM_FM", "ii", 0 },	//0x5e
+	{ "FMOV_FM_FIMMI", "ii", 0 },	//0x5f
+	{ "FMOV_MFR_FIMMI", "ri", 0 },	//0x60
+	{ "FADD_FR_FR", "yf", 0 },	//0x61
+	{ "FADD_R_FR", "xf", 0 },	//0x62
+	{ "FADD_FR_R", "ry", 0 },	//0x63
+	{ "FADD_FR_FIMMI", "yi", 0 },	//0x64
+	{ "FADD_R_FIMMI", "xi", 0 },	//0x65
+	{ "FSUB_FR_FR", "yf", 0 },	//0x66
+	{ "FSUB_R_FR", "xf", 0 },	//0x67
+	{ "FSUB_FR_R", "ry", 0 },	//0x68
+	{ "FSUB_FR_FIMMI", "yi", 0 },	//0x69
+	{ "FSUB_R_FIMMI", "xi", 0 },	//0x6a
+	{ "FMUL_FR_FR", "yf", 0 },	//0x6b
+	{ "FMUL_R_FR", "xf", 0 },	//0x6c
+	{ "FMUL_FR_R", "ry", 0 },	//0x6d
+	{ "FMUL_FR_FIMMI", "yi", 0 },	//0x6e
+	{ "FMUL_R_FIMMI", "xi", 0 },	//0x6f
+	{ "FDIV_FR_FR", "yf", 0 },	//0x70
+	{ "FDIV_R_FR", "xf", 0 },	//0x71
+	{ "FDIV_FR_R", "ry", 0 },	//0x72
+	{ "FDIV_FR_FIMMI", "yi", 0 },	//0x73
+	{ "FDIV_R_FIMMI", "xi", 0 },	//0x74
+	{ "FMOD_FR_FR", "yf", INSTRUCTION_CALLS_HOST },	//0x75
+	{ "FMOD_R_FR", "xf", INSTRUCTION_CALLS_HOST },	//0x76
+	{ "FMOD_FR_R", "ry", INSTRUCTION_CALLS_HOST },	//0x77
+	{ "FMOD_FR_FIMMI", "yi", INSTRUCTION_CALLS_HOST },	//0x78
+	{ "FMOD_R_FIMMI", "xi", INSTRUCTION_CALLS_HOST },	//0x79
+	{ "BMOV_R_BR_IMMI", "wri", 0 },	//0x7a
+	{ "BMOV_BR_IMMI_R", "rri", 0 },	//0x7b
+	{ "BMOV_BR_IMMI_BR_IMMI", "rrii", 0 },	//0x7c
+	{ "BMOV_BR_IMMI_IMMI8", "rib", 0 },	//0x7d
+	{ "BMOV_R_BM", "wi", 0 },	//0x7e
+	{ "BMOV_BM_R", "ri", 0 },	//0x7f
+	{ "BMOV_R_BR", "wr", 0 },	//0x80
+	{ "BMOV_BR_R", "rr", 0 },	//0x81
+	{ "BMOV_BR_BR", "rr", 0 },	//0x82
+	{ "BMOV_BM_BM", "ii", 0 },	//0x83
+	{ "BMOV_BR_IMMI8", "rb", 0 },	//0x84
+	{ "BMOV_BM_IMMI8", "ib", 0 },	//0x85
+	{ "CMPE_R_R", "xr", 0 },	//0x86
+	{ "CMPNE_R_R", "xr", 0 },	//0x87
+	{ "CMPG_R_R", "xr", 0 },	//0x88
+	{ "CMPL_R_R", "xr", 0 },	//0x89
+	{ "CMPGE_R_R", "xr", 0 },	//0x8a
+	{ "CMPLE_R_R", "xr", 0 },	//0x8b
+	{ "CMPE_R_FR_FR", "wff", 0 },	//0x8c
+	{ "CMPNE_R_FR_FR", "wff", 0 },	//0x8d
+	{ "CMPG_R_FR_FR", "wff", 0 },	//0x8e
+	{ "CMPL_R_FR_FR", "wff", 0 },	//0x8f
+	{ "CMPGE_R_FR_FR", "wff", 0 },	//0x90
+	{ "CMPLE_R_FR_FR", "wff", 0 },	//0x91
+	{ "FOUT_IMMI_FR", "fi", INSTRUCTION_CALLS_HOST },	//0x92
+	{ "FIN_IMMI_FR", "gi", INSTRUCTION_CALLS_HOST },	//0x93
+	{ "FOUT_IMMI_FIMMI", "ii", INSTRUCTION_CALLS_HOST },	//0x94
+	{ "PUSHES_R_R", "bb", INSTRUCTION_ALL_REGS },	//0x95
+	{ "POPS_R_R", "bb", INSTRUCTION_ALL_REGS },	//0x96
+	{ "FPUSHES_FR_FR", "bb", INSTRUCTION_ALL_REGS },	//0x97
+	{ "FPOPS_FR_FR", "bb", INSTRUCTION_ALL_REGS },	//0x98
+	{ "FPUSH_FR", "f", 0 },	//0x99
+	{ "FPOP_FR", "g", 0 },	//0x9a
+	{ "CMPE_R_IMMI", "xi", 0 },	//0x9b
+	{ "CMPNE_R_IMMI", "xi", 0 },	//0x9c
+	{ "CMPG_R_IMMI", "xi", 0 },	//0x9d
+	{ "CMPGE_R_IMMI", "xi", 0 },	//0x9e
+	{ "CMPL_R_IMMI", "xi", 0 },	//0x9f
+	{ "CMPLE_R_IMMI", "xi", 0 },	//0xa0
+	{ "TIME", "", INSTRUCTION_CALLS_HOST | INSTRUCTION_ALL_REGS },	//0xa1
+	{ "SLEEP", "", INSTRUCTION_CALLS_HOST },	//0xa2
+	{ "RAND", "", INSTRUCTION_CALLS_HOST | INSTRUCTION_ALL_REGS },	//0xa3
+	{ "JMP_R", "r", INSTRUCTION_BRANCH },	//0xa4
+	{ "JMPR_R", "r", INSTRUCTION_BRANCH },	//0xa5
+	{ "JC_R_R", "rr", INSTRUCTION_BRANCH },	//0xa6
+	{ "JCR_R_R", "rr", INSTRUCTION_BRANCH },	//0xa7
+};
+
+const InstructionInfo *InstructionsInfo::getInstructionInfo(uint16 opcode) {
+	if (opcode >= sizeof(instructionsInfo) / sizeof(InstructionInfo)) {
+		return 0;
+	}
+	return &instructionsInfo[opcode];
+}
+
+int InstructionsInfo::getOperandSize(char operand) {
+	switch (operand) {
+		case OPERAND_IMMI16:
+			return 2;
+		case OPERAND_IMMI32:
+			return 4;
+		case OPERAND_IMMI64:
+			return 8;
+		default:
+			return 1;
+	}
+}
+
+int InstructionsInfo::getInstructionSize(const InstructionInfo *instructionInfo) {
+	int size = 2;
+
+	for (const char *operand = instructionInfo->operands; *operand; ++operand) {
+		size += getOperandSize(*operand);
+	}
+	return size;
+}
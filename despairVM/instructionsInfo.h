@@ -0,0 +1,46 @@
+/*
+	Written By Pradipna Nepal
+	www.pradsprojects.com
+
+	Copyright (C) 2013 Pradipna Nepal
+	Please read COPYING.txt included along with this source code for more detail.
+	If not included, see http://www.gnu.org/licenses/
+*/
+
+#ifndef INSTRUCTIONS_INFO_H
+#define INSTRUCTIONS_INFO_H
+
+#include "build.h"
+#include "declarations.h"
+
+//Operand kinds, one character per operand in the order they are encoded
+#define OPERAND_REG_READ			'r'
+#define OPERAND_REG_WRITE			'w'
+#define OPERAND_REG_READ_WRITE		'x'
+#define OPERAND_FREG_READ			'f'
+#define OPERAND_FREG_WRITE			'g'
+#define OPERAND_FREG_READ_WRITE		'y'
+#define OPERAND_IMMI8				'b'
+#define OPERAND_IMMI16				'h'
+#define OPERAND_IMMI32				'i'	//Also used for float immediates and global memory addresses
+#define OPERAND_IMMI64				'q'
+
+#define INSTRUCTION_BRANCH			0x01	//Ends a block
+#define INSTRUCTION_CALLS_HOST		0x02	//Calls a host function
+#define INSTRUCTION_ALL_REGS		0x04	//Reads or writes registers that are not in its operands
+
+struct InstructionInfo {
+	const char *name;
+	const char *operands;
+	uint8 flags;
+};
+
+namespace InstructionsInfo {
+	//Returns 0 if the opcode is not a Despair instruction
+	const InstructionInfo *getInstructionInfo(uint16 opcode);
+	int getOperandSize(char operand);
+	//Size of the whole instruction including the opcode
+	int getInstructionSize(const InstructionInfo *instructionInfo);
+}
+
+#endif
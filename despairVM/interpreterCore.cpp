@@ -0,0 +1,1137 @@
+/*
+	Written By Pradipna Nepal
+	www.pradsprojects.com
+
+	Copyright (C) 2013 Pradipna Nepal
+	Please read COPYING.txt included along with this source code for more detail.
+	If not included, see http://www.gnu.org/licenses/
+*/
+
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <xmmintrin.h>
+#include "interpreterCore.h"
+#include "instructionsSet.h"
+#include "instructionsInfo.h"
+#include "portAddress.h"
+using namespace std;
+
+//Same conversions as cvtsi2ss and cvtss2si on the low dword of a register
+static float32 toFloat(int64 value) {
+	return (float32)(int32)value;
+}
+
+static int64 toInt(float32 value) {
+	return (uint32)_mm_cvtss_si32(_mm_set_ss(value));
+}
+
+//Register plus a sign extended displacement, like the add rax, immi of the translated code
+static uint8 *getAddress(int64 base, const uint8 *immi) {
+	return (uint8*)(base + *(int32*)immi);
+}
+
+static uint64 getSource(const IRInstruction &ir, const int64 *regs) {
+	return (ir.srcImmi) ? ir.immi : (uint64)regs[ir.src];
+}
+
+InterpreterCore::InterpreterCore(int64 *regs, float32 *fRegs, int64 *sP, MemoryManager *memManager, PortManager *portManager, GPUCore *gpuCore, DespairTimer *timer, uint64 codeSize) {
+	this->regs = regs;
+	this->fRegs = fRegs;
+	this->sP = sP;
+	this->memManager = memManager;
+	this->portManager = portManager;
+	this->gpuCore = gpuCore;
+	this->timer = timer;
+	this->codeSize = codeSize;
+	nextPC = 0;
+}
+
+InterpreterCore::~InterpreterCore() {
+	for (map<int64, InterpretedBlock*>::iterator i = blocks.begin(); i != blocks.end(); ++i) {
+		delete i->second;
+	}
+}
+
+bool InterpreterCore::runBlock(int64 *pC, uint32 hotThreshold) {
+	if (hotThreshold == 0 || (uint64)*pC >= codeSize) return false;
+
+	InterpretedBlock *block;
+	map<int64, InterpretedBlock*>::iterator found = blocks.find(*pC);
+	if (found != blocks.end()) {
+		block = found->second;
+	} else {
+		block = decodeBlock(*pC);
+		found = blocks.insert(make_pair(*pC, block)).first;
+	}
+
+	//The dynarec takes over from here, the decoded block is not needed anymore
+	if (!block->interpretable || block->executionCount >= hotThreshold) {
+		delete block;
+		blocks.erase(found);
+		return false;
+	}
+
+	++block->executionCount;
+	nextPC = block->endAddress;
+	const ThreadedInstruction *instruction = &block->instructions[0];
+	for (size_t count = block->instructions.size(); count; --count, ++instruction) {
+		instruction->handler(this, *instruction);
+	}
+	*pC = nextPC;
+
+	return true;
+}
+
+InterpretedBlock *InterpreterCore::decodeBlock(int64 address) {
+	InterpretedBlock *block = new InterpretedBlock;
+	IRBlock irBlock(memManager->codeSpace);
+
+	irBlock.decode(address);
+	block->endAddress = irBlock.endAddress;
+	block->executionCount = 0;
+	block->interpretable = true;
+	for (size_t i = 0; i < irBlock.instructions.size(); ++i) {
+		const IRInstruction &ir = irBlock.instructions[i];
+		const InstructionInfo *instructionInfo = InstructionsInfo::getInstructionInfo(ir.despairOpcode);
+		ThreadedInstruction instruction;
+
+		instruction.handler = getHandler(ir);
+		instruction.ir = ir;
+		instruction.operands = &memManager->codeSpace[ir.address + 2];
+		instruction.nextAddress = (i + 1 < irBlock.instructions.size()) ? irBlock.instructions[i + 1].address : irBlock.endAddress;
+		//Instructions past the end of the code can't be decoded safely
+		if (!instruction.handler || !instructionInfo || (uint64)instruction.nextAddress > codeSize) {
+			block->interpretable = false;
+			break;
+		}
+		block->instructions.push_back(instruction);
+	}
+
+	return block;
+}
+
+InterpreterHandler InterpreterCore::getHandler(const IRInstruction &instruction) {
+	switch (instruction.opcode) {
+		case IR_MOV: return irMov;
+		case IR_ADD: return irAdd;
+		case IR_SUB: return irSub;
+		case IR_MUL: return irMul;
+		case IR_DIV: return irDiv;
+		case IR_MOD: return irMod;
+		case IR_AND: return irAnd;
+		case IR_OR: return irOr;
+		case IR_XOR: return irXor;
+		case IR_SHL: return irShl;
+		case IR_SHR: return irShr;
+		case IR_CMPE: return irCmpE;
+		case IR_CMPNE: return irCmpNE;
+		case IR_CMPG: return irCmpG;
+		case IR_CMPL: return irCmpL;
+		case IR_CMPGE: return irCmpGE;
+		case IR_CMPLE: return irCmpLE;
+		case IR_LOAD32: return irLoad32;
+		case IR_LOAD64: return irLoad64;
+		case IR_STORE32: return irStore32;
+		case IR_STORE64: return irStore64;
+		default: break;
+	}
+
+	switch (instruction.despairOpcode) {
+		case _MOV_R_MR_IMMI: return MOV_R_MR_IMMI;
+		case _MOV_MR_IMMI_R: return MOV_MR_IMMI_R;
+		case _MOV_MR_IMMI_MR_IMMI: return MOV_MR_IMMI_MR_IMMI;
+		case _MOV_MR_IMMI_IMMI: return MOV_MR_IMMI_IMMI;
+		case _MOV_M_M: return MOV_M_M;
+		case _MOV_MR_R: return MOV_MR_R;
+		case _MOV_R_MR: return MOV_R_MR;
+		case _MOV_MR_M: return MOV_MR_M;
+		case _MOV_M_MR: return MOV_M_MR;
+		case _MOV_MR_MR: return MOV_MR_MR;
+		case _MOV_MR_IMMI: return MOV_MR_IMMI;
+		case _NOP: return NOP;
+		case _MOVP_R_MR_IMMI: return MOVP_R_MR_IMMI;
+		case _MOVP_MR_IMMI_R: return MOVP_MR_IMMI_R;
+		case _MOVP_MR_IMMI_MR_IMMI: return MOVP_MR_IMMI_MR_IMMI;
+		case _MOVP_R_MR: return MOVP_R_MR;
+		case _MOVP_MR_R: return MOVP_MR_R;
+		case _PUSH_R: return PUSH_R;
+		case _POP_R: return POP_R;
+		case _DRW_R_R_MR: return DRW_R_R_MR;
+		case _OUT_R_IMMI8: return OUT_R_IMMI8;
+		case _OUT_R_IMMI16: return OUT_R_IMMI16;
+		case _OUT_R_IMMI32: return OUT_R_IMMI32;
+		case _OUT_R_IMMI64: return OUT_R_IMMI64;
+		case _OUT_IMMI_R8: return OUT_IMMI_R8;
+		case _OUT_IMMI_R16: return OUT_IMMI_R16;
+		case _OUT_IMMI_R32: return OUT_IMMI_R32;
+		case _OUT_IMMI_R64: return OUT_IMMI_R64;
+		case _OUT_R_R8: return OUT_R_R8;
+		case _OUT_R_R16: return OUT_R_R16;
+		case _OUT_R_R32: return OUT_R_R32;
+		case _OUT_R_R64: return OUT_R_R64;
+		case _OUT_IMMI_IMMI8: return OUT_IMMI_IMMI8;
+		case _OUT_IMMI_IMMI16: return OUT_IMMI_IMMI16;
+		case _OUT_IMMI_IMMI32: return OUT_IMMI_IMMI32;
+		case _OUT_IMMI_IMMI64: return OUT_IMMI_IMMI64;
+		case _IN_R8_IMMI: return IN_R8_IMMI;
+		case _IN_R16_IMMI: return IN_R16_IMMI;
+		case _IN_R32_IMMI: return IN_R32_IMMI;
+		case _IN_R64_IMMI: return IN_R64_IMMI;
+		case _IN_R8_R: return IN_R8_R;
+		case _IN_R16_R: return IN_R16_R;
+		case _IN_R32_R: return IN_R32_R;
+		case _IN_R64_R: return IN_R64_R;
+		case _FCON_R_FR: return FCON_R_FR;
+		case _FCON_FR_R: return FCON_FR_R;
+		case _FCON_FR_IMMI: return FCON_FR_IMMI;
+		case _FCON_R_FIMMI: return FCON_R_FIMMI;
+		case _FMOV_FR_FR: return FMOV_FR_FR;
+		case _FMOV_FR_MFR_IMMI: return FMOV_FR_MFR_IMMI;
+		case _FMOV_MFR_IMMI_FR: return FMOV_MFR_IMMI_FR;
+		case _FMOV_MFR_IMMI_MFR_IMMI: return FMOV_MFR_IMMI_MFR_IMMI;
+		case _FMOV_FR_FIMMI: return FMOV_FR_FIMMI;
+		case _FMOV_MFR_IMMI_FIMMI: return FMOV_MFR_IMMI_FIMMI;
+		case _FMOV_FR_FM: return FMOV_FR_FM;
+		case _FMOV_FM_FR: return FMOV_FM_FR;
+		case _FMOV_FR_MFR: return FMOV_FR_MFR;
+		case _FMOV_MFR_FR: return FMOV_MFR_FR;
+		case _FMOV_FM_MFR: return FMOV_FM_MFR;
+		case _FMOV_MFR_FM: return FMOV_MFR_FM;
+		case _FMOV_MFR_MFR: return FMOV_MFR_MFR;
+		case _FMOV_FM_FM: return FMOV_FM_FM;
+		case _FMOV_FM_FIMMI: return FMOV_FM_FIMMI;
+		case _FMOV_MFR_FIMMI: return FMOV_MFR_FIMMI;
+		case _FADD_FR_FR: return FADD_FR_FR;
+		case _FADD_R_FR: return FADD_R_FR;
+		case _FADD_FR_R: return FADD_FR_R;
+		case _FADD_FR_FIMMI: return FADD_FR_FIMMI;
+		case _FADD_R_FIMMI: return FADD_R_FIMMI;
+		case _FSUB_FR_FR: return FSUB_FR_FR;
+		case _FSUB_R_FR: return FSUB_R_FR;
+		case _FSUB_FR_R: return FSUB_FR_R;
+		case _FSUB_FR_FIMMI: return FSUB_FR_FIMMI;
+		case _FSUB_R_FIMMI: return FSUB_R_FIMMI;
+		case _FMUL_FR_FR: return FMUL_FR_FR;
+		case _FMUL_R_FR: return FMUL_R_FR;
+		case _FMUL_FR_R: return FMUL_FR_R;
+		case _FMUL_FR_FIMMI: return FMUL_FR_FIMMI;
+		case _FMUL_R_FIMMI: return FMUL_R_FIMMI;
+		case _FDIV_FR_FR: return FDIV_FR_FR;
+		case _FDIV_R_FR: return FDIV_R_FR;
+		case _FDIV_FR_R: return FDIV_FR_R;
+		case _FDIV_FR_FIMMI: return FDIV_FR_FIMMI;
+		case _FDIV_R_FIMMI: return FDIV_R_FIMMI;
+		case _FMOD_FR_FR: return FMOD_FR_FR;
+		case _FMOD_R_FR: return FMOD_R_FR;
+		case _FMOD_FR_R: return FMOD_FR_R;
+		case _FMOD_FR_FIMMI: return FMOD_FR_FIMMI;
+		case _FMOD_R_FIMMI: return FMOD_R_FIMMI;
+		case _BMOV_R_BR_IMMI: return BMOV_R_MBR_IMMI;
+		case _BMOV_BR_IMMI_BR_IMMI: return BMOV_MBR_IMMI_MBR_IMMI;
+		case _BMOV_BR_IMMI_IMMI8: return BMOV_MBR_IMMI_IMMI8;
+		case _BMOV_R_BM: return BMOV_R_BM;
+		case _BMOV_BM_R: return BMOV_BM_R;
+		case _BMOV_R_BR: return BMOV_R_MBR;
+		case _BMOV_BR_R: return BMOV_MBR_R;
+		case _BMOV_BR_BR: return BMOV_MBR_MBR;
+		case _BMOV_BM_BM: return BMOV_BM_BM;
+		case _BMOV_BR_IMMI8: return BMOV_MBR_IMMI8;
+		//BMOV_BR_IMMI_R and BMOV_BM_IMMI8 are left to the dynarec, the interpreter would not do the same
+		//as its translation
+		case _CMPE_R_FR_FR: return FCMPE_R_FR_FR;
+		case _CMPNE_R_FR_FR: return FCMPNE_R_FR_FR;
+		case _CMPG_R_FR_FR: return FCMPG_R_FR_FR;
+		case _CMPL_R_FR_FR: return FCMPL_R_FR_FR;
+		case _CMPGE_R_FR_FR: return FCMPGE_R_FR_FR;
+		case _CMPLE_R_FR_FR: return FCMPLE_R_FR_FR;
+		case _FOUT_IMMI_FR: return FOUT_IMMI_FR;
+		case _FIN_IMMI_FR: return FIN_FR_IMMI;
+		case _FOUT_IMMI_FIMMI: return FOUT_IMMI_FIMMI;
+		case _PUSHES_R_R: return PUSHES_R_R;
+		case _POPS_R_R: return POPS_R_R;
+		case _FPUSHES_FR_FR: return FPUSHES_FR_FR;
+		case _FPOPS_FR_FR: return FPOPS_FR_FR;
+		case _FPUSH_FR: return FPUSH_FR;
+		case _FPOP_FR: return FPOP_FR;
+		case _TIME: return TIME;
+		case _SLEEP: return SLEEP;
+		case _RAND: return RAND;
+		case _JMP_IMMI: return JMP_IMMI;
+		case _JMPR_IMMI: return JMPR_IMMI;
+		case _JC_R_IMMI: return JC_R_IMMI;
+		case _JCR_R_IMMI: return JCR_R_IMMI;
+		case _CALL_IMMI: return CALL_IMMI;
+		case _RET: return RET;
+		case _JMP_R: return JMP_R;
+		case _JMPR_R: return JMPR_R;
+		case _JC_R_R: return JC_R_R;
+		case _JCR_R_R: return JCR_R_R;
+		default: return 0;
+	}
+}
+
+void InterpreterCore::irMov(InterpreterCore *core, const ThreadedInstruction &instruction) {
+	core->regs[instruction.ir.dst] = getSource(instruction.ir, core->regs);
+}
+
+void InterpreterCore::irAdd(InterpreterCore *core, const ThreadedInstruction &instruction) {
+	core->regs[instruction.ir.dst] += getSource(instruction.ir, core->regs);
+}
+
+void InterpreterCore::irSub(InterpreterCore *core, const ThreadedInstruction &instruction) {
+	core->regs[instruction.ir.dst] -= getSource(instruction.ir, core->regs);
+}
+
+void InterpreterCore::irMul(InterpreterCore *core, const ThreadedInstruction &instruction) {
+	core->regs[instruction.ir.dst] = (uint64)core->regs[instruction.ir.dst] * getSource(instruction.ir, core->regs);
+}
+
+//The translated code uses idiv with rdx cleared, so the dividend is unsigned and the divisor signed.
+//Dividing by zero faults the same way.
+void InterpreterCore::irDiv(InterpreterCore *core, const ThreadedInstruction &instruction) {
+	uint64 dividend = core->regs[instruction.ir.dst];
+	int64 divisor = getSource(instruction.ir, core->regs);
+	uint64 quotient = dividend / ((divisor < 0) ? 0 - (uint64)divisor : (uint64)divisor);
+
+	core->regs[instruction.ir.dst] = (divisor < 0) ? 0 - quotient : quotient;
+}
+
+void InterpreterCore::irMod(InterpreterCore *core, const ThreadedInstruction &instruction) {
+	uint64 dividend = core->regs[instruction.ir.dst];
+	int64 divisor = getSource(instruction.ir, core->regs);
+
+	core->regs[instruction.ir.dst] = dividend % ((divisor < 0) ? 0 - (uint64)divisor : (uint64)divisor);
+}
+
+void InterpreterCore::irAnd(InterpreterCore *core, const ThreadedInstruction &instruction) {
+	core->regs[instruction.ir.dst] &= getSource(instruction.ir, core->regs);
+}
+
+void InterpreterCore::irOr(InterpreterCore *core, const ThreadedInstruction &instruction) {
+	core->regs[instruction.ir.dst] |= getSource(instruction.ir, core->regs);
+}
+
+void InterpreterCore::irXor(InterpreterCore *core, const ThreadedInstruction &instruction) {
+	core->regs[instruction.ir.dst] ^= getSource(instruction.ir, core->regs);
+}
+
+void InterpreterCore::irShl(InterpreterCore *core, const ThreadedInstruction &instruction) {
+	core->regs[instruction.ir.dst] = (uint64)core->regs[instruction.ir.dst] << (getSource(instruction.ir, core->regs) & 63);
+}
+
+void InterpreterCore::irShr(InterpreterCore *core, const ThreadedInstruction &instruction) {
+	core->regs[instruction.ir.dst] = (uint64)core->regs[instruction.ir.dst] >> (getSource(instruction.ir, core->regs) & 63);
+}
+
+void InterpreterCore::irCmpE(InterpreterCore *core, const ThreadedInstruction &instruction) {
+	core->regs[instruction.ir.dst] = ((int32)core->regs[instruction.ir.dst] == (int32)getSource(instruction.ir, core->regs)) ? 1 : 0;
+}
+
+void InterpreterCore::irCmpNE(InterpreterCore *core, const ThreadedInstruction &instruction) {
+	core->regs[instruction.ir.dst] = ((int32)core->regs[instruction.ir.dst] != (int32)getSource(instruction.ir, core->regs)) ? 1 : 0;
+}
+
+void InterpreterCore::irCmpG(InterpreterCore *core, const ThreadedInstruction &instruction) {
+	core->regs[instruction.ir.dst] = ((int32)core->regs[instruction.ir.dst] > (int32)getSource(instruction.ir, core->regs)) ? 1 : 0;
+}
+
+void InterpreterCore::irCmpL(InterpreterCore *core, const ThreadedInstruction &instruction) {
+	core->regs[instruction.ir.dst] = ((int32)core->regs[instruction.ir.dst] < (int32)getSource(instruction.ir, core->regs)) ? 1 : 0;
+}
+
+void InterpreterCore::irCmpGE(InterpreterCore *core, const ThreadedInstruction &instruction) {
+	core->regs[instruction.ir.dst] = ((int32)core->regs[instruction.ir.dst] >= (int32)getSource(instruction.ir, core->regs)) ? 1 : 0;
+}
+
+void InterpreterCore::irCmpLE(InterpreterCore *core, const ThreadedInstruction &instruction) {
+	core->regs[instruction.ir.dst] = ((int32)core->regs[instruction.ir.dst] <= (int32)getSource(instruction.ir, core->regs)) ? 1 : 0;
+}
+
+void InterpreterCore::irLoad32(InterpreterCore *core, const ThreadedInstruction &instruction) {
+	core->regs[instruction.ir.dst] = *(uint32*)&core->memManager->globalDataSpace[instruction.ir.mOffset];
+}
+
+void InterpreterCore::irLoad64(InterpreterCore *core, const ThreadedInstruction &instruction) {
+	core->regs[instruction.ir.dst] = *(int64*)&core->memManager->globalDataSpace[instruction.ir.mOffset];
+}
+
+void InterpreterCore::irStore32(InterpreterCore *core, const ThreadedInstruction &instruction) {
+	*(uint32*)&core->memManager->globalDataSpace[instruction.ir.mOffset] = (uint32)getSource(instruction.ir, core->regs);
+}
+
+void InterpreterCore::irStore64(InterpreterCore *core, const ThreadedInstruction &instruction) {
+	*(uint64*)&core->memManager->globalDataSpace[instruction.ir.mOffset] = getSource(instruction.ir, core->regs);
+}
+
+void InterpreterCore::MOV_R_MR_IMMI(InterpreterCore *core, const ThreadedInstruction &instruction) {
+	const uint8 *operands = instruction.operands;
+
+	core->regs[operands[0]] = *(uint32*)getAddress(core->regs[operands[1]], &operands[2]);
+}
+
+void InterpreterCore::MOV_MR_IMMI_R(InterpreterCore *core, const ThreadedInstruction &instruction) {
+	const uint8 *operands = instruction.operands;
+
+	*(uint32*)getAddress(core->regs[operands[1]], &operands[2]) = (uint32)core->regs[operands[0]];
+}
+
+void InterpreterCore::MOV_MR_IMMI_MR_IMMI(InterpreterCore *core, const ThreadedInstruction &instruction) {
+	const uint8 *operands = instruction.operands;
+
+	*(uint32*)getAddress(core->regs[operands[0]], &operands[2]) = *(uint32*)getAddress(core->regs[operands[1]], &operands[6]);
+}
+
+void InterpreterCore::MOV_MR_IMMI_IMMI(InterpreterCore *core, const ThreadedInstruction &instruction) {
+	const uint8 *operands = instruction.operands;
+
+	*(uint32*)getAddress(core->regs[operands[0]], &operands[1]) = *(uint32*)&operands[5];
+}
+
+void InterpreterCore::MOV_M_M(InterpreterCore *core, const ThreadedInstruction &instruction) {
+	uint8 *globalDataSpace = core->memManager->globalDataSpace;
+	const uint8 *operands = instruction.operands;
+
+	*(uint32*)&globalDataSpace[*(uint32*)&operands[0]] = *(uint32*)&globalDataSpace[*(uint32*)&operands[4]];
+}
+
+void InterpreterCore::MOV_MR_R(InterpreterCore *core, const ThreadedInstruction &instruction) {
+	const uint8 *operands = instruction.operands;
+
+	*(uint32*)core->regs[operands[1]] = (uint32)core->regs[operands[0]];
+}
+
+void InterpreterCore::MOV_R_MR(InterpreterCore *core, const ThreadedInstruction &instruction) {
+	const uint8 *operands = instruction.operands;
+
+	core->regs[operands[0]] = *(uint32*)core->regs[operands[1]];
+}
+
+void InterpreterCore::MOV_MR_M(InterpreterCore *core, const ThreadedInstruction &instruction) {
+	const uint8 *operands = instruction.operands;
+
+	*(uint32*)core->regs[operands[0]] = *(uint32*)&core->memManager->globalDataSpace[*(uint32*)&operands[1]];
+}
+
+void InterpreterCore::MOV_M_MR(InterpreterCore *core, const ThreadedInstruction &instruction) {
+	const uint8 *operands = instruction.operands;
+
+	*(uint32*)&core->memManager->globalDataSpace[*(uint32*)&operands[1]] = *(uint32*)core->regs[operands[0]];
+}
+
+void InterpreterCore::MOV_MR_MR(InterpreterCore *core, const ThreadedInstruction &instruction) {
+	const uint8 *operands = instruction.operands;
+
+	*(uint32*)core->regs[operands[0]] = *(uint32*)core->regs[operands[1]];
+}
+
+void InterpreterCore::MOV_MR_IMMI(InterpreterCore *core, const ThreadedInstruction &instruction) {
+	const uint8 *operands = instruction.operands;
+
+	*(uint32*)core->regs[operands[0]] = *(uint32*)&operands[1];
+}
+
+void InterpreterCore::NOP(InterpreterCore *, const ThreadedInstruction &) {
+}
+
+void InterpreterCore::MOVP_R_MR_IMMI(InterpreterCore *core, const ThreadedInstruction &instruction) {
+	const uint8 *operands = instruction.operands;
+
+	core->regs[operands[0]] = *(int64*)getAddress(core->regs[operands[1]], &operands[2]);
+}
+
+void InterpreterCore::MOVP_MR_IMMI_R(InterpreterCore *core, const ThreadedInstruction &instruction) {
+	const uint8 *operands = instruction.operands;
+
+	*(int64*)getAddress(core->regs[operands[1]], &operands[2]) = core->regs[operands[0]];
+}
+
+void InterpreterCore::MOVP_MR_IMMI_MR_IMMI(InterpreterCore *core, const ThreadedInstruction &instruction) {
+	const uint8 *operands = instruction.operands;
+
+	*(int64*)getAddress(core->regs[operands[0]], &operands[2]) = *(int64*)getAddress(core->regs[operands[1]], &operands[6]);
+}
+
+void InterpreterCore::MOVP_R_MR(InterpreterCore *core, const ThreadedInstruction &instruction) {
+	const uint8 *operands = instruction.operands;
+
+	core->regs[operands[0]] = *(int64*)core->regs[operands[1]];
+}
+
+void InterpreterCore::MOVP_MR_R(InterpreterCore *core, const ThreadedInstruction &instruction) {
+	const uint8 *operands = instruction.operands;
+
+	*(int64*)core->regs[operands[1]] = core->regs[operands[0]];
+}
+
+//The stack pointer is a dword, only its low half moves like the add (sP), n of the translated code
+void InterpreterCore::PUSH_R(InterpreterCore *core, const ThreadedInstruction &instruction) {
+	uint32 *stackPointer = (uint32*)core->sP;
+
+	*(int64*)&core->memManager->stackSpace[*stackPointer] = core->regs[instruction.operands[0]];
+	*stackPointer += 8;
+}
+
+void InterpreterCore::POP_R(InterpreterCore *core, const ThreadedInstruction &instruction) {
+	uint32 *stackPointer = (uint32*)core->sP;
+
+	*stackPointer -= 8;
+	core->regs[instruction.operands[0]] = *(int64*)&core->memManager->stackSpace[*stackPointer];
+}
+
+void InterpreterCore::DRW_R_R_MR(InterpreterCore *core, const ThreadedInstruction &instruction) {
+	const uint8 *operands = instruction.operands;
+
+	core->gpuCore->draw((int32)core->regs[operands[0]], (int32)core->regs[operands[1]], core->regs[operands[2]],
+						PortManager::readPort<uint8>(PORT_GPU_EFFECTS, core->portManager), PortManager::readPort<uint16>(PORT_GPU_ROTATION, core->portManager));
+}
+
+void InterpreterCore::OUT_R_IMMI8(InterpreterCore *core, const ThreadedInstruction &instruction) {
+	const uint8 *operands = instruction.operands;
+
+	PortManager::writePort<uint8>(operands[1], (uint32)core->regs[operands[0]], core->portManager);
+}
+
+void InterpreterCore::OUT_R_IMMI16(InterpreterCore *core, const ThreadedInstruction &instruction) {
+	const uint8 *operands = instruction.operands;
+
+	PortManager::writePort<uint16>(*(uint16*)&operands[1], (uint32)core->regs[operands[0]], core->portManager);
+}
+
+void InterpreterCore::OUT_R_IMMI32(InterpreterCore *core, const ThreadedInstruction &instruction) {
+	const uint8 *operands = instruction.operands;
+
+	PortManager::writePort<uint32>(*(uint32*)&operands[1], (uint32)core->regs[operands[0]], core->portManager);
+}
+
+void InterpreterCore::OUT_R_IMMI64(InterpreterCore *core, const ThreadedInstruction &instruction) {
+	const uint8 *operands = instruction.operands;
+
+	PortManager::writePort<uint64>(*(uint64*)&operands[1], (uint32)core->regs[operands[0]], core->portManager);
+}
+
+void InterpreterCore::OUT_IMMI_R8(InterpreterCore *core, const ThreadedInstruction &instruction) {
+	const uint8 *operands = instruction.operands;
+
+	PortManager::writePort<uint8>((uint8)core->regs[operands[0]], *(uint32*)&operands[1], core->portManager);
+}
+
+void InterpreterCore::OUT_IMMI_R16(InterpreterCore *core, const ThreadedInstruction &instruction) {
+	const uint8 *operands = instruction.operands;
+
+	PortManager::writePort<uint16>((uint16)core->regs[operands[0]], *(uint32*)&operands[1], core->portManager);
+}
+
+void InterpreterCore::OUT_IMMI_R32(InterpreterCore *core, const ThreadedInstruction &instruction) {
+	const uint8 *operands = instruction.operands;
+
+	PortManager::writePort<uint32>((uint32)core->regs[operands[0]], *(uint32*)&operands[1], core->portManager);
+}
+
+void InterpreterCore::OUT_IMMI_R64(InterpreterCore *core, const ThreadedInstruction &instruction) {
+	const uint8 *operands = instruction.operands;
+
+	PortManager::writePort<uint64>((uint64)core->regs[operands[0]], *(uint32*)&operands[1], core->portManager);
+}
+
+void InterpreterCore::OUT_R_R8(InterpreterCore *core, const ThreadedInstruction &instruction) {
+	const uint8 *operands = instruction.operands;
+
+	PortManager::writePort<uint8>((uint8)core->regs[operands[1]], (uint32)core->regs[operands[0]], core->portManager);
+}
+
+void InterpreterCore::OUT_R_R16(InterpreterCore *core, const ThreadedInstruction &instruction) {
+	const uint8 *operands = instruction.operands;
+
+	PortManager::writePort<uint16>((uint16)core->regs[operands[1]], (uint32)core->regs[operands[0]], core->portManager);
+}
+
+void InterpreterCore::OUT_R_R32(InterpreterCore *core, const ThreadedInstruction &instruction) {
+	const uint8 *operands = instruction.operands;
+
+	PortManager::writePort<uint32>((uint32)core->regs[operands[1]], (uint32)core->regs[operands[0]], core->portManager);
+}
+
+void InterpreterCore::OUT_R_R64(InterpreterCore *core, const ThreadedInstruction &instruction) {
+	const uint8 *operands = instruction.operands;
+
+	PortManager::writePort<uint64>((uint64)core->regs[operands[1]], (uint32)core->regs[operands[0]], core->portManager);
+}
+
+void InterpreterCore::OUT_IMMI_IMMI8(InterpreterCore *core, const ThreadedInstruction &instruction) {
+	const uint8 *operands = instruction.operands;
+
+	PortManager::writePort<uint8>(operands[4], *(uint32*)&operands[0], core->portManager);
+}
+
+void InterpreterCore::OUT_IMMI_IMMI16(InterpreterCore *core, const ThreadedInstruction &instruction) {
+	const uint8 *operands = instruction.operands;
+
+	PortManager::writePort<uint16>(*(uint16*)&operands[4], *(uint32*)&operands[0], core->portManager);
+}
+
+void InterpreterCore::OUT_IMMI_IMMI32(InterpreterCore *core, const ThreadedInstruction &instruction) {
+	const uint8 *operands = instruction.operands;
+
+	PortManager::writePort<uint32>(*(uint32*)&operands[4], *(uint32*)&operands[0], core->portManager);
+}
+
+void InterpreterCore::OUT_IMMI_IMMI64(InterpreterCore *core, const ThreadedInstruction &instruction) {
+	const uint8 *operands = instruction.operands;
+
+	PortManager::writePort<uint64>(*(uint64*)&operands[4], *(uint32*)&operands[0], core->portManager);
+}
+
+void InterpreterCore::IN_R8_IMMI(InterpreterCore *core, const ThreadedInstruction &instruction) {
+	const uint8 *operands = instruction.operands;
+
+	core->regs[operands[0]] = PortManager::readPort<uint8>(*(uint32*)&operands[1], core->portManager);
+}
+
+void InterpreterCore::IN_R16_IMMI(InterpreterCore *core, const ThreadedInstruction &instruction) {
+	const uint8 *operands = instruction.operands;
+
+	core->regs[operands[0]] = PortManager::readPort<uint16>(*(uint32*)&operands[1], core->portManager);
+}
+
+void InterpreterCore::IN_R32_IMMI(InterpreterCore *core, const ThreadedInstruction &instruction) {
+	const uint8 *operands = instruction.operands;
+
+	core->regs[operands[0]] = PortManager::readPort<uint32>(*(uint32*)&operands[1], core->portManager);
+}
+
+void InterpreterCore::IN_R64_IMMI(InterpreterCore *core, const ThreadedInstruction &instruction) {
+	const uint8 *operands = instruction.operands;
+
+	core->regs[operands[0]] = PortManager::readPort<uint64>(*(uint32*)&operands[1], core->portManager);
+}
+
+void InterpreterCore::IN_R8_R(InterpreterCore *core, const ThreadedInstruction &instruction) {
+	const uint8 *operands = instruction.operands;
+
+	core->regs[operands[0]] = PortManager::readPort<uint8>((uint32)core->regs[operands[1]], core->portManager);
+}
+
+void InterpreterCore::IN_R16_R(InterpreterCore *core, const ThreadedInstruction &instruction) {
+	const uint8 *operands = instruction.operands;
+
+	core->regs[operands[0]] = PortManager::readPort<uint16>((uint32)core->regs[operands[1]], core->portManager);
+}
+
+void InterpreterCore::IN_R32_R(InterpreterCore *core, const ThreadedInstruction &instruction) {
+	const uint8 *operands = instruction.operands;
+
+	core->regs[operands[0]] = PortManager::readPort<uint32>((uint32)core->regs[operands[1]], core->portManager);
+}
+
+void InterpreterCore::IN_R64_R(InterpreterCore *core, const ThreadedInstruction &instruction) {
+	const uint8 *operands = instruction.operands;
+
+	core->regs[operands[0]] = PortManager::readPort<uint64>((uint32)core->regs[operands[1]], core->portManager);
+}
+
+void InterpreterCore::FCON_R_FR(InterpreterCore *core, const ThreadedInstruction &instruction) {
+	const uint8 *operands = instruction.operands;
+
+	core->regs[operands[0]] = toInt(core->fRegs[operands[1]]);
+}
+
+void InterpreterCore::FCON_FR_R(InterpreterCore *core, const ThreadedInstruction &instruction) {
+	const uint8 *operands = instruction.operands;
+
+	core->fRegs[operands[1]] = toFloat(core->regs[operands[0]]);
+}
+
+void InterpreterCore::FCON_FR_IMMI(InterpreterCore *core, const ThreadedInstruction &instruction) {
+	const uint8 *operands = instruction.operands;
+
+	core->fRegs[operands[0]] = toFloat(*(int32*)&operands[1]);
+}
+
+void InterpreterCore::FCON_R_FIMMI(InterpreterCore *core, const ThreadedInstruction &instruction) {
+	const uint8 *operands = instruction.operands;
+
+	core->regs[operands[0]] = toInt(*(float32*)&operands[1]);
+}
+
+void InterpreterCore::FMOV_FR_MFR_IMMI(InterpreterCore *core, const ThreadedInstruction &instruction) {
+	const uint8 *operands = instruction.operands;
+
+	core->fRegs[operands[1]] = *(float32*)getAddress(core->regs[operands[0]], &operands[2]);
+}
+
+void InterpreterCore::FMOV_MFR_IMMI_FR(InterpreterCore *core, const ThreadedInstruction &instruction) {
+	const uint8 *operands = instruction.operands;
+
+	*(float32*)getAddress(core->regs[operands[0]], &operands[2]) = core->fRegs[operands[1]];
+}
+
+void InterpreterCore::FMOV_MFR_IMMI_MFR_IMMI(InterpreterCore *core, const ThreadedInstruction &instruction) {
+	const uint8 *operands = instruction.operands;
+
+	*(float32*)getAddress(core->regs[operands[0]], &operands[2]) = *(float32*)getAddress(core->regs[operands[1]], &operands[6]);
+}
+
+void InterpreterCore::FMOV_MFR_IMMI_FIMMI(InterpreterCore *core, const ThreadedInstruction &instruction) {
+	const uint8 *operands = instruction.operands;
+
+	*(float32*)getAddress(core->regs[operands[0]], &operands[1]) = *(float32*)&operands[5];
+}
+
+void InterpreterCore::FMOV_FR_FR(InterpreterCore *core, const ThreadedInstruction &instruction) {
+	const uint8 *operands = instruction.operands;
+
+	core->fRegs[operands[0]] = core->fRegs[operands[1]];
+}
+
+void InterpreterCore::FMOV_FR_FM(InterpreterCore *core, const ThreadedInstruction &instruction) {
+	const uint8 *operands = instruction.operands;
+
+	core->fRegs[operands[0]] = *(float32*)&core->memManager->globalDataSpace[*(uint32*)&operands[1]];
+}
+
+void InterpreterCore::FMOV_FM_FR(InterpreterCore *core, const ThreadedInstruction &instruction) {
+	const uint8 *operands = instruction.operands;
+
+	*(float32*)&core->memManager->globalDataSpace[*(uint32*)&operands[1]] = core->fRegs[operands[0]];
+}
+
+void InterpreterCore::FMOV_FR_MFR(InterpreterCore *core, const ThreadedInstruction &instruction) {
+	const uint8 *operands = instruction.operands;
+
+	core->fRegs[operands[1]] = *(float32*)core->regs[operands[0]];
+}
+
+void InterpreterCore::FMOV_MFR_FR(InterpreterCore *core, const ThreadedInstruction &instruction) {
+	const uint8 *operands = instruction.operands;
+
+	*(float32*)core->regs[operands[0]] = core->fRegs[operands[1]];
+}
+
+void InterpreterCore::FMOV_FM_MFR(InterpreterCore *core, const ThreadedInstruction &instruction) {
+	const uint8 *operands = instruction.operands;
+
+	*(float32*)&core->memManager->globalDataSpace[*(uint32*)&operands[1]] = *(float32*)core->regs[operands[0]];
+}
+
+void InterpreterCore::FMOV_MFR_FM(InterpreterCore *core, const ThreadedInstruction &instruction) {
+	const uint8 *operands = instruction.operands;
+
+	*(float32*)core->regs[operands[0]] = *(float32*)&core->memManager->globalDataSpace[*(uint32*)&operands[1]];
+}
+
+void InterpreterCore::FMOV_MFR_MFR(InterpreterCore *core, const ThreadedInstruction &instruction) {
+	const uint8 *operands = instruction.operands;
+
+	*(float32*)core->regs[operands[0]] = *(float32*)core->regs[operands[1]];
+}
+
+void InterpreterCore::FMOV_FM_FM(InterpreterCore *core, const ThreadedInstruction &instruction) {
+	uint8 *globalDataSpace = core->memManager->globalDataSpace;
+	const uint8 *operands = instruction.operands;
+
+	*(float32*)&globalDataSpace[*(uint32*)&operands[0]] = *(float32*)&globalDataSpace[*(uint32*)&operands[4]];
+}
+
+void InterpreterCore::FMOV_FR_FIMMI(InterpreterCore *core, const ThreadedInstruction &instruction) {
+	const uint8 *operands = instruction.operands;
+
+	core->fRegs[operands[0]] = *(float32*)&operands[1];
+}
+
+void InterpreterCore::FMOV_FM_FIMMI(InterpreterCore *core, const ThreadedInstruction &instruction) {
+	const uint8 *operands = instruction.operands;
+
+	*(float32*)&core->memManager->globalDataSpace[*(uint32*)&operands[0]] = *(float32*)&operands[4];
+}
+
+void InterpreterCore::FMOV_MFR_FIMMI(InterpreterCore *core, const ThreadedInstruction &instruction) {
+	const uint8 *operands = instruction.operands;
+
+	*(float32*)core->regs[operands[0]] = *(float32*)&operands[1];
+}
+
+void InterpreterCore::FADD_FR_FR(InterpreterCore *core, const ThreadedInstruction &instruction) {
+	const uint8 *operands = instruction.operands;
+
+	core->fRegs[operands[0]] += core->fRegs[operands[1]];
+}
+
+void InterpreterCore::FADD_R_FR(InterpreterCore *core, const ThreadedInstruction &instruction) {
+	const uint8 *operands = instruction.operands;
+
+	core->regs[operands[0]] = toInt(toFloat(core->regs[operands[0]]) + core->fRegs[operands[1]]);
+}
+
+void InterpreterCore::FADD_FR_R(InterpreterCore *core, const ThreadedInstruction &instruction) {
+	const uint8 *operands = instruction.operands;
+
+	core->fRegs[operands[1]] += toFloat(core->regs[operands[0]]);
+}
+
+void InterpreterCore::FADD_FR_FIMMI(InterpreterCore *core, const ThreadedInstruction &instruction) {
+	const uint8 *operands = instruction.operands;
+
+	core->fRegs[operands[0]] += *(float32*)&operands[1];
+}
+
+void InterpreterCore::FADD_R_FIMMI(InterpreterCore *core, const ThreadedInstruction &instruction) {
+	const uint8 *operands = instruction.operands;
+
+	core->regs[operands[0]] = toInt(toFloat(core->regs[operands[0]]) + *(float32*)&operands[1]);
+}
+
+void InterpreterCore::FSUB_FR_FR(InterpreterCore *core, const ThreadedInstruction &instruction) {
+	const uint8 *operands = instruction.operands;
+
+	core->fRegs[operands[0]] -= core->fRegs[operands[1]];
+}
+
+void InterpreterCore::FSUB_R_FR(InterpreterCore *core, const ThreadedInstruction &instruction) {
+	const uint8 *operands = instruction.operands;
+
+	core->regs[operands[0]] = toInt(toFloat(core->regs[operands[0]]) - core->fRegs[operands[1]]);
+}
+
+void InterpreterCore::FSUB_FR_R(InterpreterCore *core, const ThreadedInstruction &instruction) {
+	const uint8 *operands = instruction.operands;
+
+	core->fRegs[operands[1]] -= toFloat(core->regs[operands[0]]);
+}
+
+void InterpreterCore::FSUB_FR_FIMMI(InterpreterCore *core, const ThreadedInstruction &instruction) {
+	const uint8 *operands = instruction.operands;
+
+	core->fRegs[operands[0]] -= *(float32*)&operands[1];
+}
+
+void InterpreterCore::FSUB_R_FIMMI(InterpreterCore *core, const ThreadedInstruction &instruction) {
+	const uint8 *operands = instruction.operands;
+
+	core->regs[operands[0]] = toInt(toFloat(core->regs[operands[0]]) - *(float32*)&operands[1]);
+}
+
+void InterpreterCore::FMUL_FR_FR(InterpreterCore *core, const ThreadedInstruction &instruction) {
+	const uint8 *operands = instruction.operands;
+
+	core->fRegs[operands[0]] *= core->fRegs[operands[1]];
+}
+
+void InterpreterCore::FMUL_R_FR(InterpreterCore *core, const ThreadedInstruction &instruction) {
+	const uint8 *operands = instruction.operands;
+
+	core->regs[operands[0]] = toInt(toFloat(core->regs[operands[0]]) * core->fRegs[operands[1]]);
+}
+
+void InterpreterCore::FMUL_FR_R(InterpreterCore *core, const ThreadedInstruction &instruction) {
+	const uint8 *operands = instruction.operands;
+
+	core->fRegs[operands[1]] *= toFloat(core->regs[operands[0]]);
+}
+
+void InterpreterCore::FMUL_FR_FIMMI(InterpreterCore *core, const ThreadedInstruction &instruction) {
+	const uint8 *operands = instruction.operands;
+
+	core->fRegs[operands[0]] *= *(float32*)&operands[1];
+}
+
+void InterpreterCore::FMUL_R_FIMMI(InterpreterCore *core, const ThreadedInstruction &instruction) {
+	const uint8 *operands = instruction.operands;
+
+	core->regs[operands[0]] = toInt(toFloat(core->regs[operands[0]]) * *(float32*)&operands[1]);
+}
+
+void InterpreterCore::FDIV_FR_FR(InterpreterCore *core, const ThreadedInstruction &instruction) {
+	const uint8 *operands = instruction.operands;
+
+	core->fRegs[operands[0]] /= core->fRegs[operands[1]];
+}
+
+void InterpreterCore::FDIV_R_FR(InterpreterCore *core, const ThreadedInstruction &instruction) {
+	const uint8 *operands = instruction.operands;
+
+	core->regs[operands[0]] = toInt(toFloat(core->regs[operands[0]]) / core->fRegs[operands[1]]);
+}
+
+void InterpreterCore::FDIV_FR_R(InterpreterCore *core, const ThreadedInstruction &instruction) {
+	const uint8 *operands = instruction.operands;
+
+	core->fRegs[operands[1]] /= toFloat(core->regs[operands[0]]);
+}
+
+void InterpreterCore::FDIV_FR_FIMMI(InterpreterCore *core, const ThreadedInstruction &instruction) {
+	const uint8 *operands = instruction.operands;
+
+	core->fRegs[operands[0]] /= *(float32*)&operands[1];
+}
+
+void InterpreterCore::FDIV_R_FIMMI(InterpreterCore *core, const ThreadedInstruction &instruction) {
+	const uint8 *operands = instruction.operands;
+
+	core->regs[operands[0]] = toInt(toFloat(core->regs[operands[0]]) / *(float32*)&operands[1]);
+}
+
+void InterpreterCore::FMOD_FR_FR(InterpreterCore *core, const ThreadedInstruction &instruction) {
+	const uint8 *operands = instruction.operands;
+
+	core->fRegs[operands[0]] = fmod(core->fRegs[operands[0]], core->fRegs[operands[1]]);
+}
+
+void InterpreterCore::FMOD_R_FR(InterpreterCore *core, const ThreadedInstruction &instruction) {
+	const uint8 *operands = instruction.operands;
+
+	core->regs[operands[0]] = toInt(fmod(toFloat(core->regs[operands[0]]), core->fRegs[operands[1]]));
+}
+
+void InterpreterCore::FMOD_FR_R(InterpreterCore *core, const ThreadedInstruction &instruction) {
+	const uint8 *operands = instruction.operands;
+
+	core->fRegs[operands[1]] = fmod(core->fRegs[operands[1]], toFloat(core->regs[operands[0]]));
+}
+
+void InterpreterCore::FMOD_FR_FIMMI(InterpreterCore *core, const ThreadedInstruction &instruction) {
+	const uint8 *operands = instruction.operands;
+
+	core->fRegs[operands[0]] = fmod(core->fRegs[operands[0]], *(float32*)&operands[1]);
+}
+
+void InterpreterCore::FMOD_R_FIMMI(InterpreterCore *core, const ThreadedInstruction &instruction) {
+	const uint8 *operands = instruction.operands;
+
+	core->regs[operands[0]] = toInt(fmod(toFloat(core->regs[operands[0]]), *(float32*)&operands[1]));
+}
+
+void InterpreterCore::BMOV_R_MBR_IMMI(InterpreterCore *core, const ThreadedInstruction &instruction) {
+	const uint8 *operands = instruction.operands;
+
+	core->regs[operands[0]] = *getAddress(core->regs[operands[1]], &operands[2]);
+}
+
+void InterpreterCore::BMOV_MBR_IMMI_MBR_IMMI(InterpreterCore *core, const ThreadedInstruction &instruction) {
+	const uint8 *operands = instruction.operands;
+
+	*getAddress(core->regs[operands[0]], &operands[2]) = *getAddress(core->regs[operands[1]], &operands[6]);
+}
+
+void InterpreterCore::BMOV_MBR_IMMI_IMMI8(InterpreterCore *core, const ThreadedInstruction &instruction) {
+	const uint8 *operands = instruction.operands;
+
+	*getAddress(core->regs[operands[0]], &operands[1]) = operands[5];
+}
+
+void InterpreterCore::BMOV_R_BM(InterpreterCore *core, const ThreadedInstruction &instruction) {
+	const uint8 *operands = instruction.operands;
+
+	core->regs[operands[0]] = core->memManager->globalDataSpace[*(uint32*)&operands[1]];
+}
+
+void InterpreterCore::BMOV_BM_R(InterpreterCore *core, const ThreadedInstruction &instruction) {
+	const uint8 *operands = instruction.operands;
+
+	core->memManager->globalDataSpace[*(uint32*)&operands[1]] = (uint8)core->regs[operands[0]];
+}
+
+void InterpreterCore::BMOV_R_MBR(InterpreterCore *core, const ThreadedInstruction &instruction) {
+	const uint8 *operands = instruction.operands;
+
+	core->regs[operands[0]] = *(uint8*)core->regs[operands[1]];
+}
+
+void InterpreterCore::BMOV_MBR_R(InterpreterCore *core, const ThreadedInstruction &instruction) {
+	const uint8 *operands = instruction.operands;
+
+	*(uint8*)core->regs[operands[1]] = (uint8)core->regs[operands[0]];
+}
+
+void InterpreterCore::BMOV_MBR_MBR(InterpreterCore *core, const ThreadedInstruction &instruction) {
+	const uint8 *operands = instruction.operands;
+
+	*(uint8*)core->regs[operands[0]] = *(uint8*)core->regs[operands[1]];
+}
+
+void InterpreterCore::BMOV_BM_BM(InterpreterCore *core, const ThreadedInstruction &instruction) {
+	uint8 *globalDataSpace = core->memManager->globalDataSpace;
+	const uint8 *operands = instruction.operands;
+
+	globalDataSpace[*(uint32*)&operands[0]] = globalDataSpace[*(uint32*)&operands[4]];
+}
+
+void InterpreterCore::BMOV_MBR_IMMI8(InterpreterCore *core, const ThreadedInstruction &instruction) {
+	const uint8 *operands = instruction.operands;
+
+	*(uint8*)core->regs[operands[0]] = operands[1];
+}
+
+//Same results as the ucomiss of the translated code, including when one of the values is NaN
+void InterpreterCore::FCMPE_R_FR_FR(InterpreterCore *core, const ThreadedInstruction &instruction) {
+	const uint8 *operands = instruction.operands;
+	float32 value1 = core->fRegs[operands[1]], value2 = core->fRegs[operands[2]];
+
+	core->regs[operands[0]] = (!(value1 < value2 || value1 > value2)) ? 1 : 0;
+}
+
+void InterpreterCore::FCMPNE_R_FR_FR(InterpreterCore *core, const ThreadedInstruction &instruction) {
+	const uint8 *operands = instruction.operands;
+	float32 value1 = core->fRegs[operands[1]], value2 = core->fRegs[operands[2]];
+
+	core->regs[operands[0]] = (value1 < value2 || value1 > value2) ? 1 : 0;
+}
+
+void InterpreterCore::FCMPG_R_FR_FR(InterpreterCore *core, const ThreadedInstruction &instruction) {
+	const uint8 *operands = instruction.operands;
+
+	core->regs[operands[0]] = (core->fRegs[operands[1]] > core->fRegs[operands[2]]) ? 1 : 0;
+}
+
+void InterpreterCore::FCMPL_R_FR_FR(InterpreterCore *core, const ThreadedInstruction &instruction) {
+	const uint8 *operands = instruction.operands;
+
+	core->regs[operands[0]] = (!(core->fRegs[operands[1]] >= core->fRegs[operands[2]])) ? 1 : 0;
+}
+
+void InterpreterCore::FCMPGE_R_FR_FR(InterpreterCore *core, const ThreadedInstruction &instruction) {
+	const uint8 *operands = instruction.operands;
+
+	core->regs[operands[0]] = (core->fRegs[operands[1]] >= core->fRegs[operands[2]]) ? 1 : 0;
+}
+
+void InterpreterCore::FCMPLE_R_FR_FR(InterpreterCore *core, const ThreadedInstruction &instruction) {
+	const uint8 *operands = instruction.operands;
+
+	core->regs[operands[0]] = (!(core->fRegs[operands[1]] > core->fRegs[operands[2]])) ? 1 : 0;
+}
+
+void InterpreterCore::FOUT_IMMI_FR(InterpreterCore *core, const ThreadedInstruction &instruction) {
+	const uint8 *operands = instruction.operands;
+
+	PortManager::writePortAsFloat(core->fRegs[operands[0]], *(uint32*)&operands[1], core->portManager);
+}
+
+void InterpreterCore::FIN_FR_IMMI(InterpreterCore *core, const ThreadedInstruction &instruction) {
+	const uint8 *operands = instruction.operands;
+
+	core->fRegs[operands[0]] = PortManager::readPortAsFloat(*(uint32*)&operands[1], core->portManager);
+}
+
+void InterpreterCore::FOUT_IMMI_FIMMI(InterpreterCore *core, const ThreadedInstruction &instruction) {
+	const uint8 *operands = instruction.operands;
+
+	PortManager::writePortAsFloat(*(float32*)&operands[4], *(uint32*)&operands[0], core->portManager);
+}
+
+void InterpreterCore::PUSHES_R_R(InterpreterCore *core, const ThreadedInstruction &instruction) {
+	const uint8 *operands = instruction.operands;
+	uint32 *stackPointer = (uint32*)core->sP;
+	uint32 size = (operands[1] - operands[0] + 1) << 3;
+
+	memcpy(&core->memManager->stackSpace[*stackPointer], &core->regs[operands[0]], size);
+	*stackPointer += size;
+}
+
+void InterpreterCore::POPS_R_R(InterpreterCore *core, const ThreadedInstruction &instruction) {
+	const uint8 *operands = instruction.operands;
+	uint32 *stackPointer = (uint32*)core->sP;
+	uint32 size = (operands[1] - operands[0] + 1) << 3;
+
+	*stackPointer -= size;
+	memcpy(&core->regs[operands[0]], &core->memManager->stackSpace[*stackPointer], size);
+}
+
+void InterpreterCore::FPUSHES_FR_FR(InterpreterCore *core, const ThreadedInstruction &instruction) {
+	const uint8 *operands = instruction.operands;
+	uint32 *stackPointer = (uint32*)core->sP;
+	uint32 size = (operands[1] - operands[0] + 1) << 2;
+
+	memcpy(&core->memManager->stackSpace[*stackPointer], &core->fRegs[operands[0]], size);
+	*stackPointer += size;
+}
+
+void InterpreterCore::FPOPS_FR_FR(InterpreterCore *core, const ThreadedInstruction &instruction) {
+	const uint8 *operands = instruction.operands;
+	uint32 *stackPointer = (uint32*)core->sP;
+	uint32 size = (operands[1] - operands[0] + 1) << 2;
+
+	*stackPointer -= size;
+	memcpy(&core->fRegs[operands[0]], &core->memManager->stackSpace[*stackPointer], size);
+}
+
+void InterpreterCore::FPUSH_FR(InterpreterCore *core, const ThreadedInstruction &instruction) {
+	uint32 *stackPointer = (uint32*)core->sP;
+
+	*(float32*)&core->memManager->stackSpace[*stackPointer] = core->fRegs[instruction.operands[0]];
+	*stackPointer += 4;
+}
+
+void InterpreterCore::FPOP_FR(InterpreterCore *core, const ThreadedInstruction &instruction) {
+	uint32 *stackPointer = (uint32*)core->sP;
+
+	*stackPointer -= 4;
+	core->fRegs[instruction.operands[0]] = *(float32*)&core->memManager->stackSpace[*stackPointer];
+}
+
+void InterpreterCore::TIME(InterpreterCore *core, const ThreadedInstruction &) {
+	core->regs[0] = DespairTimer::getMilliseconds(core->timer);
+}
+
+void InterpreterCore::SLEEP(InterpreterCore *, const ThreadedInstruction &) {
+	DespairTimer::sleep(1);
+}
+
+void InterpreterCore::RAND(InterpreterCore *core, const ThreadedInstruction &) {
+	core->regs[0] = rand();
+}
+
+void InterpreterCore::JMP_IMMI(InterpreterCore *core, const ThreadedInstruction &instruction) {
+	core->nextPC = *(uint32*)&instruction.operands[0];
+}
+
+void InterpreterCore::JMPR_IMMI(InterpreterCore *core, const ThreadedInstruction &instruction) {
+	core->nextPC = instruction.nextAddress + *(int32*)&instruction.operands[0];
+}
+
+//Conditional jumps are taken when the register is 0
+void InterpreterCore::JC_R_IMMI(InterpreterCore *core, const ThreadedInstruction &instruction) {
+	const uint8 *operands = instruction.operands;
+
+	if (core->regs[operands[0]] == 0) core->nextPC = *(uint32*)&operands[1];
+}
+
+void InterpreterCore::JCR_R_IMMI(InterpreterCore *core, const ThreadedInstruction &instruction) {
+	const uint8 *operands = instruction.operands;
+
+	if (core->regs[operands[0]] == 0) core->nextPC = instruction.nextAddress + *(int32*)&operands[1];
+}
+
+void InterpreterCore::CALL_IMMI(InterpreterCore *core, const ThreadedInstruction &instruction) {
+	int64 stackPointer = *core->sP;
+
+	*(uint32*)&core->memManager->stackSpace[stackPointer] = (uint32)instruction.nextAddress;
+	*core->sP = stackPointer + 4;
+	core->nextPC = *(uint32*)&instruction.operands[0];
+}
+
+//Returning from the first function ends the thread
+void InterpreterCore::RET(InterpreterCore *core, const ThreadedInstruction &) {
+	*core->sP -= 4;
+	core->nextPC = (*core->sP < 0) ? -1 : (int64)*(uint32*)&core->memManager->stackSpace[*core->sP];
+}
+
+void InterpreterCore::JMP_R(InterpreterCore *core, const ThreadedInstruction &instruction) {
+	core->nextPC = core->regs[instruction.operands[0]];
+}
+
+void InterpreterCore::JMPR_R(InterpreterCore *core, const ThreadedInstruction &instruction) {
+	core->nextPC = core->regs[instruction.operands[0]] + instruction.nextAddress;
+}
+
+void InterpreterCore::JC_R_R(InterpreterCore *core, const ThreadedInstruction &instruction) {
+	const uint8 *operands = instruction.operands;
+
+	if (core->regs[operands[0]] == 0) core->nextPC = core->regs[operands[1]];
+}
+
+void InterpreterCore::JCR_R_R(InterpreterCore *core, const ThreadedInstruction &instruction) {
+	const uint8 *operands = instruction.operands;
+
+	if (core->regs[operands[0]] == 0) core->nextPC = core->regs[operands[1]] + instruction.nextAddress;
+}
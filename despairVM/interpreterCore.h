@@ -0,0 +1,245 @@
+/*
+	Written By Pradipna Nepal
+	www.pradsprojects.com
+
+	Copyright (C) 2013 Pradipna Nepal
+	Please read COPYING.txt included along with this source code for more detail.
+	If not included, see http://www.gnu.org/licenses/
+*/
+
+#ifndef INTERPRETER_CORE_H
+#define INTERPRETER_CORE_H
+
+#include <map>
+#include <vector>
+#include "build.h"
+#include "declarations.h"
+#include "memoryManager.h"
+#include "portManager.h"
+#include "gpuCore.h"
+#include "timer.h"
+#include "irBlock.h"
+
+#define INTERPRETER_NO_THRESHOLD		0xFFFFFFFF	//Keeps running a block however hot it is, while its translation is not ready
+
+class InterpreterCore;
+struct ThreadedInstruction;
+
+typedef void (*InterpreterHandler)(InterpreterCore *core, const ThreadedInstruction &instruction);
+
+//Despair instruction decoded once, so running it again is only a call through handler
+struct ThreadedInstruction {
+	InterpreterHandler handler;
+	IRInstruction ir;	//Operands of the instructions that have an IR opcode
+	const uint8 *operands;	//Operands of every other instruction, right after the opcode
+	int64 nextAddress;
+};
+
+struct InterpretedBlock {
+	std::vector<ThreadedInstruction> instructions;
+	int64 endAddress;
+	uint32 executionCount;
+	bool interpretable;	//Every instruction has a handler
+};
+
+//Runs blocks that are not hot enough to be worth translating. A block is interpreted until it ran
+//hotThreshold times, then runBlock leaves it to the dynarec. It works on the same regs/fRegs/sP as
+//the translated code, so the two can take turns at any block boundary.
+class InterpreterCore {
+private:
+	int64 *regs;
+	float32 *fRegs;
+	int64 *sP;
+	MemoryManager *memManager;
+	PortManager *portManager;
+	GPUCore *gpuCore;
+	DespairTimer *timer;
+	uint64 codeSize;
+	std::map<int64, InterpretedBlock*> blocks;
+	int64 nextPC;	//Set by the branch that ends the block
+
+	InterpretedBlock *decodeBlock(int64 address);
+	static InterpreterHandler getHandler(const IRInstruction &instruction);
+
+	static void irMov(InterpreterCore *core, const ThreadedInstruction &instruction);
+	static void irAdd(InterpreterCore *core, const ThreadedInstruction &instruction);
+	static void irSub(InterpreterCore *core, const ThreadedInstruction &instruction);
+	static void irMul(InterpreterCore *core, const ThreadedInstruction &instruction);
+	static void irDiv(InterpreterCore *core, const ThreadedInstruction &instruction);
+	static void irMod(InterpreterCore *core, const ThreadedInstruction &instruction);
+	static void irAnd(InterpreterCore *core, const ThreadedInstruction &instruction);
+	static void irOr(InterpreterCore *core, const ThreadedInstruction &instruction);
+	static void irXor(InterpreterCore *core, const ThreadedInstruction &instruction);
+	static void irShl(InterpreterCore *core, const ThreadedInstruction &instruction);
+	static void irShr(InterpreterCore *core, const ThreadedInstruction &instruction);
+	static void irCmpE(InterpreterCore *core, const ThreadedInstruction &instruction);
+	static void irCmpNE(InterpreterCore *core, const ThreadedInstruction &instruction);
+	static void irCmpG(InterpreterCore *core, const ThreadedInstruction &instruction);
+	static void irCmpL(InterpreterCore *core, const ThreadedInstruction &instruction);
+	static void irCmpGE(InterpreterCore *core, const ThreadedInstruction &instruction);
+	static void irCmpLE(InterpreterCore *core, const ThreadedInstruction &instruction);
+	static void irLoad32(InterpreterCore *core, const ThreadedInstruction &instruction);
+	static void irLoad64(InterpreterCore *core, const ThreadedInstruction &instruction);
+	static void irStore32(InterpreterCore *core, const ThreadedInstruction &instruction);
+	static void irStore64(InterpreterCore *core, const ThreadedInstruction &instruction);
+
+	static void MOV_R_MR_IMMI(InterpreterCore *core, const ThreadedInstruction &instruction);
+	static void MOV_MR_IMMI_R(InterpreterCore *core, const ThreadedInstruction &instruction);
+	static void MOV_MR_IMMI_MR_IMMI(InterpreterCore *core, const ThreadedInstruction &instruction);
+	static void MOV_MR_IMMI_IMMI(InterpreterCore *core, const ThreadedInstruction &instruction);
+	static void MOV_M_M(InterpreterCore *core, const ThreadedInstruction &instruction);
+	static void MOV_MR_R(InterpreterCore *core, const ThreadedInstruction &instruction);
+	static void MOV_R_MR(InterpreterCore *core, const ThreadedInstruction &instruction);
+	static void MOV_MR_M(InterpreterCore *core, const ThreadedInstruction &instruction);
+	static void MOV_M_MR(InterpreterCore *core, const ThreadedInstruction &instruction);
+	static void MOV_MR_MR(InterpreterCore *core, const ThreadedInstruction &instruction);
+	static void MOV_MR_IMMI(InterpreterCore *core, const ThreadedInstruction &instruction);
+
+	static void NOP(InterpreterCore *core, const ThreadedInstruction &instruction);
+
+	static void MOVP_R_MR_IMMI(InterpreterCore *core, const ThreadedInstruction &instruction);
+	static void MOVP_MR_IMMI_R(InterpreterCore *core, const ThreadedInstruction &instruction);
+	static void MOVP_MR_IMMI_MR_IMMI(InterpreterCore *core, const ThreadedInstruction &instruction);
+	static void MOVP_R_MR(InterpreterCore *core, const ThreadedInstruction &instruction);
+	static void MOVP_MR_R(InterpreterCore *core, const ThreadedInstruction &instruction);
+
+	static void PUSH_R(InterpreterCore *core, const ThreadedInstruction &instruction);
+	static void POP_R(InterpreterCore *core, const ThreadedInstruction &instruction);
+
+	static void DRW_R_R_MR(InterpreterCore *core, const ThreadedInstruction &instruction);
+
+	static void OUT_R_IMMI8(InterpreterCore *core, const ThreadedInstruction &instruction);
+	static void OUT_R_IMMI16(InterpreterCore *core, const ThreadedInstruction &instruction);
+	static void OUT_R_IMMI32(InterpreterCore *core, const ThreadedInstruction &instruction);
+	static void OUT_R_IMMI64(InterpreterCore *core, const ThreadedInstruction &instruction);
+	static void OUT_IMMI_R8(InterpreterCore *core, const ThreadedInstruction &instruction);
+	static void OUT_IMMI_R16(InterpreterCore *core, const ThreadedInstruction &instruction);
+	static void OUT_IMMI_R32(InterpreterCore *core, const ThreadedInstruction &instruction);
+	static void OUT_IMMI_R64(InterpreterCore *core, const ThreadedInstruction &instruction);
+	static void OUT_R_R8(InterpreterCore *core, const ThreadedInstruction &instruction);
+	static void OUT_R_R16(InterpreterCore *core, const ThreadedInstruction &instruction);
+	static void OUT_R_R32(InterpreterCore *core, const ThreadedInstruction &instruction);
+	static void OUT_R_R64(InterpreterCore *core, const ThreadedInstruction &instruction);
+	static void OUT_IMMI_IMMI8(InterpreterCore *core, const ThreadedInstruction &instruction);
+	static void OUT_IMMI_IMMI16(InterpreterCore *core, const ThreadedInstruction &instruction);
+	static void OUT_IMMI_IMMI32(InterpreterCore *core, const ThreadedInstruction &instruction);
+	static void OUT_IMMI_IMMI64(InterpreterCore *core, const ThreadedInstruction &instruction);
+
+	static void IN_R8_IMMI(InterpreterCore *core, const ThreadedInstruction &instruction);
+	static void IN_R16_IMMI(InterpreterCore *core, const ThreadedInstruction &instruction);
+	static void IN_R32_IMMI(InterpreterCore *core, const ThreadedInstruction &instruction);
+	static void IN_R64_IMMI(InterpreterCore *core, const ThreadedInstruction &instruction);
+	static void IN_R8_R(InterpreterCore *core, const ThreadedInstruction &instruction);
+	static void IN_R16_R(InterpreterCore *core, const ThreadedInstruction &instruction);
+	static void IN_R32_R(InterpreterCore *core, const ThreadedInstruction &instruction);
+	static void IN_R64_R(InterpreterCore *core, const ThreadedInstruction &instruction);
+
+	static void FCON_R_FR(InterpreterCore *core, const ThreadedInstruction &instruction);
+	static void FCON_FR_R(InterpreterCore *core, const ThreadedInstruction &instruction);
+	static void FCON_FR_IMMI(InterpreterCore *core, const ThreadedInstruction &instruction);
+	static void FCON_R_FIMMI(InterpreterCore *core, const ThreadedInstruction &instruction);
+
+	static void FMOV_FR_MFR_IMMI(InterpreterCore *core, const ThreadedInstruction &instruction);
+	static void FMOV_MFR_IMMI_FR(InterpreterCore *core, const ThreadedInstruction &instruction);
+	static void FMOV_MFR_IMMI_MFR_IMMI(InterpreterCore *core, const ThreadedInstruction &instruction);
+	static void FMOV_MFR_IMMI_FIMMI(InterpreterCore *core, const ThreadedInstruction &instruction);
+	static void FMOV_FR_FR(InterpreterCore *core, const ThreadedInstruction &instruction);
+	static void FMOV_FR_FM(InterpreterCore *core, const ThreadedInstruction &instruction);
+	static void FMOV_FM_FR(InterpreterCore *core, const ThreadedInstruction &instruction);
+	static void FMOV_FR_MFR(InterpreterCore *core, const ThreadedInstruction &instruction);
+	static void FMOV_MFR_FR(InterpreterCore *core, const ThreadedInstruction &instruction);
+	static void FMOV_FM_MFR(InterpreterCore *core, const ThreadedInstruction &instruction);
+	static void FMOV_MFR_FM(InterpreterCore *core, const ThreadedInstruction &instruction);
+	static void FMOV_MFR_MFR(InterpreterCore *core, const ThreadedInstruction &instruction);
+	static void FMOV_FM_FM(InterpreterCore *core, const ThreadedInstruction &instruction);
+	static void FMOV_FR_FIMMI(InterpreterCore *core, const ThreadedInstruction &instruction);
+	static void FMOV_FM_FIMMI(InterpreterCore *core, const ThreadedInstruction &instruction);
+	static void FMOV_MFR_FIMMI(InterpreterCore *core, const ThreadedInstruction &instruction);
+
+	static void FADD_FR_FR(InterpreterCore *core, const ThreadedInstruction &instruction);
+	static void FADD_R_FR(InterpreterCore *core, const ThreadedInstruction &instruction);
+	static void FADD_FR_R(InterpreterCore *core, const ThreadedInstruction &instruction);
+	static void FADD_FR_FIMMI(InterpreterCore *core, const ThreadedInstruction &instruction);
+	static void FADD_R_FIMMI(InterpreterCore *core, const ThreadedInstruction &instruction);
+
+	static void FSUB_FR_FR(InterpreterCore *core, const ThreadedInstruction &instruction);
+	static void FSUB_R_FR(InterpreterCore *core, const ThreadedInstruction &instruction);
+	static void FSUB_FR_R(InterpreterCore *core, const ThreadedInstruction &instruction);
+	static void FSUB_FR_FIMMI(InterpreterCore *core, const ThreadedInstruction &instruction);
+	static void FSUB_R_FIMMI(InterpreterCore *core, const ThreadedInstruction &instruction);
+
+	static void FMUL_FR_FR(InterpreterCore *core, const ThreadedInstruction &instruction);
+	static void FMUL_R_FR(InterpreterCore *core, const ThreadedInstruction &instruction);
+	static void FMUL_FR_R(InterpreterCore *core, const ThreadedInstruction &instruction);
+	static void FMUL_FR_FIMMI(InterpreterCore *core, const ThreadedInstruction &instruction);
+	static void FMUL_R_FIMMI(InterpreterCore *core, const ThreadedInstruction &instruction);
+
+	static void FDIV_FR_FR(InterpreterCore *core, const ThreadedInstruction &instruction);
+	static void FDIV_R_FR(InterpreterCore *core, const ThreadedInstruction &instruction);
+	static void FDIV_FR_R(InterpreterCore *core, const ThreadedInstruction &instruction);
+	static void FDIV_FR_FIMMI(InterpreterCore *core, const ThreadedInstruction &instruction);
+	static void FDIV_R_FIMMI(InterpreterCore *core, const ThreadedInstruction &instruction);
+
+	static void FMOD_FR_FR(InterpreterCore *core, const ThreadedInstruction &instruction);
+	static void FMOD_R_FR(InterpreterCore *core, const ThreadedInstruction &instruction);
+	static void FMOD_FR_R(InterpreterCore *core, const ThreadedInstruction &instruction);
+	static void FMOD_FR_FIMMI(InterpreterCore *core, const ThreadedInstruction &instruction);
+	static void FMOD_R_FIMMI(InterpreterCore *core, const ThreadedInstruction &instruction);
+
+	static void BMOV_R_MBR_IMMI(InterpreterCore *core, const ThreadedInstruction &instruction);
+	static void BMOV_MBR_IMMI_MBR_IMMI(InterpreterCore *core, const ThreadedInstruction &instruction);
+	static void BMOV_MBR_IMMI_IMMI8(InterpreterCore *core, const ThreadedInstruction &instruction);
+	static void BMOV_R_BM(InterpreterCore *core, const ThreadedInstruction &instruction);
+	static void BMOV_BM_R(InterpreterCore *core, const ThreadedInstruction &instruction);
+	static void BMOV_R_MBR(InterpreterCore *core, const ThreadedInstruction &instruction);
+	static void BMOV_MBR_R(InterpreterCore *core, const ThreadedInstruction &instruction);
+	static void BMOV_MBR_MBR(InterpreterCore *core, const ThreadedInstruction &instruction);
+	static void BMOV_BM_BM(InterpreterCore *core, const ThreadedInstruction &instruction);
+	static void BMOV_MBR_IMMI8(InterpreterCore *core, const ThreadedInstruction &instruction);
+
+	static void FCMPE_R_FR_FR(InterpreterCore *core, const ThreadedInstruction &instruction);
+	static void FCMPNE_R_FR_FR(InterpreterCore *core, const ThreadedInstruction &instruction);
+	static void FCMPG_R_FR_FR(InterpreterCore *core, const ThreadedInstruction &instruction);
+	static void FCMPL_R_FR_FR(InterpreterCore *core, const ThreadedInstruction &instruction);
+	static void FCMPGE_R_FR_FR(InterpreterCore *core, const ThreadedInstruction &instruction);
+	static void FCMPLE_R_FR_FR(InterpreterCore *core, const ThreadedInstruction &instruction);
+
+	static void FOUT_IMMI_FR(InterpreterCore *core, const ThreadedInstruction &instruction);
+	static void FIN_FR_IMMI(InterpreterCore *core, const ThreadedInstruction &instruction);
+	static void FOUT_IMMI_FIMMI(InterpreterCore *core, const ThreadedInstruction &instruction);
+
+	static void PUSHES_R_R(InterpreterCore *core, const ThreadedInstruction &instruction);
+	static void POPS_R_R(InterpreterCore *core, const ThreadedInstruction &instruction);
+
+	static void FPUSHES_FR_FR(InterpreterCore *core, const ThreadedInstruction &instruction);
+	static void FPOPS_FR_FR(InterpreterCore *core, const ThreadedInstruction &instruction);
+	static void FPUSH_FR(InterpreterCore *core, const ThreadedInstruction &instruction);
+	static void FPOP_FR(InterpreterCore *core, const ThreadedInstruction &instruction);
+
+	static void TIME(InterpreterCore *core, const ThreadedInstruction &instruction);
+	static void SLEEP(InterpreterCore *core, const ThreadedInstruction &instruction);
+
+	static void RAND(InterpreterCore *core, const ThreadedInstruction &instruction);
+
+	//These instructions end a block and set nextPC
+	static void JMP_IMMI(InterpreterCore *core, const ThreadedInstruction &instruction);
+	static void JMPR_IMMI(InterpreterCore *core, const ThreadedInstruction &instruction);
+	static void JC_R_IMMI(InterpreterCore *core, const ThreadedInstruction &instruction);
+	static void JCR_R_IMMI(InterpreterCore *core, const ThreadedInstruction &instruction);
+	static void CALL_IMMI(InterpreterCore *core, const ThreadedInstruction &instruction);
+	static void RET(InterpreterCore *core, const ThreadedInstruction &instruction);
+	static void JMP_R(InterpreterCore *core, const ThreadedInstruction &instruction);
+	static void JMPR_R(InterpreterCore *core, const ThreadedInstruction &instruction);
+	static void JC_R_R(InterpreterCore *core, const ThreadedInstruction &instruction);
+	static void JCR_R_R(InterpreterCore *core, const ThreadedInstruction &instruction);
+
+public:
+	InterpreterCore(int64 *regs, float32 *fRegs, int64 *sP, MemoryManager *memManager, PortManager *portManager, GPUCore *gpuCore, DespairTimer *timer, uint64 codeSize);
+	~InterpreterCore();
+
+	//Runs the block at *pC and moves *pC to the block it branches to. Returns false without running
+	//anything once the block ran hotThreshold times or has an instruction the interpreter can't run.
+	bool runBlock(int64 *pC, uint32 hotThreshold);
+};
+
+#endif
@@ -0,0 +1,291 @@
+/*
+	Written By Pradipna Nepal
+	www.pradsprojects.com
+
+	Copyright (C) 2013 Pradipna Nepal
+	Please read COPYING.txt included along with this source code for more detail.
+	If not included, see http://www.gnu.org/licenses/
+*/
+
+#include <iomanip>
+#include "irBlock.h"
+#include "instructionsSet.h"
+#include "instructionsInfo.h"
+using namespace std;
+
+static const char *irOpcodeNames[] = {
+	"NATIVE", "MOV", "ADD", "SUB", "MUL", "DIV", "MOD", "AND", "OR", "XOR", "SHL", "SHR",
+	"CMPE", "CMPNE", "CMPG", "CMPL", "CMPGE", "CMPLE", "LOAD32", "LOAD64", "STORE32", "STORE64"
+};
+
+IRBlock::IRBlock(const uint8 *codeSpace) {
+	this->codeSpace = codeSpace;
+	startAddress = 0;
+	endAddress = 0;
+}
+
+void IRBlock::decode(int64 address) {
+	startAddress = address;
+	instructions.clear();
+	append(address);
+}
+
+void IRBlock::append(int64 address) {
+	while (true) {
+		IRInstruction instruction;
+		uint16 opcode = *(uint16*)&codeSpace[address];
+		const InstructionInfo *instructionInfo = InstructionsInfo::getInstructionInfo(opcode);
+
+		instruction.despairOpcode = opcode;
+		instruction.address = address;
+		instruction.dst = 0;
+		instruction.src = 0;
+		instruction.srcImmi = false;
+		instruction.immi = 0;
+		instruction.mOffset = 0;
+		instruction.dead = false;
+		if (!decodeInstruction(&instruction, opcode, &codeSpace[address + 2])) {
+			instruction.opcode = IR_NATIVE;
+		}
+		instructions.push_back(instruction);
+
+		//fdCycle skips the opcode of instructions it does not know
+		address += (instructionInfo) ? InstructionsInfo::getInstructionSize(instructionInfo) : 2;
+		if (instructionInfo && (instructionInfo->flags & INSTRUCTION_BRANCH)) break;
+	}
+	endAddress = address;
+}
+
+bool IRBlock::decodeInstruction(IRInstruction *instruction, uint16 opcode, const uint8 *operands) {
+	switch (opcode) {
+		case _MOV_R_R:
+		case _MOV_R_IMMI:
+			instruction->opcode = IR_MOV;
+			break;
+		case _ADD_R_R:
+		case _ADD_R_IMMI:
+			instruction->opcode = IR_ADD;
+			break;
+		case _SUB_R_R:
+		case _SUB_R_IMMI:
+			instruction->opcode = IR_SUB;
+			break;
+		case _MUL_R_R:
+		case _MUL_R_IMMI:
+			instruction->opcode = IR_MUL;
+			break;
+		case _DIV_R_R:
+		case _DIV_R_IMMI:
+			instruction->opcode = IR_DIV;
+			break;
+		case _MOD_R_R:
+		case _MOD_R_IMMI:
+			instruction->opcode = IR_MOD;
+			break;
+		case _AND_R_R:
+		case _AND_R_IMMI:
+			instruction->opcode = IR_AND;
+			break;
+		case _OR_R_R:
+		case _OR_R_IMMI:
+			instruction->opcode = IR_OR;
+			break;
+		case _XOR_R_R:
+		case _XOR_R_IMMI:
+			instruction->opcode = IR_XOR;
+			break;
+		case _SHL_R_R:
+		case _SHL_R_IMMI8:
+			instruction->opcode = IR_SHL;
+			break;
+		case _SHR_R_R:
+		case _SHR_R_IMMI8:
+			instruction->opcode = IR_SHR;
+			break;
+		case _CMPE_R_R:
+		case _CMPE_R_IMMI:
+			instruction->opcode = IR_CMPE;
+			break;
+		case _CMPNE_R_R:
+		case _CMPNE_R_IMMI:
+			instruction->opcode = IR_CMPNE;
+			break;
+		case _CMPG_R_R:
+		case _CMPG_R_IMMI:
+			instruction->opcode = IR_CMPG;
+			break;
+		case _CMPL_R_R:
+		case _CMPL_R_IMMI:
+			instruction->opcode = IR_CMPL;
+			break;
+		case _CMPGE_R_R:
+		case _CMPGE_R_IMMI:
+			instruction->opcode = IR_CMPGE;
+			break;
+		case _CMPLE_R_R:
+		case _CMPLE_R_IMMI:
+			instruction->opcode = IR_CMPLE;
+			break;
+		case _MOV_R_M:
+			instruction->opcode = IR_LOAD32;
+			instruction->dst = operands[0];
+			instruction->mOffset = *(uint32*)&operands[1];
+			return true;
+		case _MOVP_R_M:
+			instruction->opcode = IR_LOAD64;
+			instruction->dst = operands[0];
+			instruction->mOffset = *(uint32*)&operands[1];
+			return true;
+		case _MOV_M_R:
+			instruction->opcode = IR_STORE32;
+			instruction->src = operands[0];
+			instruction->mOffset = *(uint32*)&operands[1];
+			return true;
+		case _MOVP_M_R:
+			instruction->opcode = IR_STORE64;
+			instruction->src = operands[0];
+			instruction->mOffset = *(uint32*)&operands[1];
+			return true;
+		case _MOV_M_IMMI:
+			instruction->opcode = IR_STORE32;
+			instruction->mOffset = *(uint32*)&operands[0];
+			instruction->srcImmi = true;
+			instruction->immi = *(uint32*)&operands[4];
+			return true;
+		default:
+			return false;
+	}
+
+	//Second operand is either a register or an immediate
+	instruction->dst = operands[0];
+	switch (opcode) {
+		case _MOV_R_IMMI: case _ADD_R_IMMI: case _SUB_R_IMMI: case _DIV_R_IMMI: case _MOD_R_IMMI:
+		case _AND_R_IMMI: case _OR_R_IMMI: case _XOR_R_IMMI:
+		case _CMPE_R_IMMI: case _CMPNE_R_IMMI: case _CMPG_R_IMMI: case _CMPL_R_IMMI: case _CMPGE_R_IMMI: case _CMPLE_R_IMMI:
+			instruction->srcImmi = true;
+			instruction->immi = *(uint32*)&operands[1];
+			break;
+		case _MUL_R_IMMI:
+			//imul sign extends its immediate
+			instruction->srcImmi = true;
+			instruction->immi = (uint64)(int64)*(int32*)&operands[1];
+			break;
+		case _SHL_R_IMMI8:
+		case _SHR_R_IMMI8:
+			instruction->srcImmi = true;
+			instruction->immi = operands[1];
+			break;
+		default:
+			instruction->src = operands[1];
+			break;
+	}
+	return true;
+}
+
+bool IRBlock::readsDst(IROpcode opcode) {
+	switch (opcode) {
+		case IR_NATIVE:
+		case IR_MOV:
+		case IR_LOAD32:
+		case IR_LOAD64:
+		case IR_STORE32:
+		case IR_STORE64:
+			return false;
+		default:
+			return true;
+	}
+}
+
+bool IRBlock::writesDst(IROpcode opcode) {
+	switch (opcode) {
+		case IR_NATIVE:
+		case IR_STORE32:
+		case IR_STORE64:
+			return false;
+		default:
+			return true;
+	}
+}
+
+bool IRBlock::readsSrc(const IRInstruction &instruction) {
+	switch (instruction.opcode) {
+		case IR_NATIVE:
+		case IR_LOAD32:
+		case IR_LOAD64:
+			return false;
+		default:
+			return !instruction.srcImmi;
+	}
+}
+
+void IRBlock::getRegisterUses(const IRInstruction &instruction, IRRegisterUses *uses) const {
+	uses->readCount = 0;
+	uses->writeCount = 0;
+	uses->allRegs = false;
+
+	if (instruction.opcode != IR_NATIVE) {
+		if (readsDst(instruction.opcode)) uses->reads[uses->readCount++] = instruction.dst;
+		if (readsSrc(instruction)) uses->reads[uses->readCount++] = instruction.src;
+		if (writesDst(instruction.opcode)) uses->writes[uses->writeCount++] = instruction.dst;
+		return;
+	}
+
+	const InstructionInfo *instructionInfo = InstructionsInfo::getInstructionInfo(instruction.despairOpcode);
+	if (!instructionInfo) return;
+
+	uses->allRegs = (instructionInfo->flags & INSTRUCTION_ALL_REGS) != 0;
+	int64 operandAddress = instruction.address + 2;
+	for (const char *operand = instructionInfo->operands; *operand; ++operand) {
+		uint8 reg = codeSpace[operandAddress];
+
+		if (*operand == OPERAND_REG_READ || *operand == OPERAND_REG_READ_WRITE) {
+			uses->reads[uses->readCount++] = reg;
+		}
+		if (*operand == OPERAND_REG_WRITE || *operand == OPERAND_REG_READ_WRITE) {
+			uses->writes[uses->writeCount++] = reg;
+		}
+		operandAddress += InstructionsInfo::getOperandSize(*operand);
+	}
+}
+
+void IRBlock::dump(ostream &out, const char *title) const {
+	out << "IR block " << hex << startAddress << " - " << endAddress << " (" << title << ")" << endl;
+
+	for (size_t i = 0; i < instructions.size(); ++i) {
+		const IRInstruction &instruction = instructions[i];
+
+		out << "  " << setw(8) << setfill('0') << instruction.address << setfill(' ') << "  ";
+		out << (instruction.dead ? "; " : "  ") << left << setw(8) << irOpcodeNames[instruction.opcode] << right;
+		switch (instruction.opcode) {
+			case IR_NATIVE:
+				{
+					const InstructionInfo *instructionInfo = InstructionsInfo::getInstructionInfo(instruction.despairOpcode);
+					out << ((instructionInfo) ? instructionInfo->name : "?");
+				}
+				break;
+			case IR_LOAD32:
+			case IR_LOAD64:
+				out << "r" << dec << (int)instruction.dst << hex << ", [" << instruction.mOffset << "]";
+				break;
+			case IR_STORE32:
+			case IR_STORE64:
+				out << "[" << instruction.mOffset << "], ";
+				if (instruction.srcImmi) {
+					out << "0x" << instruction.immi;
+				} else {
+					out << "r" << dec << (int)instruction.src << hex;
+				}
+				break;
+			default:
+				out << "r" << dec << (int)instruction.dst << hex << ", ";
+				if (instruction.srcImmi) {
+					out << "0x" << instruction.immi;
+				} else {
+					out << "r" << dec << (int)instruction.src << hex;
+				}
+				break;
+		}
+		out << endl;
+	}
+	out << dec;
+}
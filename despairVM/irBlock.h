@@ -0,0 +1,87 @@
+/*
+	Written By Pradipna Nepal
+	www.pradsprojects.com
+
+	Copyright (C) 2013 Pradipna Nepal
+	Please read COPYING.txt included along with this source code for more detail.
+	If not included, see http://www.gnu.org/licenses/
+*/
+
+#ifndef IR_BLOCK_H
+#define IR_BLOCK_H
+
+#include <vector>
+#include <ostream>
+#include "build.h"
+#include "declarations.h"
+
+//Integer register operations get their own IR instruction so they can be optimized, everything else
+//is kept as IR_NATIVE and translated by its fdCycle handler
+enum IROpcode {
+	IR_NATIVE,
+	IR_MOV,			//dst = src
+	IR_ADD,			//dst += src
+	IR_SUB,
+	IR_MUL,
+	IR_DIV,
+	IR_MOD,
+	IR_AND,
+	IR_OR,
+	IR_XOR,
+	IR_SHL,
+	IR_SHR,
+	IR_CMPE,		//dst = (int32)dst == (int32)src
+	IR_CMPNE,
+	IR_CMPG,
+	IR_CMPL,
+	IR_CMPGE,
+	IR_CMPLE,
+	IR_LOAD32,		//dst = zero extended 32 bit value at global memory mOffset
+	IR_LOAD64,
+	IR_STORE32,		//Low 32 bits of src to global memory mOffset
+	IR_STORE64
+};
+
+struct IRInstruction {
+	IROpcode opcode;
+	uint16 despairOpcode;	//Opcode of the Despair instruction it was decoded from
+	int64 address;	//Address of the Despair instruction it was decoded from
+	uint8 dst, src;
+	bool srcImmi;	//Use immi instead of src
+	uint64 immi;
+	uint32 mOffset;
+	bool dead;	//Removed by an optimization pass
+};
+
+//Integer registers an instruction reads and writes
+struct IRRegisterUses {
+	uint8 reads[3], writes[3];
+	int readCount, writeCount;
+	bool allRegs;	//Reads and writes registers that are not in its operands
+};
+
+class IRBlock {
+private:
+	const uint8 *codeSpace;
+
+	bool decodeInstruction(IRInstruction *instruction, uint16 opcode, const uint8 *operands);
+
+public:
+	int64 startAddress, endAddress;
+	std::vector<IRInstruction> instructions;
+
+	IRBlock(const uint8 *codeSpace);
+
+	//Decodes the Despair instructions from address up to and including the first branch
+	void decode(int64 address);
+	//Same as decode but adds the instructions after the ones already decoded, for traces
+	void append(int64 address);
+	void getRegisterUses(const IRInstruction &instruction, IRRegisterUses *uses) const;
+	void dump(std::ostream &out, const char *title) const;
+
+	static bool readsDst(IROpcode opcode);
+	static bool writesDst(IROpcode opcode);
+	static bool readsSrc(const IRInstruction &instruction);
+};
+
+#endif
@@ -0,0 +1,457 @@
+/*
+	Written By Pradipna Nepal
+	www.pradsprojects.com
+
+	Copyright (C) 2013 Pradipna Nepal
+	Please read COPYING.txt included along with this source code for more detail.
+	If not included, see http://www.gnu.org/licenses/
+*/
+
+#include <vector>
+#include <algorithm>
+#include "irOptimizer.h"
+#include "instructionsInfo.h"
+using namespace std;
+
+//Global memory at mOffset that is also in the holder register
+struct IRKnownMemory {
+	uint32 mOffset;
+	uint32 size;
+	uint8 holder;
+};
+
+static uint32 getAccessSize(IROpcode opcode) {
+	return (opcode == IR_LOAD64 || opcode == IR_STORE64) ? 8 : 4;
+}
+
+static void forgetHolder(vector<IRKnownMemory> *knownMemory, uint8 reg) {
+	for (size_t i = 0; i < knownMemory->size();) {
+		if (knownMemory->at(i).holder == reg) {
+			knownMemory->erase(knownMemory->begin() + i);
+		} else {
+			++i;
+		}
+	}
+}
+
+static void forgetMemory(vector<IRKnownMemory> *knownMemory, uint32 mOffset, uint32 size) {
+	for (size_t i = 0; i < knownMemory->size();) {
+		const IRKnownMemory &known = knownMemory->at(i);
+		if ((uint64)known.mOffset < (uint64)mOffset + size && (uint64)mOffset < (uint64)known.mOffset + known.size) {
+			knownMemory->erase(knownMemory->begin() + i);
+		} else {
+			++i;
+		}
+	}
+}
+
+//Same arithmetic as the translated code, returns false if it has to be left to run time
+static bool foldConstant(IROpcode opcode, uint64 value1, uint64 value2, uint64 *result) {
+	switch (opcode) {
+		case IR_ADD:
+			*result = value1 + value2;
+			return true;
+		case IR_SUB:
+			*result = value1 - value2;
+			return true;
+		case IR_MUL:
+			*result = value1 * value2;
+			return true;
+		case IR_DIV:
+		case IR_MOD:
+			//idiv is done with rdx cleared, which only matches signed division for positive dividends
+			if ((int64)value1 < 0 || value2 == 0) return false;
+			if (opcode == IR_DIV) {
+				*result = (uint64)((int64)value1 / (int64)value2);
+			} else {
+				*result = (uint64)((int64)value1 % (int64)value2);
+			}
+			return true;
+		case IR_AND:
+			*result = value1 & value2;
+			return true;
+		case IR_OR:
+			*result = value1 | value2;
+			return true;
+		case IR_XOR:
+			*result = value1 ^ value2;
+			return true;
+		case IR_SHL:
+			*result = value1 << (value2 & 63);
+			return true;
+		case IR_SHR:
+			*result = value1 >> (value2 & 63);
+			return true;
+		case IR_CMPE:
+			*result = ((int32)value1 == (int32)value2) ? 1 : 0;
+			return true;
+		case IR_CMPNE:
+			*result = ((int32)value1 != (int32)value2) ? 1 : 0;
+			return true;
+		case IR_CMPG:
+			*result = ((int32)value1 > (int32)value2) ? 1 : 0;
+			return true;
+		case IR_CMPL:
+			*result = ((int32)value1 < (int32)value2) ? 1 : 0;
+			return true;
+		case IR_CMPGE:
+			*result = ((int32)value1 >= (int32)value2) ? 1 : 0;
+			return true;
+		case IR_CMPLE:
+			*result = ((int32)value1 <= (int32)value2) ? 1 : 0;
+			return true;
+		default:
+			return false;
+	}
+}
+
+static bool isPowerOfTwo(uint64 value) {
+	return value != 0 && (value & (value - 1)) == 0;
+}
+
+static uint8 getLog2(uint64 value) {
+	uint8 log2 = 0;
+
+	while (value >>= 1) {
+		++log2;
+	}
+	return log2;
+}
+
+void IROptimizer::optimize(IRBlock *irBlock) {
+	eliminateRedundantLoads(irBlock);
+	propagateConstants(irBlock);
+	reduceStrength(irBlock);
+	propagateCopies(irBlock);
+	eliminateDeadStores(irBlock);
+}
+
+void IROptimizer::eliminateRedundantLoads(IRBlock *irBlock) {
+	vector<IRKnownMemory> knownMemory;
+
+	for (size_t i = 0; i < irBlock->instructions.size(); ++i) {
+		IRInstruction &instruction = irBlock->instructions[i];
+		if (instruction.dead) continue;
+
+		switch (instruction.opcode) {
+			case IR_NATIVE:
+				//May write global memory through a pointer
+				knownMemory.clear();
+				break;
+			case IR_LOAD32:
+			case IR_LOAD64:
+				{
+					uint32 size = getAccessSize(instruction.opcode);
+					int holder = -1;
+
+					for (size_t j = 0; j < knownMemory.size(); ++j) {
+						if (knownMemory[j].mOffset == instruction.mOffset && knownMemory[j].size == size) {
+							holder = knownMemory[j].holder;
+							break;
+						}
+					}
+
+					if (holder == instruction.dst) {
+						instruction.dead = true;
+						break;
+					}
+					forgetHolder(&knownMemory, instruction.dst);
+					if (holder != -1) {
+						instruction.opcode = IR_MOV;
+						instruction.src = (uint8)holder;
+						instruction.srcImmi = false;
+					} else {
+						IRKnownMemory known = { instruction.mOffset, size, instruction.dst };
+						knownMemory.push_back(known);
+					}
+				}
+				break;
+			case IR_STORE32:
+			case IR_STORE64:
+				forgetMemory(&knownMemory, instruction.mOffset, getAccessSize(instruction.opcode));
+				//A 32 bit store only leaves the low half of the register in memory
+				if (instruction.opcode == IR_STORE64 && !instruction.srcImmi) {
+					IRKnownMemory known = { instruction.mOffset, 8, instruction.src };
+					knownMemory.push_back(known);
+				}
+				break;
+			default:
+				forgetHolder(&knownMemory, instruction.dst);
+				break;
+		}
+	}
+}
+
+void IROptimizer::propagateConstants(IRBlock *irBlock) {
+	bool known[256];
+	uint64 value[256];
+
+	for (int i = 0; i < 256; ++i) {
+		known[i] = false;
+	}
+
+	for (size_t i = 0; i < irBlock->instructions.size(); ++i) {
+		IRInstruction &instruction = irBlock->instructions[i];
+		if (instruction.dead) continue;
+
+		if (instruction.opcode == IR_NATIVE) {
+			IRRegisterUses uses;
+			irBlock->getRegisterUses(instruction, &uses);
+
+			if (uses.allRegs) {
+				for (int j = 0; j < 256; ++j) {
+					known[j] = false;
+				}
+			}
+			for (int j = 0; j < uses.writeCount; ++j) {
+				known[uses.writes[j]] = false;
+			}
+			continue;
+		}
+
+		if (IRBlock::readsSrc(instruction) && known[instruction.src]) {
+			instruction.srcImmi = true;
+			instruction.immi = value[instruction.src];
+		}
+		if (!IRBlock::writesDst(instruction.opcode)) continue;
+
+		if (instruction.opcode == IR_MOV && instruction.srcImmi) {
+			known[instruction.dst] = true;
+			value[instruction.dst] = instruction.immi;
+		} else if (IRBlock::readsDst(instruction.opcode) && instruction.srcImmi && known[instruction.dst]
+					&& foldConstant(instruction.opcode, value[instruction.dst], instruction.immi, &value[instruction.dst])) {
+			instruction.opcode = IR_MOV;
+			instruction.immi = value[instruction.dst];
+		} else {
+			known[instruction.dst] = false;
+		}
+	}
+}
+
+void IROptimizer::reduceStrength(IRBlock *irBlock) {
+	for (size_t i = 0; i < irBlock->instructions.size(); ++i) {
+		IRInstruction &instruction = irBlock->instructions[i];
+		if (instruction.dead || !instruction.srcImmi) continue;
+
+		if (instruction.opcode == IR_MUL && instruction.immi == 0) {
+			instruction.opcode = IR_MOV;
+			continue;
+		}
+		//A divisor with the top bit set is negative to idiv
+		if (!isPowerOfTwo(instruction.immi) || (instruction.opcode != IR_MUL && (int64)instruction.immi < 0)) continue;
+
+		uint8 log2 = getLog2(instruction.immi);
+		switch (instruction.opcode) {
+			case IR_MUL:
+			case IR_DIV:
+				//The dividend is unsigned, so dividing is a logical shift. Dividing by 1 no longer faults
+				//for dividends with the top bit set, the same as in the interpreter.
+				if (log2 == 0) {
+					instruction.dead = true;
+				} else {
+					instruction.opcode = (instruction.opcode == IR_MUL) ? IR_SHL : IR_SHR;
+					instruction.immi = log2;
+				}
+				break;
+			case IR_MOD:
+				instruction.opcode = (log2 == 0) ? IR_MOV : IR_AND;
+				instruction.immi -= 1;
+				break;
+			default:
+				break;
+		}
+	}
+}
+
+void IROptimizer::propagateCopies(IRBlock *irBlock) {
+	int copyOf[256];
+
+	for (int i = 0; i < 256; ++i) {
+		copyOf[i] = -1;
+	}
+
+	for (size_t i = 0; i < irBlock->instructions.size(); ++i) {
+		IRInstruction &instruction = irBlock->instructions[i];
+		IRRegisterUses uses;
+		if (instruction.dead) continue;
+
+		if (instruction.opcode != IR_NATIVE && IRBlock::readsSrc(instruction) && copyOf[instruction.src] != -1) {
+			instruction.src = (uint8)copyOf[instruction.src];
+		}
+		if (instruction.opcode == IR_MOV && !instruction.srcImmi && instruction.src == instruction.dst) {
+			instruction.dead = true;
+			continue;
+		}
+
+		irBlock->getRegisterUses(instruction, &uses);
+		if (uses.allRegs) {
+			for (int j = 0; j < 256; ++j) {
+				copyOf[j] = -1;
+			}
+		}
+		//A register that changes is no longer a copy and no longer has copies
+		for (int j = 0; j < uses.writeCount; ++j) {
+			uint8 reg = uses.writes[j];
+
+			copyOf[reg] = -1;
+			for (int k = 0; k < 256; ++k) {
+				if (copyOf[k] == reg) copyOf[k] = -1;
+			}
+		}
+
+		if (instruction.opcode == IR_MOV && !instruction.srcImmi) {
+			copyOf[instruction.dst] = instruction.src;
+		}
+	}
+}
+
+void IROptimizer::eliminateDeadStores(IRBlock *irBlock) {
+	bool live[256];
+
+	//Next block may read any register
+	for (int i = 0; i < 256; ++i) {
+		live[i] = true;
+	}
+
+	for (size_t i = irBlock->instructions.size(); i-- > 0;) {
+		IRInstruction &instruction = irBlock->instructions[i];
+		IRRegisterUses uses;
+		if (instruction.dead) continue;
+
+		irBlock->getRegisterUses(instruction, &uses);
+		if (instruction.opcode == IR_NATIVE) {
+			const InstructionInfo *instructionInfo = InstructionsInfo::getInstructionInfo(instruction.despairOpcode);
+
+			//Natives may write only part of a register or not write it at all, so they don't end a live range.
+			//A branch in the middle of a trace may leave it, and the code it leads to can read any register.
+			if (uses.allRegs || (instructionInfo && (instructionInfo->flags & INSTRUCTION_BRANCH))) {
+				for (int j = 0; j < 256; ++j) {
+					live[j] = true;
+				}
+			}
+		} else if (IRBlock::writesDst(instruction.opcode)) {
+			//Division is kept for its divide by zero fault
+			if (!live[instruction.dst] && instruction.opcode != IR_DIV && instruction.opcode != IR_MOD) {
+				instruction.dead = true;
+				continue;
+			}
+			live[instruction.dst] = false;
+		}
+
+		for (int j = 0; j < uses.readCount; ++j) {
+			live[uses.reads[j]] = true;
+		}
+	}
+}
+
+//Whether the instructions writing reg can all run before the loop. They have to be before headEnd and
+//start with a move, and everything else they read has to be invariant. Nothing else may read reg before
+//the last of them, it would see the value of the previous time around the loop.
+static bool isHoistable(const IRBlock &irBlock, size_t headEnd, uint8 reg, const bool *invariant, const vector<bool> &hoisted) {
+	size_t lastWrite = 0;
+	bool written = false;
+
+	for (size_t i = 0; i < irBlock.instructions.size(); ++i) {
+		const IRInstruction &instruction = irBlock.instructions[i];
+		IRRegisterUses uses;
+		if (instruction.dead || hoisted[i]) continue;
+
+		irBlock.getRegisterUses(instruction, &uses);
+		bool writes = false;
+		for (int j = 0; j < uses.writeCount; ++j) {
+			if (uses.writes[j] == reg) writes = true;
+		}
+
+		if (writes) {
+			if (i >= headEnd || instruction.opcode == IR_NATIVE || instruction.opcode == IR_LOAD32 || instruction.opcode == IR_LOAD64) return false;
+			if (!written && IRBlock::readsDst(instruction.opcode)) return false;
+			if (IRBlock::readsSrc(instruction) && instruction.src != reg && !invariant[instruction.src]) return false;
+			written = true;
+			lastWrite = i;
+		}
+	}
+	if (!written) return false;
+
+	for (size_t i = 0; i < lastWrite; ++i) {
+		const IRInstruction &instruction = irBlock.instructions[i];
+		IRRegisterUses uses;
+		if (instruction.dead || hoisted[i] || (IRBlock::writesDst(instruction.opcode) && instruction.dst == reg)) continue;
+
+		irBlock.getRegisterUses(instruction, &uses);
+		for (int j = 0; j < uses.readCount; ++j) {
+			if (uses.reads[j] == reg) return false;
+		}
+	}
+	return true;
+}
+
+size_t IROptimizer::hoistLoopInvariants(IRBlock *irBlock, size_t headEnd) {
+	vector<IRInstruction> &instructions = irBlock->instructions;
+	vector<bool> hoisted(instructions.size(), false);
+	bool invariant[256];
+
+	for (int i = 0; i < 256; ++i) {
+		invariant[i] = true;
+	}
+	for (size_t i = 0; i < instructions.size(); ++i) {
+		IRRegisterUses uses;
+		if (instructions[i].dead) continue;
+
+		irBlock->getRegisterUses(instructions[i], &uses);
+		if (uses.allRegs) return 0;
+		for (int j = 0; j < uses.writeCount; ++j) {
+			invariant[uses.writes[j]] = false;
+		}
+	}
+
+	//A register that is hoisted is invariant to the ones after it, so go around until nothing changes
+	bool changed = true;
+	while (changed) {
+		changed = false;
+		for (int reg = 0; reg < 256; ++reg) {
+			if (invariant[reg] || !isHoistable(*irBlock, headEnd, (uint8)reg, invariant, hoisted)) continue;
+
+			for (size_t i = 0; i < headEnd; ++i) {
+				if (!instructions[i].dead && instructions[i].opcode != IR_NATIVE && IRBlock::writesDst(instructions[i].opcode) && instructions[i].dst == reg) {
+					hoisted[i] = true;
+				}
+			}
+			invariant[reg] = true;
+			changed = true;
+		}
+	}
+
+	//Keeps the order of both the hoisted instructions and the others
+	vector<IRInstruction> hoistedInstructions, loopInstructions;
+	for (size_t i = 0; i < headEnd; ++i) {
+		if (hoisted[i]) {
+			hoistedInstructions.push_back(instructions[i]);
+		} else {
+			loopInstructions.push_back(instructions[i]);
+		}
+	}
+	copy(hoistedInstructions.begin(), hoistedInstructions.end(), instructions.begin());
+	copy(loopInstructions.begin(), loopInstructions.end(), instructions.begin() + hoistedInstructions.size());
+	return hoistedInstructions.size();
+}
+
+bool IROptimizer::isOverwrittenBeforeRead(const IRBlock &irBlock, uint8 reg) {
+	for (size_t i = 0; i < irBlock.instructions.size(); ++i) {
+		const IRInstruction &instruction = irBlock.instructions[i];
+		IRRegisterUses uses;
+
+		irBlock.getRegisterUses(instruction, &uses);
+		if (uses.allRegs) return false;
+		for (int j = 0; j < uses.readCount; ++j) {
+			if (uses.reads[j] == reg) return false;
+		}
+		for (int j = 0; j < uses.writeCount; ++j) {
+			if (uses.writes[j] != reg) continue;
+			//Natives may write only part of the register
+			return instruction.opcode != IR_NATIVE;
+		}
+	}
+
+	//The next block may read it
+	return false;
+}
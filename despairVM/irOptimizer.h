@@ -0,0 +1,45 @@
+/*
+	Written By Pradipna Nepal
+	www.pradsprojects.com
+
+	Copyright (C) 2013 Pradipna Nepal
+	Please read COPYING.txt included along with this source code for more detail.
+	If not included, see http://www.gnu.org/licenses/
+*/
+
+#ifndef IR_OPTIMIZER_H
+#define IR_OPTIMIZER_H
+
+#include "build.h"
+#include "declarations.h"
+#include "irBlock.h"
+
+//Passes only look inside a block. Every register is treated as live when the block exits, including at
+//the side exits of a trace, and IR_NATIVE instructions are assumed to read and write global memory.
+namespace IROptimizer {
+	//Runs all the passes below in order
+	void optimize(IRBlock *irBlock);
+
+	//Loads of global memory whose value is still in a register become moves
+	void eliminateRedundantLoads(IRBlock *irBlock);
+	//Folds instructions whose operands are known and replaces known sources with immediates
+	void propagateConstants(IRBlock *irBlock);
+	//Multiplies, divides and modulos by powers of two become shifts and masks
+	void reduceStrength(IRBlock *irBlock);
+	//Reads of a register that is a copy of another register read the original instead
+	void propagateCopies(IRBlock *irBlock);
+	//Removes writes to regs[] that are overwritten before they are read
+	void eliminateDeadStores(IRBlock *irBlock);
+
+	//For a trace that loops back to its start. Moves the instructions that give a register the same value
+	//every time around the loop to the front, and returns how many there are, so they run once before
+	//the loop instead. Only instructions before headEnd, the branch of the first block, are moved, so
+	//no side exit sees them early. Loads of global memory stay, another thread may change it.
+	size_t hoistLoopInvariants(IRBlock *irBlock, size_t headEnd);
+
+	//Whether the code of irBlock writes all of reg before anything reads it, so the value reg has when
+	//the block is entered is never used
+	bool isOverwrittenBeforeRead(const IRBlock &irBlock, uint8 reg);
+}
+
+#endif
@@ -31,13 +31,15 @@ template void PortManager::writePort(uint16 val, uint32 address, PortManager *pM
 template void PortManager::writePort(uint32 val, uint32 address, PortManager *pM);
 template void PortManager::writePort(uint64 val, uint32 address, PortManager *pM);
 
-void PortManager::initializePortManager(GPUCore *gpuCore, uint8 *codePtr, uint8 *globalDataPtr, DespairHeader::ExecutableHeader *header, KeyboardManager *keyboardManager) {
+void PortManager::initializePortManager(GPUCore *gpuCore, uint8 *codePtr, uint8 *globalDataPtr, DespairHeader::ExecutableHeader *header, KeyboardManager *keyboardManager,
+										X86SharedTranslation *sharedTranslation) {
 	memset(ports, 0, PORTS_NUMBER);
 	this->gpuCore = gpuCore;
 	this->codePtr = codePtr;
 	this->globalDataPtr = globalDataPtr;
 	this->header = header;
 	this->keyboardManager = keyboardManager;
+	this->sharedTranslation = sharedTranslation;
 }
 
 template<typename Type>
@@ -47,6 +49,12 @@ Type PortManager::readPort(uint32 address, PortManager *pM) {
 
 template<typename Type>
 void PortManager::writePort(Type val, uint32 address, PortManager *pM) {
+	//Translated code stores to the same ports without calling this
+	if (isPlainPort(address)) {
+		*(Type*)&pM->ports[address] = val;
+		return;
+	}
+
 	switch (address) {
 		case PORT_GPU_FB_IN_DMA:
 			pM->gpuCore->gpuDMA_In((uint32*)val);
@@ -79,6 +87,7 @@ void PortManager::writePort(Type val, uint32 address, PortManager *pM) {
 				param.gpuCore = pM->gpuCore;
 				param.header = pM->header;
 				param.keyboardManager = pM->keyboardManager;
+				param.sharedTranslation = pM->sharedTranslation;
 
 				pM->ports[PORT_THREAD_CREATE] = (int)createNewThread(&param);
 				return;
@@ -90,8 +99,25 @@ void PortManager::writePort(Type val, uint32 address, PortManager *pM) {
 			pM->gpuCore->gpuDecodeCommand(val);
 			return;
 	}
+}
+
+//The ports writePort does something else for, each needs a case in its switch
+bool PortManager::isPlainPort(uint32 address) {
+	switch (address) {
+		case PORT_GPU_FB_IN_DMA:
+		case PORT_GPU_FB_OUT_DMA:
+		case PORT_KEYBOARD:
+		case PORT_MEMORY_MAKE_HEAP:
+		case PORT_MEMORY_DESTROY_HEAP:
+		case PORT_FILE_COMMAND:
+		case PORT_STRING_COMMAND:
+		case PORT_THREAD_CREATE:
+		case PORT_DMA_SIZE:
+		case PORT_GPU_COMMAND:
+			return false;
+	}
 
-	*(Type*)&pM->ports[address] = val;
+	return (address < PORTS_NUMBER);
 }
 
 float32 PortManager::readPortAsFloat(uint32 address, PortManager *pM) {
@@ -18,6 +18,7 @@
 #include "gpuCore.h"
 #include "keyboardManager.h"
 #include "despairHeader.h"
+#include "x86SharedTranslation.h"
 
 #define PORTS_NUMBER				256
 
@@ -28,9 +29,11 @@ private:
 	uint8 *codePtr, *globalDataPtr;
 	DespairHeader::ExecutableHeader *header;
 	KeyboardManager *keyboardManager;
+	X86SharedTranslation *sharedTranslation;	//Given to the threads the program creates
 
 public:
-	void initializePortManager(GPUCore *gpuCore, uint8 *codePtr, uint8 *globalDataPtr, DespairHeader::ExecutableHeader *header, KeyboardManager *keyboardManager);
+	void initializePortManager(GPUCore *gpuCore, uint8 *codePtr, uint8 *globalDataPtr, DespairHeader::ExecutableHeader *header, KeyboardManager *keyboardManager,
+								X86SharedTranslation *sharedTranslation);
 	void initializePorts();
 
 	template<typename Type>
@@ -41,6 +44,12 @@ public:
 
 	static float32 readPortAsFloat(uint32 address, PortManager *pM);
 	static void writePortAsFloat(float32 val, uint32 address, PortManager *pM);
+
+	//Writing a plain port only stores the value, so translated code writes it without calling writePort
+	static bool isPlainPort(uint32 address);
+	uint8 *getPortAddress(uint32 address) {
+		return &ports[address];
+	}
 };
 
 #endif
\ No newline at end of file
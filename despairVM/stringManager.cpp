@@ -7,6 +7,7 @@
 	If not included, see http://www.gnu.org/licenses/
 */
 
+#include <stdexcept>
 #include "stringManager.h"
 using namespace std;
 
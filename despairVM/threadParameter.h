@@ -16,19 +16,25 @@
 #include "gpuCore.h"
 #include "keyboardManager.h"
 #include "despairHeader.h"
+#include "x86SharedTranslation.h"
 
 struct ThreadParameter {
 	uint32 codeStartIndex;
 	volatile bool *threadStopped, threadInitialized;
+	volatile int64 *exitStatus;	//Gets r0 when the thread returns, if not 0
 	uint64 paramAddr;
 	uint8 *codePtr, *globalDataPtr;
 	GPUCore *gpuCore;
 	KeyboardManager *keyboardManager;
 	DespairHeader::ExecutableHeader *header;
+	std::string translationCachePath;	//Translated code is loaded from and saved here if not empty
+	X86SharedTranslation *sharedTranslation;	//May be 0
 
 	ThreadParameter() {
 		threadStopped = 0;
+		exitStatus = 0;
 		threadInitialized = false;
+		sharedTranslation = 0;
 	}
 };
 
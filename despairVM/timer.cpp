@@ -13,6 +13,7 @@
 #endif
 #ifdef BUILD_FOR_UNIX
 #include <sys/time.h>
+#include <unistd.h>
 #endif
 
 DespairTimer::DespairTimer() {
@@ -38,8 +39,17 @@ uint64 DespairTimer::getMilliseconds(DespairTimer *timer) {
 #ifdef BUILD_FOR_UNIX
     timeval tv;
     gettimeofday(&tv, 0);
-    milliSeconds = tv.tv_sec * 1000 + tv.tv_usec / 1000;
+    timer->milliSeconds = tv.tv_sec * 1000 + tv.tv_usec / 1000;
 #endif
 
 	return timer->milliSeconds;
+}
+
+void DespairTimer::sleep(uint32 milliseconds) {
+#ifdef BUILD_FOR_WINDOWS
+	Sleep(milliseconds);
+#endif
+#ifdef BUILD_FOR_UNIX
+	usleep(milliseconds * 1000);
+#endif
 }
\ No newline at end of file
@@ -26,6 +26,7 @@ private:
 public:
 	DespairTimer();
 	static uint64 getMilliseconds(DespairTimer *timer);
+	static void sleep(uint32 milliseconds);
 };
 
 #endif
\ No newline at end of file
@@ -8,61 +8,92 @@
 */
 
 #include <cstdlib>
+#include <algorithm>
 #include "x86BinBlock.h"
+using namespace std;
 
 template void X86BinBlock::write(uint8 val);
 template void X86BinBlock::write(uint16 val);
 template void X86BinBlock::write(uint32 val);
 template void X86BinBlock::write(uint64 val);
+template void X86BinBlock::writeAtIndex(uint32 val, uint32 index);
+template void X86BinBlock::writeAtIndex(uint64 val, uint32 index);
 
 X86BinBlock::X86BinBlock() {
 	counter = 0;
-	size = 10240;	//10 KB
-
-#ifdef BUILD_FOR_UNIX
-	binBlock = (uint8*)malloc(binBlockSize);
-#endif
-
-#ifdef BUILD_FOR_WINDOWS
-	heapHandle = HeapCreate(HEAP_CREATE_ENABLE_EXECUTE, 0, 0);
-	binBlock = (uint8*)HeapAlloc(heapHandle, 0, size);
-#endif
+	trace = false;
+	retired = false;
+	size = 1024;
+	binBlock = (uint8*)malloc(size);
+	codeArena = 0;
 }
 
 X86BinBlock::~X86BinBlock() {
-#ifdef BUILD_FOR_UNIX
-	free(binBlock);
-#endif
+	for (size_t i = 0; i < exits.size(); ++i) {
+		delete exits[i];
+	}
 
-#ifdef BUILD_FOR_WINDOWS
-	HeapFree(heapHandle, 0, (void*)binBlock);
-	HeapDestroy(heapHandle);
-#endif
+	if (codeArena) {
+		codeArena->release(binBlock, counter);
+	} else {
+		free(binBlock);
+	}
+}
+
+static bool isBeforeGuestAddress(uint32 index, const X86GuestAddress &guestAddress) {
+	return index < guestAddress.hostIndex;
 }
 
 void X86BinBlock::checkBinBufferBoundary(int typeSize) {
 	if (counter + typeSize >= size) {
-		size += 10240; //Another 10 KB
-
-#ifdef BUILD_FOR_UNIX
-		binBlock = (uint8*)realloc((void*)binBlock, binBlockSize);
-#endif
-
-#ifdef BUILD_FOR_WINDOWS
-		binBlock = (uint8*)HeapReAlloc(heapHandle, 0, (void*)binBlock, size);
-#endif
+		size <<= 1;
+		binBlock = (uint8*)realloc((void*)binBlock, size);
 	}
 }
 
 template<typename Type>
 void X86BinBlock::write(Type val) {
 	checkBinBufferBoundary(sizeof(Type));
+	if (sizeof(Type) == 8) immi64Indices.push_back(counter);
 	*(Type*)&binBlock[counter] = val;
 	counter += sizeof(Type);
 }
 
-void X86BinBlock::writeAtIndex(uint32 val, uint32 index) {
-	*(uint32*)&binBlock[index] = val;
+template<typename Type>
+void X86BinBlock::writeAtIndex(Type val, uint32 index) {
+	if (codeArena) {
+		codeArena->write(&binBlock[index], &val, sizeof(Type));
+	} else {
+		*(Type*)&binBlock[index] = val;
+	}
+}
+
+void X86BinBlock::markGuestAddress(int64 address) {
+	X86GuestAddress guestAddress = { (uint32)counter, (int32)(address - startAddress) };
+
+	//An instruction that was left without code gives its place to this one
+	if (!guestAddresses.empty() && guestAddresses.back().hostIndex == guestAddress.hostIndex) guestAddresses.pop_back();
+	if (!guestAddresses.empty() && guestAddresses.back().guestOffset == guestAddress.guestOffset) return;
+	guestAddresses.push_back(guestAddress);
+}
+
+int64 X86BinBlock::getGuestAddress(uint32 index) const {
+	vector<X86GuestAddress>::const_iterator it = upper_bound(guestAddresses.begin(), guestAddresses.end(), index, isBeforeGuestAddress);
+	if (it == guestAddresses.begin()) return startAddress;
+
+	return startAddress + (--it)->guestOffset;
+}
+
+bool X86BinBlock::install(X86CodeArena *codeArena) {
+	uint8 *code = codeArena->allocate(counter);
+	if (!code) return false;
+
+	codeArena->write(code, binBlock, counter);
+	free(binBlock);
+	binBlock = code;
+	this->codeArena = codeArena;
+
+	return true;
 }
 
 uint8 *X86BinBlock::getBinBuffer() {
@@ -10,24 +10,68 @@
 #ifndef X86_BIN_BUFFER_H
 #define X86_BIN_BUFFER_H
 
+#include <vector>
+#include <atomic>
 #include "build.h"
 #include "declarations.h"
-#ifdef BUILD_FOR_WINDOWS
-#include <Windows.h>
-#endif
+#include "x86CodeArena.h"
 
+#define BLOCK_EXIT_SIZE				5	//jmp rel32
+
+class X86BinBlock;
+
+//Start of the host code translated from one guest instruction, the code up to the next one belongs to it
+struct X86GuestAddress {
+	uint32 hostIndex;
+	int32 guestOffset;	//From startAddress of the block, a trace may go back before it
+};
+
+//An exit of a translated block. Every exit jumps through a patchable site which initially leads to
+//an out of line tail that returns to the dispatcher, and later straight to the successor block.
+//An entry of an inline cache is an exit whose target is only known once a jump through it went there,
+//its compare with the guest address is patched along with the jump.
+struct X86BinBlockExit {
+	X86BinBlock *owner;
+	X86BinBlock *linkedBlock;
+	int64 targetAddress;	//Guest address this exit continues at
+	uint32 patchIndex;	//Index of "jmp rel32" in owner's buffer, its offset is 4 byte aligned so that it is patched atomically
+	uint32 tailIndex;	//Index of the tail that goes back to the dispatcher
+	uint32 compareIndex;	//Index of the 4 byte aligned address the entry of an inline cache compares with, 0 for other exits
+	uint32 missIndex;	//Index of "jmp rel32" the inline cache goes through when no entry matches
+	uint32 nextTailIndex;	//Where missIndex goes once this entry is filled, the tail of the next entry or the dispatcher
+	std::atomic<uint32> executionCount;	//Times the exit was taken while it was not linked, by every core that runs it
+
+	X86BinBlockExit(X86BinBlock *owner, int64 targetAddress) {
+		this->owner = owner;
+		this->targetAddress = targetAddress;
+		linkedBlock = 0;
+		patchIndex = 0;
+		tailIndex = 0;
+		compareIndex = 0;
+		missIndex = 0;
+		nextTailIndex = 0;
+		executionCount = 0;
+	}
+};
+
+//Code is written to a growing buffer first and moved to the code arena by install, after which it
+//can run and only writeAtIndex can change it
 class X86BinBlock {
 private:
 	uint8 *binBlock;
 	int size, counter;
-#ifdef BUILD_FOR_WINDOWS
-	HANDLE heapHandle;
-#endif
+	X86CodeArena *codeArena;	//0 until the block is installed
 
 	void checkBinBufferBoundary(int size);
 
 public:
 	int64 startAddress, endAddress;
+	bool trace;	//Several guest blocks stitched together along their hot path
+	bool retired;	//Taken out of the X86CodeCache, but cores may still be running it
+	std::vector<X86BinBlockExit*> exits;	//Exits of this block
+	std::vector<X86BinBlockExit*> linkedExits;	//Exits of other blocks that jump straight into this block
+	std::vector<uint32> immi64Indices;	//Index of every 64 bit value written, which is where host addresses are
+	std::vector<X86GuestAddress> guestAddresses;	//Sorted by hostIndex, so samples of the code can be traced back to the guest
 
 	X86BinBlock();
 	~X86BinBlock();
@@ -35,8 +79,16 @@ public:
 	template<typename Type>
 	void write(Type val);
 
-	void writeAtIndex(uint32 val, uint32 index);
+	template<typename Type>
+	void writeAtIndex(Type val, uint32 index);
+
+	//Code written from now on is translated from the guest instruction at address
+	void markGuestAddress(int64 address);
+	//Guest instruction the code at index was translated from, code before the first one belongs to startAddress
+	int64 getGuestAddress(uint32 index) const;
 
+	//Returns false if the arena is full
+	bool install(X86CodeArena *codeArena);
 	uint8 *getBinBuffer();
 	uint32 getCounter();
 };
@@ -0,0 +1,92 @@
+/*
+	Written By Pradipna Nepal
+	www.pradsprojects.com
+
+	Copyright (C) 2013 Pradipna Nepal
+	Please read COPYING.txt included along with this source code for more detail.
+	If not included, see http://www.gnu.org/licenses/
+*/
+
+#include "x86BinBlockCache.h"
+using namespace std;
+
+X86BinBlockCache::X86BinBlockCache(uint64 codeSize) {
+	this->codeSize = codeSize;
+	pageCount = (uint32)((codeSize + BIN_BLOCK_CACHE_PAGE_MASK) >> BIN_BLOCK_CACHE_PAGE_BITS);
+	entryPages = new uint8**[pageCount];
+	blockPages = new atomic<BlockSlot*>[pageCount];
+	for (uint32 i = 0; i < pageCount; ++i) {
+		entryPages[i] = 0;
+		blockPages[i] = 0;
+	}
+}
+
+X86BinBlockCache::~X86BinBlockCache() {
+	for (uint32 i = 0; i < pageCount; ++i) {
+		delete [] entryPages[i];
+		delete [] blockPages[i];
+	}
+	delete [] entryPages;
+	delete [] blockPages;
+}
+
+X86BinBlock *X86BinBlockCache::findOutsideCode(int64 address) const {
+	lock_guard<mutex> guard(outsideCodeLock);
+	map<int64, X86BinBlock*>::const_iterator it = outsideCode.find(address);
+	return (it == outsideCode.end()) ? 0 : it->second;
+}
+
+void X86BinBlockCache::insert(int64 address, X86BinBlock *binBlock, uint8 *entryPoint) {
+	if ((uint64)address >= codeSize) {
+		lock_guard<mutex> guard(outsideCodeLock);
+		outsideCode[address] = binBlock;
+		return;
+	}
+
+	uint32 page = (uint32)(address >> BIN_BLOCK_CACHE_PAGE_BITS);
+	if (!blockPages[page]) {
+		//Pages are only published once they are cleared, the dispatcher reads entryPages without a lock
+		uint8 **entryPage = new uint8*[BIN_BLOCK_CACHE_PAGE_SIZE]();
+		atomic_thread_fence(memory_order_release);
+		entryPages[page] = entryPage;
+		blockPages[page] = new BlockSlot[BIN_BLOCK_CACHE_PAGE_SIZE]();
+	}
+	entryPages[page][address & BIN_BLOCK_CACHE_PAGE_MASK] = entryPoint;
+	blockPages[page][address & BIN_BLOCK_CACHE_PAGE_MASK] = binBlock;
+}
+
+void X86BinBlockCache::erase(int64 address) {
+	if ((uint64)address >= codeSize) {
+		lock_guard<mutex> guard(outsideCodeLock);
+		outsideCode.erase(address);
+		return;
+	}
+
+	uint32 page = (uint32)(address >> BIN_BLOCK_CACHE_PAGE_BITS);
+	if (blockPages[page]) {
+		entryPages[page][address & BIN_BLOCK_CACHE_PAGE_MASK] = 0;
+		blockPages[page][address & BIN_BLOCK_CACHE_PAGE_MASK] = 0;
+	}
+}
+
+void X86BinBlockCache::getBinBlocks(vector<X86BinBlock*> *binBlocks) const {
+	for (uint32 i = 0; i < pageCount; ++i) {
+		if (!blockPages[i]) continue;
+
+		for (int j = 0; j < BIN_BLOCK_CACHE_PAGE_SIZE; ++j) {
+			if (blockPages[i][j]) binBlocks->push_back(blockPages[i][j]);
+		}
+	}
+	lock_guard<mutex> guard(outsideCodeLock);
+	for (map<int64, X86BinBlock*>::const_iterator it = outsideCode.begin(); it != outsideCode.end(); ++it) {
+		binBlocks->push_back(it->second);
+	}
+}
+
+uint8 ***X86BinBlockCache::getEntryPages() {
+	return entryPages;
+}
+
+uint64 X86BinBlockCache::getCodeSize() {
+	return codeSize;
+}
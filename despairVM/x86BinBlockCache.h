@@ -0,0 +1,65 @@
+/*
+	Written By Pradipna Nepal
+	www.pradsprojects.com
+
+	Copyright (C) 2013 Pradipna Nepal
+	Please read COPYING.txt included along with this source code for more detail.
+	If not included, see http://www.gnu.org/licenses/
+*/
+
+#ifndef X86_BIN_BLOCK_CACHE_H
+#define X86_BIN_BLOCK_CACHE_H
+
+#include <map>
+#include <vector>
+#include <atomic>
+#include <mutex>
+#include "build.h"
+#include "declarations.h"
+
+#define BIN_BLOCK_CACHE_PAGE_BITS		12
+#define BIN_BLOCK_CACHE_PAGE_SIZE		(1 << BIN_BLOCK_CACHE_PAGE_BITS)
+#define BIN_BLOCK_CACHE_PAGE_MASK		(BIN_BLOCK_CACHE_PAGE_SIZE - 1)
+
+class X86BinBlock;
+
+//Two level table from guest address to translated block. There is a page for every
+//BIN_BLOCK_CACHE_PAGE_SIZE bytes of code, allocated when the first block in it is translated.
+//Entry points have their own pages so that translated code can look them up without calling back:
+//entry = entryPages[address >> BIN_BLOCK_CACHE_PAGE_BITS][address & BIN_BLOCK_CACHE_PAGE_MASK]
+//Only one thread may change the table at a time, but any number can look up blocks while it does.
+class X86BinBlockCache {
+private:
+	typedef std::atomic<X86BinBlock*> BlockSlot;
+
+	uint64 codeSize;
+	uint32 pageCount;
+	uint8 ***entryPages;
+	std::atomic<BlockSlot*> *blockPages;
+	std::map<int64, X86BinBlock*> outsideCode;	//Blocks that start outside codeSpace, which only broken programs have
+	mutable std::mutex outsideCodeLock;
+
+public:
+	X86BinBlockCache(uint64 codeSize);
+	~X86BinBlockCache();
+
+	//Returns 0 if address has not been translated
+	X86BinBlock *find(int64 address) const {
+		if ((uint64)address < codeSize) {
+			BlockSlot *blockPage = blockPages[address >> BIN_BLOCK_CACHE_PAGE_BITS];
+			return (blockPage) ? blockPage[address & BIN_BLOCK_CACHE_PAGE_MASK].load() : 0;
+		}
+		return findOutsideCode(address);
+	}
+
+	X86BinBlock *findOutsideCode(int64 address) const;
+	void insert(int64 address, X86BinBlock *binBlock, uint8 *entryPoint);
+	void erase(int64 address);
+	//Every block in the cache, in no particular order
+	void getBinBlocks(std::vector<X86BinBlock*> *binBlocks) const;
+
+	uint8 ***getEntryPages();
+	uint64 getCodeSize();
+};
+
+#endif
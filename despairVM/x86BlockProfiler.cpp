@@ -0,0 +1,87 @@
+/*
+	Written By Pradipna Nepal
+	www.pradsprojects.com
+
+	Copyright (C) 2013 Pradipna Nepal
+	Please read COPYING.txt included along with this source code for more detail.
+	If not included, see http://www.gnu.org/licenses/
+*/
+
+#include <vector>
+#include <algorithm>
+#include <cstdio>
+#include "x86BlockProfiler.h"
+using namespace std;
+
+static bool tookMoreCycles(const X86BlockProfileLine &a, const X86BlockProfileLine &b) {
+	return a.cycles > b.cycles;
+}
+
+static X86BlockProfileLine getLine(const X86BlockProfile &profile, const string &name) {
+	X86BlockProfileLine line;
+
+	line.entries = profile.entries;
+	line.instructions = profile.instructions;
+	line.cycles = profile.cycles;
+	line.name = name;
+	return line;
+}
+
+X86BlockProfile *X86BlockProfiler::getProfile(int64 startAddress, int64 endAddress, bool trace) {
+	lock_guard<mutex> guard(lock);
+	X86BlockProfile *profile = &profiles[make_pair(make_pair(startAddress, endAddress), trace)];
+
+	profile->startAddress = startAddress;
+	profile->endAddress = endAddress;
+	profile->trace = trace;
+	return profile;
+}
+
+//Other cores may still be adding to the counters, so they are copied before they are sorted
+void X86BlockProfiler::getReportLines(vector<X86BlockProfileLine> *lines) {
+	{
+		lock_guard<mutex> guard(lock);
+		for (ProfileMap::iterator it = profiles.begin(); it != profiles.end(); ++it) {
+			lines->push_back(getLine(it->second, getFrameName(it->second)));
+		}
+	}
+	lines->push_back(getLine(untranslated, "untranslated"));
+	stable_sort(lines->begin(), lines->end(), tookMoreCycles);
+}
+
+string X86BlockProfiler::getFrameName(const X86BlockProfile &profile) {
+	char name[64];
+	sprintf(name, "0x%08llx-0x%08llx%s", (unsigned long long)profile.startAddress, (unsigned long long)profile.endAddress, (profile.trace) ? " [trace]" : "");
+	return name;
+}
+
+bool X86BlockProfiler::saveReport(const string &path) {
+	vector<X86BlockProfileLine> lines;
+	getReportLines(&lines);
+
+	FILE *reportFile = fopen(path.c_str(), "w");
+	if (reportFile == 0) return false;
+
+	fprintf(reportFile, "#cycles entries instructions block\n");
+	for (size_t i = 0; i < lines.size(); ++i) {
+		fprintf(reportFile, "%llu %llu %llu %s\n", (unsigned long long)lines[i].cycles, (unsigned long long)lines[i].entries,
+				(unsigned long long)lines[i].instructions, lines[i].name.c_str());
+	}
+
+	return fclose(reportFile) == 0;
+}
+
+//One "despair;block cycles" line per block that took any cycles, no guest call stacks are kept
+bool X86BlockProfiler::saveFoldedStacks(const string &path) {
+	vector<X86BlockProfileLine> lines;
+	getReportLines(&lines);
+
+	FILE *foldedFile = fopen(path.c_str(), "w");
+	if (foldedFile == 0) return false;
+
+	for (size_t i = 0; i < lines.size() && lines[i].cycles; ++i) {
+		fprintf(foldedFile, "despair;%s %llu\n", lines[i].name.c_str(), (unsigned long long)lines[i].cycles);
+	}
+
+	return fclose(foldedFile) == 0;
+}
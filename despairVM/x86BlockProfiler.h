@@ -0,0 +1,82 @@
+/*
+	Written By Pradipna Nepal
+	www.pradsprojects.com
+
+	Copyright (C) 2013 Pradipna Nepal
+	Please read COPYING.txt included along with this source code for more detail.
+	If not included, see http://www.gnu.org/licenses/
+*/
+
+#ifndef X86_BLOCK_PROFILER_H
+#define X86_BLOCK_PROFILER_H
+
+#include <map>
+#include <vector>
+#include <string>
+#include <mutex>
+#include <atomic>
+#include "build.h"
+#include "declarations.h"
+#ifdef USING_MICROSOFT_COMPILER
+#include <intrin.h>
+#else
+#include <x86intrin.h>
+#endif
+
+//Counters of one guest block, translated code adds to them with lock add so they are shared by every core
+struct X86BlockProfile {
+	std::atomic<uint64> entries;
+	std::atomic<uint64> instructions;	//Guest instructions of the block times entries, a trace that leaves early counts all of them
+	std::atomic<uint64> cycles;	//Host cycles from the entry of the block until the next block or the return to startCPULoop
+	int64 startAddress, endAddress;
+	bool trace;
+
+	X86BlockProfile() {
+		entries = 0;
+		instructions = 0;
+		cycles = 0;
+		startAddress = -1;
+		endAddress = -1;
+		trace = false;
+	}
+};
+
+//Counters of a profile read at one point in time, for the report
+struct X86BlockProfileLine {
+	uint64 entries, instructions, cycles;
+	std::string name;
+};
+
+//Counters for every guest block that was translated while profiling. A block that is translated
+//again, by another core or after the cache was flushed, counts into the same profile. Time that is not
+//spent in translated code (interpreting, translating, host calls of startCPULoop) goes to the untranslated
+//profile. Profiles are never deleted, so translated code can refer to them by address.
+class X86BlockProfiler {
+private:
+	typedef std::map<std::pair<std::pair<int64, int64>, bool>, X86BlockProfile> ProfileMap;
+
+	std::mutex lock;
+	ProfileMap profiles;
+	X86BlockProfile untranslated;
+
+	//The untranslated profile is included, the profiles that took the most cycles come first
+	void getReportLines(std::vector<X86BlockProfileLine> *lines);
+	static std::string getFrameName(const X86BlockProfile &profile);
+
+public:
+	static uint64 readCycleCounter() {
+		return __rdtsc();
+	}
+
+	X86BlockProfile *getProfile(int64 startAddress, int64 endAddress, bool trace);
+	X86BlockProfile *getUntranslatedProfile() {
+		return &untranslated;
+	}
+
+	//Writes one line per block, "cycles entries instructions start-end", the ones that took the most
+	//cycles first. The folded file has the same cycles in the format flamegraph.pl reads.
+	bool saveReport(const std::string &path);
+	bool saveFoldedStacks(const std::string &path);
+};
+
+#endif
@@ -0,0 +1,184 @@
+/*
+	Written By Pradipna Nepal
+	www.pradsprojects.com
+
+	Copyright (C) 2013 Pradipna Nepal
+	Please read COPYING.txt included along with this source code for more detail.
+	If not included, see http://www.gnu.org/licenses/
+*/
+
+#include "build.h"
+
+#ifdef BUILD_FOR_WINDOWS
+#include <Windows.h>
+#endif
+
+#ifdef BUILD_FOR_UNIX
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include <cstring>
+#include "x86CodeArena.h"
+using namespace std;
+
+#define CODE_ARENA_PAGE_SIZE		4096
+
+X86CodeArena::X86CodeArena() {
+	execView = 0;
+	writeView = 0;
+	top = 0;
+	usedSize = 0;
+
+#ifdef BUILD_FOR_UNIX
+#ifdef SYS_memfd_create
+	//Two views of the same memory, so code can be patched while other blocks run
+	int fd = (int)syscall(SYS_memfd_create, "despairvm-code", 0);
+	if (fd != -1) {
+		if (ftruncate(fd, CODE_ARENA_SIZE) == 0) {
+			void *exec = mmap(0, CODE_ARENA_SIZE, PROT_READ | PROT_EXEC, MAP_SHARED, fd, 0);
+			void *write = mmap(0, CODE_ARENA_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+
+			if (exec != MAP_FAILED && write != MAP_FAILED) {
+				execView = (uint8*)exec;
+				writeView = (uint8*)write;
+			} else {
+				if (exec != MAP_FAILED) munmap(exec, CODE_ARENA_SIZE);
+				if (write != MAP_FAILED) munmap(write, CODE_ARENA_SIZE);
+			}
+		}
+		close(fd);
+	}
+#endif
+	if (!execView) {
+		void *exec = mmap(0, CODE_ARENA_SIZE, PROT_READ | PROT_EXEC, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+		if (exec != MAP_FAILED) {
+			execView = (uint8*)exec;
+		}
+	}
+#endif
+
+#ifdef BUILD_FOR_WINDOWS
+	committed = 0;
+	execView = (uint8*)VirtualAlloc(0, CODE_ARENA_SIZE, MEM_RESERVE, PAGE_NOACCESS);
+#endif
+}
+
+X86CodeArena::~X86CodeArena() {
+	if (!execView) return;
+
+#ifdef BUILD_FOR_UNIX
+	munmap(execView, CODE_ARENA_SIZE);
+	if (writeView) {
+		munmap(writeView, CODE_ARENA_SIZE);
+	}
+#endif
+
+#ifdef BUILD_FOR_WINDOWS
+	VirtualFree(execView, 0, MEM_RELEASE);
+#endif
+}
+
+uint8 *X86CodeArena::allocate(uint32 size) {
+	if (!execView) return 0;
+	size = (size + CODE_ARENA_ALIGNMENT - 1) & ~(CODE_ARENA_ALIGNMENT - 1);
+
+	//First fit in the space of deleted blocks
+	for (map<uint32, uint32>::iterator it = freeRanges.begin(); it != freeRanges.end(); ++it) {
+		if (it->second >= size) {
+			uint32 offset = it->first;
+			uint32 rest = it->second - size;
+
+			freeRanges.erase(it);
+			if (rest) {
+				freeRanges[offset + size] = rest;
+			}
+			usedSize += size;
+			return execView + offset;
+		}
+	}
+
+	if ((uint64)top + size > CODE_ARENA_SIZE) return 0;
+#ifdef BUILD_FOR_WINDOWS
+	while (top + size > committed) {
+		if (!VirtualAlloc(execView + committed, CODE_ARENA_COMMIT_SIZE, MEM_COMMIT, PAGE_EXECUTE_READ)) return 0;
+		committed += CODE_ARENA_COMMIT_SIZE;
+	}
+#endif
+	uint8 *address = execView + top;
+	top += size;
+	usedSize += size;
+
+	return address;
+}
+
+void X86CodeArena::release(uint8 *address, uint32 size) {
+	uint32 offset = (uint32)(address - execView);
+	size = (size + CODE_ARENA_ALIGNMENT - 1) & ~(CODE_ARENA_ALIGNMENT - 1);
+	usedSize -= size;
+
+	//Merge with the free ranges around it
+	map<uint32, uint32>::iterator next = freeRanges.lower_bound(offset);
+	if (next != freeRanges.end() && offset + size == next->first) {
+		size += next->second;
+		freeRanges.erase(next++);
+	}
+	if (next != freeRanges.begin()) {
+		map<uint32, uint32>::iterator previous = next;
+		--previous;
+		if (previous->first + previous->second == offset) {
+			offset = previous->first;
+			size += previous->second;
+			freeRanges.erase(previous);
+		}
+	}
+
+	if (offset + size == top) {
+		top = offset;
+	} else {
+		freeRanges[offset] = size;
+	}
+}
+
+uint32 X86CodeArena::getUsedSize() {
+	return usedSize;
+}
+
+//Other threads may be running the code that is written, exits are patched with one aligned store so
+//that they never see half a jump offset
+static void copyCode(uint8 *destination, const void *data, uint32 size) {
+	if (size == sizeof(uint32) && ((uint64)destination & 3) == 0) {
+		*(volatile uint32*)destination = *(const uint32*)data;
+	} else {
+		memcpy(destination, data, size);
+	}
+}
+
+void X86CodeArena::write(uint8 *address, const void *data, uint32 size) {
+	if (writeView) {
+		copyCode(writeView + (address - execView), data, size);
+		return;
+	}
+
+	setWritable(address, size, true);
+	copyCode(address, data, size);
+	setWritable(address, size, false);
+}
+
+void X86CodeArena::setWritable(uint8 *address, uint32 size, bool writable) {
+	uint8 *start = execView + ((address - execView) & ~(CODE_ARENA_PAGE_SIZE - 1));
+	size_t length = (address + size) - start;
+
+#ifdef BUILD_FOR_UNIX
+	mprotect(start, length, (writable) ? (PROT_READ | PROT_WRITE | PROT_EXEC) : (PROT_READ | PROT_EXEC));
+#endif
+
+#ifdef BUILD_FOR_WINDOWS
+	DWORD oldProtect;
+	VirtualProtect(start, length, (writable) ? PAGE_EXECUTE_READWRITE : PAGE_EXECUTE_READ, &oldProtect);
+	if (!writable) {
+		FlushInstructionCache(GetCurrentProcess(), start, length);
+	}
+#endif
+}
@@ -0,0 +1,54 @@
+/*
+	Written By Pradipna Nepal
+	www.pradsprojects.com
+
+	Copyright (C) 2013 Pradipna Nepal
+	Please read COPYING.txt included along with this source code for more detail.
+	If not included, see http://www.gnu.org/licenses/
+*/
+
+#ifndef X86_CODE_ARENA_H
+#define X86_CODE_ARENA_H
+
+#include <map>
+#include "build.h"
+#include "declarations.h"
+
+#define CODE_ARENA_SIZE				(256 << 20)	//Reserved up front so that every block can reach every other block with rel32
+#define CODE_ARENA_ALIGNMENT		16
+#ifdef BUILD_FOR_WINDOWS
+#define CODE_ARENA_COMMIT_SIZE		(1 << 20)
+#endif
+
+//Executable memory shared by all translated blocks. Blocks are packed one after the other and the
+//space of deleted blocks is reused. The code is only writable while it is written: on Unix it is
+//mapped twice, once read/write and once read/execute, and on Windows (or when the double mapping is
+//not available) the pages are made writable only while write() copies into them. They stay executable
+//meanwhile, since cores that share the arena may be running other code on the same page.
+//The arena is not locked, X86CodeCache serializes the threads that use it.
+class X86CodeArena {
+private:
+	uint8 *execView;
+	uint8 *writeView;	//0 if the pages have to be made writable for every write
+	uint32 top;
+	uint32 usedSize;	//Of the blocks that have not been released
+#ifdef BUILD_FOR_WINDOWS
+	uint32 committed;
+#endif
+	std::map<uint32, uint32> freeRanges;	//Offset, size
+
+	void setWritable(uint8 *address, uint32 size, bool writable);
+
+public:
+	X86CodeArena();
+	~X86CodeArena();
+
+	//Returns 0 if the arena is full
+	uint8 *allocate(uint32 size);
+	void release(uint8 *address, uint32 size);
+	uint32 getUsedSize();
+	//Copies data to an address returned by allocate
+	void write(uint8 *address, const void *data, uint32 size);
+};
+
+#endif
@@ -0,0 +1,341 @@
+/*
+	Written By Pradipna Nepal
+	www.pradsprojects.com
+
+	Copyright (C) 2013 Pradipna Nepal
+	Please read COPYING.txt included along with this source code for more detail.
+	If not included, see http://www.gnu.org/licenses/
+*/
+
+#include "x86CodeCache.h"
+using namespace std;
+
+#define CODE_CACHE_SAFE_PASSES		2	//Passes every user makes before a retired block is deleted
+
+X86CodeCache::X86CodeCache(uint64 codeSize) : binBlocks(codeSize) {
+	blockCount = 0;
+	changed = false;
+	dispatcherBlock = 0;
+	dispatcherIndirectIndex = 0;
+	dispatcherExitIndex = 0;
+	retiredCount = 0;
+	retirements = 0;
+	perfMap = 0;
+}
+
+X86CodeCache::~X86CodeCache() {
+	vector<X86BinBlock*> cachedBlocks;
+
+	binBlocks.getBinBlocks(&cachedBlocks);
+	for (size_t i = 0; i < cachedBlocks.size(); ++i) {
+		delete cachedBlocks[i];
+	}
+	for (size_t i = 0; i < retired.size(); ++i) {
+		for (size_t j = 0; j < retired[i].binBlocks.size(); ++j) {
+			delete retired[i].binBlocks[j];
+		}
+	}
+	delete dispatcherBlock;
+}
+
+bool X86CodeCache::isEmpty() {
+	lock_guard<mutex> guard(lock);
+	return blockCount == 0;
+}
+
+uint64 X86CodeCache::getCodeSize() {
+	return binBlocks.getCodeSize();
+}
+
+uint8 ***X86CodeCache::getEntryPages() {
+	return binBlocks.getEntryPages();
+}
+
+uint64 X86CodeCache::getTranslatedSize() {
+	lock_guard<mutex> guard(lock);
+	return codeArena.getUsedSize();
+}
+
+bool X86CodeCache::findGuestLocation(const uint8 *code, X86GuestLocation *location) {
+	lock_guard<mutex> guard(lock);
+
+	map<const uint8*, X86BinBlock*>::iterator it = codeBlocks.upper_bound(code);
+	if (it == codeBlocks.begin()) return false;
+	X86BinBlock *binBlock = (--it)->second;
+	uint32 index = (uint32)(code - it->first);
+	if (index >= binBlock->getCounter()) return false;
+
+	location->blockAddress = binBlock->startAddress;
+	location->trace = binBlock->trace;
+	location->address = binBlock->getGuestAddress(index);
+	return true;
+}
+
+void X86CodeCache::setPerfMap(X86PerfMap *perfMap) {
+	lock_guard<mutex> guard(lock);
+	this->perfMap = perfMap;
+}
+
+void X86CodeCache::addUser(X86CodeCacheUser *user) {
+	lock_guard<mutex> guard(lock);
+	users.insert(user);
+}
+
+void X86CodeCache::removeUser(X86CodeCacheUser *user) {
+	lock_guard<mutex> guard(lock);
+
+	users.erase(user);
+	for (size_t i = 0; i < retired.size(); ++i) {
+		retired[i].passes.erase(user);
+	}
+}
+
+void X86CodeCache::collect() {
+	lock_guard<mutex> guard(lock);
+
+	for (size_t i = 0; i < retired.size();) {
+		map<X86CodeCacheUser*, uint64>::iterator it;
+		for (it = retired[i].passes.begin(); it != retired[i].passes.end(); ++it) {
+			if (it->first->passes < it->second + CODE_CACHE_SAFE_PASSES) break;
+		}
+		if (it != retired[i].passes.end()) {
+			++i;
+			continue;
+		}
+
+		for (size_t j = 0; j < retired[i].binBlocks.size(); ++j) {
+			codeBlocks.erase(retired[i].binBlocks[j]->getBinBuffer());
+			delete retired[i].binBlocks[j];
+		}
+		retired.erase(retired.begin() + i);
+	}
+	retiredCount = retired.size();
+}
+
+bool X86CodeCache::setDispatcher(X86BinBlock *dispatcherBlock, uint32 indirectIndex, uint32 exitIndex) {
+	lock_guard<mutex> guard(lock);
+
+	if (this->dispatcherBlock) {
+		delete dispatcherBlock;
+		return true;
+	}
+	if (!dispatcherBlock->install(&codeArena)) {
+		delete dispatcherBlock;
+		return false;
+	}
+
+	this->dispatcherBlock = dispatcherBlock;
+	if (perfMap) perfMap->addCode(dispatcherBlock->getBinBuffer(), dispatcherBlock->getCounter(), "despair dispatcher");
+	dispatcherIndirectIndex = indirectIndex;
+	dispatcherExitIndex = exitIndex;
+	return true;
+}
+
+X86BinBlock *X86CodeCache::getDispatcher() {
+	return dispatcherBlock;
+}
+
+uint8 *X86CodeCache::getDispatcherIndirect() {
+	return dispatcherBlock->getBinBuffer() + dispatcherIndirectIndex;
+}
+
+uint8 *X86CodeCache::getDispatcherExit() {
+	return dispatcherBlock->getBinBuffer() + dispatcherExitIndex;
+}
+
+bool X86CodeCache::install(X86BinBlock *binBlock) {
+	lock_guard<mutex> guard(lock);
+	return binBlock->install(&codeArena);
+}
+
+void X86CodeCache::discard(X86BinBlock *binBlock) {
+	lock_guard<mutex> guard(lock);
+	delete binBlock;
+}
+
+X86BinBlock *X86CodeCache::insert(X86BinBlock *binBlock) {
+	lock_guard<mutex> guard(lock);
+
+	X86BinBlock *inserted = insertBinBlock(binBlock);
+	if (inserted == binBlock) {
+		changed = true;
+		if (binBlock->trace) linkBlockExits(binBlock);
+	}
+	return inserted;
+}
+
+X86BinBlock *X86CodeCache::insertBinBlock(X86BinBlock *binBlock) {
+	X86BinBlock *current = binBlocks.find(binBlock->startAddress);
+
+	if (current && (!binBlock->trace || current->trace)) {
+		delete binBlock;
+		return current;
+	}
+	if (current) {
+		retire(vector<X86BinBlock*>(1, current), 0);
+	}
+	binBlocks.insert(binBlock->startAddress, binBlock, binBlock->getBinBuffer());
+	codeBlocks[binBlock->getBinBuffer()] = binBlock;
+	++blockCount;
+	if (perfMap) perfMap->addBlock(binBlock);
+
+	return binBlock;
+}
+
+void X86CodeCache::link(X86BinBlockExit *blockExit, X86BinBlock *target) {
+	lock_guard<mutex> guard(lock);
+
+	if (blockExit->owner->retired || target->retired) return;
+	linkBlockExit(blockExit, target);
+}
+
+void X86CodeCache::fillInlineCache(X86BinBlockExit *entry, X86BinBlock *target) {
+	lock_guard<mutex> guard(lock);
+	X86BinBlock *owner = entry->owner;
+
+	//The address is compared with a sign extended imm32
+	if (owner->retired || target->retired || entry->linkedBlock || (int32)target->startAddress != target->startAddress) return;
+
+	//Until the jump is linked a match still goes to the tail, which is right for any address
+	entry->targetAddress = target->startAddress;
+	owner->writeAtIndex((uint32)target->startAddress, entry->compareIndex);
+	linkBlockExit(entry, target);
+
+	//An entry that is filled again after its block was retired leaves the misses where they go
+	uint8 *missEnd = owner->getBinBuffer() + entry->missIndex + BLOCK_EXIT_SIZE;
+	if (missEnd + *(int32*)(missEnd - 4) == owner->getBinBuffer() + entry->tailIndex) {
+		owner->writeAtIndex(entry->nextTailIndex - (entry->missIndex + BLOCK_EXIT_SIZE), entry->missIndex + 1);
+	}
+}
+
+void X86CodeCache::linkBlockExits(X86BinBlock *binBlock) {
+	for (size_t i = 0; i < binBlock->exits.size(); ++i) {
+		X86BinBlock *target = binBlocks.find(binBlock->exits[i]->targetAddress);
+		if (target) {
+			linkBlockExit(binBlock->exits[i], target);
+		}
+	}
+}
+
+void X86CodeCache::linkBlockExit(X86BinBlockExit *blockExit, X86BinBlock *target) {
+	//Only link exits that lead to the start of the target, interpreted instructions have no block
+	if (blockExit->linkedBlock || blockExit->targetAddress != target->startAddress) return;
+
+	uint8 *patchEnd = blockExit->owner->getBinBuffer() + blockExit->patchIndex + BLOCK_EXIT_SIZE;
+	blockExit->owner->writeAtIndex((uint32)(target->getBinBuffer() - patchEnd), blockExit->patchIndex + 1);
+	blockExit->linkedBlock = target;
+	target->linkedExits.push_back(blockExit);
+}
+
+void X86CodeCache::unlinkBlockExit(X86BinBlockExit *blockExit) {
+	blockExit->owner->writeAtIndex(blockExit->tailIndex - (blockExit->patchIndex + BLOCK_EXIT_SIZE), blockExit->patchIndex + 1);
+	blockExit->linkedBlock = 0;
+}
+
+//Takes a block out of the cache, along with every link that leads into it or out of it
+void X86CodeCache::detachBinBlock(X86BinBlock *binBlock) {
+	//Blocks that jump straight into this block have to go through the dispatcher again
+	for (size_t i = 0; i < binBlock->linkedExits.size(); ++i) {
+		unlinkBlockExit(binBlock->linkedExits[i]);
+	}
+	binBlock->linkedExits.clear();
+
+	//Forget the links this block made to other blocks
+	for (size_t i = 0; i < binBlock->exits.size(); ++i) {
+		X86BinBlock *target = binBlock->exits[i]->linkedBlock;
+		if (target && target != binBlock) {
+			vector<X86BinBlockExit*> &linkedExits = target->linkedExits;
+			for (size_t j = 0; j < linkedExits.size(); ++j) {
+				if (linkedExits[j] == binBlock->exits[i]) {
+					linkedExits.erase(linkedExits.begin() + j);
+					break;
+				}
+			}
+		}
+	}
+
+	binBlocks.erase(binBlock->startAddress);
+	binBlock->retired = true;
+	--blockCount;
+}
+
+//caller is the user that retires the blocks, if it does not hold any of them
+void X86CodeCache::retire(const vector<X86BinBlock*> &retiredBlocks, X86CodeCacheUser *caller) {
+	if (retiredBlocks.empty()) return;
+
+	++retirements;
+	retired.push_back(RetiredBlocks());
+	RetiredBlocks &entry = retired.back();
+	entry.binBlocks = retiredBlocks;
+	for (size_t i = 0; i < retiredBlocks.size(); ++i) {
+		detachBinBlock(retiredBlocks[i]);
+	}
+
+	//Read after the blocks are out of the cache: a user that found one of them has not made the pass
+	//that comes after it yet
+	for (set<X86CodeCacheUser*>::iterator it = users.begin(); it != users.end(); ++it) {
+		if (*it != caller) entry.passes[*it] = (*it)->passes;
+	}
+	retiredCount = retired.size();
+}
+
+void X86CodeCache::flush(X86CodeCacheUser *caller) {
+	lock_guard<mutex> guard(lock);
+	vector<X86BinBlock*> cachedBlocks;
+
+	binBlocks.getBinBlocks(&cachedBlocks);
+	retire(cachedBlocks, caller);
+}
+
+void X86CodeCache::insertLoadedBlocks(const vector<X86BinBlock*> &loadedBlocks) {
+	vector<X86BinBlock*> traces;
+
+	for (size_t i = 0; i < loadedBlocks.size(); ++i) {
+		X86BinBlock *binBlock = loadedBlocks[i];
+		if (insertBinBlock(binBlock) == binBlock && binBlock->trace) traces.push_back(binBlock);
+	}
+
+	//Traces are linked as soon as they are created, the exits of other blocks once they are hot again
+	for (size_t i = 0; i < traces.size(); ++i) {
+		linkBlockExits(traces[i]);
+	}
+	changed = false;
+}
+
+bool X86CodeCache::load(X86TranslationCache *translationCache, const vector<uint8> &image) {
+	lock_guard<mutex> guard(lock);
+	vector<X86BinBlock*> loadedBlocks;
+
+	if (!translationCache->load(image, &codeArena, &loadedBlocks)) return false;
+	insertLoadedBlocks(loadedBlocks);
+	return true;
+}
+
+bool X86CodeCache::loadFile(X86TranslationCache *translationCache, const string &path) {
+	lock_guard<mutex> guard(lock);
+	vector<X86BinBlock*> loadedBlocks;
+
+	if (!translationCache->loadFile(path, &codeArena, &loadedBlocks)) return false;
+	insertLoadedBlocks(loadedBlocks);
+	return true;
+}
+
+void X86CodeCache::save(X86TranslationCache *translationCache, vector<uint8> *image) {
+	lock_guard<mutex> guard(lock);
+	vector<X86BinBlock*> cachedBlocks;
+
+	binBlocks.getBinBlocks(&cachedBlocks);
+	translationCache->save(cachedBlocks, image);
+}
+
+bool X86CodeCache::saveFile(X86TranslationCache *translationCache, const string &path) {
+	lock_guard<mutex> guard(lock);
+	if (!changed) return true;
+
+	vector<X86BinBlock*> cachedBlocks;
+	binBlocks.getBinBlocks(&cachedBlocks);
+	if (!translationCache->saveFile(path, cachedBlocks)) return false;
+	changed = false;
+
+	return true;
+}
@@ -0,0 +1,147 @@
+/*
+	Written By Pradipna Nepal
+	www.pradsprojects.com
+
+	Copyright (C) 2013 Pradipna Nepal
+	Please read COPYING.txt included along with this source code for more detail.
+	If not included, see http://www.gnu.org/licenses/
+*/
+
+#ifndef X86_CODE_CACHE_H
+#define X86_CODE_CACHE_H
+
+#include <vector>
+#include <map>
+#include <set>
+#include <string>
+#include <mutex>
+#include <atomic>
+#include "build.h"
+#include "declarations.h"
+#include "x86BinBlock.h"
+#include "x86BinBlockCache.h"
+#include "x86CodeArena.h"
+#include "x86TranslationCache.h"
+#include "x86PerfMap.h"
+
+//A core that runs code from an X86CodeCache. passes is increased every time the core is back in
+//startCPULoop, where it runs no translated code and lets go of the blocks it found before.
+struct X86CodeCacheUser {
+	std::atomic<uint64> passes;
+
+	X86CodeCacheUser() {
+		passes = 0;
+	}
+};
+
+//Guest code that host code of a translated block came from
+struct X86GuestLocation {
+	int64 blockAddress;	//Start of the block
+	bool trace;
+	int64 address;	//Guest instruction
+};
+
+//Translated blocks of a program with the code arena and the dispatcher they run in. Translated code
+//reaches the state of the core that runs it through the context register, so every thread of the
+//program can share one cache and a block is translated once for all of them.
+//Blocks are looked up without locking, by find and by the dispatcher. Everything that changes the
+//cache takes lock. A block that is replaced or flushed may still be running on other cores, so it is
+//retired: it is taken out of the cache at once and deleted when every user has gone back to
+//startCPULoop twice, which is when no core can be in it or still hold one of its exits.
+class X86CodeCache {
+private:
+	struct RetiredBlocks {
+		std::vector<X86BinBlock*> binBlocks;
+		std::map<X86CodeCacheUser*, uint64> passes;	//Passes of every user that may be running the blocks, when they were retired
+	};
+
+	std::mutex lock;
+	X86CodeArena codeArena;
+	X86BinBlockCache binBlocks;
+	std::map<const uint8*, X86BinBlock*> codeBlocks;	//Inserted blocks by their code, until they are deleted
+	size_t blockCount;
+	bool changed;	//Blocks were translated since the cache was last loaded or saved
+	X86BinBlock *dispatcherBlock;
+	uint32 dispatcherIndirectIndex;
+	uint32 dispatcherExitIndex;
+	std::set<X86CodeCacheUser*> users;
+	std::vector<RetiredBlocks> retired;
+	std::atomic<size_t> retiredCount;
+	std::atomic<uint64> retirements;
+	X86PerfMap *perfMap;	//0 unless perf is told about the blocks
+
+	//These expect lock to be held
+	X86BinBlock *insertBinBlock(X86BinBlock *binBlock);
+	void linkBlockExits(X86BinBlock *binBlock);
+	void linkBlockExit(X86BinBlockExit *blockExit, X86BinBlock *target);
+	void unlinkBlockExit(X86BinBlockExit *blockExit);
+	void detachBinBlock(X86BinBlock *binBlock);
+	void retire(const std::vector<X86BinBlock*> &binBlocks, X86CodeCacheUser *caller);
+	void insertLoadedBlocks(const std::vector<X86BinBlock*> &loadedBlocks);
+
+public:
+	X86CodeCache(uint64 codeSize);
+	~X86CodeCache();
+
+	//Returns 0 if address has not been translated
+	X86BinBlock *find(int64 address) const {
+		return binBlocks.find(address);
+	}
+	bool isEmpty();
+	uint64 getCodeSize();
+	uint8 ***getEntryPages();
+	//Bytes of translated code in the arena, retired blocks and the dispatcher included
+	uint64 getTranslatedSize();
+
+	//Finds the block that code is in, retired ones included. Returns false if code is not in a block,
+	//which includes the dispatcher.
+	bool findGuestLocation(const uint8 *code, X86GuestLocation *location);
+
+	//Every block that is inserted from now on, and the dispatcher, is added to perfMap
+	void setPerfMap(X86PerfMap *perfMap);
+
+	void addUser(X86CodeCacheUser *user);
+	void removeUser(X86CodeCacheUser *user);
+	bool hasRetired() const {
+		return retiredCount != 0;
+	}
+	//Times blocks were retired. Cores that keep addresses of code in blocks let go of them when it
+	//changed, before they run any block after they went back to startCPULoop.
+	uint64 getRetirements() const {
+		return retirements;
+	}
+	//Deletes the retired blocks no user can be running anymore
+	void collect();
+
+	//Installs the dispatcher of the first core, the ones that come later are deleted. Returns false if
+	//the arena is full.
+	bool setDispatcher(X86BinBlock *dispatcherBlock, uint32 indirectIndex, uint32 exitIndex);
+	X86BinBlock *getDispatcher();
+	uint8 *getDispatcherIndirect();
+	uint8 *getDispatcherExit();
+
+	//Moves a translated block to the code arena. Returns false if the arena is full.
+	bool install(X86BinBlock *binBlock);
+	//Deletes an installed block that was not inserted
+	void discard(X86BinBlock *binBlock);
+	//Makes an installed block the one that runs at its start address and returns it. A trace replaces a
+	//block that is not a trace and is linked to the blocks it leads to. If the address has a block that
+	//stays, binBlock is deleted and that block is returned.
+	X86BinBlock *insert(X86BinBlock *binBlock);
+	//Makes blockExit jump straight into target, unless either of them was retired
+	void link(X86BinBlockExit *blockExit, X86BinBlock *target);
+	//Makes an entry of an inline cache jump straight into target when it jumps to its start, and the
+	//misses of the cache go to the next entry. Nothing changes if the entry is filled already.
+	void fillInlineCache(X86BinBlockExit *entry, X86BinBlock *target);
+	//Retires every block, caller must not hold any of them anymore
+	void flush(X86CodeCacheUser *caller);
+
+	//Same as X86TranslationCache, the blocks are inserted the way insert does it
+	bool load(X86TranslationCache *translationCache, const std::vector<uint8> &image);
+	bool loadFile(X86TranslationCache *translationCache, const std::string &path);
+	void save(X86TranslationCache *translationCache, std::vector<uint8> *image);
+	//Only writes the file if blocks were translated since the cache was loaded
+	bool saveFile(X86TranslationCache *translationCache, const std::string &path);
+};
+
+#endif
@@ -0,0 +1,104 @@
+/*
+	Written By Pradipna Nepal
+	www.pradsprojects.com
+
+	Copyright (C) 2013 Pradipna Nepal
+	Please read COPYING.txt included along with this source code for more detail.
+	If not included, see http://www.gnu.org/licenses/
+*/
+
+#include "x86CompileQueue.h"
+#include "x86DynaRecCore.h"
+using namespace std;
+
+X86CompileQueue::X86CompileQueue(uint8 *codePtr, uint8 *globalDataPtr, GPUCore *gpuCore, DespairHeader::ExecutableHeader *header, KeyboardManager *keyboardManager, uint32 threadCount) {
+	stopping = false;
+	for (uint32 i = 0; i < threadCount; ++i) {
+		cores.push_back(new X86DynaRecCore(codePtr, globalDataPtr, header->part1.codeOffset, 0, gpuCore, header, keyboardManager, 0));
+	}
+	for (uint32 i = 0; i < threadCount; ++i) {
+		threads.push_back(thread(&X86DynaRecCore::translateCompileRequests, cores[i], this));
+	}
+}
+
+X86CompileQueue::~X86CompileQueue() {
+	{
+		lock_guard<mutex> guard(lock);
+		stopping = true;
+		changed.notify_all();
+	}
+
+	for (size_t i = 0; i < threads.size(); ++i) {
+		threads[i].join();
+		delete cores[i];
+	}
+}
+
+X86CompileClient *X86CompileQueue::connect() {
+	X86CompileClient *client = new X86CompileClient;
+	client->readyCount = 0;
+	client->inFlight = 0;
+	return client;
+}
+
+void X86CompileQueue::disconnect(X86CompileClient *client) {
+	unique_lock<mutex> guard(lock);
+
+	for (size_t i = 0; i < requests.size();) {
+		if (requests[i].client == client) {
+			requests.erase(requests.begin() + i);
+		} else {
+			++i;
+		}
+	}
+	while (client->inFlight) {
+		changed.wait(guard);
+	}
+	delete client;
+}
+
+void X86CompileQueue::request(X86CompileClient *client, const vector<int64> &path, bool closesLoop) {
+	lock_guard<mutex> guard(lock);
+	X86CompileRequest compileRequest;
+
+	compileRequest.client = client;
+	compileRequest.path = path;
+	compileRequest.closesLoop = closesLoop;
+	requests.push_back(compileRequest);
+	changed.notify_one();
+}
+
+void X86CompileQueue::takeResults(X86CompileClient *client, vector<X86CompileResult> *results) {
+	lock_guard<mutex> guard(lock);
+
+	results->swap(client->results);
+	client->results.clear();
+	client->readyCount = 0;
+}
+
+bool X86CompileQueue::pop(X86CompileRequest *request) {
+	unique_lock<mutex> guard(lock);
+
+	while (requests.empty() && !stopping) {
+		changed.wait(guard);
+	}
+	if (stopping) return false;
+
+	*request = requests.front();
+	requests.pop_front();
+	++request->client->inFlight;
+	return true;
+}
+
+void X86CompileQueue::finish(const X86CompileRequest &request, X86CompileResult *result) {
+	lock_guard<mutex> guard(lock);
+	X86CompileClient *client = request.client;
+
+	client->results.push_back(X86CompileResult());
+	client->results.back().startAddress = result->startAddress;
+	client->results.back().trace = result->trace;
+	client->results.back().image.swap(result->image);
+	++client->readyCount;
+	--client->inFlight;
+	changed.notify_all();
+}
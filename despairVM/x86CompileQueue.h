@@ -0,0 +1,76 @@
+/*
+	Written By Pradipna Nepal
+	www.pradsprojects.com
+
+	Copyright (C) 2013 Pradipna Nepal
+	Please read COPYING.txt included along with this source code for more detail.
+	If not included, see http://www.gnu.org/licenses/
+*/
+
+#ifndef X86_COMPILE_QUEUE_H
+#define X86_COMPILE_QUEUE_H
+
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <condition_variable>
+#include "build.h"
+#include "declarations.h"
+#include "gpuCore.h"
+#include "keyboardManager.h"
+#include "despairHeader.h"
+
+class X86DynaRecCore;
+struct X86CompileClient;
+
+//Block or trace a core wants translated. The path is translated the way translateBlocks does it.
+struct X86CompileRequest {
+	X86CompileClient *client;
+	std::vector<int64> path;
+	bool closesLoop;
+};
+
+struct X86CompileResult {
+	int64 startAddress;
+	bool trace;
+	std::vector<uint8> image;	//In the X86TranslationCache format, empty if it could not be translated
+};
+
+//Results for one core. Only the core takes them, so it checks readyCount before it takes the lock.
+struct X86CompileClient {
+	std::vector<X86CompileResult> results;
+	std::atomic<uint32> readyCount;
+	uint32 inFlight;	//Requests a worker is translating right now
+};
+
+//Translates blocks for the cores that run a program on a pool of worker threads, so that the guest
+//threads keep running while their hot code is translated. Every worker translates with a core of
+//its own and hands the code over as a relocatable image, which the requesting core installs in its
+//block cache between two blocks.
+class X86CompileQueue {
+private:
+	std::mutex lock;
+	std::condition_variable changed;
+	std::deque<X86CompileRequest> requests;
+	std::vector<X86DynaRecCore*> cores;
+	std::vector<std::thread> threads;
+	bool stopping;
+
+public:
+	X86CompileQueue(uint8 *codePtr, uint8 *globalDataPtr, GPUCore *gpuCore, DespairHeader::ExecutableHeader *header, KeyboardManager *keyboardManager, uint32 threadCount);
+	~X86CompileQueue();
+
+	X86CompileClient *connect();
+	//Drops the requests of client that were not translated yet and waits for the ones that are
+	void disconnect(X86CompileClient *client);
+	void request(X86CompileClient *client, const std::vector<int64> &path, bool closesLoop);
+	void takeResults(X86CompileClient *client, std::vector<X86CompileResult> *results);
+
+	//Used by the workers. pop returns false once the queue is being destroyed.
+	bool pop(X86CompileRequest *request);
+	void finish(const X86CompileRequest &request, X86CompileResult *result);
+};
+
+#endif
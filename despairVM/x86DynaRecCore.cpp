@@ -10,143 +10,1391 @@
 #include "build.h"
 #include "declarations.h"
 
-#ifdef BUILD_FOR_WINDOWS
-#include <Windows.h>
-#endif
-
 #include <vector>
+#include <map>
+#include <algorithm>
+#include <iostream>
 #include <cmath>
+#include <cstddef>
 #include <time.h>
+#include <thread>
+#include <chrono>
 #include "x86DynaRecCore.h"
 #include "x86_64Emitter.h"
+#include "x86HostCall.h"
 #include "instructionsSet.h"
+#include "instructionsInfo.h"
+#include "irOptimizer.h"
 using namespace X86_64Emitter;
 using namespace std;
 
 #define FD_CYCLE_CONTINUE			1
-#define FD_CYCLE_BREAK_MASK			0x80
-#define FD_CYCLE_BREAK_JMP			0x80
-#define FD_CYCLE_BREAK_JMPR			0x81
-#define FD_CYCLE_BREAK_JC			0x82
-#define FD_CYCLE_BREAK_JCR			0x83
-#define FD_CYCLE_BREAK_CALL			0x84
-#define FD_CYCLE_BREAK_RET			0x85
-#define FD_CYCLE_JMP_R				0x86
-#define FD_CYCLE_JMPR_R				0x87
-#define FD_CYCLE_JC_R_R				0x88
-#define FD_CYCLE_JCR_R_R			0x89
+#define FD_CYCLE_BLOCK_END			2
 #define FD_CYCLE_END				0x8A
 
+#define TRACE_HOT_COUNT				50	//Times an exit goes through the dispatcher before it is linked
+#define TRACE_MAX_BLOCKS			16
+
+#define INLINE_CACHE_SIZE			4	//Blocks a register jump goes straight to before it looks them up
+
+#define DEFAULT_JIT_THRESHOLD		8	//Times a block is interpreted before it is translated
+
+#define TRANSLATION_CODE_VERSION	1	//Bump whenever translated code changes, translation caches of other versions are not loaded
+
+#define DISPATCHER_STACK_SIZE		(HOST_CALL_SHADOW_SPACE + 8)	//Keeps rsp 16 byte aligned inside the blocks
+#define DISPATCHER_XMM_SAVE_SIZE	(REG_ALLOCATOR_HOST_FREGS << 4)
+
 DespairTimer X86DynaRecCore::timer;
+uint32 X86DynaRecCore::jitThreshold = DEFAULT_JIT_THRESHOLD;
+X86BlockProfiler *X86DynaRecCore::profiler = 0;
+atomic<uint64> X86DynaRecCore::translatedBlocks(0);
+atomic<uint64> X86DynaRecCore::translationTime(0);
+
+static const X86_64Register dispatcherSavedRegs[] = { rbx, rbp, rsi, rdi, r12, r13, r14, r15 };
+
+//IN and OUT with an immediate port number are a load or store into the ports when the port is plain,
+//the others call PortManager
+static bool isDirectPortAccess(uint16 opcode, const uint8 *operands) {
+	uint32 port;
+	int size;
+	bool write = true;
+
+	switch (opcode) {
+		case _OUT_IMMI_R8:
+		case _OUT_IMMI_R16:
+		case _OUT_IMMI_R32:
+		case _OUT_IMMI_R64:
+			port = *(uint32*)&operands[1];
+			size = 1 << (opcode - _OUT_IMMI_R8);
+			break;
+		case _OUT_IMMI_IMMI8:
+		case _OUT_IMMI_IMMI16:
+		case _OUT_IMMI_IMMI32:
+		case _OUT_IMMI_IMMI64:
+			port = *(uint32*)&operands[0];
+			size = 1 << (opcode - _OUT_IMMI_IMMI8);
+			break;
+		case _IN_R8_IMMI:
+		case _IN_R16_IMMI:
+		case _IN_R32_IMMI:
+		case _IN_R64_IMMI:
+			port = *(uint32*)&operands[1];
+			size = 1 << (opcode - _IN_R8_IMMI);
+			write = false;
+			break;
+		case _FOUT_IMMI_FR:	//writePortAsFloat only stores the value
+		case _FIN_IMMI_FR:
+			port = *(uint32*)&operands[1];
+			size = 4;
+			write = false;
+			break;
+		case _FOUT_IMMI_FIMMI:
+			port = *(uint32*)&operands[0];
+			size = 4;
+			write = false;
+			break;
+		default:
+			return false;
+	}
+	if (write && !PortManager::isPlainPort(port)) return false;
+
+	return ((uint64)port + size <= PORTS_NUMBER);
+}
+
+//Instructions whose handlers get their registers from regAllocator, the others are translated with
+//the registers written back to memory and reload the ones they change
+static bool usesRegAllocator(uint16 opcode, const uint8 *operands) {
+	if (isDirectPortAccess(opcode, operands)) return true;
+
+	switch (opcode) {
+		case _MOV_R_MR_IMMI:
+		case _MOV_MR_IMMI_R:
+		case _MOV_MR_IMMI_MR_IMMI:
+		case _MOV_MR_IMMI_IMMI:
+		case _MOV_M_M:
+		case _MOV_MR_R:
+		case _MOV_R_MR:
+		case _MOV_MR_M:
+		case _MOV_M_MR:
+		case _MOV_MR_MR:
+		case _MOV_MR_IMMI:
+		case _NOP:
+		case _MOVP_R_MR_IMMI:
+		case _MOVP_MR_IMMI_R:
+		case _MOVP_MR_IMMI_MR_IMMI:
+		case _MOVP_R_MR:
+		case _MOVP_MR_R:
+		case _PUSH_R:
+		case _POP_R:
+		case _FCON_R_FR:
+		case _FCON_FR_R:
+		case _FCON_FR_IMMI:
+		case _FCON_R_FIMMI:
+		case _FMOV_FR_FR:
+		case _FMOV_FR_MFR_IMMI:
+		case _FMOV_MFR_IMMI_FR:
+		case _FMOV_MFR_IMMI_MFR_IMMI:
+		case _FMOV_FR_FIMMI:
+		case _FMOV_MFR_IMMI_FIMMI:
+		case _FMOV_FR_FM:
+		case _FMOV_FM_FR:
+		case _FMOV_FR_MFR:
+		case _FMOV_MFR_FR:
+		case _FMOV_FM_MFR:
+		case _FMOV_MFR_FM:
+		case _FMOV_MFR_MFR:
+		case _FMOV_FM_FM:
+		case _FMOV_FM_FIMMI:
+		case _FMOV_MFR_FIMMI:
+		case _FADD_FR_FR:
+		case _FADD_FR_FIMMI:
+		case _FSUB_FR_FR:
+		case _FSUB_FR_FIMMI:
+		case _FMUL_FR_FR:
+		case _FMUL_FR_FIMMI:
+		case _FDIV_FR_FR:
+		case _FDIV_FR_FIMMI:
+		case _BMOV_BM_BM:
+		case _BMOV_BM_IMMI8:
+		case _FPUSH_FR:
+		case _FPOP_FR:
+			return true;
+		default:
+			return false;
+	}
+}
+
+//Smallest mov that zero extends immi into reg
+static int putIRImmediate(X86BinBlock *binBlock, X86_64Register reg, uint64 immi) {
+	if (immi <= 0xFFFFFFFF) {
+		return movReg32Immi32(binBlock, reg, (uint32)immi);
+	}
+	return movReg64Immi64(binBlock, reg, immi);
+}
+
+//Jump that is taken when the comparison is true
+static int (*getConditionJump(IROpcode opcode))(X86BinBlock*, uint32) {
+	switch (opcode) {
+		case IR_CMPE:
+			return jeRel32;
+		case IR_CMPNE:
+			return jneRel32;
+		case IR_CMPG:
+			return jgRel32;
+		case IR_CMPL:
+			return jlRel32;
+		case IR_CMPGE:
+			return jgeRel32;
+		default:
+			return jleRel32;
+	}
+}
 
-X86DynaRecCore::X86DynaRecCore(uint8 *codePtr, uint8 *globalDataPtr, uint32 codeStartIndex, uint64 paramAddr, GPUCore *gpuCore, DespairHeader::ExecutableHeader *header, KeyboardManager *keyboardManager)
-					: memManager(header->part1.stackSize, header->part1.dataSize, codePtr, globalDataPtr) {
+//Jump that is taken when the comparison is false
+static int (*getInverseConditionJump(IROpcode opcode))(X86BinBlock*, uint32) {
+	switch (opcode) {
+		case IR_CMPE:
+			return jneRel32;
+		case IR_CMPNE:
+			return jeRel32;
+		case IR_CMPG:
+			return jleRel32;
+		case IR_CMPL:
+			return jgeRel32;
+		case IR_CMPGE:
+			return jlRel32;
+		default:
+			return jgRel32;
+	}
+}
+
+//Divides the 128 bit high:low by divisor, high has to be less than divisor so the quotient fits
+static uint64 divide128(uint64 high, uint64 low, uint64 divisor, uint64 *remainder) {
+	uint64 quotient = 0;
+
+	for (int i = 0; i < 64; ++i) {
+		bool carry = (high >> 63) != 0;
+		high = (high << 1) | (low >> 63);
+		low <<= 1;
+		quotient <<= 1;
+		if (carry || high >= divisor) {
+			high -= divisor;
+			quotient |= 1;
+		}
+	}
+	*remainder = high;
+	return quotient;
+}
+
+//Magic number that turns unsigned division by divisor, which is not a power of two, into the high half
+//of a multiply and a shift. When it takes 65 bits, add is set and the top bit is added back after the
+//multiply. See Granlund and Montgomery, "Division by Invariant Integers using Multiplication".
+static void getDivisionMagic(uint64 divisor, uint64 *magic, uint8 *shift, bool *add) {
+	uint8 log2 = 63;
+	while (!(divisor >> log2)) {
+		--log2;
+	}
+
+	//floor(2^(64 + log2) / divisor)
+	uint64 remainder;
+	uint64 proposed = divide128((uint64)1 << log2, 0, divisor, &remainder);
+
+	if (divisor - remainder < ((uint64)1 << log2)) {
+		*add = false;
+	} else {
+		uint64 twiceRemainder = remainder + remainder;
+		proposed += proposed;
+		if (twiceRemainder >= divisor || twiceRemainder < remainder) ++proposed;
+		*add = true;
+	}
+	*magic = proposed + 1;
+	*shift = log2;
+}
+
+static bool isCompare(IROpcode opcode) {
+	return opcode >= IR_CMPE && opcode <= IR_CMPLE;
+}
+
+//Size of the exit putBlockExit puts at index, with the nops that align its offset
+static uint32 getBlockExitSize(uint32 index) {
+	return ((3 - (index & 3)) & 3) + BLOCK_EXIT_SIZE;
+}
+
+//Where a JC_R_IMMI or JCR_R_IMMI goes when it is taken
+static int64 getConditionalBranchTarget(const IRInstruction &instruction, const uint8 *codeSpace) {
+	const uint8 *operands = &codeSpace[instruction.address + 2];
+
+	if (instruction.despairOpcode == _JC_R_IMMI) {
+		return *(uint32*)&operands[1];
+	}
+	return instruction.address + 7 + *(int32*)&operands[1];
+}
+
+X86DynaRecCore::X86DynaRecCore(uint8 *codePtr, uint8 *globalDataPtr, uint32 codeStartIndex, uint64 paramAddr, GPUCore *gpuCore, DespairHeader::ExecutableHeader *header, KeyboardManager *keyboardManager,
+								X86SharedTranslation *sharedTranslation)
+					: memManager(header->part1.stackSize, header->part1.dataSize, codePtr, globalDataPtr), regAllocator(getContextOffset(regs), getContextOffset(fRegs)),
+					interpreterCore(regs, fRegs, &sP, &memManager, &portManager, gpuCore, &timer, header->part1.codeSize),
+					translationCache(TRANSLATION_CODE_VERSION, header->part1.codeSize) {
 	regs[0xFF] = (uint64)memManager.dataSpace;
 	regs[0xFE] = (uint64)memManager.globalDataSpace;
 	if (paramAddr != 0) *(uint64*)&memManager.dataSpace[0] = paramAddr;
 	sP = 0;
 	pC = codeStartIndex;
 	this->gpuCore = gpuCore;
-	portManager.initializePortManager(gpuCore, memManager.codeSpace, memManager.globalDataSpace, header, keyboardManager);
+	portManager.initializePortManager(gpuCore, memManager.codeSpace, memManager.globalDataSpace, header, keyboardManager, sharedTranslation);
 	immediateFloat = 0;
+	profileCycles = X86BlockProfiler::readCycleCounter();
+	profileBlock = (profiler) ? profiler->getUntranslatedProfile() : 0;
+	ownsCodeCache = !sharedTranslation || !sharedTranslation->codeCache;
+	codeCache = (ownsCodeCache) ? new X86CodeCache(header->part1.codeSize) : sharedTranslation->codeCache;
+	codeCache->addUser(&cacheUser);
+	clearShadowStack();
+	createDispatcherBlock();
+	initializeTranslationCache(header);
+	//The first core of the program loads the image for all of them
+	if (sharedTranslation && !sharedTranslation->image.empty() && codeCache->isEmpty()) loadTranslationImage(sharedTranslation->image);
+	compileQueue = (sharedTranslation) ? sharedTranslation->compileQueue : 0;
+	compileClient = (compileQueue) ? compileQueue->connect() : 0;
 	//As far as I know, microsoft compiler needs srand to be called in each thread
 #ifdef USING_MICROSOFT_COMPILER
 	srand(time(0));
 #endif
 }
 
-X86DynaRecCore::~X86DynaRecCore() {
-	//Flush the cache
-	for (X86BinBlockCache::iterator it = x86BinBlockCache.begin(); it != x86BinBlockCache.end(); ++it) {
-		delete it->second;
-	}
+X86DynaRecCore::~X86DynaRecCore() {
+	if (compileClient) compileQueue->disconnect(compileClient);
+	codeCache->removeUser(&cacheUser);
+	if (ownsCodeCache) delete codeCache;
+}
+
+void X86DynaRecCore::startCPULoop() {
+	X86BinBlockExit *lastExit = 0;
+
+	while (true) {
+		X86BinBlock *binBlock;
+
+		if (pC < 0) {
+			return;
+		}
+
+		//No translated code runs here, so the blocks this core found before can be deleted once retired
+		++cacheUser.passes;
+		if (codeCache->hasRetired()) codeCache->collect();
+
+		//Blocks translated in the background go in the cache between two blocks, while no translated code runs
+		if (compileClient && compileClient->readyCount) installCompiledBlocks(&lastExit);
+
+		//Check if the code is already in cache
+		binBlock = codeCache->find(pC);
+		if (!binBlock) {
+			bool compiling = compilingBlocks.count(pC) != 0;
+
+			//Code that ran only a few times is cheaper to interpret than to translate. Hot code is interpreted
+			//until compileQueue has translated it, if there is one.
+			if (interpreterCore.runBlock(&pC, (compiling) ? INTERPRETER_NO_THRESHOLD : jitThreshold)
+					|| (!compiling && requestBlock(pC) && interpreterCore.runBlock(&pC, INTERPRETER_NO_THRESHOLD))) {
+				lastExit = 0;
+				continue;
+			}
+			binBlock = createNewBinBlock();
+			if (!binBlock) {
+				//Code arena is full, start over with an empty cache. Other cores still run the old blocks
+				//until they are back here, the block is interpreted if they take all the space meanwhile.
+				codeCache->flush(&cacheUser);
+				lastExit = 0;
+				codeCache->collect();
+				binBlock = createNewBinBlock();
+				if (!binBlock) {
+					if (!interpreterCore.runBlock(&pC, INTERPRETER_NO_THRESHOLD)) return;
+					continue;
+				}
+			}
+		}
+
+		//The previous block left through an exit that is not linked yet. Exits are only linked once they
+		//are hot, so until then they count which way the branches of the block go. Inline caches
+		//take the first blocks their jump goes to.
+		if (lastExit && lastExit->compareIndex) {
+			codeCache->fillInlineCache(lastExit, binBlock);
+		} else if (lastExit && ++lastExit->executionCount >= TRACE_HOT_COUNT) {
+			//A hot backward branch closes a loop, the loop body becomes one trace starting at its target
+			if (lastExit->targetAddress <= lastExit->owner->startAddress && !binBlock->trace) {
+				X86BinBlock *lastExitOwner = lastExit->owner;
+				X86BinBlock *trace = 0;
+
+				if (compileQueue) {
+					requestTrace(binBlock);
+				} else {
+					trace = createTrace(binBlock);
+				}
+				if (trace) {
+					//The head block is retired along with its exits
+					if (lastExitOwner == binBlock) lastExit = 0;
+					binBlock = trace;
+				}
+			}
+			if (lastExit) codeCache->link(lastExit, binBlock);
+		}
+		lastExit = executeBlock(binBlock);
+	}
+}
+
+int64 X86DynaRecCore::getRegister(uint8 reg) {
+	return regs[reg];
+}
+
+void X86DynaRecCore::setJITThreshold(uint32 threshold) {
+	jitThreshold = threshold;
+}
+
+void X86DynaRecCore::setProfiler(X86BlockProfiler *profiler) {
+	X86DynaRecCore::profiler = profiler;
+}
+
+uint64 X86DynaRecCore::getTranslatedBlockCount() {
+	return translatedBlocks;
+}
+
+uint64 X86DynaRecCore::getTranslationTime() {
+	return translationTime;
+}
+
+//Tells the translation cache where everything translated code refers to is in this run. The functions
+//are taken the same way the handlers take them, so that they have the same address.
+void X86DynaRecCore::initializeTranslationCache(DespairHeader::ExecutableHeader *header) {
+	void (*drawPtr)(int, int, uint64, X86DynaRecCore*) = draw;
+	void (*writePort8)(uint8, uint32, PortManager*) = PortManager::writePort;
+	void (*writePort16)(uint16, uint32, PortManager*) = PortManager::writePort;
+	void (*writePort32)(uint32, uint32, PortManager*) = PortManager::writePort;
+	void (*writePort64)(uint64, uint32, PortManager*) = PortManager::writePort;
+	uint8 (*readPort8)(uint32, PortManager*) = PortManager::readPort;
+	uint16 (*readPort16)(uint32, PortManager*) = PortManager::readPort;
+	uint32 (*readPort32)(uint32, PortManager*) = PortManager::readPort;
+	uint64 (*readPort64)(uint32, PortManager*) = PortManager::readPort;
+	void (*writePortFloatPtr)(float32, uint32, PortManager*) = PortManager::writePortAsFloat;
+	float32 (*readPortFloatPtr)(uint32, PortManager*) = PortManager::readPortAsFloat;
+	float32 (*fmodPtr)(float32, float32) = fmod;
+	uint64 (*timerPtr)(DespairTimer*) = timer.getMilliseconds;
+	void (*sleepPtr)(uint32) = DespairTimer::sleep;
+	int (*randPtr)() = rand;
+
+	translationCache.setRegion(RELOCATION_CORE, this, sizeof(*this));
+	translationCache.setRegion(RELOCATION_TIMER, &timer, sizeof(timer));
+	translationCache.setRegion(RELOCATION_STACK, memManager.stackSpace, header->part1.stackSize);
+	translationCache.setRegion(RELOCATION_GLOBAL_DATA, memManager.globalDataSpace, header->part1.globalDataSize);
+	if (codeCache->getDispatcher()) {
+		translationCache.setRegion(RELOCATION_DISPATCHER, codeCache->getDispatcher()->getBinBuffer(), codeCache->getDispatcher()->getCounter());
+	}
+
+	translationCache.addHostFunction((uint64)drawPtr);
+	translationCache.addHostFunction((uint64)writePort8);
+	translationCache.addHostFunction((uint64)writePort16);
+	translationCache.addHostFunction((uint64)writePort32);
+	translationCache.addHostFunction((uint64)writePort64);
+	translationCache.addHostFunction((uint64)readPort8);
+	translationCache.addHostFunction((uint64)readPort16);
+	translationCache.addHostFunction((uint64)readPort32);
+	translationCache.addHostFunction((uint64)readPort64);
+	translationCache.addHostFunction((uint64)writePortFloatPtr);
+	translationCache.addHostFunction((uint64)readPortFloatPtr);
+	translationCache.addHostFunction((uint64)fmodPtr);
+	translationCache.addHostFunction((uint64)timerPtr);
+	translationCache.addHostFunction((uint64)sleepPtr);
+	translationCache.addHostFunction((uint64)randPtr);
+}
+
+bool X86DynaRecCore::loadTranslationImage(const vector<uint8> &image) {
+	return pC >= 0 && codeCache->load(&translationCache, image);
+}
+
+bool X86DynaRecCore::loadTranslationCache(const string &path) {
+	return pC >= 0 && codeCache->loadFile(&translationCache, path);
+}
+
+bool X86DynaRecCore::saveTranslationCache(const string &path) {
+	return codeCache->saveFile(&translationCache, path);
+}
+
+void X86DynaRecCore::translateProgram(uint8 *codePtr, uint8 *globalDataPtr, GPUCore *gpuCore, DespairHeader::ExecutableHeader *header, KeyboardManager *keyboardManager,
+										uint32 threadCount, vector<uint8> *image) {
+	X86TranslationWorklist worklist(codePtr, header->part1.codeSize);
+	vector<X86DynaRecCore*> cores;
+	vector<thread> threads;
+
+	//Every thread translates with a core of its own, the code refers to that core
+	if (threadCount == 0) threadCount = 1;
+	for (uint32 i = 0; i < threadCount; ++i) {
+		cores.push_back(new X86DynaRecCore(codePtr, globalDataPtr, header->part1.codeOffset, 0, gpuCore, header, keyboardManager, 0));
+	}
+
+	worklist.push(header->part1.codeOffset);
+	for (uint32 i = 1; i < threadCount; ++i) {
+		threads.push_back(thread(&X86DynaRecCore::translateWorklist, cores[i], &worklist));
+	}
+	cores[0]->translateWorklist(&worklist);
+	for (size_t i = 0; i < threads.size(); ++i) {
+		threads[i].join();
+	}
+
+	//The blocks of the other cores are relocated into the first one, which writes them all to image
+	for (uint32 i = 1; i < threadCount; ++i) {
+		vector<uint8> coreImage;
+
+		cores[i]->codeCache->save(&cores[i]->translationCache, &coreImage);
+		cores[0]->loadTranslationImage(coreImage);
+		delete cores[i];
+	}
+
+	cores[0]->codeCache->save(&cores[0]->translationCache, image);
+	delete cores[0];
+}
+
+void X86DynaRecCore::translateWorklist(X86TranslationWorklist *worklist) {
+	int64 address;
+
+	while (worklist->pop(&address)) {
+		vector<int64> successors;
+
+		//Blocks that would run into data or past the end of the code are left to startCPULoop
+		if (pC >= 0 && worklist->scanBlock(address, &successors)) {
+			pC = address;
+			X86BinBlock *binBlock = createNewBinBlock();
+
+			if (binBlock) {
+				for (size_t i = 0; i < binBlock->exits.size(); ++i) {
+					successors.push_back(binBlock->exits[i]->targetAddress);
+				}
+			}
+		}
+		worklist->finish(successors);
+	}
+}
+
+//Runs on a thread of compileQueue. The blocks are handed over as images, this core does not keep them.
+void X86DynaRecCore::translateCompileRequests(X86CompileQueue *compileQueue) {
+	X86CompileRequest request;
+
+	while (compileQueue->pop(&request)) {
+		X86CompileResult result;
+		X86BinBlock *binBlock = (pC >= 0) ? translateBlocks(request.path, request.closesLoop) : 0;
+
+		result.startAddress = request.path[0];
+		result.trace = (request.path.size() > 1 || request.closesLoop);
+		if (binBlock) {
+			vector<X86BinBlock*> binBlocks(1, binBlock);
+			translationCache.save(binBlocks, &result.image);
+			codeCache->discard(binBlock);
+		}
+		compileQueue->finish(request, &result);
+	}
+}
+
+//Asks compileQueue to translate the block at address. Returns false if blocks are translated on this thread.
+bool X86DynaRecCore::requestBlock(int64 address) {
+	if (!compileQueue) return false;
+
+	if (compilingBlocks.insert(address).second) compileQueue->request(compileClient, vector<int64>(1, address), false);
+	return true;
+}
+
+//Asks compileQueue for the trace createTrace would make, head keeps running until the trace is installed
+void X86DynaRecCore::requestTrace(X86BinBlock *head) {
+	vector<int64> path;
+	bool closesLoop;
+
+	if (compilingTraces.count(head->startAddress)) return;
+	selectTracePath(head->startAddress, &path, &closesLoop);
+	if (path.size() == 1 && !closesLoop) return;
+
+	compilingTraces.insert(head->startAddress);
+	compileQueue->request(compileClient, path, closesLoop);
+}
+
+void X86DynaRecCore::installCompiledBlocks(X86BinBlockExit **lastExit) {
+	vector<X86CompileResult> results;
+
+	compileQueue->takeResults(compileClient, &results);
+	for (size_t i = 0; i < results.size(); ++i) {
+		const X86CompileResult &result = results[i];
+
+		if (result.trace) {
+			compilingTraces.erase(result.startAddress);
+		} else {
+			compilingBlocks.erase(result.startAddress);
+		}
+		if (result.image.empty()) continue;
+
+		//A trace takes the place of its first block, like in createTrace
+		if (!codeCache->load(&translationCache, result.image)) {
+			//Code arena is full, start over with an empty cache
+			codeCache->flush(&cacheUser);
+			*lastExit = 0;
+			codeCache->collect();
+			codeCache->load(&translationCache, result.image);
+		}
+	}
+}
+
+void X86DynaRecCore::createDispatcherBlock() {
+	int savedRegCount = sizeof(dispatcherSavedRegs) / sizeof(X86_64Register);
+	uint32 missJumps[3];	//Index right after each jump to the miss path
+	X86BinBlock *dispatcherBlock = new X86BinBlock;
+
+	//Entry: X86BinBlockExit *(*)(uint8 *block, uint8 *context), context is CONTEXT_REGISTER_BIAS bytes into the core
+	for (int i = 0; i < savedRegCount; ++i) {
+		pushReg64(dispatcherBlock, dispatcherSavedRegs[i]);
+	}
+#ifdef HOST_CALL_MICROSOFT_X64
+	//xmm6 - xmm15 are callee saved in the Microsoft ABI and the register allocator uses xmm8 - xmm15
+	subReg64Immi32(dispatcherBlock, rsp, DISPATCHER_XMM_SAVE_SIZE);
+	for (int i = 0; i < REG_ALLOCATOR_HOST_FREGS; ++i) {
+		movupsMRegDisp8XMM(dispatcherBlock, rsp, i << 4, X86RegAllocator::hostFRegs[i]);	//movups (rsp + i * 16), xmm
+	}
+#endif
+	subReg64Immi32(dispatcherBlock, rsp, DISPATCHER_STACK_SIZE);
+#ifdef HOST_CALL_MICROSOFT_X64
+	movReg64Reg64(dispatcherBlock, CONTEXT_REGISTER, rdx);	//mov r15, rdx
+	jmpReg64(dispatcherBlock, rcx);	//jmp rcx
+#else
+	movReg64Reg64(dispatcherBlock, CONTEXT_REGISTER, rsi);	//mov r15, rsi
+	jmpReg64(dispatcherBlock, rdi);	//jmp rdi
+#endif
+
+	//Indirect: blocks jump here with the guest address in rax
+	uint32 indirectIndex = dispatcherBlock->getCounter();
+	movContextRAX(dispatcherBlock, &pC);	//mov (pC), rax
+	movReg64Immi64(dispatcherBlock, rcx, codeCache->getCodeSize());	//mov rcx, codeSize
+	cmpReg64Reg64(dispatcherBlock, rax, rcx);	//cmp rax, rcx
+	missJumps[0] = dispatcherBlock->getCounter() + jaeRel32(0, 0);
+	jaeRel32(dispatcherBlock, 0);	//jae miss (also catches negative addresses)
+	movReg64Reg64(dispatcherBlock, rcx, rax);	//mov rcx, rax
+	shrReg64Immi8(dispatcherBlock, rcx, BIN_BLOCK_CACHE_PAGE_BITS);	//shr rcx, BIN_BLOCK_CACHE_PAGE_BITS
+	movReg64Immi64(dispatcherBlock, rdx, (uint64)codeCache->getEntryPages());	//mov rdx, entryPages
+	movReg64MReg64(dispatcherBlock, rdx, 3, rcx, rdx);	//mov rdx, (rdx + rcx * 8)
+	testReg64Reg64(dispatcherBlock, rdx, rdx);	//test rdx, rdx
+	missJumps[1] = dispatcherBlock->getCounter() + jeRel32(0, 0);
+	jeRel32(dispatcherBlock, 0);	//je miss (page not allocated)
+	movReg32Immi32(dispatcherBlock, ecx, BIN_BLOCK_CACHE_PAGE_MASK);	//mov ecx, BIN_BLOCK_CACHE_PAGE_MASK
+	andReg64Reg64(dispatcherBlock, rcx, rax);	//and rcx, rax
+	movReg64MReg64(dispatcherBlock, rcx, 3, rcx, rdx);	//mov rcx, (rdx + rcx * 8)
+	testReg64Reg64(dispatcherBlock, rcx, rcx);	//test rcx, rcx
+	missJumps[2] = dispatcherBlock->getCounter() + jeRel32(0, 0);
+	jeRel32(dispatcherBlock, 0);	//je miss (not translated)
+	jmpReg64(dispatcherBlock, rcx);	//jmp rcx
+
+	//Miss: go back to startCPULoop with nothing to link, it translates the block
+	for (int i = 0; i < 3; ++i) {
+		dispatcherBlock->writeAtIndex(dispatcherBlock->getCounter() - missJumps[i], missJumps[i] - 4);
+	}
+	xorReg64Reg64(dispatcherBlock, rax, rax);	//xor rax, rax
+
+	//Exit: blocks jump here with their exit in rax
+	uint32 exitIndex = dispatcherBlock->getCounter();
+	addReg64Immi32(dispatcherBlock, rsp, DISPATCHER_STACK_SIZE);
+#ifdef HOST_CALL_MICROSOFT_X64
+	for (int i = 0; i < REG_ALLOCATOR_HOST_FREGS; ++i) {
+		movupsXMM_MRegDisp8(dispatcherBlock, X86RegAllocator::hostFRegs[i], rsp, i << 4);	//movups xmm, (rsp + i * 16)
+	}
+	addReg64Immi32(dispatcherBlock, rsp, DISPATCHER_XMM_SAVE_SIZE);
+#endif
+	for (int i = savedRegCount - 1; i >= 0; --i) {
+		popReg64(dispatcherBlock, dispatcherSavedRegs[i]);
+	}
+	ret(dispatcherBlock);
+
+	//Every core of the cache runs the same dispatcher, nothing can run without executable memory
+	if (!codeCache->setDispatcher(dispatcherBlock, indirectIndex, exitIndex)) {
+		pC = -1;
+	}
+}
+
+X86BinBlock *X86DynaRecCore::createNewBinBlock() {
+	vector<int64> path(1, pC);
+	X86BinBlock *binBlock = translateBlocks(path, false);
+	if (!binBlock) return 0;
+
+	//Put it in the cache for future use, its exits are linked by startCPULoop once they are hot. Another
+	//core may have translated the block meanwhile, then that one is used.
+	return codeCache->insert(binBlock);
+}
+
+X86BinBlock *X86DynaRecCore::createTrace(X86BinBlock *head) {
+	vector<int64> path;
+	bool closesLoop;
+
+	selectTracePath(head->startAddress, &path, &closesLoop);
+	if (path.size() == 1 && !closesLoop) return 0;
+
+	int64 savedPC = pC;
+	X86BinBlock *trace = translateBlocks(path, closesLoop);
+	pC = savedPC;
+	if (!trace) return 0;
+
+	//The trace takes the place of its first block, unless another core put a trace there first
+	trace = codeCache->insert(trace);
+	return (trace->trace) ? trace : 0;
+}
+
+//Follows the exits that were taken the most from headAddress until the path gets back to it or reaches
+//code that is not worth putting in the trace
+void X86DynaRecCore::selectTracePath(int64 headAddress, vector<int64> *path, bool *closesLoop) {
+	int64 address = headAddress;
+
+	*closesLoop = false;
+	while (true) {
+		path->push_back(address);
+		if (path->size() == TRACE_MAX_BLOCKS) return;
+
+		int64 nextAddress = getHotSuccessor(codeCache->find(address));
+		if (nextAddress < 0) return;
+		if (nextAddress == headAddress) {
+			*closesLoop = true;
+			return;
+		}
+
+		//Blocks that never ran, other traces and inner loops end the trace
+		X86BinBlock *next = codeCache->find(nextAddress);
+		if (!next || next->trace || find(path->begin(), path->end(), nextAddress) != path->end()) return;
+		address = nextAddress;
+	}
+}
+
+//Address the block goes to most of the time if it ends with a direct jump or a conditional branch,
+//-1 otherwise
+int64 X86DynaRecCore::getHotSuccessor(X86BinBlock *binBlock) {
+	IRBlock irBlock(memManager.codeSpace);
+	irBlock.decode(binBlock->startAddress);
+
+	switch (irBlock.instructions.back().despairOpcode) {
+		case _JMP_IMMI:
+		case _JMPR_IMMI:
+			if (binBlock->exits.size() != 1) return -1;
+			return binBlock->exits[0]->targetAddress;
+		case _JC_R_IMMI:
+		case _JCR_R_IMMI:
+			{
+				if (binBlock->exits.size() != 2) return -1;
+				X86BinBlockExit *taken = binBlock->exits[0], *notTaken = binBlock->exits[1];
+
+				if (taken->executionCount == 0 && notTaken->executionCount == 0) return -1;
+				return (taken->executionCount >= notTaken->executionCount) ? taken->targetAddress : notTaken->targetAddress;
+			}
+		default:
+			return -1;
+	}
+}
+
+//Translates the blocks at path as one piece of code. Branches between them fall through to the next
+//block and leave through side exits when they go the other way. If closesLoop is set the last block
+//jumps back to the start of the code, after the registers are loaded.
+X86BinBlock *X86DynaRecCore::translateBlocks(const vector<int64> &path, bool closesLoop) {
+	chrono::steady_clock::time_point startTime = chrono::steady_clock::now();
+	X86BinBlock *binBlock = new X86BinBlock;
+	IRBlock irBlock(memManager.codeSpace);
+	vector<size_t> branchIndices;	//Last instruction of each block of the path
+	vector<TraceSideExit> sideExits;
+	immediateFloat = new vector<ImmediateFloat>;
+
+	//Decode the code
+	binBlock->startAddress = path[0];
+	binBlock->trace = (path.size() > 1 || closesLoop);
+	irBlock.decode(path[0]);
+	branchIndices.push_back(irBlock.instructions.size() - 1);
+	for (size_t i = 1; i < path.size(); ++i) {
+		irBlock.append(path[i]);
+		branchIndices.push_back(irBlock.instructions.size() - 1);
+	}
+#ifdef DUMP_DYNAREC_IR
+	irBlock.dump(cerr, "before optimization");
+#endif
+	IROptimizer::optimize(&irBlock);
+	size_t loopStart = (closesLoop) ? IROptimizer::hoistLoopInvariants(&irBlock, branchIndices[0]) : 0;
+#ifdef DUMP_DYNAREC_IR
+	irBlock.dump(cerr, "after optimization");
+#endif
+
+	allocateRegisters(irBlock);
+	if (binBlock->trace) {
+		//The loop comes back with values in every pinned register that may not be in memory
+		regAllocator.reloadAll(binBlock);
+		regAllocator.markAllDirty();
+	} else {
+		regAllocator.loadAll(binBlock);
+	}
+	//Invariants of the loop run once, it comes back after them
+	for (size_t i = 0; i < loopStart; ++i) {
+		pC = irBlock.instructions[i].address;
+		binBlock->markGuestAddress(pC);
+		lowerIRInstruction(binBlock, irBlock.instructions[i]);
+	}
+	uint32 bodyIndex = binBlock->getCounter();
+	if (profiler) {
+		uint32 instructionCount = 0;
+		for (size_t i = 0; i < irBlock.instructions.size(); ++i) {
+			if (i == 0 || irBlock.instructions[i].address != irBlock.instructions[i - 1].address) ++instructionCount;
+		}
+		putProfileCounters(binBlock, profiler->getProfile(path[0], irBlock.endAddress, binBlock->trace), instructionCount);
+	}
+	int fdCycleRetVal = FD_CYCLE_CONTINUE;
+	size_t pathIndex = 0;
+	const IRInstruction *fusedCompare = 0;	//Compare that left its flags for the branch at the end of the block
+	for (size_t i = loopStart; i < irBlock.instructions.size(); ++i) {
+		const IRInstruction &instruction = irBlock.instructions[i];
+		if (instruction.dead) continue;
+
+		pC = instruction.address;
+		binBlock->markGuestAddress(pC);
+		bool lastBlock = (pathIndex == path.size() - 1);
+		const IRInstruction &branch = irBlock.instructions[branchIndices[pathIndex]];
+		if (i == branchIndices[pathIndex] && (!lastBlock || closesLoop)) {
+			putTraceBranch(binBlock, instruction, fusedCompare, (lastBlock) ? path[0] : path[pathIndex + 1], (lastBlock) ? (int64)bodyIndex : -1, &sideExits);
+			fdCycleRetVal = (lastBlock) ? FD_CYCLE_BLOCK_END : FD_CYCLE_CONTINUE;
+		} else if (i == branchIndices[pathIndex] && fusedCompare) {
+			putCompareBranch(binBlock, instruction, fusedCompare->opcode);
+			fdCycleRetVal = FD_CYCLE_BLOCK_END;
+		} else if (isCompare(instruction.opcode) && isFusableCompare(irBlock, i, branchIndices[pathIndex])) {
+			//The boolean is only written if the code after the branch may read it
+			putCompare(binBlock, instruction, !isDeadAfterBranch(branch, instruction.dst));
+			fusedCompare = &instruction;
+			fdCycleRetVal = FD_CYCLE_CONTINUE;
+		} else if (instruction.opcode == IR_NATIVE) {
+			fdCycleRetVal = translateInstruction(binBlock);
+		} else {
+			lowerIRInstruction(binBlock, instruction);
+			fdCycleRetVal = FD_CYCLE_CONTINUE;
+		}
+		if (i == branchIndices[pathIndex]) {
+			++pathIndex;
+			fusedCompare = 0;
+		}
+	}
+	pC = irBlock.endAddress;
+	binBlock->endAddress = pC;
+	if (fdCycleRetVal != FD_CYCLE_BLOCK_END) {
+		regAllocator.storeDirty(binBlock);
+		putBlockExit(binBlock, pC);
+	}
+	putTraceSideExits(binBlock, sideExits);
+	putBlockExitTails(binBlock);
+	putImmediateFloats(binBlock);
+	delete immediateFloat;
+	immediateFloat = 0;
+	if (!codeCache->install(binBlock)) {
+		delete binBlock;
+		return 0;
+	}
+
+	++translatedBlocks;
+	translationTime += chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - startTime).count();
+	return binBlock;
+}
+
+//Branch at the end of a block of a trace that continues at nextAddress. fusedCompare is the compare
+//whose flags a JC uses instead of its register, if there is one. loopIndex is where the jump back to
+//the start of the trace goes if this branch closes the loop, -1 otherwise.
+void X86DynaRecCore::putTraceBranch(X86BinBlock *binBlock, const IRInstruction &instruction, const IRInstruction *fusedCompare, int64 nextAddress, int64 loopIndex, vector<TraceSideExit> *sideExits) {
+	if (instruction.despairOpcode == _JMP_IMMI || instruction.despairOpcode == _JMPR_IMMI) {
+		//The next block is right after this one
+		if (loopIndex >= 0) {
+			jmpRel32(binBlock, (uint32)(loopIndex - (binBlock->getCounter() + jmpRel32(0, 0))));	//jmp body
+		}
+		return;
+	}
+
+	//JC is taken when the register is 0
+	int (*jumpIfTaken)(X86BinBlock*, uint32) = jeRel32;
+	int (*jumpIfNotTaken)(X86BinBlock*, uint32) = jneRel32;
+	if (fusedCompare) {
+		jumpIfTaken = getInverseConditionJump(fusedCompare->opcode);
+		jumpIfNotTaken = getConditionJump(fusedCompare->opcode);
+	} else {
+		X86_64Register reg = regAllocator.useReg(binBlock, memManager.codeSpace[instruction.address + 2], rax);
+		testReg64Reg64(binBlock, reg, reg);	//test reg, reg
+	}
+
+	int64 takenAddress = getConditionalBranchTarget(instruction, memManager.codeSpace);
+	int64 notTakenAddress = instruction.address + 7;
+	bool followTaken = (nextAddress == takenAddress);
+	int64 sideExitAddress = (followTaken) ? notTakenAddress : takenAddress;
+
+	if (loopIndex >= 0) {
+		int (*jccRel32)(X86BinBlock*, uint32) = (followTaken) ? jumpIfTaken : jumpIfNotTaken;
+		jccRel32(binBlock, (uint32)(loopIndex - (binBlock->getCounter() + jccRel32(0, 0))));	//jcc body
+		regAllocator.storeDirty(binBlock);
+		putBlockExit(binBlock, sideExitAddress);
+		return;
+	}
+
+	TraceSideExit sideExit;
+	if (followTaken) {
+		jumpIfNotTaken(binBlock, 0);	//jcc sideExit
+	} else {
+		jumpIfTaken(binBlock, 0);	//jcc sideExit
+	}
+	sideExit.jumpIndex = binBlock->getCounter();
+	sideExit.targetAddress = sideExitAddress;
+	regAllocator.saveState(&sideExit.regAllocatorState);
+	sideExits->push_back(sideExit);
+}
+
+void X86DynaRecCore::putTraceSideExits(X86BinBlock *binBlock, const vector<TraceSideExit> &sideExits) {
+	for (size_t i = 0; i < sideExits.size(); ++i) {
+		const TraceSideExit &sideExit = sideExits[i];
+
+		binBlock->writeAtIndex(binBlock->getCounter() - sideExit.jumpIndex, sideExit.jumpIndex - 4);
+		regAllocator.restoreState(sideExit.regAllocatorState);
+		regAllocator.storeDirty(binBlock);
+		putBlockExit(binBlock, sideExit.targetAddress);
+	}
+}
+
+//A compare can leave its result in the flags if the next instruction that is kept is a JC on its register
+bool X86DynaRecCore::isFusableCompare(const IRBlock &irBlock, size_t compareIndex, size_t branchIndex) {
+	const IRInstruction &branch = irBlock.instructions[branchIndex];
+
+	if (branch.despairOpcode != _JC_R_IMMI && branch.despairOpcode != _JCR_R_IMMI) return false;
+	if (memManager.codeSpace[branch.address + 2] != irBlock.instructions[compareIndex].dst) return false;
+	for (size_t i = compareIndex + 1; i < branchIndex; ++i) {
+		if (!irBlock.instructions[i].dead) return false;
+	}
+	return true;
+}
+
+//Whether both ways the JC at branch can go write reg before reading it
+bool X86DynaRecCore::isDeadAfterBranch(const IRInstruction &branch, uint8 reg) {
+	int64 successors[2] = { getConditionalBranchTarget(branch, memManager.codeSpace), branch.address + 7 };
+
+	for (int i = 0; i < 2; ++i) {
+		if ((uint64)successors[i] >= codeCache->getCodeSize()) return false;
+
+		IRBlock successor(memManager.codeSpace);
+		successor.decode(successors[i]);
+		if (!IROptimizer::isOverwrittenBeforeRead(successor, reg)) return false;
+	}
+	return true;
+}
+
+//JC at the end of a block that uses the flags of the compare before it instead of its register
+void X86DynaRecCore::putCompareBranch(X86BinBlock *binBlock, const IRInstruction &instruction, IROpcode compare) {
+	int64 targetAddress = getConditionalBranchTarget(instruction, memManager.codeSpace);
+
+	regAllocator.storeDirty(binBlock);	//Only movs, the flags are kept
+	int (*jccRel32)(X86BinBlock*, uint32) = getConditionJump(compare);
+	jccRel32(binBlock, getBlockExitSize(binBlock->getCounter() + jccRel32(0, 0)));	//jcc notTaken
+	putBlockExit(binBlock, targetAddress);
+	putBlockExit(binBlock, instruction.address + 7);	//notTaken:
+}
+
+void X86DynaRecCore::allocateRegisters(const IRBlock &irBlock) {
+	regAllocator.reset();
+
+	//Count the register uses of the instructions that keep their registers in the allocator
+	for (size_t i = 0; i < irBlock.instructions.size(); ++i) {
+		const IRInstruction &instruction = irBlock.instructions[i];
+		if (instruction.dead) continue;
+
+		if (instruction.opcode == IR_NATIVE) {
+			if (usesRegAllocator(instruction.despairOpcode, &memManager.codeSpace[instruction.address + 2])) {
+				countRegisterOperands(instruction.despairOpcode, instruction.address);
+			}
+		} else {
+			IRRegisterUses uses;
+			irBlock.getRegisterUses(instruction, &uses);
+
+			for (int j = 0; j < uses.readCount; ++j) {
+				regAllocator.countReg(uses.reads[j], true);
+			}
+			for (int j = 0; j < uses.writeCount; ++j) {
+				regAllocator.countReg(uses.writes[j], false);
+			}
+		}
+	}
+	regAllocator.allocate();
+}
+
+void X86DynaRecCore::countRegisterOperands(uint16 opcode, int64 address) {
+	const InstructionInfo *instructionInfo = InstructionsInfo::getInstructionInfo(opcode);
+	if (!instructionInfo) return;
+
+	//Operands are read before the result is written, so count the reads first
+	for (int pass = 0; pass < 2; ++pass) {
+		int64 operandAddress = address + 2;
+		for (const char *operand = instructionInfo->operands; *operand; ++operand) {
+			uint8 index = memManager.codeSpace[operandAddress];
+			bool write = (*operand == OPERAND_REG_WRITE || *operand == OPERAND_FREG_WRITE);
+
+			if (write == (pass == 1)) {
+				if (*operand == OPERAND_REG_READ || *operand == OPERAND_REG_WRITE || *operand == OPERAND_REG_READ_WRITE) {
+					regAllocator.countReg(index, !write);
+				} else if (*operand == OPERAND_FREG_READ || *operand == OPERAND_FREG_WRITE || *operand == OPERAND_FREG_READ_WRITE) {
+					regAllocator.countFReg(index, !write);
+				}
+			}
+			operandAddress += InstructionsInfo::getOperandSize(*operand);
+		}
+	}
+}
+
+int X86DynaRecCore::translateInstruction(X86BinBlock *binBlock) {
+	if (pC < 0) {
+		return FD_CYCLE_END;
+	}
+
+	int64 address = pC;
+	uint16 opcode = *(uint16*)&memManager.codeSpace[pC];
+	bool allocatorAware = usesRegAllocator(opcode, &memManager.codeSpace[pC + 2]);
+
+	//Everything else reads and writes the registers in memory
+	if (!allocatorAware) {
+		regAllocator.storeDirty(binBlock);
+	}
+	int fdCycleRetVal = fdCycle(binBlock);
+	if (!allocatorAware && fdCycleRetVal == FD_CYCLE_CONTINUE) {
+		reloadWrittenRegisters(binBlock, opcode, address);
+	}
+	return fdCycleRetVal;
+}
+
+void X86DynaRecCore::reloadWrittenRegisters(X86BinBlock *binBlock, uint16 opcode, int64 address) {
+	const InstructionInfo *instructionInfo = InstructionsInfo::getInstructionInfo(opcode);
+	if (!instructionInfo) return;
+
+	if (instructionInfo->flags & INSTRUCTION_ALL_REGS) {
+		regAllocator.reloadAll(binBlock);
+		return;
+	}
+
+	int64 operandAddress = address + 2;
+	for (const char *operand = instructionInfo->operands; *operand; ++operand) {
+		uint8 index = memManager.codeSpace[operandAddress];
+
+		if (*operand == OPERAND_REG_WRITE || *operand == OPERAND_REG_READ_WRITE) {
+			regAllocator.reload(binBlock, index);
+		} else if (*operand == OPERAND_FREG_WRITE || *operand == OPERAND_FREG_READ_WRITE) {
+			regAllocator.reloadF(binBlock, index);
+		}
+		operandAddress += InstructionsInfo::getOperandSize(*operand);
+	}
+
+#ifndef HOST_CALL_MICROSOFT_X64
+	//xmm registers are all caller saved in the System V ABI
+	if (instructionInfo->flags & INSTRUCTION_CALLS_HOST) {
+		regAllocator.reloadFloats(binBlock);
+	}
+#endif
+}
+
+//Return addresses are 32 bits, so none of them is -1
+void X86DynaRecCore::clearShadowStack() {
+	for (int i = 0; i < SHADOW_STACK_SIZE; ++i) {
+		shadowStack[i].guestAddress = -1;
+		shadowStack[i].hostAddress = 0;
+	}
+	shadowTop = 0;
+	shadowRetirements = codeCache->getRetirements();
+}
+
+X86BinBlockExit *X86DynaRecCore::executeBlock(X86BinBlock *binBlock) {
+	//Blocks the shadow stack leads into may have been retired by any core, this one included, since it
+	//last ran one. It is only read after the pass of startCPULoop, so they cannot be deleted yet.
+	if (codeCache->getRetirements() != shadowRetirements) clearShadowStack();
+
+	uint8 *dispatcherPtr = codeCache->getDispatcher()->getBinBuffer();
+	X86BinBlockExit *blockExit = ((X86BinBlockExit*(*)(uint8*, uint8*))dispatcherPtr)(binBlock->getBinBuffer(), (uint8*)this + CONTEXT_REGISTER_BIAS);
+
+	//The last block that ran gets the cycles until here, what comes until the next block is untranslated
+	if (profileBlock) {
+		uint64 cycles = X86BlockProfiler::readCycleCounter();
+		profileBlock->cycles += cycles - profileCycles;
+		profileBlock = profiler->getUntranslatedProfile();
+		profileCycles = cycles;
+	}
+	return blockExit;
+}
+
+void X86DynaRecCore::putBlockExit(X86BinBlock *binBlock, int64 targetAddress) {
+	//Linking patches the offset while other cores may run the block, it is aligned so that they never
+	//see half of it
+	while ((binBlock->getCounter() + 1) & 3) {
+		nop(binBlock);
+	}
+	X86BinBlockExit *blockExit = new X86BinBlockExit(binBlock, targetAddress);
+	blockExit->patchIndex = binBlock->getCounter();
+	binBlock->exits.push_back(blockExit);
+
+	//The offset is filled in by putBlockExitTails and replaced when the exit is linked
+	jmpRel32(binBlock, 0);	//jmp tail
+}
+
+int X86DynaRecCore::putIndirectBlockExit(X86BinBlock *binBlock) {
+	uint64 dispatcherIndirectAddr = (uint64)codeCache->getDispatcherIndirect();
+
+	//Guest address has to be in rax
+	return movReg64Immi64(binBlock, rcx, dispatcherIndirectAddr)	//mov rcx, dispatcherIndirect
+		+ jmpReg64(binBlock, rcx);	//jmp rcx
+}
+
+//Jumps to the block at the guest address in rax. Every entry compares it with the block it was filled with
+//and jumps straight there, addresses no entry has go to the tail of the next entry that is not filled,
+//which returns to startCPULoop to fill it. Once every entry is filled the dispatcher looks them up.
+void X86DynaRecCore::putInlineCache(X86BinBlock *binBlock) {
+	for (int i = 0; i < INLINE_CACHE_SIZE; ++i) {
+		//The address is patched while other cores may run the block, like the offset of an exit
+		while ((binBlock->getCounter() + 3) & 3) {
+			nop(binBlock);
+		}
+		uint32 compareIndex = binBlock->getCounter() + 3;
+		cmpReg64Immi32(binBlock, rax, (uint32)-1);	//cmp rax, address
+		jneRel32(binBlock, getBlockExitSize(binBlock->getCounter() + jneRel32(0, 0)));	//jne next
+		putBlockExit(binBlock, -1);
+		binBlock->exits.back()->compareIndex = compareIndex;
+	}
+
+	while ((binBlock->getCounter() + 1) & 3) {
+		nop(binBlock);
+	}
+	uint32 missIndex = binBlock->getCounter();
+	jmpRel32(binBlock, 0);	//jmp tail of the first entry, filled in by putBlockExitTails
+	for (int i = 1; i <= INLINE_CACHE_SIZE; ++i) {
+		binBlock->exits[binBlock->exits.size() - i]->missIndex = missIndex;
+	}
+	putIndirectBlockExit(binBlock);	//Every entry is filled
+}
+
+void X86DynaRecCore::putBlockExitTails(X86BinBlock *binBlock) {
+	uint64 dispatcherExitAddr = (uint64)codeCache->getDispatcherExit();
+
+	for (size_t i = 0; i < binBlock->exits.size(); ++i) {
+		X86BinBlockExit *blockExit = binBlock->exits[i];
+		blockExit->tailIndex = binBlock->getCounter();
+
+		//The entries of an inline cache have the guest address in rax
+		if (!blockExit->compareIndex) {
+			movReg64Immi64(binBlock, rax, blockExit->targetAddress);	//mov rax, targetAddress
+		}
+		movContextRAX(binBlock, &pC);	//mov (pC), rax
+		movReg64Immi64(binBlock, rax, (uint64)blockExit);	//mov rax, blockExit
+		movReg64Immi64(binBlock, rcx, dispatcherExitAddr);	//mov rcx, dispatcherExit
+		jmpReg64(binBlock, rcx);	//jmp rcx
+	}
+
+	//Tails are only known now
+	for (size_t i = 0; i < binBlock->exits.size(); ++i) {
+		X86BinBlockExit *blockExit = binBlock->exits[i];
+		binBlock->writeAtIndex(blockExit->tailIndex - (blockExit->patchIndex + BLOCK_EXIT_SIZE), blockExit->patchIndex + 1);
+		if (!blockExit->compareIndex) continue;
+
+		//The entries of an inline cache are filled in order, misses go to the first one
+		bool firstEntry = (i == 0 || binBlock->exits[i - 1]->missIndex != blockExit->missIndex);
+		bool lastEntry = (i + 1 == binBlock->exits.size() || binBlock->exits[i + 1]->missIndex != blockExit->missIndex);
+		blockExit->nextTailIndex = (lastEntry) ? blockExit->missIndex + BLOCK_EXIT_SIZE : binBlock->exits[i + 1]->tailIndex;
+		if (firstEntry) {
+			binBlock->writeAtIndex(blockExit->tailIndex - (blockExit->missIndex + BLOCK_EXIT_SIZE), blockExit->missIndex + 1);
+		}
+	}
+}
+
+uint32 X86DynaRecCore::getContextOffset(const void *address) {
+	return (uint32)((const uint8*)address - ((const uint8*)this + CONTEXT_REGISTER_BIAS));
+}
+
+//lea reg, address, for state of the core that runs the code
+int X86DynaRecCore::putContextAddress(X86BinBlock *binBlock, X86_64Register reg, const void *address) {
+	return leaReg64MRegDisp(binBlock, reg, CONTEXT_REGISTER, getContextOffset(address));
+}
+
+int X86DynaRecCore::movRAX_Context(X86BinBlock *binBlock, const void *address) {
+	return movReg64MRegDisp(binBlock, rax, CONTEXT_REGISTER, getContextOffset(address));
+}
+
+int X86DynaRecCore::movEAX_Context(X86BinBlock *binBlock, const void *address) {
+	return movReg32MRegDisp(binBlock, eax, CONTEXT_REGISTER, getContextOffset(address));
+}
+
+int X86DynaRecCore::movContextRAX(X86BinBlock *binBlock, const void *address) {
+	return movMRegDispReg64(binBlock, CONTEXT_REGISTER, getContextOffset(address), rax);
+}
+
+int X86DynaRecCore::movContextEAX(X86BinBlock *binBlock, const void *address) {
+	return movMRegDispReg32(binBlock, CONTEXT_REGISTER, getContextOffset(address), eax);
 }
 
-void X86DynaRecCore::startCPULoop() {
-	while (true) {
-		//Check if the code is already in cache
-		X86BinBlockCache::const_iterator cacheCode = x86BinBlockCache.find(pC);
-		if (cacheCode == x86BinBlockCache.end()) {
-			//Check if it is an instruction that needs to be interpreted
-			int fdCycleRetVal = fdCycle(0);
-			if (fdCycleRetVal & FD_CYCLE_BREAK_MASK) {
-				switch (fdCycleRetVal) {
-					case FD_CYCLE_BREAK_CALL:
-						CALL_IMMI();
-						break;
-					case FD_CYCLE_BREAK_JC:
-						JC_R_IMMI();
-						break;
-					case FD_CYCLE_BREAK_JCR:
-						JCR_R_IMMI();
-						break;
-					case FD_CYCLE_BREAK_JMP:
-						JMP_IMMI();
-						break;
-					case FD_CYCLE_BREAK_JMPR:
-						JMPR_IMMI();
-						break;
-					case FD_CYCLE_BREAK_RET:
-						RET();
-						break;
-					case FD_CYCLE_JMP_R:
-						JMP_R();
-						break;
-					case FD_CYCLE_JMPR_R:
-						JMPR_R();
-						break;
-					case FD_CYCLE_JC_R_R:
-						JC_R_R();
-						break;
-					case FD_CYCLE_JCR_R_R:
-						JCR_R_R();
-						break;
-					case FD_CYCLE_END:
-						return;
-				}
-			} else {
-				createNewBinBlock();
-			}
-		} else {
-			//If the code exists in the cache, run it
-			executeBlock(cacheCode->second);
-			pC = cacheCode->second->endAddress;
+//mov reg, stackSpace, every core has a stack of its own
+int X86DynaRecCore::putStackAddress(X86BinBlock *binBlock, X86_64Register reg) {
+	return movReg64MRegDisp(binBlock, reg, CONTEXT_REGISTER, getContextOffset(&memManager.stackSpace));
+}
+
+//Constant pool after the code of the block, every value is put once and 4 byte aligned
+void X86DynaRecCore::putImmediateFloats(X86BinBlock *binBlock) {
+	if (immediateFloat->empty()) return;
+
+	while (binBlock->getCounter() & 3) {
+		nop(binBlock);
+	}
+	map<uint32, uint32> floatIndices;	//Bits of the value, where it is in the block
+	for (size_t i = 0; i < immediateFloat->size(); ++i) {
+		uint32 bits = *(uint32*)&immediateFloat->at(i).value;
+		map<uint32, uint32>::iterator it = floatIndices.find(bits);
+		if (it == floatIndices.end()) {
+			it = floatIndices.insert(make_pair(bits, binBlock->getCounter())).first;
+			binBlock->write<uint32>(bits);
 		}
+		binBlock->writeAtIndex(it->second - immediateFloat->at(i).counter - 4, immediateFloat->at(i).counter);
 	}
 }
 
-void X86DynaRecCore::createNewBinBlock() {
-	//Decode the code
-	X86BinBlock *binBlock = new X86BinBlock;
-	immediateFloat = new vector<ImmediateFloat>;
+//Gives the cycles since profileCycles to profileBlock and makes profile the block that runs. It is put
+//where the loop of a trace jumps back to, so every time around the loop counts as an entry.
+void X86DynaRecCore::putProfileCounters(X86BinBlock *binBlock, X86BlockProfile *profile, uint32 instructionCount) {
+	rdtsc(binBlock);	//rdtsc
+	shlReg64Immi8(binBlock, rdx, 32);	//shl rdx, 32
+	orReg64Reg64(binBlock, rax, rdx);	//or rax, rdx
+	movReg64Reg64(binBlock, rcx, rax);	//mov rcx, rax
+	movReg64MRegDisp(binBlock, rdx, CONTEXT_REGISTER, getContextOffset(&profileCycles));	//mov rdx, (profileCycles)
+	subReg64Reg64(binBlock, rax, rdx);	//sub rax, rdx
+	movMRegDispReg64(binBlock, CONTEXT_REGISTER, getContextOffset(&profileCycles), rcx);	//mov (profileCycles), rcx
+	movReg64MRegDisp(binBlock, rdx, CONTEXT_REGISTER, getContextOffset(&profileBlock));	//mov rdx, (profileBlock)
+	lockAddMRegDisp64Reg64(binBlock, rdx, offsetof(X86BlockProfile, cycles), rax);	//lock add (rdx + cycles), rax
+	movReg64Immi64(binBlock, rax, (uint64)profile);	//mov rax, profile
+	movMRegDispReg64(binBlock, CONTEXT_REGISTER, getContextOffset(&profileBlock), rax);	//mov (profileBlock), rax
+	lockAddMRegDisp64Immi32(binBlock, rax, offsetof(X86BlockProfile, entries), 1);	//lock add (rax + entries), 1
+	lockAddMRegDisp64Immi32(binBlock, rax, offsetof(X86BlockProfile, instructions), instructionCount);	//lock add (rax + instructions), instructionCount
+}
+
+void X86DynaRecCore::putSetCondition(X86BinBlock *binBlock, int (*jccRel32)(X86BinBlock*, uint32), X86_64Register reg) {
+	//reg = 1 if the condition of the flags is true, 0 otherwise
+	jccRel32(binBlock, movReg32Immi32(0, reg, 0) + jmpRel32(0, 0));	//jcc true
+	movReg32Immi32(binBlock, reg, 0);	//mov reg, 0
+	jmpRel32(binBlock, movReg32Immi32(0, reg, 1));	//jmp end
+	movReg32Immi32(binBlock, reg, 1);	//true: mov reg, 1
+}
+
+//Sets the flags for the comparison, and dst to 1 or 0 if setResult is set
+void X86DynaRecCore::putCompare(X86BinBlock *binBlock, const IRInstruction &instruction, bool setResult) {
+	X86_64Register src1 = regAllocator.useReg(binBlock, instruction.dst, rax);	//mov rax, reg
+	if (instruction.srcImmi) {
+		cmpReg32Immi32(binBlock, src1, (uint32)instruction.immi);	//cmp eax, immi
+	} else {
+		cmpReg32Reg32(binBlock, src1, regAllocator.useReg(binBlock, instruction.src, rcx));	//cmp eax, ecx
+	}
+	if (!setResult) return;
 
-	subReg64Immi32(binBlock, rsp, 0x20);	//Shadow Space
-	binBlock->startAddress = pC;
-	while (fdCycle(binBlock) == FD_CYCLE_CONTINUE);
-	binBlock->endAddress = pC;
-	addReg64Immi32(binBlock, rsp, 0x20);	//Shadow Space
-	ret(binBlock);
-	putImmediateFloats(binBlock);
-	delete immediateFloat;
-	immediateFloat = 0;
+	//putSetCondition and storeReg don't change the flags
+	X86_64Register dst = regAllocator.getReg(instruction.dst, rax);
+	putSetCondition(binBlock, getConditionJump(instruction.opcode), dst);
+	regAllocator.storeReg(binBlock, instruction.dst, dst);	//mov reg, rax
+}
 
-	//Execute the code
-	executeBlock(binBlock);
+X86_64Register X86DynaRecCore::useIRSource(X86BinBlock *binBlock, const IRInstruction &instruction, X86_64Register scratch) {
+	if (instruction.srcImmi) {
+		putIRImmediate(binBlock, scratch, instruction.immi);	//mov scratch, immi
+		return scratch;
+	}
+	return regAllocator.useReg(binBlock, instruction.src, scratch);	//mov scratch, src
+}
+
+//Division by a positive constant, powers of two are already shifts and masks. The dividend is unsigned
+//like the one idiv gets with rdx cleared.
+void X86DynaRecCore::putConstantDivision(X86BinBlock *binBlock, const IRInstruction &instruction) {
+	uint64 magic;
+	uint8 shift;
+	bool add;
+	getDivisionMagic(instruction.immi, &magic, &shift, &add);
+
+	X86_64Register dividend = regAllocator.useReg(binBlock, instruction.dst, rcx);	//mov rcx, reg
+	movReg64Immi64(binBlock, rax, magic);	//mov rax, magic
+	mulRAX_Reg64(binBlock, dividend);	//mul rcx
+	X86_64Register quotient = rdx;
+	if (add) {
+		//(((dividend - high) >> 1) + high) >> shift, the 65th bit of the magic number
+		movReg64Reg64(binBlock, rax, dividend);	//mov rax, rcx
+		subReg64Reg64(binBlock, rax, rdx);	//sub rax, rdx
+		shrReg64Immi8(binBlock, rax, 1);	//shr rax, 1
+		addReg64Reg64(binBlock, rax, rdx);	//add rax, rdx
+		quotient = rax;
+	}
+	shrReg64Immi8(binBlock, quotient, shift);	//shr rdx, shift
 
-	//Put it in the cache for future use
-	x86BinBlockCache.insert(X86BinBlockCache::value_type(binBlock->startAddress, binBlock));
-}
+	if (instruction.opcode == IR_DIV) {
+		regAllocator.storeReg(binBlock, instruction.dst, quotient);	//mov reg, rdx
+		return;
+	}
 
-void X86DynaRecCore::executeBlock(X86BinBlock *binBlock) {
-	uint8 *bufferPtr = binBlock->getBinBuffer();
-	((void(*)())bufferPtr)();
+	//dividend - quotient * divisor
+	if ((int64)instruction.immi == (int32)instruction.immi) {
+		imulReg64Reg64Immi32(binBlock, quotient, quotient, (uint32)instruction.immi);	//imul rdx, rdx, divisor
+	} else {
+		X86_64Register divisor = (quotient == rax) ? rdx : rax;
+		movReg64Immi64(binBlock, divisor, instruction.immi);	//mov rax, divisor
+		imulReg64Reg64(binBlock, quotient, divisor);	//imul rdx, rax
+	}
+	subReg64Reg64(binBlock, dividend, quotient);	//sub rcx, rdx
+	regAllocator.storeReg(binBlock, instruction.dst, dividend);	//mov reg, rcx
 }
 
-void X86DynaRecCore::putImmediateFloats(X86BinBlock *binBlock) {
-	for (size_t i = 0; i < immediateFloat->size(); ++i) {
-		uint32 floatIndex = binBlock->getCounter();
-		binBlock->write<uint32>(*(uint32*)&immediateFloat->at(i).value);
-		binBlock->writeAtIndex(immediateFloat->at(i).counter, floatIndex - immediateFloat->at(i).counter - 4);
+void X86DynaRecCore::lowerIRInstruction(X86BinBlock *binBlock, const IRInstruction &instruction) {
+	uint8 reg = instruction.dst;
+	uint64 gMemoryAddr = (uint64)memManager.globalDataSpace + instruction.mOffset;
+
+	switch (instruction.opcode) {
+		case IR_MOV:
+			if (instruction.srcImmi) {
+				X86_64Register dst = regAllocator.getReg(reg, rax);
+				putIRImmediate(binBlock, dst, instruction.immi);	//mov rax, immi
+				regAllocator.storeReg(binBlock, reg, dst);	//mov reg, rax
+			} else {
+				regAllocator.storeReg(binBlock, reg, regAllocator.useReg(binBlock, instruction.src, rax));	//mov reg, src
+			}
+			break;
+		case IR_ADD:
+		case IR_SUB:
+		case IR_MUL:
+		case IR_AND:
+		case IR_OR:
+		case IR_XOR:
+			{
+				X86_64Register dst = regAllocator.useReg(binBlock, reg, rax);	//mov rax, reg
+
+				if (instruction.opcode == IR_MUL && instruction.srcImmi && (instruction.immi == 3 || instruction.immi == 5 || instruction.immi == 9)) {
+					leaReg64MReg64(binBlock, dst, (instruction.immi == 3) ? 1 : ((instruction.immi == 5) ? 2 : 3), dst, dst);	//lea rax, (rax + rax * (immi - 1))
+				} else if (instruction.opcode == IR_MUL && instruction.srcImmi && (int64)instruction.immi == (int32)instruction.immi) {
+					imulReg64Reg64Immi32(binBlock, dst, dst, (uint32)instruction.immi);	//imul rax, rax, immi
+				} else {
+					X86_64Register src = useIRSource(binBlock, instruction, rcx);	//mov rcx, src
+					switch (instruction.opcode) {
+						case IR_ADD:
+							addReg64Reg64(binBlock, dst, src);	//add rax, rcx
+							break;
+						case IR_SUB:
+							subReg64Reg64(binBlock, dst, src);	//sub rax, rcx
+							break;
+						case IR_MUL:
+							imulReg64Reg64(binBlock, dst, src);	//imul rax, rcx
+							break;
+						case IR_AND:
+							andReg64Reg64(binBlock, dst, src);	//and rax, rcx
+							break;
+						case IR_OR:
+							orReg64Reg64(binBlock, dst, src);	//or rax, rcx
+							break;
+						default:
+							xorReg64Reg64(binBlock, dst, src);	//xor rax, rcx
+							break;
+					}
+				}
+				regAllocator.storeReg(binBlock, reg, dst);	//mov reg, rax
+			}
+			break;
+		case IR_DIV:
+		case IR_MOD:
+			if (instruction.srcImmi && (int64)instruction.immi > 0 && (instruction.immi & (instruction.immi - 1))) {
+				putConstantDivision(binBlock, instruction);
+			} else {
+				X86_64Register divisor = useIRSource(binBlock, instruction, rcx);	//mov rcx, src
+				regAllocator.loadReg(binBlock, rax, reg);	//mov rax, reg
+				xorReg64Reg64(binBlock, rdx, rdx);	//xor rdx, rdx
+				idivRAX_Reg64(binBlock, divisor);	//idiv rax, rcx
+				regAllocator.storeReg(binBlock, reg, (instruction.opcode == IR_DIV) ? rax : rdx);	//mov reg, rax/rdx
+			}
+			break;
+		case IR_SHL:
+		case IR_SHR:
+			if (instruction.srcImmi) {
+				X86_64Register dst = regAllocator.useReg(binBlock, reg, rax);	//mov rax, reg
+				if (instruction.opcode == IR_SHL) {
+					shlReg64Immi8(binBlock, dst, instruction.immi & 63);	//shl rax, immi
+				} else {
+					shrReg64Immi8(binBlock, dst, instruction.immi & 63);	//shr rax, immi
+				}
+				regAllocator.storeReg(binBlock, reg, dst);	//mov reg, rax
+			} else {
+				regAllocator.loadReg(binBlock, rcx, instruction.src);	//mov rcx, src
+				X86_64Register dst = regAllocator.useReg(binBlock, reg, rax);	//mov rax, reg
+				if (instruction.opcode == IR_SHL) {
+					shlReg64Cl(binBlock, dst);	//shl rax, cl
+				} else {
+					shrReg64Cl(binBlock, dst);	//shr rax, cl
+				}
+				regAllocator.storeReg(binBlock, reg, dst);	//mov reg, rax
+			}
+			break;
+		case IR_CMPE:
+		case IR_CMPNE:
+		case IR_CMPG:
+		case IR_CMPL:
+		case IR_CMPGE:
+		case IR_CMPLE:
+			putCompare(binBlock, instruction, true);
+			break;
+		case IR_LOAD32:
+			movEAX_MOffset(binBlock, gMemoryAddr);	//mov eax, (gMemoryAddr)
+			regAllocator.storeReg(binBlock, reg, rax);	//mov reg, rax
+			break;
+		case IR_LOAD64:
+			movRAX_MOffset(binBlock, gMemoryAddr);	//mov rax, (gMemoryAddr)
+			regAllocator.storeReg(binBlock, reg, rax);	//mov reg, rax
+			break;
+		case IR_STORE32:
+			if (instruction.srcImmi) {
+				movReg64Immi64(binBlock, rax, gMemoryAddr);	//mov rax, gMemoryAddr
+				movMReg32Immi32(binBlock, rax, (uint32)instruction.immi);	//mov (rax), immi
+			} else {
+				regAllocator.loadReg(binBlock, rax, instruction.src);	//mov rax, src
+				movMOffsetEAX(binBlock, gMemoryAddr);	//mov (gMemoryAddr), eax
+			}
+			break;
+		case IR_STORE64:
+			if (instruction.srcImmi) {
+				movReg64Immi64(binBlock, rcx, gMemoryAddr);	//mov rcx, gMemoryAddr
+				putIRImmediate(binBlock, rax, instruction.immi);	//mov rax, immi
+				movMReg64Reg64(binBlock, rcx, rax);	//mov (rcx), rax
+			} else {
+				regAllocator.loadReg(binBlock, rax, instruction.src);	//mov rax, src
+				movMOffsetRAX(binBlock, gMemoryAddr);	//mov (gMemoryAddr), rax
+			}
+			break;
+		default:
+			break;
 	}
 }
 
@@ -175,18 +1423,6 @@ int X86DynaRecCore::fdCycle(X86BinBlock *binBlock) {
 			MOV_MR_IMMI_IMMI(binBlock);
 			if (binBlock) pC += 9;
 			break;
-		case _MOV_R_M:
-			MOV_R_M(binBlock);
-			if (binBlock) pC += 5;
-			break;
-		case _MOV_M_R:
-			MOV_M_R(binBlock);
-			if (binBlock) pC += 5;
-			break;
-		case _MOV_R_R:
-			MOV_R_R(binBlock);
-			if (binBlock) pC += 2;
-			break;
 		case _MOV_M_M:
 			MOV_M_M(binBlock);
 			if (binBlock) pC += 8;
@@ -211,113 +1447,29 @@ int X86DynaRecCore::fdCycle(X86BinBlock *binBlock) {
 			MOV_MR_MR(binBlock);
 			if (binBlock) pC += 2;
 			break;
-		case _MOV_R_IMMI:
-			MOV_R_IMMI(binBlock);
-			if (binBlock) pC += 5;
-			break;
-		case _MOV_M_IMMI:
-			MOV_M_IMMI(binBlock);
-			if (binBlock) pC += 8;
-			break;
 		case _MOV_MR_IMMI:
 			MOV_MR_IMMI(binBlock);
 			if (binBlock) pC += 5;
 			break;
-		case _ADD_R_R:
-			ADD_R_R(binBlock);
-			if (binBlock) pC += 2;
-			break;
-		case _ADD_R_IMMI:
-			ADD_R_IMMI(binBlock);
-			if (binBlock) pC += 5;
-			break;
-		case _SUB_R_R:
-			SUB_R_R(binBlock);
-			if (binBlock) pC += 2;
-			break;
-		case _SUB_R_IMMI:
-			SUB_R_IMMI(binBlock);
-			if (binBlock) pC += 5;
-			break;
-		case _MUL_R_R:
-			MUL_R_R(binBlock);
-			if (binBlock) pC += 2;
-			break;
-		case _MUL_R_IMMI:
-			MUL_R_IMMI(binBlock);
-			if (binBlock) pC += 5;
-			break;
-		case _DIV_R_R:
-			DIV_R_R(binBlock);
-			if (binBlock) pC += 2;
-			break;
-		case _DIV_R_IMMI:
-			DIV_R_IMMI(binBlock);
-			if (binBlock) pC += 5;
-			break;
-		case _MOD_R_R:
-			MOD_R_R(binBlock);
-			if (binBlock) pC += 2;
-			break;
-		case _MOD_R_IMMI:
-			MOD_R_IMMI(binBlock);
-			if (binBlock) pC += 5;
-			break;
-		case _AND_R_R:
-			AND_R_R(binBlock);
-			if (binBlock) pC += 2;
-			break;
-		case _AND_R_IMMI:
-			AND_R_IMMI(binBlock);
-			if (binBlock) pC += 5;
-			break;
-		case _OR_R_R:
-			OR_R_R(binBlock);
-			if (binBlock) pC += 2;
-			break;
-		case _OR_R_IMMI:
-			OR_R_IMMI(binBlock);
-			if (binBlock) pC += 5;
-			break;
-		case _XOR_R_R:
-			XOR_R_R(binBlock);
-			if (binBlock) pC += 2;
-			break;
-		case _XOR_R_IMMI:
-			XOR_R_IMMI(binBlock);
-			if (binBlock) pC += 5;
-			break;
-		case _SHL_R_IMMI8:
-			SHL_R_IMMI8(binBlock);
-			if (binBlock) pC += 2;
-			break;
-		case _SHL_R_R:
-			SHL_R_R(binBlock);
-			if (binBlock) pC += 2;
-			break;
-		case _SHR_R_IMMI8:
-			SHR_R_IMMI8(binBlock);
-			if (binBlock) pC += 2;
-			break;
-		case _SHR_R_R:
-			SHR_R_R(binBlock);
-			if (binBlock) pC += 2;
-			break;
 		case _NOP:
 			NOP(binBlock);
 			break;
 		case _JMP_IMMI:
-			pC -= 2;
-			return FD_CYCLE_BREAK_JMP;
+			if (!binBlock) break;
+			JMP_IMMI(binBlock);
+			return FD_CYCLE_BLOCK_END;
 		case _JMPR_IMMI:
-			pC -= 2;
-			return FD_CYCLE_BREAK_JMPR;
+			if (!binBlock) break;
+			JMPR_IMMI(binBlock);
+			return FD_CYCLE_BLOCK_END;
 		case _JC_R_IMMI:
-			pC -= 2;
-			return FD_CYCLE_BREAK_JC;
+			if (!binBlock) break;
+			JC_R_IMMI(binBlock);
+			return FD_CYCLE_BLOCK_END;
 		case _JCR_R_IMMI:
-			pC -= 2;
-			return FD_CYCLE_BREAK_JCR;
+			if (!binBlock) break;
+			JCR_R_IMMI(binBlock);
+			return FD_CYCLE_BLOCK_END;
 		case _MOVP_R_MR_IMMI:
 			MOVP_R_MR_IMMI(binBlock);
 			if (binBlock) pC += 6;
@@ -330,14 +1482,6 @@ int X86DynaRecCore::fdCycle(X86BinBlock *binBlock) {
 			MOVP_MR_IMMI_MR_IMMI(binBlock);
 			if (binBlock) pC += 10;
 			break;
-		case _MOVP_R_M:
-			MOVP_R_M(binBlock);
-			if (binBlock) pC += 5;
-			break;
-		case _MOVP_M_R:
-			MOVP_M_R(binBlock);
-			if (binBlock) pC += 5;
-			break;
 		case _MOVP_R_MR:
 			MOVP_R_MR(binBlock);
 			if (binBlock) pC += 2;
@@ -347,11 +1491,13 @@ int X86DynaRecCore::fdCycle(X86BinBlock *binBlock) {
 			if (binBlock) pC += 2;
 			break;
 		case _CALL_IMMI:
-			pC -= 2;
-			return FD_CYCLE_BREAK_CALL;
+			if (!binBlock) break;
+			CALL_IMMI(binBlock);
+			return FD_CYCLE_BLOCK_END;
 		case _RET:
-			pC -= 2;
-			return FD_CYCLE_BREAK_RET;
+			if (!binBlock) break;
+			RET(binBlock);
+			return FD_CYCLE_BLOCK_END;
 		case _PUSH_R:
 			PUSH_R(binBlock);
 			if (binBlock) ++pC;
@@ -473,6 +1619,10 @@ int X86DynaRecCore::fdCycle(X86BinBlock *binBlock) {
 			FCON_FR_IMMI(binBlock);
 			if (binBlock) pC += 5;
 			break;
+		case _FCON_R_FIMMI:
+			FCON_R_FIMMI(binBlock);
+			if (binBlock) pC += 5;
+			break;
 		case _FMOV_FR_MFR_IMMI:
 			FMOV_FR_MFR_IMMI(binBlock);
 			if (binBlock) pC += 6;
@@ -685,30 +1835,6 @@ int X86DynaRecCore::fdCycle(X86BinBlock *binBlock) {
 			BMOV_BM_IMMI8(binBlock);
 			if (binBlock) pC += 5;
 			break;
-		case _CMPE_R_R:
-			CMPE_R_R(binBlock);
-			if (binBlock) pC += 2;
-			break;
-		case _CMPNE_R_R:
-			CMPNE_R_R(binBlock);
-			if (binBlock) pC += 2;
-			break;
-		case _CMPG_R_R:
-			CMPG_R_R(binBlock);
-			if (binBlock) pC += 2;
-			break;
-		case _CMPL_R_R:
-			CMPL_R_R(binBlock);
-			if (binBlock) pC += 2;
-			break;
-		case _CMPGE_R_R:
-			CMPGE_R_R(binBlock);
-			if (binBlock) pC += 2;
-			break;
-		case _CMPLE_R_R:
-			CMPLE_R_R(binBlock);
-			if (binBlock) pC += 2;
-			break;
 		case _CMPE_R_FR_FR:
 			FCMPE_R_FR_FR(binBlock);
 			if (binBlock) pC += 3;
@@ -745,29 +1871,29 @@ int X86DynaRecCore::fdCycle(X86BinBlock *binBlock) {
 			FOUT_IMMI_FIMMI(binBlock);
 			if (binBlock) pC += 8;
 			break;
-		case _CMPE_R_IMMI:
-			CMPE_R_IMMI(binBlock);
-			if (binBlock) pC += 5;
+		case _PUSHES_R_R:
+			PUSHES_R_R(binBlock);
+			if (binBlock) pC += 2;
 			break;
-		case _CMPNE_R_IMMI:
-			CMPNE_R_IMMI(binBlock);
-			if (binBlock) pC += 5;
+		case _POPS_R_R:
+			POPS_R_R(binBlock);
+			if (binBlock) pC += 2;
 			break;
-		case _CMPG_R_IMMI:
-			CMPG_R_IMMI(binBlock);
-			if (binBlock) pC += 5;
+		case _FPUSHES_FR_FR:
+			FPUSHES_FR_FR(binBlock);
+			if (binBlock) pC += 2;
 			break;
-		case _CMPGE_R_IMMI:
-			CMPGE_R_IMMI(binBlock);
-			if (binBlock) pC += 5;
+		case _FPOPS_FR_FR:
+			FPOPS_FR_FR(binBlock);
+			if (binBlock) pC += 2;
 			break;
-		case _CMPL_R_IMMI:
-			CMPL_R_IMMI(binBlock);
-			if (binBlock) pC += 5;
+		case _FPUSH_FR:
+			FPUSH_FR(binBlock);
+			if (binBlock) ++pC;
 			break;
-		case _CMPLE_R_IMMI:
-			CMPLE_R_IMMI(binBlock);
-			if (binBlock) pC += 5;
+		case _FPOP_FR:
+			FPOP_FR(binBlock);
+			if (binBlock) ++pC;
 			break;
 		case _TIME:
 			TIME(binBlock);
@@ -779,17 +1905,21 @@ int X86DynaRecCore::fdCycle(X86BinBlock *binBlock) {
 			RAND(binBlock);
 			break;
 		case _JMP_R:
-			pC -= 2;
-			return FD_CYCLE_JMP_R;
+			if (!binBlock) break;
+			JMP_R(binBlock);
+			return FD_CYCLE_BLOCK_END;
 		case _JMPR_R:
-			pC -= 2;
-			return FD_CYCLE_JMPR_R;
+			if (!binBlock) break;
+			JMPR_R(binBlock);
+			return FD_CYCLE_BLOCK_END;
 		case _JC_R_R:
-			pC -= 2;
-			return FD_CYCLE_JC_R_R;
+			if (!binBlock) break;
+			JC_R_R(binBlock);
+			return FD_CYCLE_BLOCK_END;
 		case _JCR_R_R:
-			pC -= 2;
-			return FD_CYCLE_JCR_R_R;
+			if (!binBlock) break;
+			JCR_R_R(binBlock);
+			return FD_CYCLE_BLOCK_END;
 	}
 
 	if (!binBlock) {
@@ -799,74 +1929,45 @@ int X86DynaRecCore::fdCycle(X86BinBlock *binBlock) {
 }
 
 void X86DynaRecCore::MOV_R_MR_IMMI(X86BinBlock *binBlock) {
-	uint64 mRegAddr = (uint64)regs + (memManager.codeSpace[pC + 1] << 3);
-	uint64 regAddr = (uint64)regs + (memManager.codeSpace[pC] << 3);
+	uint8 reg = memManager.codeSpace[pC];
+	uint8 mReg = memManager.codeSpace[pC + 1];
 	uint32 immi = *(uint32*)&memManager.codeSpace[pC + 2];
 
-	movRAX_MOffset(binBlock, mRegAddr);	//mov rax, (mRegAddr)
-	addRAX_Immi32(binBlock, immi);	//add rax, immi
-	movReg32MReg32(binBlock, eax, rax);	//mov eax, (rax)
-	movMOffsetRAX(binBlock, regAddr);	//mov (regAddr), rax
+	X86_64Register base = regAllocator.useReg(binBlock, mReg, rax);	//mov rax, mReg
+	X86_64Register dst = regAllocator.getReg(reg, rax);
+	movReg32MRegDisp(binBlock, dst, base, immi);	//mov eax, (rax + immi)
+	regAllocator.storeReg(binBlock, reg, dst);	//mov reg, rax
 }
 
 void X86DynaRecCore::MOV_MR_IMMI_R(X86BinBlock *binBlock) {
-	uint64 mRegAddr = (uint64)regs + (memManager.codeSpace[pC + 1] << 3);
-	uint64 regAddr = (uint64)regs + (memManager.codeSpace[pC] << 3);
+	uint8 reg = memManager.codeSpace[pC];
+	uint8 mReg = memManager.codeSpace[pC + 1];
 	uint32 immi = *(uint32*)&memManager.codeSpace[pC + 2];
 
-	movRAX_MOffset(binBlock, mRegAddr);	//mov rax, (mRegAddr)
-	addRAX_Immi32(binBlock, immi);	//add rax, immi
-	movReg64Reg64(binBlock, rcx, rax);	//mov rcx, rax
-	movEAX_MOffset(binBlock, regAddr);	//mov eax, (regAddr)
-	movMReg32Reg32(binBlock, rcx, eax);	//mov (rcx), eax
+	X86_64Register base = regAllocator.useReg(binBlock, mReg, rax);	//mov rax, mReg
+	X86_64Register src = regAllocator.useReg(binBlock, reg, rcx);	//mov rcx, reg
+	movMRegDispReg32(binBlock, base, immi, src);	//mov (rax + immi), ecx
 }
 
 void X86DynaRecCore::MOV_MR_IMMI_MR_IMMI(X86BinBlock *binBlock) {
-	uint64 mRegAddr1 = (uint64)regs + (memManager.codeSpace[pC] << 3);
-	uint64 mRegAddr2 = (uint64)regs + (memManager.codeSpace[pC + 1] << 3);
+	uint8 mReg1 = memManager.codeSpace[pC];
+	uint8 mReg2 = memManager.codeSpace[pC + 1];
 	uint32 immi1 = *(uint32*)&memManager.codeSpace[pC + 2];
 	uint32 immi2 = *(uint32*)&memManager.codeSpace[pC + 6];
 
-	movRAX_MOffset(binBlock, mRegAddr2);	//mov rax, (mRegAddr2)
-	addRAX_Immi32(binBlock, immi2);	//add rax, immi1
-	movReg32MReg32(binBlock, ecx, rax);	//mov ecx, (rax)
-	movRAX_MOffset(binBlock, mRegAddr1);	//mov rax, (mRegAddr1)
-	addRAX_Immi32(binBlock, immi1);	//add rax, immi2
-	movMReg32Reg32(binBlock, rax, ecx);	//mov (rax), ecx
+	X86_64Register base = regAllocator.useReg(binBlock, mReg2, rax);	//mov rax, mReg2
+	movReg32MRegDisp(binBlock, ecx, base, immi2);	//mov ecx, (rax + immi2)
+	base = regAllocator.useReg(binBlock, mReg1, rax);	//mov rax, mReg1
+	movMRegDispReg32(binBlock, base, immi1, ecx);	//mov (rax + immi1), ecx
 }
 
 void X86DynaRecCore::MOV_MR_IMMI_IMMI(X86BinBlock *binBlock) {
-	uint64 mRegAddr = (uint64)regs + (memManager.codeSpace[pC] << 3);
+	uint8 mReg = memManager.codeSpace[pC];
 	uint32 immi1 = *(uint32*)&memManager.codeSpace[pC + 1];
 	uint32 immi2 = *(uint32*)&memManager.codeSpace[pC + 5];
 
-	movRAX_MOffset(binBlock, mRegAddr);	//mov rax, (mRegAddr)
-	addRAX_Immi32(binBlock, immi1);	//add rax, immi1
-	movMReg32Immi32(binBlock, rax, immi2);	//mov (rax), immi2
-}
-
-void X86DynaRecCore::MOV_R_M(X86BinBlock *binBlock) {
-	uint64 regAddr = (uint64)regs + (memManager.codeSpace[pC] << 3);
-	uint64 gMemoryAddr = (uint64)memManager.globalDataSpace + *(uint32*)&memManager.codeSpace[pC + 1];
-
-	movEAX_MOffset(binBlock, gMemoryAddr);	//mov eax, (gMemoryAddr)
-	movMOffsetRAX(binBlock, regAddr);	//mov (regAddr), rax
-}
-
-void X86DynaRecCore::MOV_M_R(X86BinBlock *binBlock) {
-	uint64 regAddr = (uint64)regs + (memManager.codeSpace[pC] << 3);
-	uint64 gMemoryAddr = (uint64)memManager.globalDataSpace + *(uint32*)&memManager.codeSpace[pC + 1];
-
-	movEAX_MOffset(binBlock, regAddr);	//mov eax, (regAddr)
-	movMOffsetEAX(binBlock, gMemoryAddr);	//mov (gMemoryAddr), eax
-}
-
-void X86DynaRecCore::MOV_R_R(X86BinBlock *binBlock) {
-	uint64 regAddr1 = (uint64)regs + (memManager.codeSpace[pC] << 3);
-	uint64 regAddr2 = (uint64)regs + (memManager.codeSpace[pC + 1] << 3);
-
-	movRAX_MOffset(binBlock, regAddr2);	//mov rax, (regAddr2)
-	movMOffsetRAX(binBlock, regAddr1);	//mov (regAddr1), rax
+	X86_64Register base = regAllocator.useReg(binBlock, mReg, rax);	//mov rax, mReg
+	movMRegDisp32Immi32(binBlock, base, immi1, immi2);	//mov (rax + immi1), immi2
 }
 
 void X86DynaRecCore::MOV_M_M(X86BinBlock *binBlock) {
@@ -878,268 +1979,57 @@ void X86DynaRecCore::MOV_M_M(X86BinBlock *binBlock) {
 }
 
 void X86DynaRecCore::MOV_MR_R(X86BinBlock *binBlock) {
-	uint64 mRegAddr = (uint64)regs + (memManager.codeSpace[pC + 1] << 3);
-	uint64 regAddr = (uint64)regs + (memManager.codeSpace[pC] << 3);
-
-	movRAX_MOffset(binBlock, mRegAddr);	//mov rax, (mRegAddr)
-	movReg64Reg64(binBlock, rcx, rax);	//mov rcx, rax
-	movEAX_MOffset(binBlock, regAddr);	//mov eax, (regAddr)
-	movMReg32Reg32(binBlock, rcx, eax);	//mov (rcx), eax
-}
-
-void X86DynaRecCore::MOV_R_MR(X86BinBlock *binBlock) {
-	uint64 mRegAddr = (uint64)regs + (memManager.codeSpace[pC + 1] << 3);
-	uint64 regAddr = (uint64)regs + (memManager.codeSpace[pC] << 3);
-
-	movRAX_MOffset(binBlock, mRegAddr);	//mov rax, (mRegAddr)
-	movReg32MReg32(binBlock, eax, rax);	//mov eax, (rax)
-	movMOffsetRAX(binBlock, regAddr);	//mov (regAddr), rax
-}
-
-void X86DynaRecCore::MOV_MR_M(X86BinBlock *binBlock) {
-	uint64 mRegAddr = (uint64)regs + (memManager.codeSpace[pC] << 3);
-	uint64 gMemoryAddr = (uint64)memManager.globalDataSpace + *(uint32*)&memManager.codeSpace[pC + 1];
-
-	movRAX_MOffset(binBlock, mRegAddr);	//mov rax, (mRegAddr)
-	movReg64Reg64(binBlock, rcx, rax);	//mov rcx, rax
-	movEAX_MOffset(binBlock, gMemoryAddr);	//mov eax, (gMemoryAddr)
-	movMReg32Reg32(binBlock, rcx, eax);	//mov (rcx), eax
-}
-
-void X86DynaRecCore::MOV_M_MR(X86BinBlock *binBlock) {
-	uint64 gMemoryAddr = (uint64)memManager.globalDataSpace + *(uint32*)&memManager.codeSpace[pC + 1];
-	uint64 mRegAddr = (uint64)regs + (memManager.codeSpace[pC] << 3);
-
-	movRAX_MOffset(binBlock, mRegAddr);	//mov rax, (mRegAddr)
-	movReg32MReg32(binBlock, eax, rax);	//mov eax, (rax)
-	movMOffsetEAX(binBlock, gMemoryAddr);	//mov (gMemoryAddr), eax
-}
-
-void X86DynaRecCore::MOV_MR_MR(X86BinBlock *binBlock) {
-	uint64 mRegAddr1 = (uint64)regs + (memManager.codeSpace[pC] << 3);
-	uint64 mRegAddr2 = (uint64)regs + (memManager.codeSpace[pC + 1] << 3);
-
-	movRAX_MOffset(binBlock, mRegAddr2);	//mov rax, (mRegAddr2)
-	movReg32MReg32(binBlock, ecx, rax);	//mov ecx, (rax)
-	movRAX_MOffset(binBlock, mRegAddr1);	//mov rax, (mRegAddr1)
-	movMReg32Reg32(binBlock, rax, ecx);	//mov (rax), ecx
-}
-
-void X86DynaRecCore::MOV_R_IMMI(X86BinBlock *binBlock) {
-	uint64 regAddr = (uint64)regs + (memManager.codeSpace[pC] << 3);
-	uint32 immiValue = *(uint32*)&memManager.codeSpace[pC + 1];
-
-	movReg32Immi32(binBlock, eax, immiValue);	//mov eax, immiValue
-	movMOffsetRAX(binBlock, regAddr);	//mov (regAddr), rax
-}
-
-void X86DynaRecCore::MOV_M_IMMI(X86BinBlock *binBlock) {
-	uint64 gMemoryAddr = (uint64)memManager.globalDataSpace + *(uint32*)&memManager.codeSpace[pC];
-	uint32 immiValue = *(uint32*)&memManager.codeSpace[pC + 4];
-
-	movReg64Immi64(binBlock, rax, gMemoryAddr);	//mov rax, gMemoryAddr
-	movMReg32Immi32(binBlock, rax, immiValue);	//mov (rax), immiValue
-}
-
-void X86DynaRecCore::MOV_MR_IMMI(X86BinBlock *binBlock) {
-	uint64 mRegAddr = (uint64)regs + (memManager.codeSpace[pC] << 3);
-	uint32 immiValue = *(uint32*)&memManager.codeSpace[pC + 1];
-
-	movRAX_MOffset(binBlock, mRegAddr);	//mov rax, (mRegAddr)
-	movMReg32Immi32(binBlock, rax, immiValue);	//mov (rax), immiValue
-}
-
-void X86DynaRecCore::ADD_R_R(X86BinBlock *binBlock) {
-	uint64 regAddr1 = (uint64)regs + (memManager.codeSpace[pC] << 3);
-	uint64 regAddr2 = (uint64)regs + (memManager.codeSpace[pC + 1] << 3);
-
-	movRAX_MOffset(binBlock, regAddr2);	//mov rax, (regAddr2)
-	movReg64Immi64(binBlock, rcx, regAddr1);	//mov rcx, regAddr1
-	addMReg64Reg64(binBlock, rcx, rax);	//add (rcx), rax
-}
-
-void X86DynaRecCore::ADD_R_IMMI(X86BinBlock *binBlock) {
-	uint64 regAddr = (uint64)regs + (memManager.codeSpace[pC] << 3);
-	uint32 immiValue = *(uint32*)&memManager.codeSpace[pC + 1];
-
-	movReg64Immi64(binBlock, rax, regAddr);	//mov rax, regAddr
-	movReg32Immi32(binBlock, ecx, immiValue);	//mov ecx, immiValue
-	addMReg64Reg64(binBlock, rax, rcx);	//add (rax), rcx
-}
-
-void X86DynaRecCore::SUB_R_R(X86BinBlock *binBlock) {
-	uint64 regAddr1 = (uint64)regs + (memManager.codeSpace[pC] << 3);
-	uint64 regAddr2 = (uint64)regs + (memManager.codeSpace[pC + 1] << 3);
-
-	movRAX_MOffset(binBlock, regAddr2);	//mov rax, (regAddr2)
-	movReg64Immi64(binBlock, rcx, regAddr1);	//mov rcx, regAddr1
-	subMReg64Reg64(binBlock, rcx, rax);	//sub (rcx), rax
-}
-
-void X86DynaRecCore::SUB_R_IMMI(X86BinBlock *binBlock) {
-	uint64 regAddr = (uint64)regs + (memManager.codeSpace[pC] << 3);
-	uint32 immiValue = *(uint32*)&memManager.codeSpace[pC + 1];
-
-	movReg64Immi64(binBlock, rax, regAddr);	//mov rax, regAddr
-	movReg32Immi32(binBlock, ecx, immiValue);	//mov ecx, immiValue
-	subMReg64Reg64(binBlock, rax, rcx);	//sub (rax), rcx
-}
-
-void X86DynaRecCore::MUL_R_R(X86BinBlock *binBlock) {
-	uint64 regAddr1 = (uint64)regs + (memManager.codeSpace[pC] << 3);
-	uint64 regAddr2 = (uint64)regs + (memManager.codeSpace[pC + 1] << 3);
-
-	movReg64Immi64(binBlock, rcx, regAddr2);	//mov rcx, regAddr2
-	movRAX_MOffset(binBlock, regAddr1);	//mov rax, (regAddr1)
-	imulReg64MReg64(binBlock, rax, rcx);	//imul rax, (rcx)
-	movMOffsetRAX(binBlock, regAddr1);	//mov (regAddr1), rax
-}
-
-void X86DynaRecCore::MUL_R_IMMI(X86BinBlock *binBlock) {
-	uint64 regAddr = (uint64)regs + (memManager.codeSpace[pC] << 3);
-	uint32 immiValue = *(uint32*)&memManager.codeSpace[pC + 1];
-
-	movRAX_MOffset(binBlock, regAddr);	//mov rax, (regAddr)
-	imulReg64Reg64Immi32(binBlock, rax, rax, immiValue); //imul rax, rax, immiValue
-	movMOffsetRAX(binBlock, regAddr);	//mov (regAddr), rax
-}
-
-void X86DynaRecCore::DIV_R_R(X86BinBlock *binBlock) {
-	uint64 regAddr1 = (uint64)regs + (memManager.codeSpace[pC] << 3);
-	uint64 regAddr2 = (uint64)regs + (memManager.codeSpace[pC + 1] << 3);
-
-	movRAX_MOffset(binBlock, regAddr2);	//mov rax, (regAddr2)
-	movReg64Reg64(binBlock, rcx, rax);	//mov rcx, rax
-	movRAX_MOffset(binBlock, regAddr1);	//mov rax, (regAddr1)
-	xorReg64Reg64(binBlock, rdx, rdx);	//xor rdx, rdx
-	idivRAX_Reg64(binBlock, rcx);	//idiv rax, rcx
-	movMOffsetRAX(binBlock, regAddr1);	//mov (regAddr1), rax
-}
-
-void X86DynaRecCore::DIV_R_IMMI(X86BinBlock *binBlock) {
-	uint64 regAddr = (uint64)regs + (memManager.codeSpace[pC] << 3);
-	uint32 immiValue = *(uint32*)&memManager.codeSpace[pC + 1];
-
-	movReg32Immi32(binBlock, ecx, immiValue);	//mov ecx, immiValue
-	movRAX_MOffset(binBlock, regAddr);	//mov rax, (regAddr)
-	xorReg64Reg64(binBlock, rdx, rdx);	//xor rdx, rdx
-	idivRAX_Reg64(binBlock, rcx); //idiv rax, rcx
-	movMOffsetRAX(binBlock, regAddr);	//mov (regAddr), rax
-}
-
-void X86DynaRecCore::MOD_R_R(X86BinBlock *binBlock) {
-	uint64 regAddr1 = (uint64)regs + (memManager.codeSpace[pC] << 3);
-	uint64 regAddr2 = (uint64)regs + (memManager.codeSpace[pC + 1] << 3);
-
-	movRAX_MOffset(binBlock, regAddr2);	//mov rax, (regAddr2)
-	movReg64Reg64(binBlock, rcx, rax);	//mov rcx, rax
-	movRAX_MOffset(binBlock, regAddr1);	//mov rax, (regAddr1)
-	xorReg64Reg64(binBlock, rdx, rdx);	//xor rdx, rdx
-	idivRAX_Reg64(binBlock, rcx);	//idiv rax, rcx
-	movReg64Reg64(binBlock, rax, rdx);	//mov rax, rdx
-	movMOffsetRAX(binBlock, regAddr1);	//mov (regAddr1), rax
-}
-
-void X86DynaRecCore::MOD_R_IMMI(X86BinBlock *binBlock) {
-	uint64 regAddr = (uint64)regs + (memManager.codeSpace[pC] << 3);
-	uint32 immiValue = *(uint32*)&memManager.codeSpace[pC + 1];
-
-	movReg32Immi32(binBlock, ecx, immiValue);	//mov ecx, immiValue
-	movRAX_MOffset(binBlock, regAddr);	//mov rax, (regAddr)
-	xorReg64Reg64(binBlock, rdx, rdx);	//xor rdx, rdx
-	idivRAX_Reg64(binBlock, rcx); //idiv rax, rcx
-	movReg64Reg64(binBlock, rax, rdx);	//mov rax, rdx
-	movMOffsetRAX(binBlock, regAddr);	//mov (regAddr), rax
-}
-
-void X86DynaRecCore::AND_R_R(X86BinBlock *binBlock) {
-	uint64 regAddr1 = (uint64)regs + (memManager.codeSpace[pC] << 3);
-	uint64 regAddr2 = (uint64)regs + (memManager.codeSpace[pC + 1] << 3);
-
-	movRAX_MOffset(binBlock, regAddr2);	//mov rax, (regAddr2)
-	movReg64Immi64(binBlock, rcx, regAddr1);	//mov rcx, regAddr1
-	andMReg64Reg64(binBlock, rcx, rax);	//and (rcx), rax
-}
-
-void X86DynaRecCore::AND_R_IMMI(X86BinBlock *binBlock) {
-	uint64 regAddr = (uint64)regs + (memManager.codeSpace[pC] << 3);
-	uint32 immiValue = *(uint32*)&memManager.codeSpace[pC + 1];
-
-	movReg64Immi64(binBlock, rax, regAddr);	//mov rax, regAddr
-	movReg32Immi32(binBlock, ecx, immiValue);	//mov ecx, immiValue
-	andMReg64Reg64(binBlock, rax, rcx);	//and (rax), rcx
-}
-
-void X86DynaRecCore::OR_R_R(X86BinBlock *binBlock) {
-	uint64 regAddr1 = (uint64)regs + (memManager.codeSpace[pC] << 3);
-	uint64 regAddr2 = (uint64)regs + (memManager.codeSpace[pC + 1] << 3);
-
-	movRAX_MOffset(binBlock, regAddr2);	//mov rax, (regAddr2)
-	movReg64Immi64(binBlock, rcx, regAddr1);	//mov rcx, regAddr1
-	orMReg64Reg64(binBlock, rcx, rax);	//or (rcx), rax
-}
-
-void X86DynaRecCore::OR_R_IMMI(X86BinBlock *binBlock) {
-	uint64 regAddr = (uint64)regs + (memManager.codeSpace[pC] << 3);
-	uint32 immiValue = *(uint32*)&memManager.codeSpace[pC + 1];
-
-	movReg64Immi64(binBlock, rax, regAddr);	//mov rax, regAddr
-	movReg32Immi32(binBlock, ecx, immiValue);	//mov ecx, immiValue
-	orMReg64Reg64(binBlock, rax, rcx);	//or (rax), rcx
-}
-
-void X86DynaRecCore::XOR_R_R(X86BinBlock *binBlock) {
-	uint64 regAddr1 = (uint64)regs + (memManager.codeSpace[pC] << 3);
-	uint64 regAddr2 = (uint64)regs + (memManager.codeSpace[pC + 1] << 3);
+	uint8 reg = memManager.codeSpace[pC];
+	uint8 mReg = memManager.codeSpace[pC + 1];
 
-	movRAX_MOffset(binBlock, regAddr2);	//mov rax, (regAddr2)
-	movReg64Immi64(binBlock, rcx, regAddr1);	//mov rcx, regAddr1
-	xorMReg64Reg64(binBlock, rcx, rax);	//xor (rcx), rax
+	regAllocator.loadReg(binBlock, rax, mReg);	//mov rax, mReg
+	X86_64Register src = regAllocator.useReg(binBlock, reg, rcx);	//mov rcx, reg
+	movMReg32Reg32(binBlock, rax, src);	//mov (rax), ecx
 }
 
-void X86DynaRecCore::XOR_R_IMMI(X86BinBlock *binBlock) {
-	uint64 regAddr = (uint64)regs + (memManager.codeSpace[pC] << 3);
-	uint32 immiValue = *(uint32*)&memManager.codeSpace[pC + 1];
+void X86DynaRecCore::MOV_R_MR(X86BinBlock *binBlock) {
+	uint8 reg = memManager.codeSpace[pC];
+	uint8 mReg = memManager.codeSpace[pC + 1];
 
-	movReg64Immi64(binBlock, rax, regAddr);	//mov rax, regAddr
-	movReg32Immi32(binBlock, ecx, immiValue);	//mov ecx, immiValue
-	xorMReg64Reg64(binBlock, rax, rcx);	//xor (rax), rcx
+	regAllocator.loadReg(binBlock, rax, mReg);	//mov rax, mReg
+	movReg32MReg32(binBlock, eax, rax);	//mov eax, (rax)
+	regAllocator.storeReg(binBlock, reg, rax);	//mov reg, rax
 }
 
-void X86DynaRecCore::SHL_R_IMMI8(X86BinBlock *binBlock) {
-	uint64 regAddr = (uint64)regs + (memManager.codeSpace[pC] << 3);
-	uint8 immiValue = memManager.codeSpace[pC + 1];
+void X86DynaRecCore::MOV_MR_M(X86BinBlock *binBlock) {
+	uint8 mReg = memManager.codeSpace[pC];
+	uint64 gMemoryAddr = (uint64)memManager.globalDataSpace + *(uint32*)&memManager.codeSpace[pC + 1];
 
-	movReg64Immi64(binBlock, rax, regAddr);	//mov rax, regAddr
-	shlMReg64Immi8(binBlock, rax, immiValue);	//shl (rax), immiValue
+	regAllocator.loadReg(binBlock, rcx, mReg);	//mov rcx, mReg
+	movEAX_MOffset(binBlock, gMemoryAddr);	//mov eax, (gMemoryAddr)
+	movMReg32Reg32(binBlock, rcx, eax);	//mov (rcx), eax
 }
 
-void X86DynaRecCore::SHL_R_R(X86BinBlock *binBlock) {
-	uint64 regAddr1 = (uint64)regs + (memManager.codeSpace[pC] << 3);
-	uint64 regAddr2 = (uint64)regs + (memManager.codeSpace[pC + 1] << 3);
+void X86DynaRecCore::MOV_M_MR(X86BinBlock *binBlock) {
+	uint64 gMemoryAddr = (uint64)memManager.globalDataSpace + *(uint32*)&memManager.codeSpace[pC + 1];
+	uint8 mReg = memManager.codeSpace[pC];
 
-	movRAX_MOffset(binBlock, regAddr2);	//mov rax, (regAddr2)
-	movReg64Reg64(binBlock, rcx, rax);	//mov rcx, rax
-	movReg64Immi64(binBlock, rax, regAddr1);	//mov rax, regAddr1
-	shlMReg64Cl(binBlock, rax);	//shl (rax), cl
+	regAllocator.loadReg(binBlock, rax, mReg);	//mov rax, mReg
+	movReg32MReg32(binBlock, eax, rax);	//mov eax, (rax)
+	movMOffsetEAX(binBlock, gMemoryAddr);	//mov (gMemoryAddr), eax
 }
 
-void X86DynaRecCore::SHR_R_IMMI8(X86BinBlock *binBlock) {
-	uint64 regAddr = (uint64)regs + (memManager.codeSpace[pC] << 3);
-	uint8 immiValue = memManager.codeSpace[pC + 1];
+void X86DynaRecCore::MOV_MR_MR(X86BinBlock *binBlock) {
+	uint8 mReg1 = memManager.codeSpace[pC];
+	uint8 mReg2 = memManager.codeSpace[pC + 1];
 
-	movReg64Immi64(binBlock, rax, regAddr);	//mov rax, regAddr
-	shrMReg64Immi8(binBlock, rax, immiValue);	//shr (rax), immiValue
+	regAllocator.loadReg(binBlock, rax, mReg2);	//mov rax, mReg2
+	movReg32MReg32(binBlock, ecx, rax);	//mov ecx, (rax)
+	regAllocator.loadReg(binBlock, rax, mReg1);	//mov rax, mReg1
+	movMReg32Reg32(binBlock, rax, ecx);	//mov (rax), ecx
 }
 
-void X86DynaRecCore::SHR_R_R(X86BinBlock *binBlock) {
-	uint64 regAddr1 = (uint64)regs + (memManager.codeSpace[pC] << 3);
-	uint64 regAddr2 = (uint64)regs + (memManager.codeSpace[pC + 1] << 3);
+void X86DynaRecCore::MOV_MR_IMMI(X86BinBlock *binBlock) {
+	uint8 mReg = memManager.codeSpace[pC];
+	uint32 immiValue = *(uint32*)&memManager.codeSpace[pC + 1];
 
-	movRAX_MOffset(binBlock, regAddr2);	//mov rax, (regAddr2)
-	movReg64Reg64(binBlock, rcx, rax);	//mov rcx, rax
-	movReg64Immi64(binBlock, rax, regAddr1);	//mov rax, regAddr1
-	shrMReg64Cl(binBlock, rax);	//shr (rax), cl
+	regAllocator.loadReg(binBlock, rax, mReg);	//mov rax, mReg
+	movMReg32Immi32(binBlock, rax, immiValue);	//mov (rax), immiValue
 }
 
 void X86DynaRecCore::NOP(X86BinBlock *binBlock) {
@@ -1147,656 +2037,664 @@ void X86DynaRecCore::NOP(X86BinBlock *binBlock) {
 }
 
 void X86DynaRecCore::MOVP_R_MR_IMMI(X86BinBlock *binBlock) {
-	uint64 mRegAddr = (uint64)regs + (memManager.codeSpace[pC + 1] << 3);
-	uint64 regAddr = (uint64)regs + (memManager.codeSpace[pC] << 3);
+	uint8 reg = memManager.codeSpace[pC];
+	uint8 mReg = memManager.codeSpace[pC + 1];
 	uint32 immi = *(uint32*)&memManager.codeSpace[pC + 2];
 
-	movRAX_MOffset(binBlock, mRegAddr);	//mov rax, (mRegAddr)
-	addRAX_Immi32(binBlock, immi);	//add rax, immi
-	movReg64MReg64(binBlock, rax, rax);	//mov rax, (rax)
-	movMOffsetRAX(binBlock, regAddr);	//mov (regAddr), rax
+	X86_64Register base = regAllocator.useReg(binBlock, mReg, rax);	//mov rax, mReg
+	X86_64Register dst = regAllocator.getReg(reg, rax);
+	movReg64MRegDisp(binBlock, dst, base, immi);	//mov rax, (rax + immi)
+	regAllocator.storeReg(binBlock, reg, dst);	//mov reg, rax
 }
 
 void X86DynaRecCore::MOVP_MR_IMMI_R(X86BinBlock *binBlock) {
-	uint64 mRegAddr = (uint64)regs + (memManager.codeSpace[pC + 1] << 3);
-	uint64 regAddr = (uint64)regs + (memManager.codeSpace[pC] << 3);
+	uint8 reg = memManager.codeSpace[pC];
+	uint8 mReg = memManager.codeSpace[pC + 1];
 	uint32 immi = *(uint32*)&memManager.codeSpace[pC + 2];
 
-	movRAX_MOffset(binBlock, mRegAddr);	//mov rax, (mRegAddr)
-	addRAX_Immi32(binBlock, immi);	//add rax, immi
-	movReg64Reg64(binBlock, rcx, rax);	//mov rcx, rax
-	movRAX_MOffset(binBlock, regAddr);	//mov rax, (regAddr)
-	movMReg64Reg64(binBlock, rcx, rax);	//mov (rcx), rax
+	X86_64Register base = regAllocator.useReg(binBlock, mReg, rax);	//mov rax, mReg
+	X86_64Register src = regAllocator.useReg(binBlock, reg, rcx);	//mov rcx, reg
+	movMRegDispReg64(binBlock, base, immi, src);	//mov (rax + immi), rcx
 }
 
 void X86DynaRecCore::MOVP_MR_IMMI_MR_IMMI(X86BinBlock *binBlock) {
-	uint64 mRegAddr1 = (uint64)regs + (memManager.codeSpace[pC] << 3);
-	uint64 mRegAddr2 = (uint64)regs + (memManager.codeSpace[pC + 1] << 3);
+	uint8 mReg1 = memManager.codeSpace[pC];
+	uint8 mReg2 = memManager.codeSpace[pC + 1];
 	uint32 immi1 = *(uint32*)&memManager.codeSpace[pC + 2];
 	uint32 immi2 = *(uint32*)&memManager.codeSpace[pC + 6];
 
-	movRAX_MOffset(binBlock, mRegAddr2);	//mov rax, (mRegAddr2)
-	addRAX_Immi32(binBlock, immi2);	//add rax, immi1
-	movReg64MReg64(binBlock, rcx, rax);	//mov rcx, (rax)
-	movRAX_MOffset(binBlock, mRegAddr1);	//mov rax, (mRegAddr1)
-	addRAX_Immi32(binBlock, immi1);	//add rax, immi2
-	movMReg64Reg64(binBlock, rax, rcx);	//mov (rax), rcx
-}
-
-void X86DynaRecCore::MOVP_R_M(X86BinBlock *binBlock) {
-	uint64 regAddr = (uint64)regs + (memManager.codeSpace[pC] << 3);
-	uint64 gMemoryAddr = (uint64)memManager.globalDataSpace + *(uint32*)&memManager.codeSpace[pC + 1];
-
-	movRAX_MOffset(binBlock, gMemoryAddr);	//mov rax, (gMemoryAddr)
-	movMOffsetRAX(binBlock, regAddr);	//mov (regAddr), rax
-}
-
-void X86DynaRecCore::MOVP_M_R(X86BinBlock *binBlock) {
-	uint64 regAddr = (uint64)regs + (memManager.codeSpace[pC] << 3);
-	uint64 gMemoryAddr = (uint64)memManager.globalDataSpace + *(uint32*)&memManager.codeSpace[pC + 1];
-
-	movRAX_MOffset(binBlock, regAddr);	//mov rax, (regAddr)
-	movMOffsetRAX(binBlock, gMemoryAddr);	//mov (gMemoryAddr), rax
+	X86_64Register base = regAllocator.useReg(binBlock, mReg2, rax);	//mov rax, mReg2
+	movReg64MRegDisp(binBlock, rcx, base, immi2);	//mov rcx, (rax + immi2)
+	base = regAllocator.useReg(binBlock, mReg1, rax);	//mov rax, mReg1
+	movMRegDispReg64(binBlock, base, immi1, rcx);	//mov (rax + immi1), rcx
 }
 
 void X86DynaRecCore::MOVP_R_MR(X86BinBlock *binBlock) {
-	uint64 mRegAddr = (uint64)regs + (memManager.codeSpace[pC + 1] << 3);
-	uint64 regAddr = (uint64)regs + (memManager.codeSpace[pC] << 3);
+	uint8 reg = memManager.codeSpace[pC];
+	uint8 mReg = memManager.codeSpace[pC + 1];
 
-	movRAX_MOffset(binBlock, mRegAddr);	//mov rax, (mRegAddr)
+	regAllocator.loadReg(binBlock, rax, mReg);	//mov rax, mReg
 	movReg64MReg64(binBlock, rax, rax);	//mov rax, (rax)
-	movMOffsetRAX(binBlock, regAddr);	//mov (regAddr), rax
+	regAllocator.storeReg(binBlock, reg, rax);	//mov reg, rax
 }
 
 void X86DynaRecCore::MOVP_MR_R(X86BinBlock *binBlock) {
-	uint64 mRegAddr = (uint64)regs + (memManager.codeSpace[pC + 1] << 3);
-	uint64 regAddr = (uint64)regs + (memManager.codeSpace[pC] << 3);
+	uint8 reg = memManager.codeSpace[pC];
+	uint8 mReg = memManager.codeSpace[pC + 1];
 
-	movRAX_MOffset(binBlock, regAddr);	//mov rax, (regAddr)
-	movReg64Reg64(binBlock, rcx, rax);	//mov rcx, rax
-	movRAX_MOffset(binBlock, mRegAddr);	//mov rax, (mRegAddr)
-	movMReg64Reg64(binBlock, rax, rcx);	//mov (rax), rcx
+	regAllocator.loadReg(binBlock, rax, mReg);	//mov rax, mReg
+	X86_64Register src = regAllocator.useReg(binBlock, reg, rcx);	//mov rcx, reg
+	movMReg64Reg64(binBlock, rax, src);	//mov (rax), rcx
 }
 
 void X86DynaRecCore::PUSH_R(X86BinBlock *binBlock) {
-	uint64 stackAddr = (uint64)memManager.stackSpace;
-	uint64 stackPointerAddr = (uint64)&sP;
-	uint64 regAddr = (uint64)regs + (memManager.codeSpace[pC] << 3);
+	int64 *stackPointerAddr = &sP;
+	uint8 reg = memManager.codeSpace[pC];
 	
-	movRAX_MOffset(binBlock, regAddr);	//mov rax, (regAddr)
-	movReg64Immi64(binBlock, rdx, stackAddr);	//mov rdx, stackAddr
-	movReg64Immi64(binBlock, rcx, stackPointerAddr);	//mov rcx, stackPointerAddr
-	movReg32MReg32(binBlock, ebx, rcx);	//mov ebx, (rcx)
-	movMReg64Reg64(binBlock, 0, ebx, rdx, rax);	//mov (rdx + ebx), rax
-	addMReg32Immi8(binBlock, rcx, 8);	//add (rcx), 8
+	movReg32MRegDisp(binBlock, edx, CONTEXT_REGISTER, getContextOffset(stackPointerAddr));	//mov edx, (stackPointerAddr)
+	putStackAddress(binBlock, rax);	//mov rax, stackAddr
+	addReg64Reg64(binBlock, rdx, rax);	//add rdx, rax
+	X86_64Register src = regAllocator.useReg(binBlock, reg, rax);	//mov rax, reg
+	movMReg64Reg64(binBlock, rdx, src);	//mov (rdx), rax
+	addMRegDisp32Immi8(binBlock, CONTEXT_REGISTER, getContextOffset(stackPointerAddr), 8);	//add (stackPointerAddr), 8
 }
 
 void X86DynaRecCore::POP_R(X86BinBlock *binBlock) {
-	uint64 stackAddr = (uint64)memManager.stackSpace;
-	uint64 stackPointerAddr = (uint64)&sP;
-	uint64 regAddr = (uint64)regs + (memManager.codeSpace[pC] << 3);
+	int64 *stackPointerAddr = &sP;
+	uint8 reg = memManager.codeSpace[pC];
 	
-	movReg64Immi64(binBlock, rdx, stackAddr);	//mov rdx, stackAddr
-	movReg64Immi64(binBlock, rcx, stackPointerAddr);	//mov rcx, stackPointerAddr
-	subMReg32Immi8(binBlock, rcx, 8);	//sub (rcx), 8
-	movReg32MReg32(binBlock, ebx, rcx);	//mov ebx, (rcx)
-	movReg64MReg64(binBlock, rax, 0, ebx, rdx);	//mov rax, (rdx + ebx)
-	movMOffsetRAX(binBlock, regAddr);	//mov (regAddr), rax
+	subMRegDisp32Immi8(binBlock, CONTEXT_REGISTER, getContextOffset(stackPointerAddr), 8);	//sub (stackPointerAddr), 8
+	movReg32MRegDisp(binBlock, edx, CONTEXT_REGISTER, getContextOffset(stackPointerAddr));	//mov edx, (stackPointerAddr)
+	putStackAddress(binBlock, rax);	//mov rax, stackAddr
+	addReg64Reg64(binBlock, rdx, rax);	//add rdx, rax
+	X86_64Register dst = regAllocator.getReg(reg, rax);
+	movReg64MReg64(binBlock, dst, rdx);	//mov rax, (rdx)
+	regAllocator.storeReg(binBlock, reg, dst);	//mov reg, rax
 }
 
 void X86DynaRecCore::draw(int x, int y, uint64 address, X86DynaRecCore *dynarecCore) {
 	dynarecCore->gpuCore->draw(x, y, address, PortManager::readPort<uint8>(PORT_GPU_EFFECTS, &dynarecCore->portManager), PortManager::readPort<uint16>(PORT_GPU_ROTATION, &dynarecCore->portManager));
 }
 
-void X86DynaRecCore::putDrawOpcode(X86BinBlock *binBlock, uint64 xAddr, uint64 yAddr, uint64 imgAddr) {
-void (*drawPtr)(int, int, uint64, X86DynaRecCore*) = draw;
+void X86DynaRecCore::putDrawOpcode(X86BinBlock *binBlock, const void *xAddr, const void *yAddr, const void *imgAddr) {
+	void (*drawPtr)(int, int, uint64, X86DynaRecCore*) = draw;
+	X86HostCall hostCall(binBlock);
 
-#ifdef USING_MICROSOFT_COMPILER
-	movRAX_MOffset(binBlock, xAddr);	//mov rax, (xAddr)
-	movReg64Reg64(binBlock, rcx, rax);	//mov rcx, rax
-	movRAX_MOffset(binBlock, yAddr);	//mov rax, (yAddr)
-	movReg64Reg64(binBlock, rdx, rax);	//mov rdx, rax
-	movRAX_MOffset(binBlock, imgAddr);	//mov rax, (imgAddr)
-	movReg64Reg64(binBlock, r8, rax);	//mov r8, rax
-	movReg64Immi64(binBlock, r9, (uint64)this);	//mov r9, this
-	movReg64Immi64(binBlock, rax, (uint64)drawPtr);	//mov rax, drawPtr
-	callReg64(binBlock, rax);	//call rax
-#endif
+	hostCall.argContext(getContextOffset(xAddr), 4);
+	hostCall.argContext(getContextOffset(yAddr), 4);
+	hostCall.argContext(getContextOffset(imgAddr), 8);
+	hostCall.argContextAddress(getContextOffset(this));
+	hostCall.call((uint64)drawPtr);
 }
 
 void X86DynaRecCore::DRW_R_R_MR(X86BinBlock *binBlock) {
-	uint64 regAddr1 = (uint64)regs + (memManager.codeSpace[pC] << 3);
-	uint64 regAddr2 = (uint64)regs + (memManager.codeSpace[pC + 1] << 3);
-	uint64 regAddr3 = (uint64)regs + (memManager.codeSpace[pC + 2] << 3);
+	int64 *regAddr1 = &regs[memManager.codeSpace[pC]];
+	int64 *regAddr2 = &regs[memManager.codeSpace[pC + 1]];
+	int64 *regAddr3 = &regs[memManager.codeSpace[pC + 2]];
 
 	putDrawOpcode(binBlock, regAddr1, regAddr2, regAddr3);
 }
 
+void X86DynaRecCore::putPortLoad(X86BinBlock *binBlock, X86_64Register reg, uint32 port, int size) {
+	uint32 disp = getContextOffset(portManager.getPortAddress(port));
+
+	switch (size) {
+		case 1:
+			movzxReg32MRegDisp8(binBlock, reg, CONTEXT_REGISTER, disp);
+			break;
+		case 2:
+			movzxReg32MRegDisp16(binBlock, reg, CONTEXT_REGISTER, disp);
+			break;
+		case 4:
+			movReg32MRegDisp(binBlock, reg, CONTEXT_REGISTER, disp);
+			break;
+		default:
+			movReg64MRegDisp(binBlock, reg, CONTEXT_REGISTER, disp);
+	}
+}
+
+void X86DynaRecCore::putPortStore(X86BinBlock *binBlock, uint32 port, X86_64Register reg, int size) {
+	uint32 disp = getContextOffset(portManager.getPortAddress(port));
+
+	switch (size) {
+		case 1:
+			movMRegDispReg8(binBlock, CONTEXT_REGISTER, disp, reg);
+			break;
+		case 2:
+			movMRegDispReg16(binBlock, CONTEXT_REGISTER, disp, reg);
+			break;
+		case 4:
+			movMRegDispReg32(binBlock, CONTEXT_REGISTER, disp, reg);
+			break;
+		default:
+			movMRegDispReg64(binBlock, CONTEXT_REGISTER, disp, reg);
+	}
+}
+
 void X86DynaRecCore::OUT_R_IMMI8(X86BinBlock *binBlock) {
 	void (*writePort)(uint8, uint32, PortManager*) = PortManager::writePort;
-	uint64 regAddr = (uint64)regs + (memManager.codeSpace[pC] << 3);
+	int64 *regAddr = &regs[memManager.codeSpace[pC]];
 	uint8 immi8 = memManager.codeSpace[pC + 1];
+	X86HostCall hostCall(binBlock);
 
-#ifdef USING_MICROSOFT_COMPILER
-	movReg8Immi8(binBlock, cl, immi8);	//mov cl, immi8
-	movRAX_MOffset(binBlock, regAddr);	//mov RAX, (regAddr)
-	movReg64Reg64(binBlock, rdx, rax);	//mov rdx, rax
-	movReg64Immi64(binBlock, r8, (uint64)&portManager);	//mov r8, portManager
-	movReg64Immi64(binBlock, rax, (uint64)writePort);	//mov rax, writePort
-	callReg64(binBlock, rax);	//call rax
-#endif
+	hostCall.argImmi(immi8);
+	hostCall.argContext(getContextOffset(regAddr), 4);
+	hostCall.argContextAddress(getContextOffset(&portManager));
+	hostCall.call((uint64)writePort);
 }
 
 void X86DynaRecCore::OUT_R_IMMI16(X86BinBlock *binBlock) {
 	void (*writePort)(uint16, uint32, PortManager*) = PortManager::writePort;
-	uint64 regAddr = (uint64)regs + (memManager.codeSpace[pC] << 3);
+	int64 *regAddr = &regs[memManager.codeSpace[pC]];
 	uint16 immi16 = *(uint16*)&memManager.codeSpace[pC + 1];
+	X86HostCall hostCall(binBlock);
 
-#ifdef USING_MICROSOFT_COMPILER
-	movReg16Immi16(binBlock, cx, immi16);	//mov cx, immi16
-	movRAX_MOffset(binBlock, regAddr);	//mov rax, (regAddr)
-	movReg64Reg64(binBlock, rdx, rax);	//moc rdx, rax
-	movReg64Immi64(binBlock, r8, (uint64)&portManager);	//mov r8, portManager
-	movReg64Immi64(binBlock, rax, (uint64)writePort);	//mov rax, writePort
-	callReg64(binBlock, rax);	//call rax
-#endif
+	hostCall.argImmi(immi16);
+	hostCall.argContext(getContextOffset(regAddr), 4);
+	hostCall.argContextAddress(getContextOffset(&portManager));
+	hostCall.call((uint64)writePort);
 }
 
 void X86DynaRecCore::OUT_R_IMMI32(X86BinBlock *binBlock) {
 	void (*writePort)(uint32, uint32, PortManager*) = PortManager::writePort;
-	uint64 regAddr = (uint64)regs + (memManager.codeSpace[pC] << 3);
+	int64 *regAddr = &regs[memManager.codeSpace[pC]];
 	uint32 immi32 = *(uint32*)&memManager.codeSpace[pC + 1];
+	X86HostCall hostCall(binBlock);
 
-#ifdef USING_MICROSOFT_COMPILER
-	movReg32Immi32(binBlock, ecx, immi32);	//mov ecx, immi32
-	movRAX_MOffset(binBlock, regAddr);	//mov rax, (regAddr)
-	movReg64Reg64(binBlock, rdx, rax);	//mov rdx, rax
-	movReg64Immi64(binBlock, r8, (uint64)&portManager);	//mov r8, portManager
-	movReg64Immi64(binBlock, rax, (uint64)writePort);	//mov rax, writePort
-	callReg64(binBlock, rax);	//call rax
-#endif
+	hostCall.argImmi(immi32);
+	hostCall.argContext(getContextOffset(regAddr), 4);
+	hostCall.argContextAddress(getContextOffset(&portManager));
+	hostCall.call((uint64)writePort);
 }
 
 void X86DynaRecCore::OUT_R_IMMI64(X86BinBlock *binBlock) {
 	void (*writePort)(uint64, uint32, PortManager*) = PortManager::writePort;
-	uint64 regAddr = (uint64)regs + (memManager.codeSpace[pC] << 3);
+	int64 *regAddr = &regs[memManager.codeSpace[pC]];
 	uint64 immi64 = *(uint64*)&memManager.codeSpace[pC + 1];
+	X86HostCall hostCall(binBlock);
 
-#ifdef USING_MICROSOFT_COMPILER
-	movReg64Immi64(binBlock, rcx, immi64);	//mov rcx, immi64
-	movRAX_MOffset(binBlock, regAddr);	//mov rax, (regAddr)
-	movReg64Reg64(binBlock, rdx, rax);	//mov rdx, rax
-	movReg64Immi64(binBlock, r8, (uint64)&portManager);	//mov r8, portManager
-	movReg64Immi64(binBlock, rax, (uint64)writePort);	//mov rax, writePort
-	callReg64(binBlock, rax);	//call rax
-#endif
+	hostCall.argImmi(immi64);
+	hostCall.argContext(getContextOffset(regAddr), 4);
+	hostCall.argContextAddress(getContextOffset(&portManager));
+	hostCall.call((uint64)writePort);
 }
 
 void X86DynaRecCore::OUT_IMMI_R8(X86BinBlock *binBlock) {
 	void (*writePort)(uint8, uint32, PortManager*) = PortManager::writePort;
-	uint64 regAddr = (uint64)regs + (memManager.codeSpace[pC] << 3);
+	int64 *regAddr = &regs[memManager.codeSpace[pC]];
 	uint32 immiValue = *(uint32*)&memManager.codeSpace[pC + 1];
+	if (isDirectPortAccess(_OUT_IMMI_R8, &memManager.codeSpace[pC])) {
+		putPortStore(binBlock, immiValue, regAllocator.useReg(binBlock, memManager.codeSpace[pC], rax), 1);	//mov (port), al
+		return;
+	}
 
-#ifdef USING_MICROSOFT_COMPILER
-	movAL_MOffset(binBlock, regAddr);	//mov al, (regAddr)
-	movReg64Reg64(binBlock, rcx, rax);	//mov rcx, rax
-	movReg32Immi32(binBlock, edx, immiValue);	//mov edx, immiValue
-	movReg64Immi64(binBlock, r8, (uint64)&portManager);	//mov r8, portManager
-	movReg64Immi64(binBlock, rax, (uint64)writePort);	//moc rax, writePort
-	callReg64(binBlock, rax);	//call rax
-#endif
+	X86HostCall hostCall(binBlock);
+
+	hostCall.argContext(getContextOffset(regAddr), 1);
+	hostCall.argImmi(immiValue);
+	hostCall.argContextAddress(getContextOffset(&portManager));
+	hostCall.call((uint64)writePort);
 }
 
 void X86DynaRecCore::OUT_IMMI_R16(X86BinBlock *binBlock) {
 	void (*writePort)(uint16, uint32, PortManager*) = PortManager::writePort;
-	uint64 regAddr = (uint64)regs + (memManager.codeSpace[pC] << 3);
+	int64 *regAddr = &regs[memManager.codeSpace[pC]];
 	uint32 immiValue = *(uint32*)&memManager.codeSpace[pC + 1];
+	if (isDirectPortAccess(_OUT_IMMI_R16, &memManager.codeSpace[pC])) {
+		putPortStore(binBlock, immiValue, regAllocator.useReg(binBlock, memManager.codeSpace[pC], rax), 2);	//mov (port), ax
+		return;
+	}
 
-#ifdef USING_MICROSOFT_COMPILER
-	movAX_MOffset(binBlock, regAddr);	//mov ax, (regAddr)
-	movReg64Reg64(binBlock, rcx, rax);	//mov rcx, rax
-	movReg32Immi32(binBlock, edx, immiValue);	//mov edx, immiValue
-	movReg64Immi64(binBlock, r8, (uint64)&portManager);	//mov r8, portManager
-	movReg64Immi64(binBlock, rax, (uint64)writePort);	//mov rax, writePort
-	callReg64(binBlock, rax);	//call rax
-#endif
+	X86HostCall hostCall(binBlock);
+
+	hostCall.argContext(getContextOffset(regAddr), 2);
+	hostCall.argImmi(immiValue);
+	hostCall.argContextAddress(getContextOffset(&portManager));
+	hostCall.call((uint64)writePort);
 }
 
 void X86DynaRecCore::OUT_IMMI_R32(X86BinBlock *binBlock) {
 	void (*writePort)(uint32, uint32, PortManager*) = PortManager::writePort;
-	uint64 regAddr = (uint64)regs + (memManager.codeSpace[pC] << 3);
+	int64 *regAddr = &regs[memManager.codeSpace[pC]];
 	uint32 immiValue = *(uint32*)&memManager.codeSpace[pC + 1];
+	if (isDirectPortAccess(_OUT_IMMI_R32, &memManager.codeSpace[pC])) {
+		putPortStore(binBlock, immiValue, regAllocator.useReg(binBlock, memManager.codeSpace[pC], rax), 4);	//mov (port), eax
+		return;
+	}
 
-#ifdef USING_MICROSOFT_COMPILER
-	movEAX_MOffset(binBlock, regAddr);	//mov eax, (regAddr)
-	movReg64Reg64(binBlock, rcx, rax);	//mov rcx, rax
-	movReg32Immi32(binBlock, edx, immiValue);	//mov edx, immiValue
-	movReg64Immi64(binBlock, r8, (uint64)&portManager);	//mov r8, portManager
-	movReg64Immi64(binBlock, rax, (uint64)writePort);	//mov rax, writePort
-	callReg64(binBlock, rax);	//call rax
-#endif
+	X86HostCall hostCall(binBlock);
+
+	hostCall.argContext(getContextOffset(regAddr), 4);
+	hostCall.argImmi(immiValue);
+	hostCall.argContextAddress(getContextOffset(&portManager));
+	hostCall.call((uint64)writePort);
 }
 
 void X86DynaRecCore::OUT_IMMI_R64(X86BinBlock *binBlock) {
 	void (*writePort)(uint64, uint32, PortManager*) = PortManager::writePort;
-	uint64 regAddr = (uint64)regs + (memManager.codeSpace[pC] << 3);
+	int64 *regAddr = &regs[memManager.codeSpace[pC]];
 	uint32 immiValue = *(uint32*)&memManager.codeSpace[pC + 1];
+	if (isDirectPortAccess(_OUT_IMMI_R64, &memManager.codeSpace[pC])) {
+		putPortStore(binBlock, immiValue, regAllocator.useReg(binBlock, memManager.codeSpace[pC], rax), 8);	//mov (port), rax
+		return;
+	}
 
-#ifdef USING_MICROSOFT_COMPILER
-	movRAX_MOffset(binBlock, regAddr);	//mov rax, (regAddr)
-	movReg64Reg64(binBlock, rcx, rax);	//mov rcx, rax
-	movReg32Immi32(binBlock, edx, immiValue);	//mov edx, immiValue
-	movReg64Immi64(binBlock, r8, (uint64)&portManager);	//mov r8, portManager
-	movReg64Immi64(binBlock, rax, (uint64)writePort);	//mov rax, writePort
-	callReg64(binBlock, rax);	//call rax
-#endif
+	X86HostCall hostCall(binBlock);
+
+	hostCall.argContext(getContextOffset(regAddr), 8);
+	hostCall.argImmi(immiValue);
+	hostCall.argContextAddress(getContextOffset(&portManager));
+	hostCall.call((uint64)writePort);
 }
 
 void X86DynaRecCore::OUT_R_R8(X86BinBlock *binBlock) {
 	void (*writePort)(uint8, uint32, PortManager*) = PortManager::writePort;
-	uint64 regAddr1 = (uint64)regs + (memManager.codeSpace[pC] << 3);
-	uint64 regAddr2 = (uint64)regs + (memManager.codeSpace[pC + 1] << 3);
+	int64 *regAddr1 = &regs[memManager.codeSpace[pC]];
+	int64 *regAddr2 = &regs[memManager.codeSpace[pC + 1]];
+	X86HostCall hostCall(binBlock);
 
-#ifdef USING_MICROSOFT_COMPILER
-	movAL_MOffset(binBlock, regAddr2);	//mov al, (regAddr2)
-	movReg64Reg64(binBlock, rcx, rax);	//mov rcx, rax
-	movRAX_MOffset(binBlock, regAddr1);	//mov rax, (regAddr1)
-	movReg64Reg64(binBlock, rdx, rax);	//mov rdx, rax
-	movReg64Immi64(binBlock, r8, (uint64)&portManager);	//mov r8, portManager
-	movReg64Immi64(binBlock, rax, (uint64)writePort);	//mov rax, writePort
-	callReg64(binBlock, rax);	//call rax
-#endif
+	hostCall.argContext(getContextOffset(regAddr2), 1);
+	hostCall.argContext(getContextOffset(regAddr1), 4);
+	hostCall.argContextAddress(getContextOffset(&portManager));
+	hostCall.call((uint64)writePort);
 }
 
 void X86DynaRecCore::OUT_R_R16(X86BinBlock *binBlock) {
 	void (*writePort)(uint16, uint32, PortManager*) = PortManager::writePort;
-	uint64 regAddr1 = (uint64)regs + (memManager.codeSpace[pC] << 3);
-	uint64 regAddr2 = (uint64)regs + (memManager.codeSpace[pC + 1] << 3);
+	int64 *regAddr1 = &regs[memManager.codeSpace[pC]];
+	int64 *regAddr2 = &regs[memManager.codeSpace[pC + 1]];
+	X86HostCall hostCall(binBlock);
 
-#ifdef USING_MICROSOFT_COMPILER
-	movAX_MOffset(binBlock, regAddr2);	//mov ax, (regAddr2)
-	movReg64Reg64(binBlock, rcx, rax);	//mov rcx, rax
-	movRAX_MOffset(binBlock, regAddr1);	//mov rax, (regAddr1)
-	movReg64Reg64(binBlock, rdx, rax);	//mov rdx, rax
-	movReg64Immi64(binBlock, r8, (uint64)&portManager);	//mov r8, portManager
-	movReg64Immi64(binBlock, rax, (uint64)writePort);	//mov rax, writePort
-	callReg64(binBlock, rax);	//call rax
-#endif
+	hostCall.argContext(getContextOffset(regAddr2), 2);
+	hostCall.argContext(getContextOffset(regAddr1), 4);
+	hostCall.argContextAddress(getContextOffset(&portManager));
+	hostCall.call((uint64)writePort);
 }
 
 void X86DynaRecCore::OUT_R_R32(X86BinBlock *binBlock) {
 	void (*writePort)(uint32, uint32, PortManager*) = PortManager::writePort;
-	uint64 regAddr1 = (uint64)regs + (memManager.codeSpace[pC] << 3);
-	uint64 regAddr2 = (uint64)regs + (memManager.codeSpace[pC + 1] << 3);
+	int64 *regAddr1 = &regs[memManager.codeSpace[pC]];
+	int64 *regAddr2 = &regs[memManager.codeSpace[pC + 1]];
+	X86HostCall hostCall(binBlock);
 
-#ifdef USING_MICROSOFT_COMPILER
-	movEAX_MOffset(binBlock, regAddr2);	//mov eax, (regAddr2)
-	movReg64Reg64(binBlock, rcx, rax);	//mov rcx, rax
-	movRAX_MOffset(binBlock, regAddr1);	//mov rax, (regAddr1)
-	movReg64Reg64(binBlock, rdx, rax);	//mov rdx, rax
-	movReg64Immi64(binBlock, r8, (uint64)&portManager);	//mov r8, portManager
-	movReg64Immi64(binBlock, rax, (uint64)writePort);	//mov rax, writePort
-	callReg64(binBlock, rax);	//call rax
-#endif
+	hostCall.argContext(getContextOffset(regAddr2), 4);
+	hostCall.argContext(getContextOffset(regAddr1), 4);
+	hostCall.argContextAddress(getContextOffset(&portManager));
+	hostCall.call((uint64)writePort);
 }
 
 void X86DynaRecCore::OUT_R_R64(X86BinBlock *binBlock) {
 	void (*writePort)(uint64, uint32, PortManager*) = PortManager::writePort;
-	uint64 regAddr1 = (uint64)regs + (memManager.codeSpace[pC] << 3);
-	uint64 regAddr2 = (uint64)regs + (memManager.codeSpace[pC + 1] << 3);
+	int64 *regAddr1 = &regs[memManager.codeSpace[pC]];
+	int64 *regAddr2 = &regs[memManager.codeSpace[pC + 1]];
+	X86HostCall hostCall(binBlock);
 
-#ifdef USING_MICROSOFT_COMPILER
-	movRAX_MOffset(binBlock, regAddr2);	//mov rax, (regAddr2)
-	movReg64Reg64(binBlock, rcx, rax);	//mov rcx, rax
-	movRAX_MOffset(binBlock, regAddr1);	//mov rax, (regAddr1)
-	movReg64Reg64(binBlock, rdx, rax);	//mov rdx, rax
-	movReg64Immi64(binBlock, r8, (uint64)&portManager);	//mov r8, portManager
-	movReg64Immi64(binBlock, rax, (uint64)writePort);	//mov rax, writePort
-	callReg64(binBlock, rax);	//call rax
-#endif
+	hostCall.argContext(getContextOffset(regAddr2), 8);
+	hostCall.argContext(getContextOffset(regAddr1), 4);
+	hostCall.argContextAddress(getContextOffset(&portManager));
+	hostCall.call((uint64)writePort);
 }
 
 void X86DynaRecCore::OUT_IMMI_IMMI8(X86BinBlock *binBlock) {
 	void (*writePort)(uint8, uint32, PortManager*) = PortManager::writePort;
 	uint32 immiValue = *(uint32*)&memManager.codeSpace[pC];
 	uint8 immi8 = memManager.codeSpace[pC + 4];
+	if (isDirectPortAccess(_OUT_IMMI_IMMI8, &memManager.codeSpace[pC])) {
+		putIRImmediate(binBlock, rax, immi8);	//mov rax, immi8
+		putPortStore(binBlock, immiValue, rax, 1);	//mov (port), al
+		return;
+	}
 
-#ifdef USING_MICROSOFT_COMPILER
-	movReg8Immi8(binBlock, cl, immi8);	//mov cl, immi8
-	movReg32Immi32(binBlock, edx, immiValue);	//mov edx, immiValue
-	movReg64Immi64(binBlock, r8, (uint64)&portManager);	//mov r8, portManager
-	movReg64Immi64(binBlock, rax, (uint64)writePort);	//mov rax, writePort
-	callReg64(binBlock, rax);	//call rax
-#endif
+	X86HostCall hostCall(binBlock);
+
+	hostCall.argImmi(immi8);
+	hostCall.argImmi(immiValue);
+	hostCall.argContextAddress(getContextOffset(&portManager));
+	hostCall.call((uint64)writePort);
 }
 
 void X86DynaRecCore::OUT_IMMI_IMMI16(X86BinBlock *binBlock) {
 	void (*writePort)(uint16, uint32, PortManager*) = PortManager::writePort;
 	uint32 immiValue = *(uint32*)&memManager.codeSpace[pC];
 	uint16 immi16 = *(uint16*)&memManager.codeSpace[pC + 4];
+	if (isDirectPortAccess(_OUT_IMMI_IMMI16, &memManager.codeSpace[pC])) {
+		putIRImmediate(binBlock, rax, immi16);	//mov rax, immi16
+		putPortStore(binBlock, immiValue, rax, 2);	//mov (port), ax
+		return;
+	}
 
-#ifdef USING_MICROSOFT_COMPILER
-	movReg16Immi16(binBlock, cx, immi16);	//mov cx, immi16
-	movReg32Immi32(binBlock, edx, immiValue);	//mov edx, immiValue
-	movReg64Immi64(binBlock, r8, (uint64)&portManager);	//mov r8, portManager
-	movReg64Immi64(binBlock, rax, (uint64)writePort);	//mov rax, writePort
-	callReg64(binBlock, rax);	//call rax
-#endif
+	X86HostCall hostCall(binBlock);
+
+	hostCall.argImmi(immi16);
+	hostCall.argImmi(immiValue);
+	hostCall.argContextAddress(getContextOffset(&portManager));
+	hostCall.call((uint64)writePort);
 }
 
 void X86DynaRecCore::OUT_IMMI_IMMI32(X86BinBlock *binBlock) {
 	void (*writePort)(uint32, uint32, PortManager*) = PortManager::writePort;
 	uint32 immiValue = *(uint32*)&memManager.codeSpace[pC];
 	uint32 immi32 = *(uint32*)&memManager.codeSpace[pC + 4];
+	if (isDirectPortAccess(_OUT_IMMI_IMMI32, &memManager.codeSpace[pC])) {
+		putIRImmediate(binBlock, rax, immi32);	//mov rax, immi32
+		putPortStore(binBlock, immiValue, rax, 4);	//mov (port), eax
+		return;
+	}
 
-#ifdef USING_MICROSOFT_COMPILER
-	movReg32Immi32(binBlock, ecx, immi32);	//mov ecx, immi32
-	movReg32Immi32(binBlock, edx, immiValue);	//mov edx, immiValue
-	movReg64Immi64(binBlock, r8, (uint64)&portManager);	//mov r8, portManager
-	movReg64Immi64(binBlock, rax, (uint64)writePort);	//mov rax, writePort
-	callReg64(binBlock, rax);	//call rax
-#endif
+	X86HostCall hostCall(binBlock);
+
+	hostCall.argImmi(immi32);
+	hostCall.argImmi(immiValue);
+	hostCall.argContextAddress(getContextOffset(&portManager));
+	hostCall.call((uint64)writePort);
 }
 
 void X86DynaRecCore::OUT_IMMI_IMMI64(X86BinBlock *binBlock) {
 	void (*writePort)(uint64, uint32, PortManager*) = PortManager::writePort;
 	uint32 immiValue = *(uint32*)&memManager.codeSpace[pC];
 	uint64 immi64 = *(uint64*)&memManager.codeSpace[pC + 4];
+	if (isDirectPortAccess(_OUT_IMMI_IMMI64, &memManager.codeSpace[pC])) {
+		putIRImmediate(binBlock, rax, immi64);	//mov rax, immi64
+		putPortStore(binBlock, immiValue, rax, 8);	//mov (port), rax
+		return;
+	}
 
-#ifdef USING_MICROSOFT_COMPILER
-	movReg64Immi64(binBlock, rcx, immi64);	//mov rcx, immi64
-	movReg32Immi32(binBlock, edx, immiValue);	//mov edx, immiValue
-	movReg64Immi64(binBlock, r8, (uint64)&portManager);	//mov r8, portManager
-	movReg64Immi64(binBlock, rax, (uint64)writePort);	//mov rax, writePort
-	callReg64(binBlock, rax);	//call rax
-#endif
+	X86HostCall hostCall(binBlock);
+
+	hostCall.argImmi(immi64);
+	hostCall.argImmi(immiValue);
+	hostCall.argContextAddress(getContextOffset(&portManager));
+	hostCall.call((uint64)writePort);
 }
 
 void X86DynaRecCore::IN_R8_IMMI(X86BinBlock *binBlock) {
 	uint8 (*readPort)(uint32, PortManager*) = PortManager::readPort;
-	uint64 regAddr = (uint64)regs + (memManager.codeSpace[pC] << 3);
+	int64 *regAddr = &regs[memManager.codeSpace[pC]];
 	uint32 immiValue = *(uint32*)&memManager.codeSpace[pC + 1];
+	if (isDirectPortAccess(_IN_R8_IMMI, &memManager.codeSpace[pC])) {
+		uint8 reg = memManager.codeSpace[pC];
+		X86_64Register dst = regAllocator.getReg(reg, rax);
+		putPortLoad(binBlock, dst, immiValue, 1);	//mov rax, (port)
+		regAllocator.storeReg(binBlock, reg, dst);	//mov reg, rax
+		return;
+	}
 
-#ifdef USING_MICROSOFT_COMPILER
-	movReg32Immi32(binBlock, ecx, immiValue);	//mov ecx, immiValue
-	movReg64Immi64(binBlock, rdx, (uint64)&portManager);	//mov rdx, portManager
-	movReg64Immi64(binBlock, rax, (uint64)readPort);	//mov rax, readPort
-	callReg64(binBlock, rax);	//call rax
+	X86HostCall hostCall(binBlock);
+
+	hostCall.argImmi(immiValue);
+	hostCall.argContextAddress(getContextOffset(&portManager));
+	hostCall.call((uint64)readPort);
 	andRAX_Immi32(binBlock, 0xFF);	//and rax, 0xFF
-	movMOffsetRAX(binBlock, regAddr);	//mov (regAddr), rax
-#endif
+	movContextRAX(binBlock, regAddr);	//mov (regAddr), rax
 }
 
 void X86DynaRecCore::IN_R16_IMMI(X86BinBlock *binBlock) {
 	uint16 (*readPort)(uint32, PortManager*) = PortManager::readPort;
-	uint64 regAddr = (uint64)regs + (memManager.codeSpace[pC] << 3);
+	int64 *regAddr = &regs[memManager.codeSpace[pC]];
 	uint32 immiValue = *(uint32*)&memManager.codeSpace[pC + 1];
+	if (isDirectPortAccess(_IN_R16_IMMI, &memManager.codeSpace[pC])) {
+		uint8 reg = memManager.codeSpace[pC];
+		X86_64Register dst = regAllocator.getReg(reg, rax);
+		putPortLoad(binBlock, dst, immiValue, 2);	//mov rax, (port)
+		regAllocator.storeReg(binBlock, reg, dst);	//mov reg, rax
+		return;
+	}
 
-#ifdef USING_MICROSOFT_COMPILER
-	movReg32Immi32(binBlock, ecx, immiValue);	//mov ecx, immiValue
-	movReg64Immi64(binBlock, rdx, (uint64)&portManager);	//mov rdx, portManager
-	movReg64Immi64(binBlock, rax, (uint64)readPort);	//mov rax, readPort
-	callReg64(binBlock, rax);	//call rax
+	X86HostCall hostCall(binBlock);
+
+	hostCall.argImmi(immiValue);
+	hostCall.argContextAddress(getContextOffset(&portManager));
+	hostCall.call((uint64)readPort);
 	andRAX_Immi32(binBlock, 0xFFFF);	//and rax, 0xFFFF
-	movMOffsetRAX(binBlock, regAddr);	//mov (regAddr), rax
-#endif
+	movContextRAX(binBlock, regAddr);	//mov (regAddr), rax
 }
 
 void X86DynaRecCore::IN_R32_IMMI(X86BinBlock *binBlock) {
 	uint32 (*readPort)(uint32, PortManager*) = PortManager::readPort;
-	uint64 regAddr = (uint64)regs + (memManager.codeSpace[pC] << 3);
+	int64 *regAddr = &regs[memManager.codeSpace[pC]];
 	uint32 immiValue = *(uint32*)&memManager.codeSpace[pC + 1];
+	if (isDirectPortAccess(_IN_R32_IMMI, &memManager.codeSpace[pC])) {
+		uint8 reg = memManager.codeSpace[pC];
+		X86_64Register dst = regAllocator.getReg(reg, rax);
+		putPortLoad(binBlock, dst, immiValue, 4);	//mov rax, (port)
+		regAllocator.storeReg(binBlock, reg, dst);	//mov reg, rax
+		return;
+	}
 
-#ifdef USING_MICROSOFT_COMPILER
-	movReg32Immi32(binBlock, ecx, immiValue);	//mov ecx, immiValue
-	movReg64Immi64(binBlock, rdx, (uint64)&portManager);	//mov rdx, portManager
-	movReg64Immi64(binBlock, rax, (uint64)readPort);	//mov rax, readPort
-	callReg64(binBlock, rax);	//call rax
-	movMOffsetRAX(binBlock, regAddr);	//mov (regAddr), rax
-#endif
+	X86HostCall hostCall(binBlock);
+
+	hostCall.argImmi(immiValue);
+	hostCall.argContextAddress(getContextOffset(&portManager));
+	hostCall.call((uint64)readPort);
+	movContextRAX(binBlock, regAddr);	//mov (regAddr), rax
 }
 
 void X86DynaRecCore::IN_R64_IMMI(X86BinBlock *binBlock) {
 	uint64 (*readPort)(uint32, PortManager*) = PortManager::readPort;
-	uint64 regAddr = (uint64)regs + (memManager.codeSpace[pC] << 3);
+	int64 *regAddr = &regs[memManager.codeSpace[pC]];
 	uint32 immiValue = *(uint32*)&memManager.codeSpace[pC + 1];
+	if (isDirectPortAccess(_IN_R64_IMMI, &memManager.codeSpace[pC])) {
+		uint8 reg = memManager.codeSpace[pC];
+		X86_64Register dst = regAllocator.getReg(reg, rax);
+		putPortLoad(binBlock, dst, immiValue, 8);	//mov rax, (port)
+		regAllocator.storeReg(binBlock, reg, dst);	//mov reg, rax
+		return;
+	}
 
-#ifdef USING_MICROSOFT_COMPILER
-	movReg32Immi32(binBlock, ecx, immiValue);	//mov ecx, immiValue
-	movReg64Immi64(binBlock, rdx, (uint64)&portManager);	//mov rdx, portManager
-	movReg64Immi64(binBlock, rax, (uint64)readPort);	//mov rax, readPort
-	callReg64(binBlock, rax);	//call rax
-	movMOffsetRAX(binBlock, regAddr);	//mov (regAddr), rax
-#endif
+	X86HostCall hostCall(binBlock);
+
+	hostCall.argImmi(immiValue);
+	hostCall.argContextAddress(getContextOffset(&portManager));
+	hostCall.call((uint64)readPort);
+	movContextRAX(binBlock, regAddr);	//mov (regAddr), rax
 }
 
 void X86DynaRecCore::IN_R8_R(X86BinBlock *binBlock) {
 	uint8 (*readPort)(uint32, PortManager*) = PortManager::readPort;
-	uint64 regAddr1 = (uint64)regs + (memManager.codeSpace[pC] << 3);
-	uint64 regAddr2 = (uint64)regs + (memManager.codeSpace[pC + 1] << 3);
+	int64 *regAddr1 = &regs[memManager.codeSpace[pC]];
+	int64 *regAddr2 = &regs[memManager.codeSpace[pC + 1]];
+	X86HostCall hostCall(binBlock);
 
-#ifdef USING_MICROSOFT_COMPILER
-	movRAX_MOffset(binBlock, regAddr2);	//mov rax, (regAddr2)
-	movReg64Reg64(binBlock, rcx, rax);	//mov rcx, rax
-	movReg64Immi64(binBlock, rdx, (uint64)&portManager);	//mov rdx, portManager
-	movReg64Immi64(binBlock, rax, (uint64)readPort);	//mov rax, readPort
-	callReg64(binBlock, rax);	//call rax
+	hostCall.argContext(getContextOffset(regAddr2), 4);
+	hostCall.argContextAddress(getContextOffset(&portManager));
+	hostCall.call((uint64)readPort);
 	andRAX_Immi32(binBlock, 0xFF);	//and rax, 0xFF
-	movMOffsetRAX(binBlock, regAddr1);	//mov (regAddr1), rax
-#endif
+	movContextRAX(binBlock, regAddr1);	//mov (regAddr1), rax
 }
 
 void X86DynaRecCore::IN_R16_R(X86BinBlock *binBlock) {
 	uint16 (*readPort)(uint32, PortManager*) = PortManager::readPort;
-	uint64 regAddr1 = (uint64)regs + (memManager.codeSpace[pC] << 3);
-	uint64 regAddr2 = (uint64)regs + (memManager.codeSpace[pC + 1] << 3);
+	int64 *regAddr1 = &regs[memManager.codeSpace[pC]];
+	int64 *regAddr2 = &regs[memManager.codeSpace[pC + 1]];
+	X86HostCall hostCall(binBlock);
 
-#ifdef USING_MICROSOFT_COMPILER
-	movRAX_MOffset(binBlock, regAddr2);	//mov rax, (regAddr2)
-	movReg64Reg64(binBlock, rcx, rax);	//mov rcx, rax
-	movReg64Immi64(binBlock, rdx, (uint64)&portManager);	//mov rdx, portManager
-	movReg64Immi64(binBlock, rax, (uint64)readPort);	//mov rax, readPort
-	callReg64(binBlock, rax);	//call rax
+	hostCall.argContext(getContextOffset(regAddr2), 4);
+	hostCall.argContextAddress(getContextOffset(&portManager));
+	hostCall.call((uint64)readPort);
 	andRAX_Immi32(binBlock, 0xFFFF);	//and rax, 0xFFFF
-	movMOffsetRAX(binBlock, regAddr1);	//mov (regAddr1), rax
-#endif
+	movContextRAX(binBlock, regAddr1);	//mov (regAddr1), rax
 }
 
 void X86DynaRecCore::IN_R32_R(X86BinBlock *binBlock) {
 	uint32 (*readPort)(uint32, PortManager*) = PortManager::readPort;
-	uint64 regAddr1 = (uint64)regs + (memManager.codeSpace[pC] << 3);
-	uint64 regAddr2 = (uint64)regs + (memManager.codeSpace[pC + 1] << 3);
+	int64 *regAddr1 = &regs[memManager.codeSpace[pC]];
+	int64 *regAddr2 = &regs[memManager.codeSpace[pC + 1]];
+	X86HostCall hostCall(binBlock);
 
-#ifdef USING_MICROSOFT_COMPILER
-	movRAX_MOffset(binBlock, regAddr2);	//mov rax, (regAddr2)
-	movReg64Reg64(binBlock, rcx, rax);	//mov rcx, rax
-	movReg64Immi64(binBlock, rdx, (uint64)&portManager);	//mov rdx, portManager
-	movReg64Immi64(binBlock, rax, (uint64)readPort);	//mov rax, readPort
-	callReg64(binBlock, rax);	//call rax
-	movMOffsetRAX(binBlock, regAddr1);	//mov (regAddr1), rax
-#endif
+	hostCall.argContext(getContextOffset(regAddr2), 4);
+	hostCall.argContextAddress(getContextOffset(&portManager));
+	hostCall.call((uint64)readPort);
+	movContextRAX(binBlock, regAddr1);	//mov (regAddr1), rax
 }
 
 void X86DynaRecCore::IN_R64_R(X86BinBlock *binBlock) {
 	uint64 (*readPort)(uint32, PortManager*) = PortManager::readPort;
-	uint64 regAddr1 = (uint64)regs + (memManager.codeSpace[pC] << 3);
-	uint64 regAddr2 = (uint64)regs + (memManager.codeSpace[pC + 1] << 3);
+	int64 *regAddr1 = &regs[memManager.codeSpace[pC]];
+	int64 *regAddr2 = &regs[memManager.codeSpace[pC + 1]];
+	X86HostCall hostCall(binBlock);
 
-#ifdef USING_MICROSOFT_COMPILER
-	movRAX_MOffset(binBlock, regAddr2);	//mov rax, (regAddr2)
-	movReg64Reg64(binBlock, rcx, rax);	//mov rcx, rax
-	movReg64Immi64(binBlock, rdx, (uint64)&portManager);	//mov rdx, portManager
-	movReg64Immi64(binBlock, rax, (uint64)readPort);	//mov rax, readPort
-	callReg64(binBlock, rax);	//call rax
-	movMOffsetRAX(binBlock, regAddr1);	//mov (regAddr1), rax
-#endif
+	hostCall.argContext(getContextOffset(regAddr2), 4);
+	hostCall.argContextAddress(getContextOffset(&portManager));
+	hostCall.call((uint64)readPort);
+	movContextRAX(binBlock, regAddr1);	//mov (regAddr1), rax
 }
 
 void X86DynaRecCore::FCON_R_FR(X86BinBlock *binBlock) {
-	uint64 regAddr = (uint64)regs + (memManager.codeSpace[pC] << 3);
-	uint64 fRegAddr = (uint64)fRegs + (memManager.codeSpace[pC + 1] << 2);
+	uint8 reg = memManager.codeSpace[pC];
+	uint8 fReg = memManager.codeSpace[pC + 1];
 
-	movReg64Immi64(binBlock, rcx, fRegAddr);	//mov rcx, fRegAddr
-	cvtss2siReg32MReg32(binBlock, eax, rcx);	//cvtss2si eax, (rcx)
-	movMOffsetRAX(binBlock, regAddr);	//mov (regAddr), rax
+	X86_64Register src = regAllocator.useFReg(binBlock, fReg, xmm0);	//movss xmm0, fReg
+	X86_64Register dst = regAllocator.getReg(reg, rax);
+	cvtss2siReg32XMM(binBlock, dst, src);	//cvtss2si eax, xmm0
+	regAllocator.storeReg(binBlock, reg, dst);	//mov reg, rax
 }
 
 void X86DynaRecCore::FCON_FR_R(X86BinBlock *binBlock) {
-	uint64 regAddr = (uint64)regs + (memManager.codeSpace[pC] << 3);
-	uint64 fRegAddr = (uint64)fRegs + (memManager.codeSpace[pC + 1] << 2);
+	uint8 reg = memManager.codeSpace[pC];
+	uint8 fReg = memManager.codeSpace[pC + 1];
 
-	movReg64Immi64(binBlock, rax, regAddr);	//mov rax, regAddr
-	cvtsi2ssXMM_MReg32(binBlock, xmm0, rax);	//cvtsi2ss xmm0, rax
-	movReg64Immi64(binBlock, rcx, fRegAddr);	//mov rcx, fRegAddr
-	movssMReg32XMM(binBlock, rcx, xmm0);	//movss (rcx), xmm0
+	X86_64Register src = regAllocator.useReg(binBlock, reg, rax);	//mov rax, reg
+	X86_64Register dst = regAllocator.getFReg(fReg, xmm0);
+	cvtsi2ssXMM_Reg32(binBlock, dst, src);	//cvtsi2ss xmm0, eax
+	regAllocator.storeFReg(binBlock, fReg, dst);	//movss fReg, xmm0
 }
 
 void X86DynaRecCore::FCON_FR_IMMI(X86BinBlock *binBlock) {
-	uint64 fRegAddr = (uint64)fRegs + (memManager.codeSpace[pC] << 2);
+	uint8 fReg = memManager.codeSpace[pC];
 	uint32 immiValue = *(uint32*)&memManager.codeSpace[pC + 1];
 
+	X86_64Register dst = regAllocator.getFReg(fReg, xmm0);
 	movReg32Immi32(binBlock, ecx, immiValue);	//mov ecx, immiValue
-	cvtsi2ssXMM_Reg32(binBlock, xmm0, ecx);	//cvtsi2ss xmm0, ecx
-	movReg64Immi64(binBlock, rax, fRegAddr);	//mov rax, fRegAddr
-	movssMReg32XMM(binBlock, rax, xmm0);	//movss (rax), xmm0
+	cvtsi2ssXMM_Reg32(binBlock, dst, ecx);	//cvtsi2ss xmm0, ecx
+	regAllocator.storeFReg(binBlock, fReg, dst);	//movss fReg, xmm0
 }
 
 void X86DynaRecCore::FCON_R_FIMMI(X86BinBlock *binBlock) {
-	uint64 regAddr = (uint64)regs + (memManager.codeSpace[pC] << 3);
+	uint8 reg = memManager.codeSpace[pC];
 	float32 fImmiValue = *(float32*)&memManager.codeSpace[pC + 1];
 
-	cvtss2siReg32Disp32(binBlock, eax, 0);	//cvtss2si eax, (rip + 0)
+	X86_64Register dst = regAllocator.getReg(reg, rax);
+	cvtss2siReg32Disp32(binBlock, dst, 0);	//cvtss2si eax, (rip + 0)
 	if (immediateFloat) immediateFloat->push_back(ImmediateFloat(fImmiValue, binBlock->getCounter() - 4));
-	movMOffsetRAX(binBlock, regAddr);	//mov (regAddr), rax
+	regAllocator.storeReg(binBlock, reg, dst);	//mov reg, rax
 }
 
 void X86DynaRecCore::FMOV_FR_MFR_IMMI(X86BinBlock *binBlock) {
-	uint64 fRegAddr = (uint64)fRegs + (memManager.codeSpace[pC + 1] << 2);
-	uint64 fMRegAddr = (uint64)regs + (memManager.codeSpace[pC] << 3);
+	uint8 fReg = memManager.codeSpace[pC + 1];
+	uint8 fMReg = memManager.codeSpace[pC];
 	uint32 immi = *(uint32*)&memManager.codeSpace[pC + 2];
 
-	movRAX_MOffset(binBlock, fMRegAddr);	//mov rax, (fMRegAddr)
-	addRAX_Immi32(binBlock, immi);	//add rax, immi
-	movssXMM_MReg32(binBlock, xmm0, rax);	//movss xmm0, (rax)
-	movReg64Immi64(binBlock, rcx, fRegAddr);	//mov rcx, fRegAddr
-	movssMReg32XMM(binBlock, rcx, xmm0);	//movss (rcx), xmm0
+	X86_64Register base = regAllocator.useReg(binBlock, fMReg, rax);	//mov rax, fMReg
+	X86_64Register dst = regAllocator.getFReg(fReg, xmm0);
+	movssXMM_MRegDisp(binBlock, dst, base, immi);	//movss xmm0, (rax + immi)
+	regAllocator.storeFReg(binBlock, fReg, dst);	//movss fReg, xmm0
 }
 
 void X86DynaRecCore::FMOV_MFR_IMMI_FR(X86BinBlock *binBlock) {
-	uint64 fRegAddr = (uint64)fRegs + (memManager.codeSpace[pC + 1] << 2);
-	uint64 fMRegAddr = (uint64)regs + (memManager.codeSpace[pC] << 3);
+	uint8 fReg = memManager.codeSpace[pC + 1];
+	uint8 fMReg = memManager.codeSpace[pC];
 	uint32 immi = *(uint32*)&memManager.codeSpace[pC + 2];
 
-	movReg64Immi64(binBlock, rcx, fRegAddr);	//mov rcx, fRegAddr
-	movssXMM_MReg32(binBlock, xmm0, rcx);	//movss xmm0, (rcx)
-	movRAX_MOffset(binBlock, fMRegAddr);	//mov rax, (fMRegAddr)
-	addRAX_Immi32(binBlock, immi);	//add rax, immi
-	movssMReg32XMM(binBlock, rax, xmm0);	//movss (rax), xmm0
+	X86_64Register src = regAllocator.useFReg(binBlock, fReg, xmm0);	//movss xmm0, fReg
+	X86_64Register base = regAllocator.useReg(binBlock, fMReg, rax);	//mov rax, fMReg
+	movssMRegDispXMM(binBlock, base, immi, src);	//movss (rax + immi), xmm0
 }
 
 void X86DynaRecCore::FMOV_MFR_IMMI_MFR_IMMI(X86BinBlock *binBlock) {
-	uint64 fMRegAddr2 = (uint64)regs + (memManager.codeSpace[pC + 1] << 3);
-	uint64 fMRegAddr1 = (uint64)regs + (memManager.codeSpace[pC] << 3);
+	uint8 fMReg2 = memManager.codeSpace[pC + 1];
+	uint8 fMReg1 = memManager.codeSpace[pC];
 	uint32 immi1 = *(uint32*)&memManager.codeSpace[pC + 2];
 	uint32 immi2 = *(uint32*)&memManager.codeSpace[pC + 6];
 
-	movRAX_MOffset(binBlock, fMRegAddr2);	//mov rax, (fMRegAddr2)
-	addRAX_Immi32(binBlock, immi2);	//add eax, immi2
-	movssXMM_MReg32(binBlock, xmm0, rax);	//mov xmm0, (rax)
-	movRAX_MOffset(binBlock, fMRegAddr1);	//mov rax, (fMRegAddr1)
-	addRAX_Immi32(binBlock, immi1);	//add eax, immi2
-	movssMReg32XMM(binBlock, rax, xmm0);	//movss (rax), xmm0
+	X86_64Register base = regAllocator.useReg(binBlock, fMReg2, rax);	//mov rax, fMReg2
+	movssXMM_MRegDisp(binBlock, xmm0, base, immi2);	//mov xmm0, (rax + immi2)
+	base = regAllocator.useReg(binBlock, fMReg1, rax);	//mov rax, fMReg1
+	movssMRegDispXMM(binBlock, base, immi1, xmm0);	//movss (rax + immi1), xmm0
 }
 
 void X86DynaRecCore::FMOV_MFR_IMMI_FIMMI(X86BinBlock *binBlock) {
-	uint64 fMRegAddr = (uint64)regs + (memManager.codeSpace[pC] << 3);
+	uint8 fMReg = memManager.codeSpace[pC];
 	uint32 immi = *(uint32*)&memManager.codeSpace[pC + 1];
 	float32 fImmiValue = *(float32*)&memManager.codeSpace[pC + 5];
 
 	movssXMM_Disp32(binBlock, xmm0, 0);	//movss xmm0, (rip + 0)
 	if (immediateFloat) immediateFloat->push_back(ImmediateFloat(fImmiValue, binBlock->getCounter() - 4));
-	movRAX_MOffset(binBlock, fMRegAddr);	//mov rax, (fMRegAddr)
-	addRAX_Immi32(binBlock, immi);	//add rax, immi
-	movssMReg32XMM(binBlock, rax, xmm0);	//movss (rax), xmm0
+	X86_64Register base = regAllocator.useReg(binBlock, fMReg, rax);	//mov rax, fMReg
+	movssMRegDispXMM(binBlock, base, immi, xmm0);	//movss (rax + immi), xmm0
 }
 
 void X86DynaRecCore::FMOV_FR_FR(X86BinBlock *binBlock) {
-	uint64 fRegAddr1 = (uint64)fRegs + (memManager.codeSpace[pC] << 2);
-	uint64 fRegAddr2 = (uint64)fRegs + (memManager.codeSpace[pC + 1] << 2);
+	uint8 fReg1 = memManager.codeSpace[pC];
+	uint8 fReg2 = memManager.codeSpace[pC + 1];
 
-	movReg64Immi64(binBlock, rax, fRegAddr2);	//mov rax, fRegAddr2
-	movssXMM_MReg32(binBlock, xmm0, rax);	//movss xmm0, (rax)
-	movReg64Immi64(binBlock, rcx, fRegAddr1);	//mov rcx, fRegAddr1
-	movssMReg32XMM(binBlock, rcx, xmm0);	//movss (rcx), xmm0
+	regAllocator.storeFReg(binBlock, fReg1, regAllocator.useFReg(binBlock, fReg2, xmm0));	//movss fReg1, fReg2
 }
 
 void X86DynaRecCore::FMOV_FR_FM(X86BinBlock *binBlock) {
-	uint64 fRegAddr = (uint64)fRegs + (memManager.codeSpace[pC] << 2);
+	uint8 fReg = memManager.codeSpace[pC];
 	uint64 gFMemoryAddr = (uint64)memManager.globalDataSpace + *(uint32*)&memManager.codeSpace[pC + 1];
 
 	movReg64Immi64(binBlock, rax, gFMemoryAddr);	//mov rax, gFMemoryAddr
-	movssXMM_MReg32(binBlock, xmm0, rax);	//movss xmm0, (rax)
-	movReg64Immi64(binBlock, rcx, fRegAddr);	//mov rcx, fRegAddr
-	movssMReg32XMM(binBlock, rcx, xmm0);	//movss (rcx), xmm0
+	X86_64Register dst = regAllocator.getFReg(fReg, xmm0);
+	movssXMM_MReg32(binBlock, dst, rax);	//movss xmm0, (rax)
+	regAllocator.storeFReg(binBlock, fReg, dst);	//movss fReg, xmm0
 }
 
 void X86DynaRecCore::FMOV_FM_FR(X86BinBlock *binBlock) {
-	uint64 fRegAddr = (uint64)fRegs + (memManager.codeSpace[pC] << 2);
+	uint8 fReg = memManager.codeSpace[pC];
 	uint64 gFMemoryAddr = (uint64)memManager.globalDataSpace + *(uint32*)&memManager.codeSpace[pC + 1];
 
-	movReg64Immi64(binBlock, rax, fRegAddr);	//mov rax, fRegAddr
-	movssXMM_MReg32(binBlock, xmm0, rax);	//movss xmm0, (rax)
+	X86_64Register src = regAllocator.useFReg(binBlock, fReg, xmm0);	//movss xmm0, fReg
 	movReg64Immi64(binBlock, rcx, gFMemoryAddr);	//mov rcx, (gFMemoryAddr)
-	movssMReg32XMM(binBlock, rcx, xmm0);	//movss (rcx), xmm0
+	movssMReg32XMM(binBlock, rcx, src);	//movss (rcx), xmm0
 }
 
 void X86DynaRecCore::FMOV_FR_MFR(X86BinBlock *binBlock) {
-	uint64 fRegAddr = (uint64)fRegs + (memManager.codeSpace[pC + 1] << 2);
-	uint64 fMRegAddr = (uint64)regs + (memManager.codeSpace[pC] << 3);
+	uint8 fReg = memManager.codeSpace[pC + 1];
+	uint8 fMReg = memManager.codeSpace[pC];
 
-	movRAX_MOffset(binBlock, fMRegAddr);	//mov rax, (fMRegAddr)
-	movssXMM_MReg32(binBlock, xmm0, rax);	//movss xmm0, (rax)
-	movReg64Immi64(binBlock, rcx, fRegAddr);	//mov rcx, fRegAddr
-	movssMReg32XMM(binBlock, rcx, xmm0);	//movss (rcx), xmm0
+	regAllocator.loadReg(binBlock, rax, fMReg);	//mov rax, fMReg
+	X86_64Register dst = regAllocator.getFReg(fReg, xmm0);
+	movssXMM_MReg32(binBlock, dst, rax);	//movss xmm0, (rax)
+	regAllocator.storeFReg(binBlock, fReg, dst);	//movss fReg, xmm0
 }
 
 void X86DynaRecCore::FMOV_MFR_FR(X86BinBlock *binBlock) {
-	uint64 fRegAddr = (uint64)fRegs + (memManager.codeSpace[pC + 1] << 2);
-	uint64 fMRegAddr = (uint64)regs + (memManager.codeSpace[pC] << 3);
+	uint8 fReg = memManager.codeSpace[pC + 1];
+	uint8 fMReg = memManager.codeSpace[pC];
 
-	movReg64Immi64(binBlock, rcx, fRegAddr);	//mov rcx, fRegAddr
-	movssXMM_MReg32(binBlock, xmm0, rcx);	//movss xmm0, (rcx)
-	movRAX_MOffset(binBlock, fMRegAddr);	//mov rax, (fMRegAddr)
-	movssMReg32XMM(binBlock, rax, xmm0);	//movss (rax), xmm0
+	X86_64Register src = regAllocator.useFReg(binBlock, fReg, xmm0);	//movss xmm0, fReg
+	regAllocator.loadReg(binBlock, rax, fMReg);	//mov rax, fMReg
+	movssMReg32XMM(binBlock, rax, src);	//movss (rax), xmm0
 }
 
 void X86DynaRecCore::FMOV_FM_MFR(X86BinBlock *binBlock) {
-	uint64 fMRegAddr = (uint64)regs + (memManager.codeSpace[pC] << 3);
+	uint8 fMReg = memManager.codeSpace[pC];
 	uint64 gFMemoryAddr = (uint64)memManager.globalDataSpace + *(uint32*)&memManager.codeSpace[pC + 1];
 
-	movRAX_MOffset(binBlock, fMRegAddr);	//mov rax, (fMRegAddr)
+	regAllocator.loadReg(binBlock, rax, fMReg);	//mov rax, fMReg
 	movssXMM_MReg32(binBlock, xmm0, rax);	//movss xmm0, (rax)
 	movReg64Immi64(binBlock, rcx, gFMemoryAddr);	//mov rcx, gFMemoryAddr
 	movssMReg32XMM(binBlock, rcx, xmm0);	//movss (rcx), xmm0
 }
 
 void X86DynaRecCore::FMOV_MFR_FM(X86BinBlock *binBlock) {
-	uint64 fMRegAddr = (uint64)regs + (memManager.codeSpace[pC] << 3);
+	uint8 fMReg = memManager.codeSpace[pC];
 	uint64 gFMemoryAddr = (uint64)memManager.globalDataSpace + *(uint32*)&memManager.codeSpace[pC + 1];
 
 	movReg64Immi64(binBlock, rcx, gFMemoryAddr);	//mov rcx, gFMemoryAddr
 	movssXMM_MReg32(binBlock, xmm0, rcx);	//movss xmm0, (rcx)
-	movRAX_MOffset(binBlock, fMRegAddr);	//mov rax, (fMRegAddr)
+	regAllocator.loadReg(binBlock, rax, fMReg);	//mov rax, fMReg
 	movssMReg32XMM(binBlock, rax, xmm0);	//movss (rax), xmm0
 }
 
 void X86DynaRecCore::FMOV_MFR_MFR(X86BinBlock *binBlock) {
-	uint64 fMRegAddr1 = (uint64)regs + (memManager.codeSpace[pC] << 3);
-	uint64 fMRegAddr2 = (uint64)regs + (memManager.codeSpace[pC + 1] << 3);
+	uint8 fMReg1 = memManager.codeSpace[pC];
+	uint8 fMReg2 = memManager.codeSpace[pC + 1];
 
-	movRAX_MOffset(binBlock, fMRegAddr2);	//mov rax, (fMRegAddr2)
+	regAllocator.loadReg(binBlock, rax, fMReg2);	//mov rax, fMReg2
 	movssXMM_MReg32(binBlock, xmm0, rax);	//mov xmm0, (rax)
-	movRAX_MOffset(binBlock, fMRegAddr1);	//mov rax, (fMRegAddr1)
+	regAllocator.loadReg(binBlock, rax, fMReg1);	//mov rax, fMReg1
 	movssMReg32XMM(binBlock, rax, xmm0);	//movss (rax), xmm0
 }
 
@@ -1811,13 +2709,13 @@ void X86DynaRecCore::FMOV_FM_FM(X86BinBlock *binBlock) {
 }
 
 void X86DynaRecCore::FMOV_FR_FIMMI(X86BinBlock *binBlock) {
-	uint64 fRegAddr = (uint64)fRegs + (memManager.codeSpace[pC] << 2);
+	uint8 fReg = memManager.codeSpace[pC];
 	float32 fImmiValue = *(float32*)&memManager.codeSpace[pC + 1];
 
-	movssXMM_Disp32(binBlock, xmm0, 0);	//movss xmm0, (rip + 0)
+	X86_64Register dst = regAllocator.getFReg(fReg, xmm0);
+	movssXMM_Disp32(binBlock, dst, 0);	//movss xmm0, (rip + 0)
 	if (immediateFloat) immediateFloat->push_back(ImmediateFloat(fImmiValue, binBlock->getCounter() - 4));
-	movReg64Immi64(binBlock, rax, fRegAddr);	//mov rax, fRegAddr
-	movssMReg32XMM(binBlock, rax, xmm0);	//movss (rax), xmm0
+	regAllocator.storeFReg(binBlock, fReg, dst);	//movss fReg, xmm0
 }
 
 void X86DynaRecCore::FMOV_FM_FIMMI(X86BinBlock *binBlock) {
@@ -1831,417 +2729,373 @@ void X86DynaRecCore::FMOV_FM_FIMMI(X86BinBlock *binBlock) {
 }
 
 void X86DynaRecCore::FMOV_MFR_FIMMI(X86BinBlock *binBlock) {
-	uint64 fMRegAddr = (uint64)regs + (memManager.codeSpace[pC] << 3);
+	uint8 fMReg = memManager.codeSpace[pC];
 	float32 fImmiValue = *(float32*)&memManager.codeSpace[pC + 1];
 
 	movssXMM_Disp32(binBlock, xmm0, 0);	//movss xmm0, (rip + 0)
 	if (immediateFloat) immediateFloat->push_back(ImmediateFloat(fImmiValue, binBlock->getCounter() - 4));
-	movRAX_MOffset(binBlock, fMRegAddr);	//mov rax, (fMRegAddr)
+	regAllocator.loadReg(binBlock, rax, fMReg);	//mov rax, fMReg
 	movssMReg32XMM(binBlock, rax, xmm0);	//movss (rax), xmm0
 }
 
 void X86DynaRecCore::FADD_FR_FR(X86BinBlock *binBlock) {
-	uint64 fRegAddr1 = (uint64)fRegs + (memManager.codeSpace[pC] << 2);
-	uint64 fRegAddr2 = (uint64)fRegs + (memManager.codeSpace[pC + 1] << 2);
+	uint8 fReg1 = memManager.codeSpace[pC];
+	uint8 fReg2 = memManager.codeSpace[pC + 1];
 
-	movReg64Immi64(binBlock, rax, fRegAddr2);	//mov rax, fRegAddr2
-	movssXMM_MReg32(binBlock, xmm0, rax);	//movss xmm0, (rax)
-	movReg64Immi64(binBlock, rcx, fRegAddr1);	//mov rcx, fRegAddr1
-	addssXMM_MReg32(binBlock, xmm0, rcx);	//addss xmm0, (rcx)
-	movssMReg32XMM(binBlock, rcx, xmm0);	//movss (rcx), xmm0
+	X86_64Register dst = regAllocator.useFReg(binBlock, fReg1, xmm0);	//movss xmm0, fReg1
+	X86_64Register src = regAllocator.useFReg(binBlock, fReg2, xmm1);	//movss xmm1, fReg2
+	addssXMM_XMM(binBlock, dst, src);	//addss xmm0, xmm1
+	regAllocator.storeFReg(binBlock, fReg1, dst);	//movss fReg1, xmm0
 }
 
 
 void X86DynaRecCore::FADD_R_FR(X86BinBlock *binBlock) {
-	uint64 regAddr = (uint64)regs + (memManager.codeSpace[pC] << 3);
-	uint64 fRegAddr = (uint64)fRegs + (memManager.codeSpace[pC + 1] << 2);
+	int64 *regAddr = &regs[memManager.codeSpace[pC]];
+	float32 *fRegAddr = &fRegs[memManager.codeSpace[pC + 1]];
 
-	movReg64Immi64(binBlock, rax, regAddr);	//mov rax, regAddr
-	cvtsi2ssXMM_MReg32(binBlock, xmm0, rax);	//cvtsi2ss xmm0, (rax)
-	movReg64Immi64(binBlock, rcx, fRegAddr);	//mov rcx, fRegAddr
-	addssXMM_MReg32(binBlock, xmm0, rcx);	//addss xmm0, (rcx)
+	cvtsi2ssXMM_MRegDisp32(binBlock, xmm0, CONTEXT_REGISTER, getContextOffset(regAddr));	//cvtsi2ss xmm0, (regAddr)
+	addssXMM_MRegDisp(binBlock, xmm0, CONTEXT_REGISTER, getContextOffset(fRegAddr));	//addss xmm0, (fRegAddr)
 	cvtss2siReg32XMM(binBlock, ecx, xmm0);	//cvtss2si ecx, xmm0
-	movMReg64Reg64(binBlock, rax, rcx);	//mov (rax), rcx
+	movMRegDispReg64(binBlock, CONTEXT_REGISTER, getContextOffset(regAddr), rcx);	//mov (regAddr), rcx
 }
 
 void X86DynaRecCore::FADD_FR_R(X86BinBlock *binBlock) {
-	uint64 regAddr = (uint64)regs + (memManager.codeSpace[pC] << 3);
-	uint64 fRegAddr = (uint64)fRegs + (memManager.codeSpace[pC + 1] << 2);
+	int64 *regAddr = &regs[memManager.codeSpace[pC]];
+	float32 *fRegAddr = &fRegs[memManager.codeSpace[pC + 1]];
 
-	movReg64Immi64(binBlock, rax, regAddr);	//mov rax, regAddr
-	cvtsi2ssXMM_MReg32(binBlock, xmm0, rax);	//cvtsi2ss xmm0, (rax)
-	movReg64Immi64(binBlock, rcx, fRegAddr);	//mov rcx, fRegAddr
-	addssXMM_MReg32(binBlock, xmm0, rcx);	//addss xmm0, (rcx)
-	movssMReg32XMM(binBlock, rcx, xmm0);	//movss (rcx), xmm0
+	cvtsi2ssXMM_MRegDisp32(binBlock, xmm0, CONTEXT_REGISTER, getContextOffset(regAddr));	//cvtsi2ss xmm0, (regAddr)
+	addssXMM_MRegDisp(binBlock, xmm0, CONTEXT_REGISTER, getContextOffset(fRegAddr));	//addss xmm0, (fRegAddr)
+	movssMRegDispXMM(binBlock, CONTEXT_REGISTER, getContextOffset(fRegAddr), xmm0);	//movss (fRegAddr), xmm0
 }
 
 void X86DynaRecCore::FADD_FR_FIMMI(X86BinBlock *binBlock) {
-	uint64 fRegAddr = (uint64)fRegs + (memManager.codeSpace[pC] << 2);
+	uint8 fReg = memManager.codeSpace[pC];
 	float32 fImmiValue = *(float32*)&memManager.codeSpace[pC + 1];
 
-	movssXMM_Disp32(binBlock, xmm0, 0);	//movss xmm0, (rip + 0)
+	X86_64Register dst = regAllocator.useFReg(binBlock, fReg, xmm0);	//movss xmm0, fReg
+	addssXMM_Disp32(binBlock, dst, 0);	//addss xmm0, (rip + 0)
 	if (immediateFloat) immediateFloat->push_back(ImmediateFloat(fImmiValue, binBlock->getCounter() - 4));
-	movReg64Immi64(binBlock, rax, fRegAddr);	//mov rax, fRegAddr
-	addssXMM_MReg32(binBlock, xmm0, rax);	//addss xmm0, (rax)
-	movssMReg32XMM(binBlock, rax, xmm0);	//movss (rax), xmm0
+	regAllocator.storeFReg(binBlock, fReg, dst);	//movss fReg, xmm0
 }
 
 void X86DynaRecCore::FADD_R_FIMMI(X86BinBlock *binBlock) {
-	uint64 regAddr = (uint64)regs + (memManager.codeSpace[pC] << 3);
+	int64 *regAddr = &regs[memManager.codeSpace[pC]];
 	float32 fImmiValue = *(float32*)&memManager.codeSpace[pC + 1];
 
-	movReg64Immi64(binBlock, rax, regAddr);	//mov rax, regAddr
-	cvtsi2ssXMM_MReg32(binBlock, xmm0, rax);	//cvtsi2ss xmm0, (rax)
+	cvtsi2ssXMM_MRegDisp32(binBlock, xmm0, CONTEXT_REGISTER, getContextOffset(regAddr));	//cvtsi2ss xmm0, (regAddr)
 	addssXMM_Disp32(binBlock, xmm0, 0);	//addss xmm0, (rip + 0)
 	if (immediateFloat) immediateFloat->push_back(ImmediateFloat(fImmiValue, binBlock->getCounter() - 4));
 	cvtss2siReg32XMM(binBlock, ecx, xmm0);	//cvtss2si ecx, xmm0
-	movMReg64Reg64(binBlock, rax, rcx);	//mov (rax), rcx
+	movMRegDispReg64(binBlock, CONTEXT_REGISTER, getContextOffset(regAddr), rcx);	//mov (regAddr), rcx
 }
 
 void X86DynaRecCore::FSUB_FR_FR(X86BinBlock *binBlock) {
-	uint64 fRegAddr1 = (uint64)fRegs + (memManager.codeSpace[pC] << 2);
-	uint64 fRegAddr2 = (uint64)fRegs + (memManager.codeSpace[pC + 1] << 2);
+	uint8 fReg1 = memManager.codeSpace[pC];
+	uint8 fReg2 = memManager.codeSpace[pC + 1];
 
-	movReg64Immi64(binBlock, rax, fRegAddr2);	//mov rax, fRegAddr2
-	movReg64Immi64(binBlock, rcx, fRegAddr1);	//mov rcx, fRegAddr1
-	movssXMM_MReg32(binBlock, xmm0, rcx);	//movss xmm0, (rcx)
-	addssXMM_MReg32(binBlock, xmm0, rax);	//addss xmm0, (rax)
-	movssMReg32XMM(binBlock, rcx, xmm0);	//movss (rcx), xmm0
+	X86_64Register dst = regAllocator.useFReg(binBlock, fReg1, xmm0);	//movss xmm0, fReg1
+	X86_64Register src = regAllocator.useFReg(binBlock, fReg2, xmm1);	//movss xmm1, fReg2
+	subssXMM_XMM(binBlock, dst, src);	//subss xmm0, xmm1
+	regAllocator.storeFReg(binBlock, fReg1, dst);	//movss fReg1, xmm0
 }
 
 void X86DynaRecCore::FSUB_R_FR(X86BinBlock *binBlock) {
-	uint64 regAddr = (uint64)regs + (memManager.codeSpace[pC] << 3);
-	uint64 fRegAddr = (uint64)fRegs + (memManager.codeSpace[pC + 1] << 2);
+	int64 *regAddr = &regs[memManager.codeSpace[pC]];
+	float32 *fRegAddr = &fRegs[memManager.codeSpace[pC + 1]];
 
-	movReg64Immi64(binBlock, rax, regAddr);	//mov rax, regAddr
-	cvtsi2ssXMM_MReg32(binBlock, xmm0, rax);	//cvtsi2ss xmm0, (rax)
-	movReg64Immi64(binBlock, rcx, fRegAddr);	//mov rcx, fRegAddr
-	subssXMM_MReg32(binBlock, xmm0, rcx);	//subss xmm0, (rcx)
+	cvtsi2ssXMM_MRegDisp32(binBlock, xmm0, CONTEXT_REGISTER, getContextOffset(regAddr));	//cvtsi2ss xmm0, (regAddr)
+	subssXMM_MRegDisp(binBlock, xmm0, CONTEXT_REGISTER, getContextOffset(fRegAddr));	//subss xmm0, (fRegAddr)
 	cvtss2siReg32XMM(binBlock, ecx, xmm0);	//cvtss2si ecx, xmm0
-	movMReg64Reg64(binBlock, rax, rcx);	//mov (rax), rcx
+	movMRegDispReg64(binBlock, CONTEXT_REGISTER, getContextOffset(regAddr), rcx);	//mov (regAddr), rcx
 }
 
 void X86DynaRecCore::FSUB_FR_R(X86BinBlock *binBlock) {
-	uint64 regAddr = (uint64)regs + (memManager.codeSpace[pC] << 3);
-	uint64 fRegAddr = (uint64)fRegs + (memManager.codeSpace[pC + 1] << 2);
+	int64 *regAddr = &regs[memManager.codeSpace[pC]];
+	float32 *fRegAddr = &fRegs[memManager.codeSpace[pC + 1]];
 
-	movReg64Immi64(binBlock, rax, regAddr);	//mov rax, regAddr
-	movReg64Immi64(binBlock, rcx, fRegAddr);	//mov rcx, fRegAddr
-	movssXMM_MReg32(binBlock, xmm0, rcx);	//movss xmm0, (rcx)
-	cvtsi2ssXMM_MReg32(binBlock, xmm1, rax);	//cvtsi2ss xmm1, (rax)
+	movssXMM_MRegDisp(binBlock, xmm0, CONTEXT_REGISTER, getContextOffset(fRegAddr));	//movss xmm0, (fRegAddr)
+	cvtsi2ssXMM_MRegDisp32(binBlock, xmm1, CONTEXT_REGISTER, getContextOffset(regAddr));	//cvtsi2ss xmm1, (regAddr)
 	subssXMM_XMM(binBlock, xmm0, xmm1);	//subss xmm0, xmm1
-	movssMReg32XMM(binBlock, rcx, xmm0);	//movss (rcx), xmm0
+	movssMRegDispXMM(binBlock, CONTEXT_REGISTER, getContextOffset(fRegAddr), xmm0);	//movss (fRegAddr), xmm0
 }
 
 void X86DynaRecCore::FSUB_FR_FIMMI(X86BinBlock *binBlock) {
-	uint64 fRegAddr = (uint64)fRegs + (memManager.codeSpace[pC] << 2);
+	uint8 fReg = memManager.codeSpace[pC];
 	float32 fImmiValue = *(float32*)&memManager.codeSpace[pC + 1];
 
-	movReg64Immi64(binBlock, rax, fRegAddr);	//mov rax, fRegAddr
-	movssXMM_MReg32(binBlock, xmm0, rax);	//movss xmm0, (rax)
-	subssXMM_Disp32(binBlock, xmm0, 0);	//subss xmm0, (rip + 0)
+	X86_64Register dst = regAllocator.useFReg(binBlock, fReg, xmm0);	//movss xmm0, fReg
+	subssXMM_Disp32(binBlock, dst, 0);	//subss xmm0, (rip + 0)
 	if (immediateFloat) immediateFloat->push_back(ImmediateFloat(fImmiValue, binBlock->getCounter() - 4));
-	movssMReg32XMM(binBlock, rax, xmm0);	//movss (rax), xmm0
+	regAllocator.storeFReg(binBlock, fReg, dst);	//movss fReg, xmm0
 }
 
 void X86DynaRecCore::FSUB_R_FIMMI(X86BinBlock *binBlock) {
-	uint64 regAddr = (uint64)regs + (memManager.codeSpace[pC] << 3);
+	int64 *regAddr = &regs[memManager.codeSpace[pC]];
 	float32 fImmiValue = *(float32*)&memManager.codeSpace[pC + 1];
 
-	movReg64Immi64(binBlock, rax, regAddr);	//mov rax, regAddr
-	cvtsi2ssXMM_MReg32(binBlock, xmm0, rax);	//cvtsi2ss xmm0, (rax)
+	cvtsi2ssXMM_MRegDisp32(binBlock, xmm0, CONTEXT_REGISTER, getContextOffset(regAddr));	//cvtsi2ss xmm0, (regAddr)
 	subssXMM_Disp32(binBlock, xmm0, 0);	//subss xmm0, (rip + 0)
 	if (immediateFloat) immediateFloat->push_back(ImmediateFloat(fImmiValue, binBlock->getCounter() - 4));
 	cvtss2siReg32XMM(binBlock, ecx, xmm0);	//cvtss2si ecx, xmm0
-	movMReg64Reg64(binBlock, rax, rcx);	//mov (rax), rcx
+	movMRegDispReg64(binBlock, CONTEXT_REGISTER, getContextOffset(regAddr), rcx);	//mov (regAddr), rcx
 }
 
 void X86DynaRecCore::FMUL_FR_FR(X86BinBlock *binBlock) {
-	uint64 fRegAddr1 = (uint64)fRegs + (memManager.codeSpace[pC] << 2);
-	uint64 fRegAddr2 = (uint64)fRegs + (memManager.codeSpace[pC + 1] << 2);
+	uint8 fReg1 = memManager.codeSpace[pC];
+	uint8 fReg2 = memManager.codeSpace[pC + 1];
 
-	movReg64Immi64(binBlock, rax, fRegAddr2);	//mov rax, fRegAddr2
-	movssXMM_MReg32(binBlock, xmm0, rax);	//movss xmm0, (rax)
-	movReg64Immi64(binBlock, rcx, fRegAddr1);	//mov rcx, fRegAddr1
-	mulssXMM_MReg32(binBlock, xmm0, rcx);	//mulss xmm0, (rcx)
-	movssMReg32XMM(binBlock, rcx, xmm0);	//movss (rcx), xmm0
+	X86_64Register dst = regAllocator.useFReg(binBlock, fReg1, xmm0);	//movss xmm0, fReg1
+	X86_64Register src = regAllocator.useFReg(binBlock, fReg2, xmm1);	//movss xmm1, fReg2
+	mulssXMM_XMM(binBlock, dst, src);	//mulss xmm0, xmm1
+	regAllocator.storeFReg(binBlock, fReg1, dst);	//movss fReg1, xmm0
 }
 
 void X86DynaRecCore::FMUL_R_FR(X86BinBlock *binBlock) {
-	uint64 regAddr = (uint64)regs + (memManager.codeSpace[pC] << 3);
-	uint64 fRegAddr = (uint64)fRegs + (memManager.codeSpace[pC + 1] << 2);
+	int64 *regAddr = &regs[memManager.codeSpace[pC]];
+	float32 *fRegAddr = &fRegs[memManager.codeSpace[pC + 1]];
 
-	movReg64Immi64(binBlock, rax, regAddr);	//mov rax, regAddr
-	cvtsi2ssXMM_MReg32(binBlock, xmm0, rax);	//cvtsi2ss xmm0, (rax)
-	movReg64Immi64(binBlock, rcx, fRegAddr);	//mov rcx, fRegAddr
-	mulssXMM_MReg32(binBlock, xmm0, rcx);	//mulss xmm0, (rcx)
+	cvtsi2ssXMM_MRegDisp32(binBlock, xmm0, CONTEXT_REGISTER, getContextOffset(regAddr));	//cvtsi2ss xmm0, (regAddr)
+	mulssXMM_MRegDisp(binBlock, xmm0, CONTEXT_REGISTER, getContextOffset(fRegAddr));	//mulss xmm0, (fRegAddr)
 	cvtss2siReg32XMM(binBlock, ecx, xmm0);	//cvtss2si ecx, xmm0
-	movMReg64Reg64(binBlock, rax, rcx);	//mov (rax), rcx
+	movMRegDispReg64(binBlock, CONTEXT_REGISTER, getContextOffset(regAddr), rcx);	//mov (regAddr), rcx
 }
 
 void X86DynaRecCore::FMUL_FR_R(X86BinBlock *binBlock) {
-	uint64 regAddr = (uint64)regs + (memManager.codeSpace[pC] << 3);
-	uint64 fRegAddr = (uint64)fRegs + (memManager.codeSpace[pC + 1] << 2);
+	int64 *regAddr = &regs[memManager.codeSpace[pC]];
+	float32 *fRegAddr = &fRegs[memManager.codeSpace[pC + 1]];
 
-	movReg64Immi64(binBlock, rax, regAddr);	//mov rax, regAddr
-	cvtsi2ssXMM_MReg32(binBlock, xmm0, rax);	//cvtsi2ss xmm0, (rax)
-	movReg64Immi64(binBlock, rcx, fRegAddr);	//mov rcx, fRegAddr
-	mulssXMM_MReg32(binBlock, xmm0, rcx);	//mulss xmm0, (rcx)
-	movssMReg32XMM(binBlock, rcx, xmm0);	//movss (rcx), xmm0
+	cvtsi2ssXMM_MRegDisp32(binBlock, xmm0, CONTEXT_REGISTER, getContextOffset(regAddr));	//cvtsi2ss xmm0, (regAddr)
+	mulssXMM_MRegDisp(binBlock, xmm0, CONTEXT_REGISTER, getContextOffset(fRegAddr));	//mulss xmm0, (fRegAddr)
+	movssMRegDispXMM(binBlock, CONTEXT_REGISTER, getContextOffset(fRegAddr), xmm0);	//movss (fRegAddr), xmm0
 }
 
 void X86DynaRecCore::FMUL_FR_FIMMI(X86BinBlock *binBlock) {
-	uint64 fRegAddr = (uint64)fRegs + (memManager.codeSpace[pC] << 2);
+	uint8 fReg = memManager.codeSpace[pC];
 	float32 fImmiValue = *(float32*)&memManager.codeSpace[pC + 1];
 
-	movssXMM_Disp32(binBlock, xmm0, 0);	//movss xmm0, (rip + 0)
+	X86_64Register dst = regAllocator.useFReg(binBlock, fReg, xmm0);	//movss xmm0, fReg
+	mulssXMM_Disp32(binBlock, dst, 0);	//mulss xmm0, (rip + 0)
 	if (immediateFloat) immediateFloat->push_back(ImmediateFloat(fImmiValue, binBlock->getCounter() - 4));
-	movReg64Immi64(binBlock, rax, fRegAddr);	//mov rax, fRegAddr
-	mulssXMM_MReg32(binBlock, xmm0, rax);	//mulss xmm0, (rax)
-	movssMReg32XMM(binBlock, rax, xmm0);	//movss (rax), xmm0
+	regAllocator.storeFReg(binBlock, fReg, dst);	//movss fReg, xmm0
 }
 
 void X86DynaRecCore::FMUL_R_FIMMI(X86BinBlock *binBlock) {
-	uint64 regAddr = (uint64)regs + (memManager.codeSpace[pC] << 3);
+	int64 *regAddr = &regs[memManager.codeSpace[pC]];
 	float32 fImmiValue = *(float32*)&memManager.codeSpace[pC + 1];
 
-	movReg64Immi64(binBlock, rax, regAddr);	//mov rax, regAddr
-	cvtsi2ssXMM_MReg32(binBlock, xmm0, rax);	//cvtsi2ss xmm0, (rax)
+	cvtsi2ssXMM_MRegDisp32(binBlock, xmm0, CONTEXT_REGISTER, getContextOffset(regAddr));	//cvtsi2ss xmm0, (regAddr)
 	mulssXMM_Disp32(binBlock, xmm0, 0);	//mulss xmm0, (rip + 0)
 	if (immediateFloat) immediateFloat->push_back(ImmediateFloat(fImmiValue, binBlock->getCounter() - 4));
 	cvtss2siReg32XMM(binBlock, ecx, xmm0);	//cvtss2si ecx, xmm0
-	movMReg64Reg64(binBlock, rax, rcx);	//mov (rax), rcx
+	movMRegDispReg64(binBlock, CONTEXT_REGISTER, getContextOffset(regAddr), rcx);	//mov (regAddr), rcx
 }
 
 void X86DynaRecCore::FDIV_FR_FR(X86BinBlock *binBlock) {
-	uint64 fRegAddr1 = (uint64)fRegs + (memManager.codeSpace[pC] << 2);
-	uint64 fRegAddr2 = (uint64)fRegs + (memManager.codeSpace[pC + 1] << 2);
+	uint8 fReg1 = memManager.codeSpace[pC];
+	uint8 fReg2 = memManager.codeSpace[pC + 1];
 
-	movReg64Immi64(binBlock, rax, fRegAddr2);	//mov rax, fRegAddr2
-	movReg64Immi64(binBlock, rcx, fRegAddr1);	//mov rcx, fRegAddr1
-	movssXMM_MReg32(binBlock, xmm0, rcx);	//movss xmm0, (rcx)
-	addssXMM_MReg32(binBlock, xmm0, rax);	//addss xmm0, (rax)
-	movssMReg32XMM(binBlock, rcx, xmm0);	//movss (rcx), xmm0
+	X86_64Register dst = regAllocator.useFReg(binBlock, fReg1, xmm0);	//movss xmm0, fReg1
+	X86_64Register src = regAllocator.useFReg(binBlock, fReg2, xmm1);	//movss xmm1, fReg2
+	divssXMM_XMM(binBlock, dst, src);	//divss xmm0, xmm1
+	regAllocator.storeFReg(binBlock, fReg1, dst);	//movss fReg1, xmm0
 }
 
 void X86DynaRecCore::FDIV_R_FR(X86BinBlock *binBlock) {
-	uint64 regAddr = (uint64)regs + (memManager.codeSpace[pC] << 3);
-	uint64 fRegAddr = (uint64)fRegs + (memManager.codeSpace[pC + 1] << 2);
+	int64 *regAddr = &regs[memManager.codeSpace[pC]];
+	float32 *fRegAddr = &fRegs[memManager.codeSpace[pC + 1]];
 
-	movReg64Immi64(binBlock, rax, regAddr);	//mov rax, regAddr
-	cvtsi2ssXMM_MReg32(binBlock, xmm0, rax);	//cvtsi2ss xmm0, (rax)
-	movReg64Immi64(binBlock, rcx, fRegAddr);	//mov rcx, fRegAddr
-	divssXMM_MReg32(binBlock, xmm0, rcx);	//divss xmm0, (rcx)
+	cvtsi2ssXMM_MRegDisp32(binBlock, xmm0, CONTEXT_REGISTER, getContextOffset(regAddr));	//cvtsi2ss xmm0, (regAddr)
+	divssXMM_MRegDisp(binBlock, xmm0, CONTEXT_REGISTER, getContextOffset(fRegAddr));	//divss xmm0, (fRegAddr)
 	cvtss2siReg32XMM(binBlock, ecx, xmm0);	//cvtss2si ecx, xmm0
-	movMReg64Reg64(binBlock, rax, rcx);	//mov (rax), rcx
+	movMRegDispReg64(binBlock, CONTEXT_REGISTER, getContextOffset(regAddr), rcx);	//mov (regAddr), rcx
 }
 
 void X86DynaRecCore::FDIV_FR_R(X86BinBlock *binBlock) {
-	uint64 regAddr = (uint64)regs + (memManager.codeSpace[pC] << 3);
-	uint64 fRegAddr = (uint64)fRegs + (memManager.codeSpace[pC + 1] << 2);
+	int64 *regAddr = &regs[memManager.codeSpace[pC]];
+	float32 *fRegAddr = &fRegs[memManager.codeSpace[pC + 1]];
 
-	movReg64Immi64(binBlock, rax, regAddr);	//mov rax, regAddr
-	movReg64Immi64(binBlock, rcx, fRegAddr);	//mov rcx, fRegAddr
-	movssXMM_MReg32(binBlock, xmm0, rcx);	//movss xmm0, (rcx)
-	cvtsi2ssXMM_MReg32(binBlock, xmm1, rax);	//cvtsi2ss xmm1, (rax)
+	movssXMM_MRegDisp(binBlock, xmm0, CONTEXT_REGISTER, getContextOffset(fRegAddr));	//movss xmm0, (fRegAddr)
+	cvtsi2ssXMM_MRegDisp32(binBlock, xmm1, CONTEXT_REGISTER, getContextOffset(regAddr));	//cvtsi2ss xmm1, (regAddr)
 	divssXMM_XMM(binBlock, xmm0, xmm1);	//divss xmm0, xmm1
-	movssMReg32XMM(binBlock, rcx, xmm0);	//movss (rcx), xmm0
+	movssMRegDispXMM(binBlock, CONTEXT_REGISTER, getContextOffset(fRegAddr), xmm0);	//movss (fRegAddr), xmm0
 }
 
 void X86DynaRecCore::FDIV_FR_FIMMI(X86BinBlock *binBlock) {
-	uint64 fRegAddr = (uint64)fRegs + (memManager.codeSpace[pC] << 2);
+	uint8 fReg = memManager.codeSpace[pC];
 	float32 fImmiValue = *(float32*)&memManager.codeSpace[pC + 1];
 
-	movReg64Immi64(binBlock, rax, fRegAddr);	//mov rax, fRegAddr
-	movssXMM_MReg32(binBlock, xmm0, rax);	//movss xmm0, (rax)
-	divssXMM_Disp32(binBlock, xmm0, 0);	//divss xmm0, (rip + 0)
+	X86_64Register dst = regAllocator.useFReg(binBlock, fReg, xmm0);	//movss xmm0, fReg
+	divssXMM_Disp32(binBlock, dst, 0);	//divss xmm0, (rip + 0)
 	if (immediateFloat) immediateFloat->push_back(ImmediateFloat(fImmiValue, binBlock->getCounter() - 4));
-	movssMReg32XMM(binBlock, rax, xmm0);	//movss (rax), xmm0
+	regAllocator.storeFReg(binBlock, fReg, dst);	//movss fReg, xmm0
 }
 
 void X86DynaRecCore::FDIV_R_FIMMI(X86BinBlock *binBlock) {
-	uint64 regAddr = (uint64)regs + (memManager.codeSpace[pC] << 3);
+	int64 *regAddr = &regs[memManager.codeSpace[pC]];
 	float32 fImmiValue = *(float32*)&memManager.codeSpace[pC + 1];
 
-	movReg64Immi64(binBlock, rax, regAddr);	//mov rax, regAddr
-	cvtsi2ssXMM_MReg32(binBlock, xmm0, rax);	//cvtsi2ss xmm0, (rax)
+	cvtsi2ssXMM_MRegDisp32(binBlock, xmm0, CONTEXT_REGISTER, getContextOffset(regAddr));	//cvtsi2ss xmm0, (regAddr)
 	divssXMM_Disp32(binBlock, xmm0, 0);	//divss xmm0, (rip + 0)
 	if (immediateFloat) immediateFloat->push_back(ImmediateFloat(fImmiValue, binBlock->getCounter() - 4));
 	cvtss2siReg32XMM(binBlock, ecx, xmm0);	//cvtss2si ecx, xmm0
-	movMReg64Reg64(binBlock, rax, rcx);	//mov (rax), rcx
+	movMRegDispReg64(binBlock, CONTEXT_REGISTER, getContextOffset(regAddr), rcx);	//mov (regAddr), rcx
 }
 
 void X86DynaRecCore::FMOD_FR_FR(X86BinBlock *binBlock) {
 	float32 (*fmodPtr)(float32, float32) = fmod;
-	uint64 fRegAddr1 = (uint64)fRegs + (memManager.codeSpace[pC] << 2);
-	uint64 fRegAddr2 = (uint64)fRegs + (memManager.codeSpace[pC + 1] << 2);
+	float32 *fRegAddr1 = &fRegs[memManager.codeSpace[pC]];
+	float32 *fRegAddr2 = &fRegs[memManager.codeSpace[pC + 1]];
+	X86HostCall hostCall(binBlock);
 
-	movReg64Immi64(binBlock, rax, fRegAddr1);
-	movReg64Immi64(binBlock, rcx, fRegAddr2);
-	movssXMM_MReg32(binBlock, xmm0, rax);
-	movssXMM_MReg32(binBlock, xmm1, rcx);
-	movReg64Immi64(binBlock, rcx, (uint64)fmodPtr);
-	callReg64(binBlock, rcx);
-	movReg64Immi64(binBlock, rax, fRegAddr1);
-	movssMReg32XMM(binBlock, rax, xmm0);
+	hostCall.argFloatContext(getContextOffset(fRegAddr1));
+	hostCall.argFloatContext(getContextOffset(fRegAddr2));
+	hostCall.call((uint64)fmodPtr);
+	movssMRegDispXMM(binBlock, CONTEXT_REGISTER, getContextOffset(fRegAddr1), xmm0);	//movss (fRegAddr1), xmm0
 }
 
 void X86DynaRecCore::FMOD_R_FR(X86BinBlock *binBlock) {
 	float32 (*fmodPtr)(float32, float32) = fmod;
-	uint64 regAddr = (uint64)regs + (memManager.codeSpace[pC] << 3);
-	uint64 fRegAddr = (uint64)fRegs + (memManager.codeSpace[pC + 1] << 2);
+	int64 *regAddr = &regs[memManager.codeSpace[pC]];
+	float32 *fRegAddr = &fRegs[memManager.codeSpace[pC + 1]];
+	X86HostCall hostCall(binBlock);
 
-	movReg64Immi64(binBlock, rax, regAddr);
-	movReg64Immi64(binBlock, rcx, fRegAddr);
-	cvtsi2ssXMM_MReg32(binBlock, xmm0, rax);
-	movssXMM_MReg32(binBlock, xmm1, rcx);
-	movReg64Immi64(binBlock, rcx, (uint64)fmodPtr);
-	callReg64(binBlock, rcx);
-	cvtss2siReg32XMM(binBlock, ecx, xmm0);
-	movReg64Immi64(binBlock, rax, regAddr);
-	movMReg64Reg64(binBlock, rax, rcx);
+	hostCall.argIntAsFloatContext(getContextOffset(regAddr));
+	hostCall.argFloatContext(getContextOffset(fRegAddr));
+	hostCall.call((uint64)fmodPtr);
+	cvtss2siReg32XMM(binBlock, ecx, xmm0);	//cvtss2si ecx, xmm0
+	movMRegDispReg64(binBlock, CONTEXT_REGISTER, getContextOffset(regAddr), rcx);	//mov (regAddr), rcx
 }
 
 void X86DynaRecCore::FMOD_FR_R(X86BinBlock *binBlock) {
 	float32 (*fmodPtr)(float32, float32) = fmod;
-	uint64 regAddr = (uint64)regs + (memManager.codeSpace[pC] << 3);
-	uint64 fRegAddr = (uint64)fRegs + (memManager.codeSpace[pC + 1] << 2);
+	int64 *regAddr = &regs[memManager.codeSpace[pC]];
+	float32 *fRegAddr = &fRegs[memManager.codeSpace[pC + 1]];
+	X86HostCall hostCall(binBlock);
 
-	movReg64Immi64(binBlock, rax, fRegAddr);
-	movReg64Immi64(binBlock, rcx, regAddr);
-	movssXMM_MReg32(binBlock, xmm0, rax);
-	cvtsi2ssXMM_MReg32(binBlock, xmm1, rcx);
-	movReg64Immi64(binBlock, rcx, (uint64)fmodPtr);
-	callReg64(binBlock, rcx);
-	movReg64Immi64(binBlock, rax, fRegAddr);
-	movssMReg32XMM(binBlock, rax, xmm0);
+	hostCall.argFloatContext(getContextOffset(fRegAddr));
+	hostCall.argIntAsFloatContext(getContextOffset(regAddr));
+	hostCall.call((uint64)fmodPtr);
+	movssMRegDispXMM(binBlock, CONTEXT_REGISTER, getContextOffset(fRegAddr), xmm0);	//movss (fRegAddr), xmm0
 }
 
 void X86DynaRecCore::FMOD_FR_FIMMI(X86BinBlock *binBlock) {
-	float (*fmodPtr)(float, float) = fmod;
-	uint64 fRegAddr = (uint64)fRegs + (memManager.codeSpace[pC] << 2);
+	float32 (*fmodPtr)(float32, float32) = fmod;
+	float32 *fRegAddr = &fRegs[memManager.codeSpace[pC]];
 	float32 fImmiValue = *(float32*)&memManager.codeSpace[pC + 1];
+	X86HostCall hostCall(binBlock);
 
-	movReg64Immi64(binBlock, rax, fRegAddr);
-	movssXMM_MReg32(binBlock, xmm0, rax);
-	movssXMM_Disp32(binBlock, xmm1, 0);
+	hostCall.argFloatContext(getContextOffset(fRegAddr));
+	movssXMM_Disp32(binBlock, hostCall.nextFloatArg(), 0);	//movss arg, (rip + 0)
 	if (immediateFloat) immediateFloat->push_back(ImmediateFloat(fImmiValue, binBlock->getCounter() - 4));
-	movReg64Immi64(binBlock, rcx, (uint64)fmodPtr);
-	callReg64(binBlock, rcx);
-	movReg64Immi64(binBlock, rax, fRegAddr);
-	movssMReg32XMM(binBlock, rax, xmm0);
+	hostCall.call((uint64)fmodPtr);
+	movssMRegDispXMM(binBlock, CONTEXT_REGISTER, getContextOffset(fRegAddr), xmm0);	//movss (fRegAddr), xmm0
 }
 
 void X86DynaRecCore::FMOD_R_FIMMI(X86BinBlock *binBlock) {
 	float32 (*fmodPtr)(float32, float32) = fmod;
-	uint64 regAddr = (uint64)regs + (memManager.codeSpace[pC] << 3);
+	int64 *regAddr = &regs[memManager.codeSpace[pC]];
 	float32 fImmiValue = *(float32*)&memManager.codeSpace[pC + 1];
+	X86HostCall hostCall(binBlock);
 
-	movReg64Immi64(binBlock, rax, regAddr);
-	cvtsi2ssXMM_MReg32(binBlock, xmm0, rax);
-	movssXMM_Disp32(binBlock, xmm1, 0);
+	hostCall.argIntAsFloatContext(getContextOffset(regAddr));
+	movssXMM_Disp32(binBlock, hostCall.nextFloatArg(), 0);	//movss arg, (rip + 0)
 	if (immediateFloat) immediateFloat->push_back(ImmediateFloat(fImmiValue, binBlock->getCounter() - 4));
-	movReg64Immi64(binBlock, rcx, (uint64)fmodPtr);
-	callReg64(binBlock, rcx);
-	movReg64Immi64(binBlock, rax, regAddr);
-	cvtss2siReg32XMM(binBlock, ecx, xmm0);
-	movMReg64Reg64(binBlock, rax, rcx);
+	hostCall.call((uint64)fmodPtr);
+	cvtss2siReg32XMM(binBlock, ecx, xmm0);	//cvtss2si ecx, xmm0
+	movMRegDispReg64(binBlock, CONTEXT_REGISTER, getContextOffset(regAddr), rcx);	//mov (regAddr), rcx
 }
 
 void X86DynaRecCore::BMOV_R_MBR_IMMI(X86BinBlock *binBlock) {
-	uint64 regAddr = (uint64)regs + (memManager.codeSpace[pC] << 3);
-	uint64 bMRegAddr = (uint64)regs + (memManager.codeSpace[pC + 1] << 3);
+	int64 *regAddr = &regs[memManager.codeSpace[pC]];
+	int64 *bMRegAddr = &regs[memManager.codeSpace[pC + 1]];
 	uint32 immi = *(uint32*)&memManager.codeSpace[pC + 2];
 
-	movRAX_MOffset(binBlock, bMRegAddr);
+	movRAX_Context(binBlock, bMRegAddr);
 	addRAX_Immi32(binBlock, immi);
 	movReg8MReg8(binBlock, al, rax);
 	andRAX_Immi32(binBlock, 0xFF);
-	movMOffsetRAX(binBlock, regAddr);
+	movContextRAX(binBlock, regAddr);
 }
 
 void X86DynaRecCore::BMOV_MBR_IMMI_R(X86BinBlock *binBlock) {
-	uint64 regAddr = (uint64)regs + (memManager.codeSpace[pC] << 3);
-	uint64 bMRegAddr = (uint64)regs + (memManager.codeSpace[pC + 1] << 3);
+	int64 *regAddr = &regs[memManager.codeSpace[pC]];
+	int64 *bMRegAddr = &regs[memManager.codeSpace[pC + 1]];
 	uint32 immi = *(uint32*)&memManager.codeSpace[pC + 2];
 
-	movRAX_MOffset(binBlock, regAddr);
-	movReg64Immi64(binBlock, rcx, bMRegAddr);
+	movRAX_Context(binBlock, regAddr);
+	putContextAddress(binBlock, rcx, bMRegAddr);
 	addReg64Immi32(binBlock, rcx, immi);
 	movReg64MReg64(binBlock, rcx, rcx);
 	movMReg8Reg8(binBlock, rcx, al);
 }
 
 void X86DynaRecCore::BMOV_MBR_IMMI_MBR_IMMI(X86BinBlock *binBlock) {
-	uint64 bMRegAddr1 = (uint64)regs + (memManager.codeSpace[pC] << 3);
-	uint64 bMRegAddr2 = (uint64)regs + (memManager.codeSpace[pC + 1] << 3);
+	int64 *bMRegAddr1 = &regs[memManager.codeSpace[pC]];
+	int64 *bMRegAddr2 = &regs[memManager.codeSpace[pC + 1]];
 	uint32 immi1 = *(uint32*)&memManager.codeSpace[pC + 2];
 	uint32 immi2 = *(uint32*)&memManager.codeSpace[pC + 6];
 
-	movRAX_MOffset(binBlock, bMRegAddr2);
+	movRAX_Context(binBlock, bMRegAddr2);
 	addRAX_Immi32(binBlock, immi2);
 	movReg32MReg32(binBlock, eax, rax);
-	movReg64Immi64(binBlock, rcx, bMRegAddr1);
-	movReg64MReg64(binBlock, rcx, rcx);
+	movReg64MRegDisp(binBlock, rcx, CONTEXT_REGISTER, getContextOffset(bMRegAddr1));
 	addReg64Immi32(binBlock, rcx, immi1);
 	movMReg8Reg8(binBlock, rcx, al);
 }
 
 void X86DynaRecCore::BMOV_MBR_IMMI_IMMI8(X86BinBlock *binBlock) {
-	uint64 bMRegAddr = (uint64)regs + (memManager.codeSpace[pC] << 3);
+	int64 *bMRegAddr = &regs[memManager.codeSpace[pC]];
 	uint32 immi1 = *(uint32*)&memManager.codeSpace[pC + 1];
 	uint8 immi2 = memManager.codeSpace[pC + 5];
 
-	movRAX_MOffset(binBlock, bMRegAddr);
+	movRAX_Context(binBlock, bMRegAddr);
 	addRAX_Immi32(binBlock, immi1);
 	movMReg8Immi8(binBlock, rax, immi2);
 }
 
 void X86DynaRecCore::BMOV_R_BM(X86BinBlock *binBlock) {
-	uint64 regAddr = (uint64)regs + (memManager.codeSpace[pC] << 3);
+	int64 *regAddr = &regs[memManager.codeSpace[pC]];
 	uint64 bMemoryAddr = (uint64)memManager.globalDataSpace + *(uint32*)&memManager.codeSpace[pC + 1];
 
 	movAL_MOffset(binBlock, bMemoryAddr);
 	andRAX_Immi32(binBlock, 0xFF);
-	movMOffsetRAX(binBlock, regAddr);
+	movContextRAX(binBlock, regAddr);
 }
 
 void X86DynaRecCore::BMOV_BM_R(X86BinBlock *binBlock) {
-	uint64 regAddr = (uint64)regs + (memManager.codeSpace[pC] << 3);
+	int64 *regAddr = &regs[memManager.codeSpace[pC]];
 	uint64 bMemoryAddr = (uint64)memManager.globalDataSpace + *(uint32*)&memManager.codeSpace[pC + 1];
 
-	movRAX_MOffset(binBlock, regAddr);
+	movRAX_Context(binBlock, regAddr);
 	movMOffsetAL(binBlock, bMemoryAddr);
 }
 
 void X86DynaRecCore::BMOV_R_MBR(X86BinBlock *binBlock) {
-	uint64 regAddr = (uint64)regs + (memManager.codeSpace[pC] << 3);
-	uint64 bMRegAddr = (uint64)regs + (memManager.codeSpace[pC + 1] << 3);
+	int64 *regAddr = &regs[memManager.codeSpace[pC]];
+	int64 *bMRegAddr = &regs[memManager.codeSpace[pC + 1]];
 
-	movRAX_MOffset(binBlock, bMRegAddr);
+	movRAX_Context(binBlock, bMRegAddr);
 	movReg8MReg8(binBlock, al, rax);
 	andRAX_Immi32(binBlock, 0xFF);
-	movMOffsetRAX(binBlock, regAddr);
+	movContextRAX(binBlock, regAddr);
 }
 
 void X86DynaRecCore::BMOV_MBR_R(X86BinBlock *binBlock) {
-	uint64 regAddr = (uint64)regs + (memManager.codeSpace[pC] << 3);
-	uint64 bMRegAddr = (uint64)regs + (memManager.codeSpace[pC + 1] << 3);
+	int64 *regAddr = &regs[memManager.codeSpace[pC]];
+	int64 *bMRegAddr = &regs[memManager.codeSpace[pC + 1]];
 
-	movRAX_MOffset(binBlock, regAddr);
-	movReg64Immi64(binBlock, rcx, bMRegAddr);
-	movReg64MReg64(binBlock, rcx, rcx);
+	movRAX_Context(binBlock, regAddr);
+	movReg64MRegDisp(binBlock, rcx, CONTEXT_REGISTER, getContextOffset(bMRegAddr));
 	movMReg8Reg8(binBlock, rcx, al);
 }
 
 void X86DynaRecCore::BMOV_MBR_MBR(X86BinBlock *binBlock) {
-	uint64 bMRegAddr1 = (uint64)regs + (memManager.codeSpace[pC] << 3);
-	uint64 bMRegAddr2 = (uint64)regs + (memManager.codeSpace[pC + 1] << 3);
+	int64 *bMRegAddr1 = &regs[memManager.codeSpace[pC]];
+	int64 *bMRegAddr2 = &regs[memManager.codeSpace[pC + 1]];
 
-	movRAX_MOffset(binBlock, bMRegAddr2);
+	movRAX_Context(binBlock, bMRegAddr2);
 	movReg32MReg32(binBlock, eax, rax);
-	movReg64Immi64(binBlock, rcx, bMRegAddr1);
-	movReg64MReg64(binBlock, rcx, rcx);
+	movReg64MRegDisp(binBlock, rcx, CONTEXT_REGISTER, getContextOffset(bMRegAddr1));
 	movMReg8Reg8(binBlock, rcx, al);
 }
 
@@ -2255,10 +3109,10 @@ void X86DynaRecCore::BMOV_BM_BM(X86BinBlock *binBlock) {
 }
 
 void X86DynaRecCore::BMOV_MBR_IMMI8(X86BinBlock *binBlock) {
-	uint64 bMRegAddr = (uint64)regs + (memManager.codeSpace[pC] << 3);
+	int64 *bMRegAddr = &regs[memManager.codeSpace[pC]];
 	uint8 immiValue = memManager.codeSpace[pC + 1];
 
-	movRAX_MOffset(binBlock, bMRegAddr);
+	movRAX_Context(binBlock, bMRegAddr);
 	movMReg8Immi8(binBlock, rax, immiValue);
 }
 
@@ -2270,217 +3124,139 @@ void X86DynaRecCore::BMOV_BM_IMMI8(X86BinBlock *binBlock) {
 	movMReg8Immi8(binBlock, rax, immiValue);
 }
 
-void X86DynaRecCore::CMPE_R_R(X86BinBlock *binBlock) {
-	uint64 regAddr1 = (uint64)regs + (memManager.codeSpace[pC] << 3);
-	uint64 regAddr2 = (uint64)regs + (memManager.codeSpace[pC + 1] << 3);
-
-	movEAX_MOffset(binBlock, regAddr2);
-	movReg64Immi64(binBlock, rcx, regAddr1);
-	cmpMReg32Reg32(binBlock, rcx, eax);
-	jeRel32(binBlock, movMReg64Immi32(0, rcx, 0) + jmpRel32(0, 0));
-	movMReg64Immi32(binBlock, rcx, 0);
-	jmpRel32(binBlock, movMReg64Immi32(0, rcx, 1));
-	movMReg64Immi32(binBlock, rcx, 1);
-}
-
-void X86DynaRecCore::CMPNE_R_R(X86BinBlock *binBlock) {
-	uint64 regAddr1 = (uint64)regs + (memManager.codeSpace[pC] << 3);
-	uint64 regAddr2 = (uint64)regs + (memManager.codeSpace[pC + 1] << 3);
-
-	movEAX_MOffset(binBlock, regAddr2);
-	movReg64Immi64(binBlock, rcx, regAddr1);
-	cmpMReg32Reg32(binBlock, rcx, eax);
-	jeRel32(binBlock, movMReg64Immi32(0, rcx, 0) + jmpRel32(0, 0));
-	movMReg64Immi32(binBlock, rcx, 1);
-	jmpRel32(binBlock, movMReg64Immi32(0, rcx, 1));
-	movMReg64Immi32(binBlock, rcx, 0);
-}
-
-void X86DynaRecCore::CMPG_R_R(X86BinBlock *binBlock) {
-	uint64 regAddr1 = (uint64)regs + (memManager.codeSpace[pC] << 3);
-	uint64 regAddr2 = (uint64)regs + (memManager.codeSpace[pC + 1] << 3);
-
-	movEAX_MOffset(binBlock, regAddr2);
-	movReg64Immi64(binBlock, rcx, regAddr1);
-	cmpMReg32Reg32(binBlock, rcx, eax);
-	jgRel32(binBlock, movMReg64Immi32(0, rcx, 0) + jmpRel32(0, 0));
-	movMReg64Immi32(binBlock, rcx, 0);
-	jmpRel32(binBlock, movMReg64Immi32(0, rcx, 1));
-	movMReg64Immi32(binBlock, rcx, 1);
-}
-
-void X86DynaRecCore::CMPL_R_R(X86BinBlock *binBlock) {
-	uint64 regAddr1 = (uint64)regs + (memManager.codeSpace[pC] << 3);
-	uint64 regAddr2 = (uint64)regs + (memManager.codeSpace[pC + 1] << 3);
-
-	movEAX_MOffset(binBlock, regAddr2);
-	movReg64Immi64(binBlock, rcx, regAddr1);
-	cmpMReg32Reg32(binBlock, rcx, eax);
-	jlRel32(binBlock, movMReg64Immi32(0, rcx, 0) + jmpRel32(0, 0));
-	movMReg64Immi32(binBlock, rcx, 0);
-	jmpRel32(binBlock, movMReg64Immi32(0, rcx, 1));
-	movMReg64Immi32(binBlock, rcx, 1);
-}
-
-void X86DynaRecCore::CMPGE_R_R(X86BinBlock *binBlock) {
-	uint64 regAddr1 = (uint64)regs + (memManager.codeSpace[pC] << 3);
-	uint64 regAddr2 = (uint64)regs + (memManager.codeSpace[pC + 1] << 3);
-
-	movEAX_MOffset(binBlock, regAddr2);
-	movReg64Immi64(binBlock, rcx, regAddr1);
-	cmpMReg32Reg32(binBlock, rcx, eax);
-	jgeRel32(binBlock, movMReg64Immi32(0, rcx, 0) + jmpRel32(0, 0));
-	movMReg64Immi32(binBlock, rcx, 0);
-	jmpRel32(binBlock, movMReg64Immi32(0, rcx, 1));
-	movMReg64Immi32(binBlock, rcx, 1);
-}
-
-void X86DynaRecCore::CMPLE_R_R(X86BinBlock *binBlock) {
-	uint64 regAddr1 = (uint64)regs + (memManager.codeSpace[pC] << 3);
-	uint64 regAddr2 = (uint64)regs + (memManager.codeSpace[pC + 1] << 3);
-
-	movEAX_MOffset(binBlock, regAddr2);
-	movReg64Immi64(binBlock, rcx, regAddr1);
-	cmpMReg32Reg32(binBlock, rcx, eax);
-	jleRel32(binBlock, movMReg64Immi32(0, rcx, 0) + jmpRel32(0, 0));
-	movMReg64Immi32(binBlock, rcx, 0);
-	jmpRel32(binBlock, movMReg64Immi32(0, rcx, 1));
-	movMReg64Immi32(binBlock, rcx, 1);
-}
-
 void X86DynaRecCore::FCMPE_R_FR_FR(X86BinBlock *binBlock) {
-	uint64 regAddr = (uint64)regs + (memManager.codeSpace[pC] << 3);
-	uint64 fRegAddr1 = (uint64)fRegs + (memManager.codeSpace[pC + 1] << 2);
-	uint64 fRegAddr2 = (uint64)fRegs + (memManager.codeSpace[pC + 2] << 2);
+	int64 *regAddr = &regs[memManager.codeSpace[pC]];
+	float32 *fRegAddr1 = &fRegs[memManager.codeSpace[pC + 1]];
+	float32 *fRegAddr2 = &fRegs[memManager.codeSpace[pC + 2]];
 
-	movReg64Immi64(binBlock, rax, fRegAddr1);
-	movssXMM_MReg32(binBlock, xmm0, rax);
-	movReg64Immi64(binBlock, rcx, fRegAddr2);
-	ucomissXMM_MReg32(binBlock, xmm0, rcx);
-	movReg64Immi64(binBlock, rax, regAddr);
-	jeRel32(binBlock, movMReg64Immi32(0, rax, 0) + jmpRel32(binBlock, 0));
-	movMReg64Immi32(binBlock, rax, 0);
-	jmpRel32(binBlock, movMReg64Immi32(0, rax, 1));
-	movMReg64Immi32(binBlock, rax, 1);
+	movssXMM_MRegDisp(binBlock, xmm0, CONTEXT_REGISTER, getContextOffset(fRegAddr1));
+	ucomissXMM_MRegDisp(binBlock, xmm0, CONTEXT_REGISTER, getContextOffset(fRegAddr2));
+	jeRel32(binBlock, movMRegDisp64Immi32(0, CONTEXT_REGISTER, getContextOffset(regAddr), 0) + jmpRel32(binBlock, 0));
+	movMRegDisp64Immi32(binBlock, CONTEXT_REGISTER, getContextOffset(regAddr), 0);
+	jmpRel32(binBlock, movMRegDisp64Immi32(0, CONTEXT_REGISTER, getContextOffset(regAddr), 1));
+	movMRegDisp64Immi32(binBlock, CONTEXT_REGISTER, getContextOffset(regAddr), 1);
 }
 
 void X86DynaRecCore::FCMPNE_R_FR_FR(X86BinBlock *binBlock) {
-	uint64 regAddr = (uint64)regs + (memManager.codeSpace[pC] << 3);
-	uint64 fRegAddr1 = (uint64)fRegs + (memManager.codeSpace[pC + 1] << 2);
-	uint64 fRegAddr2 = (uint64)fRegs + (memManager.codeSpace[pC + 2] << 2);
+	int64 *regAddr = &regs[memManager.codeSpace[pC]];
+	float32 *fRegAddr1 = &fRegs[memManager.codeSpace[pC + 1]];
+	float32 *fRegAddr2 = &fRegs[memManager.codeSpace[pC + 2]];
 
-	movReg64Immi64(binBlock, rax, fRegAddr1);
-	movssXMM_MReg32(binBlock, xmm0, rax);
-	movReg64Immi64(binBlock, rcx, fRegAddr2);
-	ucomissXMM_MReg32(binBlock, xmm0, rcx);
-	movReg64Immi64(binBlock, rax, regAddr);
-	jeRel32(binBlock, movMReg64Immi32(0, rax, 0) + jmpRel32(binBlock, 0));
-	movMReg64Immi32(binBlock, rax, 1);
-	jmpRel32(binBlock, movMReg64Immi32(0, rax, 1));
-	movMReg64Immi32(binBlock, rax, 0);
+	movssXMM_MRegDisp(binBlock, xmm0, CONTEXT_REGISTER, getContextOffset(fRegAddr1));
+	ucomissXMM_MRegDisp(binBlock, xmm0, CONTEXT_REGISTER, getContextOffset(fRegAddr2));
+	jeRel32(binBlock, movMRegDisp64Immi32(0, CONTEXT_REGISTER, getContextOffset(regAddr), 0) + jmpRel32(binBlock, 0));
+	movMRegDisp64Immi32(binBlock, CONTEXT_REGISTER, getContextOffset(regAddr), 1);
+	jmpRel32(binBlock, movMRegDisp64Immi32(0, CONTEXT_REGISTER, getContextOffset(regAddr), 1));
+	movMRegDisp64Immi32(binBlock, CONTEXT_REGISTER, getContextOffset(regAddr), 0);
 }
 
 void X86DynaRecCore::FCMPG_R_FR_FR(X86BinBlock *binBlock) {
-	uint64 regAddr = (uint64)regs + (memManager.codeSpace[pC] << 3);
-	uint64 fRegAddr1 = (uint64)fRegs + (memManager.codeSpace[pC + 1] << 2);
-	uint64 fRegAddr2 = (uint64)fRegs + (memManager.codeSpace[pC + 2] << 2);
+	int64 *regAddr = &regs[memManager.codeSpace[pC]];
+	float32 *fRegAddr1 = &fRegs[memManager.codeSpace[pC + 1]];
+	float32 *fRegAddr2 = &fRegs[memManager.codeSpace[pC + 2]];
 
-	movReg64Immi64(binBlock, rax, fRegAddr1);
-	movssXMM_MReg32(binBlock, xmm0, rax);
-	movReg64Immi64(binBlock, rcx, fRegAddr2);
-	ucomissXMM_MReg32(binBlock, xmm0, rcx);
-	movReg64Immi64(binBlock, rax, regAddr);
-	jaRel32(binBlock, movMReg64Immi32(0, rax, 0) + jmpRel32(binBlock, 0));
-	movMReg64Immi32(binBlock, rax, 0);
-	jmpRel32(binBlock, movMReg64Immi32(0, rax, 1));
-	movMReg64Immi32(binBlock, rax, 1);
+	movssXMM_MRegDisp(binBlock, xmm0, CONTEXT_REGISTER, getContextOffset(fRegAddr1));
+	ucomissXMM_MRegDisp(binBlock, xmm0, CONTEXT_REGISTER, getContextOffset(fRegAddr2));
+	jaRel32(binBlock, movMRegDisp64Immi32(0, CONTEXT_REGISTER, getContextOffset(regAddr), 0) + jmpRel32(binBlock, 0));
+	movMRegDisp64Immi32(binBlock, CONTEXT_REGISTER, getContextOffset(regAddr), 0);
+	jmpRel32(binBlock, movMRegDisp64Immi32(0, CONTEXT_REGISTER, getContextOffset(regAddr), 1));
+	movMRegDisp64Immi32(binBlock, CONTEXT_REGISTER, getContextOffset(regAddr), 1);
 }
 
 void X86DynaRecCore::FCMPL_R_FR_FR(X86BinBlock *binBlock) {
-	uint64 regAddr = (uint64)regs + (memManager.codeSpace[pC] << 3);
-	uint64 fRegAddr1 = (uint64)fRegs + (memManager.codeSpace[pC + 1] << 2);
-	uint64 fRegAddr2 = (uint64)fRegs + (memManager.codeSpace[pC + 2] << 2);
+	int64 *regAddr = &regs[memManager.codeSpace[pC]];
+	float32 *fRegAddr1 = &fRegs[memManager.codeSpace[pC + 1]];
+	float32 *fRegAddr2 = &fRegs[memManager.codeSpace[pC + 2]];
 
-	movReg64Immi64(binBlock, rax, fRegAddr1);
-	movssXMM_MReg32(binBlock, xmm0, rax);
-	movReg64Immi64(binBlock, rcx, fRegAddr2);
-	ucomissXMM_MReg32(binBlock, xmm0, rcx);
-	movReg64Immi64(binBlock, rax, regAddr);
-	jbRel32(binBlock, movMReg64Immi32(0, rax, 0) + jmpRel32(binBlock, 0));
-	movMReg64Immi32(binBlock, rax, 0);
-	jmpRel32(binBlock, movMReg64Immi32(0, rax, 1));
-	movMReg64Immi32(binBlock, rax, 1);
+	movssXMM_MRegDisp(binBlock, xmm0, CONTEXT_REGISTER, getContextOffset(fRegAddr1));
+	ucomissXMM_MRegDisp(binBlock, xmm0, CONTEXT_REGISTER, getContextOffset(fRegAddr2));
+	jbRel32(binBlock, movMRegDisp64Immi32(0, CONTEXT_REGISTER, getContextOffset(regAddr), 0) + jmpRel32(binBlock, 0));
+	movMRegDisp64Immi32(binBlock, CONTEXT_REGISTER, getContextOffset(regAddr), 0);
+	jmpRel32(binBlock, movMRegDisp64Immi32(0, CONTEXT_REGISTER, getContextOffset(regAddr), 1));
+	movMRegDisp64Immi32(binBlock, CONTEXT_REGISTER, getContextOffset(regAddr), 1);
 }
 
 void X86DynaRecCore::FCMPGE_R_FR_FR(X86BinBlock *binBlock) {
-	uint64 regAddr = (uint64)regs + (memManager.codeSpace[pC] << 3);
-	uint64 fRegAddr1 = (uint64)fRegs + (memManager.codeSpace[pC + 1] << 2);
-	uint64 fRegAddr2 = (uint64)fRegs + (memManager.codeSpace[pC + 2] << 2);
+	int64 *regAddr = &regs[memManager.codeSpace[pC]];
+	float32 *fRegAddr1 = &fRegs[memManager.codeSpace[pC + 1]];
+	float32 *fRegAddr2 = &fRegs[memManager.codeSpace[pC + 2]];
 
-	movReg64Immi64(binBlock, rax, fRegAddr1);
-	movssXMM_MReg32(binBlock, xmm0, rax);
-	movReg64Immi64(binBlock, rcx, fRegAddr2);
-	ucomissXMM_MReg32(binBlock, xmm0, rcx);
-	movReg64Immi64(binBlock, rax, regAddr);
-	jaeRel32(binBlock, movMReg64Immi32(0, rax, 0) + jmpRel32(binBlock, 0));
-	movMReg64Immi32(binBlock, rax, 0);
-	jmpRel32(binBlock, movMReg64Immi32(0, rax, 1));
-	movMReg64Immi32(binBlock, rax, 1);
+	movssXMM_MRegDisp(binBlock, xmm0, CONTEXT_REGISTER, getContextOffset(fRegAddr1));
+	ucomissXMM_MRegDisp(binBlock, xmm0, CONTEXT_REGISTER, getContextOffset(fRegAddr2));
+	jaeRel32(binBlock, movMRegDisp64Immi32(0, CONTEXT_REGISTER, getContextOffset(regAddr), 0) + jmpRel32(binBlock, 0));
+	movMRegDisp64Immi32(binBlock, CONTEXT_REGISTER, getContextOffset(regAddr), 0);
+	jmpRel32(binBlock, movMRegDisp64Immi32(0, CONTEXT_REGISTER, getContextOffset(regAddr), 1));
+	movMRegDisp64Immi32(binBlock, CONTEXT_REGISTER, getContextOffset(regAddr), 1);
 }
 
 void X86DynaRecCore::FCMPLE_R_FR_FR(X86BinBlock *binBlock) {
-	uint64 regAddr = (uint64)regs + (memManager.codeSpace[pC] << 3);
-	uint64 fRegAddr1 = (uint64)fRegs + (memManager.codeSpace[pC + 1] << 2);
-	uint64 fRegAddr2 = (uint64)fRegs + (memManager.codeSpace[pC + 2] << 2);
+	int64 *regAddr = &regs[memManager.codeSpace[pC]];
+	float32 *fRegAddr1 = &fRegs[memManager.codeSpace[pC + 1]];
+	float32 *fRegAddr2 = &fRegs[memManager.codeSpace[pC + 2]];
 
-	movReg64Immi64(binBlock, rax, fRegAddr1);
-	movssXMM_MReg32(binBlock, xmm0, rax);
-	movReg64Immi64(binBlock, rcx, fRegAddr2);
-	ucomissXMM_MReg32(binBlock, xmm0, rcx);
-	movReg64Immi64(binBlock, rax, regAddr);
-	jbeRel32(binBlock, movMReg64Immi32(0, rax, 0) + jmpRel32(binBlock, 0));
-	movMReg64Immi32(binBlock, rax, 0);
-	jmpRel32(binBlock, movMReg64Immi32(0, rax, 1));
-	movMReg64Immi32(binBlock, rax, 1);
+	movssXMM_MRegDisp(binBlock, xmm0, CONTEXT_REGISTER, getContextOffset(fRegAddr1));
+	ucomissXMM_MRegDisp(binBlock, xmm0, CONTEXT_REGISTER, getContextOffset(fRegAddr2));
+	jbeRel32(binBlock, movMRegDisp64Immi32(0, CONTEXT_REGISTER, getContextOffset(regAddr), 0) + jmpRel32(binBlock, 0));
+	movMRegDisp64Immi32(binBlock, CONTEXT_REGISTER, getContextOffset(regAddr), 0);
+	jmpRel32(binBlock, movMRegDisp64Immi32(0, CONTEXT_REGISTER, getContextOffset(regAddr), 1));
+	movMRegDisp64Immi32(binBlock, CONTEXT_REGISTER, getContextOffset(regAddr), 1);
 }
 
 void X86DynaRecCore::FOUT_IMMI_FR(X86BinBlock *binBlock) {
 	void (*writePortPtr)(float32, uint32, PortManager*) = PortManager::writePortAsFloat;
-	uint64 fRegAddr = (uint64)fRegs + (memManager.codeSpace[pC] << 2);
+	float32 *fRegAddr = &fRegs[memManager.codeSpace[pC]];
 	uint32 immiValue = *(uint32*)&memManager.codeSpace[pC + 1];
+	if (isDirectPortAccess(_FOUT_IMMI_FR, &memManager.codeSpace[pC])) {
+		X86_64Register src = regAllocator.useFReg(binBlock, memManager.codeSpace[pC], xmm0);	//movss xmm0, fReg
+		movssMRegDispXMM(binBlock, CONTEXT_REGISTER, getContextOffset(portManager.getPortAddress(immiValue)), src);	//movss (port), xmm0
+		return;
+	}
 
-	movReg64Immi64(binBlock, rax, fRegAddr);
-	movssXMM_MReg32(binBlock, xmm0, rax);
-	movReg32Immi32(binBlock, edx, immiValue);
-	movReg64Immi64(binBlock, r8, (uint64)&portManager);
-	movReg64Immi64(binBlock, rax, (uint64)writePortPtr);
-	callReg64(binBlock, rax);
+	X86HostCall hostCall(binBlock);
+
+	hostCall.argFloatContext(getContextOffset(fRegAddr));
+	hostCall.argImmi(immiValue);
+	hostCall.argContextAddress(getContextOffset(&portManager));
+	hostCall.call((uint64)writePortPtr);
 }
 
 void X86DynaRecCore::FIN_FR_IMMI(X86BinBlock *binBlock) {
 	float32 (*readPortPtr)(uint32, PortManager*) = PortManager::readPortAsFloat;
-	uint64 fRegAddr = (uint64)fRegs + (memManager.codeSpace[pC] << 2);
+	float32 *fRegAddr = &fRegs[memManager.codeSpace[pC]];
 	uint32 immiValue = *(uint32*)&memManager.codeSpace[pC + 1];
+	if (isDirectPortAccess(_FIN_IMMI_FR, &memManager.codeSpace[pC])) {
+		uint8 fReg = memManager.codeSpace[pC];
+		X86_64Register dst = regAllocator.getFReg(fReg, xmm0);
+		movssXMM_MRegDisp(binBlock, dst, CONTEXT_REGISTER, getContextOffset(portManager.getPortAddress(immiValue)));	//movss xmm0, (port)
+		regAllocator.storeFReg(binBlock, fReg, dst);	//movss fReg, xmm0
+		return;
+	}
 
-	movReg32Immi32(binBlock, rcx, immiValue);
-	movReg64Immi64(binBlock, rdx, (uint64)&portManager);
-	movReg64Immi64(binBlock, rax, (uint64)readPortPtr);
-	callReg64(binBlock, rax);
-	movReg64Immi64(binBlock, rax, fRegAddr);
-	movssMReg32XMM(binBlock, rax, xmm0);
+	X86HostCall hostCall(binBlock);
+
+	hostCall.argImmi(immiValue);
+	hostCall.argContextAddress(getContextOffset(&portManager));
+	hostCall.call((uint64)readPortPtr);
+	movssMRegDispXMM(binBlock, CONTEXT_REGISTER, getContextOffset(fRegAddr), xmm0);	//movss (fRegAddr), xmm0
 }
 
 void X86DynaRecCore::FOUT_IMMI_FIMMI(X86BinBlock *binBlock) {
 	void (*writePortPtr)(float32, uint32, PortManager*) = PortManager::writePortAsFloat;
 	uint32 immiValue1 = *(uint32*)&memManager.codeSpace[pC];
 	float32 immiValue2 = *(float32*)&memManager.codeSpace[pC + 4];
+	if (isDirectPortAccess(_FOUT_IMMI_FIMMI, &memManager.codeSpace[pC])) {
+		movReg32Immi32(binBlock, eax, *(uint32*)&immiValue2);	//mov eax, immiValue2
+		putPortStore(binBlock, immiValue1, eax, 4);	//mov (port), eax
+		return;
+	}
 
-	movssXMM_Disp32(binBlock, xmm0, 0);
+	X86HostCall hostCall(binBlock);
+
+	movssXMM_Disp32(binBlock, hostCall.nextFloatArg(), 0);	//movss arg, (rip + 0)
 	if (immediateFloat) immediateFloat->push_back(ImmediateFloat(immiValue2, binBlock->getCounter() - 4));
-	movReg32Immi32(binBlock, edx, immiValue1);
-	movReg64Immi64(binBlock, r8, (uint64)&portManager);
-	movReg64Immi64(binBlock, rax, (uint64)writePortPtr);
-	callReg64(binBlock, rax);
+	hostCall.argImmi(immiValue1);
+	hostCall.argContextAddress(getContextOffset(&portManager));
+	hostCall.call((uint64)writePortPtr);
 }
 
 void X86DynaRecCore::PUSHES_R_R(X86BinBlock *binBlock) {
@@ -2488,16 +3264,15 @@ void X86DynaRecCore::PUSHES_R_R(X86BinBlock *binBlock) {
 	int regIndex2 = memManager.codeSpace[pC + 1];
 	
 	int numOfRegsToPush = regIndex2 - regIndex1 + 1;
-	uint64 sourceAddr = (uint64)regs + (regIndex1 << 3);
+	int64 *sourceAddr = &regs[regIndex1];
 	
-	movReg64Immi64(binBlock, rax, (uint64)&sP);
-	movReg64Immi64(binBlock, rsi, sourceAddr);
-	movReg64Immi64(binBlock, rdi, (uint64)memManager.stackSpace);
-	movReg32MReg32(binBlock, ecx, rax);
+	putContextAddress(binBlock, rsi, sourceAddr);
+	putStackAddress(binBlock, rdi);
+	movReg32MRegDisp(binBlock, ecx, CONTEXT_REGISTER, getContextOffset(&sP));
 	addReg64Reg64(binBlock, rdi, rcx);
 	movReg32Immi32(binBlock, ecx, numOfRegsToPush);
 	repMovs64(binBlock);
-	addMReg32Immi32(binBlock, rax, numOfRegsToPush << 3);
+	addMRegDisp32Immi32(binBlock, CONTEXT_REGISTER, getContextOffset(&sP), numOfRegsToPush << 3);
 }
 
 void X86DynaRecCore::POPS_R_R(X86BinBlock *binBlock) {
@@ -2505,14 +3280,13 @@ void X86DynaRecCore::POPS_R_R(X86BinBlock *binBlock) {
 	int regIndex2 = memManager.codeSpace[pC + 1];
 	
 	int numOfRegsToPop = regIndex2 - regIndex1 + 1;
-	uint64 destinationAddr = (uint64)regs + (regIndex1 << 3);
+	int64 *destinationAddr = &regs[regIndex1];
 	
-	movReg64Immi64(binBlock, rax, (uint64)&sP);
-	subMReg32Immi32(binBlock, rax, numOfRegsToPop << 3);
-	movReg64Immi64(binBlock, rsi, (uint64)memManager.stackSpace);
-	movReg32MReg32(binBlock, eax, rax);
+	subMRegDisp32Immi32(binBlock, CONTEXT_REGISTER, getContextOffset(&sP), numOfRegsToPop << 3);
+	putStackAddress(binBlock, rsi);
+	movReg32MRegDisp(binBlock, eax, CONTEXT_REGISTER, getContextOffset(&sP));
 	addReg64Reg64(binBlock, rsi, rax);
-	movReg64Immi64(binBlock, rdi, destinationAddr);
+	putContextAddress(binBlock, rdi, destinationAddr);
 	movReg32Immi32(binBlock, ecx, numOfRegsToPop);
 	repMovs64(binBlock);
 }
@@ -2521,16 +3295,15 @@ void X86DynaRecCore::FPUSHES_FR_FR(X86BinBlock *binBlock) {
 	int fRegIndex1 = memManager.codeSpace[pC];
 	int fRegIndex2 = memManager.codeSpace[pC + 1];
 	int numOfRegsToPush = fRegIndex2 - fRegIndex1 + 1;
-	uint64 sourceAddr = (uint64)fRegs + (fRegIndex1 << 2);
+	float32 *sourceAddr = &fRegs[fRegIndex1];
 
-	movReg64Immi64(binBlock, rax, (uint64)&sP);
-	movReg64Immi64(binBlock, rsi, sourceAddr);
-	movReg64Immi64(binBlock, rdi, (uint64)memManager.stackSpace);
-	movReg32MReg32(binBlock, ecx, rax);
+	putContextAddress(binBlock, rsi, sourceAddr);
+	putStackAddress(binBlock, rdi);
+	movReg32MRegDisp(binBlock, ecx, CONTEXT_REGISTER, getContextOffset(&sP));
 	addReg64Reg64(binBlock, rdi, rcx);
 	movReg32Immi32(binBlock, ecx, numOfRegsToPush);
 	repMovs32(binBlock);
-	addMReg32Immi32(binBlock, rax, numOfRegsToPush << 2);
+	addMRegDisp32Immi32(binBlock, CONTEXT_REGISTER, getContextOffset(&sP), numOfRegsToPush << 2);
 }
 
 void X86DynaRecCore::FPOPS_FR_FR(X86BinBlock *binBlock) {
@@ -2538,213 +3311,207 @@ void X86DynaRecCore::FPOPS_FR_FR(X86BinBlock *binBlock) {
 	int fRegIndex2 = memManager.codeSpace[pC + 1];
 	
 	int numOfRegsToPop = fRegIndex2 - fRegIndex1 + 1;
-	uint64 destinationAddr = (uint64)fRegs + (fRegIndex1 << 2);
+	float32 *destinationAddr = &fRegs[fRegIndex1];
 
-	movReg64Immi64(binBlock, rax, (uint64)&sP);
-	subMReg32Immi32(binBlock, rax, numOfRegsToPop << 2);
-	movReg64Immi64(binBlock, rsi, (uint64)memManager.stackSpace);
-	movReg32MReg32(binBlock, eax, rax);
+	subMRegDisp32Immi32(binBlock, CONTEXT_REGISTER, getContextOffset(&sP), numOfRegsToPop << 2);
+	putStackAddress(binBlock, rsi);
+	movReg32MRegDisp(binBlock, eax, CONTEXT_REGISTER, getContextOffset(&sP));
 	addReg64Reg64(binBlock, rsi, rax);
-	movReg64Immi64(binBlock, rdi, destinationAddr);
+	putContextAddress(binBlock, rdi, destinationAddr);
 	movReg32Immi32(binBlock, ecx, numOfRegsToPop);
 	repMovs32(binBlock);
 }
 
 void X86DynaRecCore::FPUSH_FR(X86BinBlock *binBlock) {
-	uint64 fRegAddr = (uint64)fRegs + (memManager.codeSpace[pC] << 2);
-	uint64 stackAddr = (uint64)memManager.stackSpace;
-	uint64 stackPointerAddr = (uint64)&sP;
+	uint8 fReg = memManager.codeSpace[pC];
+	int64 *stackPointerAddr = &sP;
 
-	movEAX_MOffset(binBlock, fRegAddr);	//mov rax, (fRegAddr)
-	movReg64Immi64(binBlock, rdx, stackAddr);	//mov rdx, stackAddr
-	movReg64Immi64(binBlock, rcx, stackPointerAddr);	//mov rcx, stackPointerAddr
-	movReg32MReg32(binBlock, ebx, rcx);	//mov ebx, (rcx)
-	movMReg32Reg32(binBlock, 0, ebx, rdx, eax);	//mov (rdx + ebx), eax
-	addMReg32Immi8(binBlock, rcx, 4);	//add (rcx), 4
+	movReg32MRegDisp(binBlock, edx, CONTEXT_REGISTER, getContextOffset(stackPointerAddr));	//mov edx, (stackPointerAddr)
+	putStackAddress(binBlock, rax);	//mov rax, stackAddr
+	addReg64Reg64(binBlock, rdx, rax);	//add rdx, rax
+	X86_64Register src = regAllocator.useFReg(binBlock, fReg, xmm0);	//movss xmm0, fReg
+	movssMReg32XMM(binBlock, rdx, src);	//movss (rdx), xmm0
+	addMRegDisp32Immi8(binBlock, CONTEXT_REGISTER, getContextOffset(stackPointerAddr), 4);	//add (stackPointerAddr), 4
 }
 
 void X86DynaRecCore::FPOP_FR(X86BinBlock *binBlock) {
-	uint64 fRegAddr = (uint64)fRegs + (memManager.codeSpace[pC] << 2);
-	uint64 stackAddr = (uint64)memManager.stackSpace;
-	uint64 stackPointerAddr = (uint64)&sP;
+	uint8 fReg = memManager.codeSpace[pC];
+	int64 *stackPointerAddr = &sP;
 
-	movReg64Immi64(binBlock, rdx, stackAddr);	//mov rdx, stackAddr
-	movReg64Immi64(binBlock, rcx, stackPointerAddr);	//mov rcx, stackPointerAddr
-	subMReg32Immi8(binBlock, rcx, 4);	//sub (rcx), 4
-	movReg32MReg32(binBlock, ebx, rcx);	//mov ebx, (rcx)
-	movReg32MReg32(binBlock, eax, 0, ebx, rdx);	//mov eax, (rdx + ebx)
-	movMOffsetEAX(binBlock, fRegAddr);	//mov (fRegAddr), rax
+	subMRegDisp32Immi8(binBlock, CONTEXT_REGISTER, getContextOffset(stackPointerAddr), 4);	//sub (stackPointerAddr), 4
+	movReg32MRegDisp(binBlock, edx, CONTEXT_REGISTER, getContextOffset(stackPointerAddr));	//mov edx, (stackPointerAddr)
+	putStackAddress(binBlock, rax);	//mov rax, stackAddr
+	addReg64Reg64(binBlock, rdx, rax);	//add rdx, rax
+	X86_64Register dst = regAllocator.getFReg(fReg, xmm0);
+	movssXMM_MReg32(binBlock, dst, rdx);	//movss xmm0, (rdx)
+	regAllocator.storeFReg(binBlock, fReg, dst);	//movss fReg, xmm0
 }
 
-void X86DynaRecCore::CMPE_R_IMMI(X86BinBlock *binBlock) {
-	uint64 regAddr = (uint64)regs + (memManager.codeSpace[pC] << 3);
-	uint32 immiValue = *(uint32*)&memManager.codeSpace[pC + 1];
+void X86DynaRecCore::TIME(X86BinBlock *binBlock) {
+	uint64 (*timerPtr)(DespairTimer*) = timer.getMilliseconds;
+	X86HostCall hostCall(binBlock);
 
-	movReg64Immi64(binBlock, rax, regAddr);
-	cmpMReg32Immi32(binBlock, rax, immiValue);
-	jeRel32(binBlock, movMReg64Immi32(0, rax, 0) + jmpRel32(0, 0));
-	movMReg64Immi32(binBlock, rax, 0);
-	jmpRel32(binBlock, movMReg32Immi32(0, rax, 1));
-	movMReg32Immi32(binBlock, rax, 1);
+	hostCall.argImmi((uint64)&timer);
+	hostCall.call((uint64)timerPtr);
+	movMRegDispReg64(binBlock, CONTEXT_REGISTER, getContextOffset(regs), rax);	//mov (regs), rax
 }
 
-void X86DynaRecCore::CMPNE_R_IMMI(X86BinBlock *binBlock) {
-	uint64 regAddr = (uint64)regs + (memManager.codeSpace[pC] << 3);
-	uint32 immiValue = *(uint32*)&memManager.codeSpace[pC + 1];
+void X86DynaRecCore::SLEEP(X86BinBlock *binBlock) {
+	void (*sleepPtr)(uint32) = DespairTimer::sleep;
+	X86HostCall hostCall(binBlock);
 
-	movReg64Immi64(binBlock, rax, regAddr);
-	cmpMReg32Immi32(binBlock, rax, immiValue);
-	jeRel32(binBlock, movMReg64Immi32(0, rax, 0) + jmpRel32(0, 0));
-	movMReg64Immi32(binBlock, rax, 1);
-	jmpRel32(binBlock, movMReg32Immi32(0, rax, 1));
-	movMReg32Immi32(binBlock, rax, 0);
+	hostCall.argImmi(1);
+	hostCall.call((uint64)sleepPtr);
 }
 
-void X86DynaRecCore::CMPG_R_IMMI(X86BinBlock *binBlock) {
-	uint64 regAddr = (uint64)regs + (memManager.codeSpace[pC] << 3);
-	uint32 immiValue = *(uint32*)&memManager.codeSpace[pC + 1];
-
-	movReg64Immi64(binBlock, rax, regAddr);
-	cmpMReg32Immi32(binBlock, rax, immiValue);
-	jgRel32(binBlock, movMReg64Immi32(0, rax, 0) + jmpRel32(0, 0));
-	movMReg64Immi32(binBlock, rax, 0);
-	jmpRel32(binBlock, movMReg32Immi32(0, rax, 1));
-	movMReg32Immi32(binBlock, rax, 1);
+void X86DynaRecCore::RAND(X86BinBlock *binBlock) {
+	int (*randPtr)() = rand;
+	int64 *regAddr0 = &regs[0];
+	X86HostCall hostCall(binBlock);
+
+	hostCall.call((uint64)randPtr);
+	movContextRAX(binBlock, regAddr0);	//mov (regAddr0), rax
 }
 
-void X86DynaRecCore::CMPGE_R_IMMI(X86BinBlock *binBlock) {
-	uint64 regAddr = (uint64)regs + (memManager.codeSpace[pC] << 3);
-	uint32 immiValue = *(uint32*)&memManager.codeSpace[pC + 1];
 
-	movReg64Immi64(binBlock, rax, regAddr);
-	cmpMReg32Immi32(binBlock, rax, immiValue);
-	jgeRel32(binBlock, movMReg64Immi32(0, rax, 0) + jmpRel32(0, 0));
-	movMReg64Immi32(binBlock, rax, 0);
-	jmpRel32(binBlock, movMReg32Immi32(0, rax, 1));
-	movMReg32Immi32(binBlock, rax, 1);
+void X86DynaRecCore::JMP_IMMI(X86BinBlock *binBlock) {
+	int64 targetAddress = *(uint32*)&memManager.codeSpace[pC];
+	pC += 4;
+
+	putBlockExit(binBlock, targetAddress);
 }
 
-void X86DynaRecCore::CMPL_R_IMMI(X86BinBlock *binBlock) {
-	uint64 regAddr = (uint64)regs + (memManager.codeSpace[pC] << 3);
-	uint32 immiValue = *(uint32*)&memManager.codeSpace[pC + 1];
+void X86DynaRecCore::JMPR_IMMI(X86BinBlock *binBlock) {
+	int64 targetAddress = pC + *(int32*)&memManager.codeSpace[pC] + 4;
+	pC += 4;
 
-	movReg64Immi64(binBlock, rax, regAddr);
-	cmpMReg32Immi32(binBlock, rax, immiValue);
-	jlRel32(binBlock, movMReg64Immi32(0, rax, 0) + jmpRel32(0, 0));
-	movMReg64Immi32(binBlock, rax, 0);
-	jmpRel32(binBlock, movMReg32Immi32(0, rax, 1));
-	movMReg32Immi32(binBlock, rax, 1);
+	putBlockExit(binBlock, targetAddress);
 }
 
-void X86DynaRecCore::CMPLE_R_IMMI(X86BinBlock *binBlock) {
-	uint64 regAddr = (uint64)regs + (memManager.codeSpace[pC] << 3);
-	uint32 immiValue = *(uint32*)&memManager.codeSpace[pC + 1];
+void X86DynaRecCore::JC_R_IMMI(X86BinBlock *binBlock) {
+	int64 *regAddr = &regs[memManager.codeSpace[pC]];
+	int64 targetAddress = *(uint32*)&memManager.codeSpace[pC + 1];
+	pC += 5;
 
-	movReg64Immi64(binBlock, rax, regAddr);
-	cmpMReg32Immi32(binBlock, rax, immiValue);
-	jleRel32(binBlock, movMReg64Immi32(0, rax, 0) + jmpRel32(0, 0));
-	movMReg64Immi32(binBlock, rax, 0);
-	jmpRel32(binBlock, movMReg32Immi32(0, rax, 1));
-	movMReg32Immi32(binBlock, rax, 1);
+	cmpMRegDisp64Immi8(binBlock, CONTEXT_REGISTER, getContextOffset(regAddr), 0);	//cmp (regAddr), 0
+	jneRel32(binBlock, getBlockExitSize(binBlock->getCounter() + jneRel32(0, 0)));	//jne notTaken
+	putBlockExit(binBlock, targetAddress);
+	putBlockExit(binBlock, pC);	//notTaken:
 }
 
-void X86DynaRecCore::TIME(X86BinBlock *binBlock) {
-	uint64 (*timerPtr)(DespairTimer*) = timer.getMilliseconds;
+void X86DynaRecCore::JCR_R_IMMI(X86BinBlock *binBlock) {
+	int64 *regAddr = &regs[memManager.codeSpace[pC]];
+	int64 targetAddress = pC + *(int32*)&memManager.codeSpace[pC + 1] + 5;
+	pC += 5;
 
-	movReg64Immi64(binBlock, rcx, (uint64)&timer);
-	movReg64Immi64(binBlock, rax, (uint64)timerPtr);
-	callReg64(binBlock, rax);
-	movReg64Immi64(binBlock, rcx, (uint64)regs);
-	movMReg64Reg64(binBlock, rcx, rax);
+	cmpMRegDisp64Immi8(binBlock, CONTEXT_REGISTER, getContextOffset(regAddr), 0);	//cmp (regAddr), 0
+	jneRel32(binBlock, getBlockExitSize(binBlock->getCounter() + jneRel32(0, 0)));	//jne notTaken
+	putBlockExit(binBlock, targetAddress);
+	putBlockExit(binBlock, pC);	//notTaken:
 }
 
-void X86DynaRecCore::SLEEP(X86BinBlock *binBlock) {
-#ifdef BUILD_FOR_WINDOWS
-	void (_stdcall *sleepPtr)(DWORD) = Sleep;
+void X86DynaRecCore::CALL_IMMI(X86BinBlock *binBlock) {
+	int64 *stackPointerAddr = &sP;
+	int64 targetAddress = *(uint32*)&memManager.codeSpace[pC];
+	pC += 4;
 
-	movReg64Immi64(binBlock, rcx, 1);
-	movReg64Immi64(binBlock, rax, (uint64)sleepPtr);
-	callReg64(binBlock, rax);
-#endif
-}
+	movRAX_Context(binBlock, stackPointerAddr);	//mov rax, (sP)
+	putStackAddress(binBlock, rcx);	//mov rcx, stackAddr
+	addReg64Reg64(binBlock, rcx, rax);	//add rcx, rax
+	movMReg32Immi32(binBlock, rcx, (uint32)pC);	//mov (rcx), returnAddress
+	addRAX_Immi32(binBlock, 4);	//add rax, 4
+	movContextRAX(binBlock, stackPointerAddr);	//mov (sP), rax
 
-void X86DynaRecCore::RAND(X86BinBlock *binBlock) {
-	int (_cdecl *randPtr)() = rand;
-	uint64 regAddr0 = (uint64)&regs[0];
+	//RET goes straight to the exit after the call while the return address is on the shadow stack
+	movRAX_Context(binBlock, &shadowTop);	//mov rax, (shadowTop)
+	addRAX_Immi32(binBlock, sizeof(X86ShadowReturn));	//add rax, sizeof(X86ShadowReturn)
+	andRAX_Immi32(binBlock, sizeof(shadowStack) - 1);	//and rax, sizeof(shadowStack) - 1
+	movContextRAX(binBlock, &shadowTop);	//mov (shadowTop), rax
+	addReg64Reg64(binBlock, rax, CONTEXT_REGISTER);	//add rax, r15
+	movMRegDisp64Immi32(binBlock, rax, getContextOffset(&shadowStack[0].guestAddress), (uint32)pC);	//mov (rax + guestAddress), returnAddress
+	leaReg64Disp32(binBlock, rcx, 0);	//lea rcx, (rip + return)
+	uint32 returnLeaIndex = binBlock->getCounter();
+	movMRegDispReg64(binBlock, rax, getContextOffset(&shadowStack[0].hostAddress), rcx);	//mov (rax + hostAddress), rcx
+	putBlockExit(binBlock, targetAddress);
 
-	movReg64Immi64(binBlock, rax, (uint64)randPtr);
-	callReg64(binBlock, rax);
-	movMOffsetRAX(binBlock, regAddr0);
+	binBlock->writeAtIndex(binBlock->getCounter() - returnLeaIndex, returnLeaIndex - 4);
+	putBlockExit(binBlock, pC);	//return:
 }
 
+void X86DynaRecCore::RET(X86BinBlock *binBlock) {
+	int64 *stackPointerAddr = &sP;
 
-void X86DynaRecCore::JMP_IMMI() {
-	pC += 2;
-	pC = *(uint32*)&memManager.codeSpace[pC];
-}
-
-void X86DynaRecCore::JMPR_IMMI() {
-	pC += 2;
-	pC += *(int32*)&memManager.codeSpace[pC] + 4;
-}
+	movRAX_Context(binBlock, stackPointerAddr);	//mov rax, (sP)
+	subRAX_Immi32(binBlock, 4);	//sub rax, 4
+	movContextRAX(binBlock, stackPointerAddr);	//mov (sP), rax
+	jlRel32(binBlock, 0);	//jl end
+	uint32 endJumpIndex = binBlock->getCounter();
+	putStackAddress(binBlock, rcx);	//mov rcx, stackAddr
+	addReg64Reg64(binBlock, rcx, rax);	//add rcx, rax
+	movReg32MReg32(binBlock, eax, rcx);	//mov eax, (rcx)
 
-void X86DynaRecCore::JC_R_IMMI() {
-	pC += 2;
-	if (regs[memManager.codeSpace[pC]] == 0) {
-		pC = *(uint32*)&memManager.codeSpace[pC + 1];
-	} else {
-		pC += 5;
-	}
-}
+	//The last call on the shadow stack is popped whether it matches or not, so that the stack stays as
+	//deep as the guest one. A mismatch is looked up.
+	movReg64MRegDisp(binBlock, rcx, CONTEXT_REGISTER, getContextOffset(&shadowTop));	//mov rcx, (shadowTop)
+	leaReg64MRegDisp(binBlock, rdx, rcx, (uint32)-(int32)sizeof(X86ShadowReturn));	//lea rdx, (rcx - sizeof(X86ShadowReturn))
+	andReg32Immi32(binBlock, edx, sizeof(shadowStack) - 1);	//and edx, sizeof(shadowStack) - 1
+	movMRegDispReg64(binBlock, CONTEXT_REGISTER, getContextOffset(&shadowTop), rdx);	//mov (shadowTop), rdx
+	addReg64Reg64(binBlock, rcx, CONTEXT_REGISTER);	//add rcx, r15
+	movReg64MRegDisp(binBlock, rdx, rcx, getContextOffset(&shadowStack[0].guestAddress));	//mov rdx, (rcx + guestAddress)
+	cmpReg64Reg64(binBlock, rdx, rax);	//cmp rdx, rax
+	jneRel32(binBlock, 0);	//jne indirect
+	uint32 mismatchJumpIndex = binBlock->getCounter();
+	movReg64MRegDisp(binBlock, rcx, rcx, getContextOffset(&shadowStack[0].hostAddress));	//mov rcx, (rcx + hostAddress)
+	jmpReg64(binBlock, rcx);	//jmp rcx
 
-void X86DynaRecCore::JCR_R_IMMI() {
-	pC += 2;
-	if (regs[memManager.codeSpace[pC]] == 0) {
-		pC += *(int32*)&memManager.codeSpace[pC + 1] + 5;
-	} else {
-		pC += 5;
-	}
+	binBlock->writeAtIndex(binBlock->getCounter() - endJumpIndex, endJumpIndex - 4);
+	movReg64Immi64(binBlock, rax, (uint64)-1);	//end: mov rax, -1
+	binBlock->writeAtIndex(binBlock->getCounter() - mismatchJumpIndex, mismatchJumpIndex - 4);
+	putIndirectBlockExit(binBlock);	//indirect:
 }
 
-void X86DynaRecCore::CALL_IMMI() {
-	*(uint32*)&memManager.stackSpace[sP] = pC + 6;
-	sP += 4;
-	pC = *(uint32*)&memManager.codeSpace[pC + 2];
-}
+void X86DynaRecCore::JMP_R(X86BinBlock *binBlock) {
+	int64 *regAddr = &regs[memManager.codeSpace[pC]];
+	++pC;
 
-void X86DynaRecCore::RET() {
-	sP -= 4;
-	if (sP < 0) {
-		pC = -1;
-	} else {
-		pC = *(uint32*)&memManager.stackSpace[sP];
-	}
+	movRAX_Context(binBlock, regAddr);	//mov rax, (regAddr)
+	putInlineCache(binBlock);
 }
 
-void X86DynaRecCore::JMP_R() {
+void X86DynaRecCore::JMPR_R(X86BinBlock *binBlock) {
+	int64 *regAddr = &regs[memManager.codeSpace[pC]];
+	++pC;
+
+	movRAX_Context(binBlock, regAddr);	//mov rax, (regAddr)
+	addRAX_Immi32(binBlock, (uint32)pC);	//add rax, nextAddress
+	putInlineCache(binBlock);
+}
+
+void X86DynaRecCore::JC_R_R(X86BinBlock *binBlock) {
+	int64 *regAddr1 = &regs[memManager.codeSpace[pC]];
+	int64 *regAddr2 = &regs[memManager.codeSpace[pC + 1]];
 	pC += 2;
-	pC = regs[memManager.codeSpace[pC]];
-}
 
-void X86DynaRecCore::JMPR_R() {
-	pC += 2;
-	pC += regs[memManager.codeSpace[pC]] + 1;
+	cmpMRegDisp64Immi8(binBlock, CONTEXT_REGISTER, getContextOffset(regAddr1), 0);	//cmp (regAddr1), 0
+	jneRel32(binBlock, 0);	//jne notTaken
+	uint32 notTakenJumpIndex = binBlock->getCounter();
+	movRAX_Context(binBlock, regAddr2);	//mov rax, (regAddr2)
+	putInlineCache(binBlock);
+	binBlock->writeAtIndex(binBlock->getCounter() - notTakenJumpIndex, notTakenJumpIndex - 4);
+	putBlockExit(binBlock, pC);	//notTaken:
 }
 
-void X86DynaRecCore::JC_R_R() {
+void X86DynaRecCore::JCR_R_R(X86BinBlock *binBlock) {
+	int64 *regAddr1 = &regs[memManager.codeSpace[pC]];
+	int64 *regAddr2 = &regs[memManager.codeSpace[pC + 1]];
 	pC += 2;
-	if (regs[memManager.codeSpace[pC]] == 0) {
-		pC = regs[memManager.codeSpace[pC + 1]];
-	} else {
-		pC += 2;
-	}
-}
 
-void X86DynaRecCore::JCR_R_R() {
-	pC += 2;
-	if (regs[memManager.codeSpace[pC]] == 0) {
-		pC += regs[memManager.codeSpace[pC + 1]] + 2;
-	} else {
-		pC += 2;
-	}
+	cmpMRegDisp64Immi8(binBlock, CONTEXT_REGISTER, getContextOffset(regAddr1), 0);	//cmp (regAddr1), 0
+	jneRel32(binBlock, 0);	//jne notTaken
+	uint32 notTakenJumpIndex = binBlock->getCounter();
+	movRAX_Context(binBlock, regAddr2);	//mov rax, (regAddr2)
+	addRAX_Immi32(binBlock, (uint32)pC);	//add rax, nextAddress
+	putInlineCache(binBlock);
+	binBlock->writeAtIndex(binBlock->getCounter() - notTakenJumpIndex, notTakenJumpIndex - 4);
+	putBlockExit(binBlock, pC);	//notTaken:
 }
\ No newline at end of file
@@ -11,18 +11,26 @@
 #define X86_DYNAMIC_RECOMPILER_H
 
 #include <vector>
-#include <map>
 #include <string>
+#include <set>
+#include <atomic>
 #include "build.h"
 #include "declarations.h"
 #include "x86BinBlock.h"
+#include "x86CodeCache.h"
 #include "memoryManager.h"
 #include "timer.h"
 #include "gpuCore.h"
 #include "portManager.h"
 #include "despairHeader.h"
-
-typedef std::map<int64, X86BinBlock*> X86BinBlockCache;
+#include "x86RegAllocator.h"
+#include "irBlock.h"
+#include "interpreterCore.h"
+#include "x86TranslationCache.h"
+#include "x86TranslationWorklist.h"
+#include "x86CompileQueue.h"
+#include "x86SharedTranslation.h"
+#include "x86BlockProfiler.h"
 
 struct ImmediateFloat {
 	float32 value;
@@ -34,6 +42,23 @@ struct ImmediateFloat {
 	}
 };
 
+//Conditional branch in the middle of a trace that leaves it. The code that writes the registers back
+//and exits is put after the trace, so the hot path falls through.
+struct TraceSideExit {
+	uint32 jumpIndex;	//Index right after the jcc that leads to the side exit
+	int64 targetAddress;
+	X86RegAllocatorState regAllocatorState;
+};
+
+#define SHADOW_STACK_SIZE			64	//Calls RET can return from without a lookup, older ones are overwritten
+
+//Where the code of a CALL continues, RET jumps straight there if it returns to guestAddress. hostAddress
+//is in the block of the call, so the stack is cleared whenever blocks are retired.
+struct X86ShadowReturn {
+	int64 guestAddress;
+	uint64 hostAddress;
+};
+
 class X86DynaRecCore {
 private:
 	int64 pC;
@@ -44,72 +69,92 @@ private:
 	static DespairTimer timer;
 	GPUCore *gpuCore;
 	PortManager portManager;
-	X86BinBlockCache x86BinBlockCache;
+	X86CodeCache *codeCache;	//Shared by every core of the program, unless the core was made without sharedTranslation
+	bool ownsCodeCache;
+	X86CodeCacheUser cacheUser;
 	std::vector<ImmediateFloat> *immediateFloat;
+	X86RegAllocator regAllocator;
+	InterpreterCore interpreterCore;	//Runs blocks until they are hot enough to translate
+	static uint32 jitThreshold;
+	static X86BlockProfiler *profiler;	//0 unless blocks are profiled
+	static std::atomic<uint64> translatedBlocks, translationTime;	//By every core, the time in nanoseconds
+	uint64 profileCycles;	//Cycle counter when profileBlock was entered
+	X86BlockProfile *profileBlock;	//Profile the cycles since profileCycles go to
+	X86ShadowReturn shadowStack[SHADOW_STACK_SIZE];
+	uint64 shadowTop;	//Offset of the last call in shadowStack, wraps around
+	uint64 shadowRetirements;	//Retirements of codeCache the shadow stack was cleared after
+	X86TranslationCache translationCache;
+	X86CompileQueue *compileQueue;	//0 if blocks are translated on this thread
+	X86CompileClient *compileClient;
+	std::set<int64> compilingBlocks, compilingTraces;	//Start addresses of the requests compileQueue has not answered yet
 	
-	void putDrawOpcode(X86BinBlock *binBlock, uint64 xAddr, uint64 yAddr, uint64 imgAddr);
+	void initializeTranslationCache(DespairHeader::ExecutableHeader *header);
+	bool loadTranslationImage(const std::vector<uint8> &image);
+	void translateWorklist(X86TranslationWorklist *worklist);
+	void translateCompileRequests(X86CompileQueue *compileQueue);
+	bool requestBlock(int64 address);
+	void requestTrace(X86BinBlock *head);
+	void installCompiledBlocks(X86BinBlockExit **lastExit);
+	uint32 getContextOffset(const void *address);
+	int putContextAddress(X86BinBlock *binBlock, X86_64Register reg, const void *address);
+	int movRAX_Context(X86BinBlock *binBlock, const void *address);
+	int movEAX_Context(X86BinBlock *binBlock, const void *address);
+	int movContextRAX(X86BinBlock *binBlock, const void *address);
+	int movContextEAX(X86BinBlock *binBlock, const void *address);
+	int putStackAddress(X86BinBlock *binBlock, X86_64Register reg);
+	void putDrawOpcode(X86BinBlock *binBlock, const void *xAddr, const void *yAddr, const void *imgAddr);
 	static void draw(int x, int y, uint64 address, X86DynaRecCore *dynarecCore);
+	//Load and store of size bytes, for the ports isDirectPortAccess accepts
+	void putPortLoad(X86BinBlock *binBlock, X86_64Register reg, uint32 port, int size);
+	void putPortStore(X86BinBlock *binBlock, uint32 port, X86_64Register reg, int size);
 	
-	void createNewBinBlock();
-	void executeBlock(X86BinBlock *binBlock);
+	void createDispatcherBlock();
+	X86BinBlock *createNewBinBlock();
+	X86BinBlock *createTrace(X86BinBlock *head);
+	void selectTracePath(int64 headAddress, std::vector<int64> *path, bool *closesLoop);
+	int64 getHotSuccessor(X86BinBlock *binBlock);
+	X86BinBlock *translateBlocks(const std::vector<int64> &path, bool closesLoop);
+	void putTraceBranch(X86BinBlock *binBlock, const IRInstruction &instruction, const IRInstruction *fusedCompare, int64 nextAddress, int64 loopIndex, std::vector<TraceSideExit> *sideExits);
+	void putTraceSideExits(X86BinBlock *binBlock, const std::vector<TraceSideExit> &sideExits);
+	void allocateRegisters(const IRBlock &irBlock);
+	void countRegisterOperands(uint16 opcode, int64 address);
+	int translateInstruction(X86BinBlock *binBlock);
+	void lowerIRInstruction(X86BinBlock *binBlock, const IRInstruction &instruction);
+	X86_64Register useIRSource(X86BinBlock *binBlock, const IRInstruction &instruction, X86_64Register scratch);
+	void putConstantDivision(X86BinBlock *binBlock, const IRInstruction &instruction);
+	void reloadWrittenRegisters(X86BinBlock *binBlock, uint16 opcode, int64 address);
+	void clearShadowStack();
+	X86BinBlockExit *executeBlock(X86BinBlock *binBlock);
+	void putBlockExit(X86BinBlock *binBlock, int64 targetAddress);
+	int putIndirectBlockExit(X86BinBlock *binBlock);
+	void putInlineCache(X86BinBlock *binBlock);
+	void putBlockExitTails(X86BinBlock *binBlock);
 	void putImmediateFloats(X86BinBlock *binBlock);
-	void makeShadowSpace(X86BinBlock *binBlock);
+	void putProfileCounters(X86BinBlock *binBlock, X86BlockProfile *profile, uint32 instructionCount);
+	void putCompare(X86BinBlock *binBlock, const IRInstruction &instruction, bool setResult);
+	bool isFusableCompare(const IRBlock &irBlock, size_t compareIndex, size_t branchIndex);
+	bool isDeadAfterBranch(const IRInstruction &branch, uint8 reg);
+	void putCompareBranch(X86BinBlock *binBlock, const IRInstruction &instruction, IROpcode compare);
+	void putSetCondition(X86BinBlock *binBlock, int (*jccRel32)(X86BinBlock*, uint32), X86_64Register reg);
 	int fdCycle(X86BinBlock *binBlock);
 
 	void MOV_R_MR_IMMI(X86BinBlock *binBlock);
 	void MOV_MR_IMMI_R(X86BinBlock *binBlock);
 	void MOV_MR_IMMI_MR_IMMI(X86BinBlock *binBlock);
 	void MOV_MR_IMMI_IMMI(X86BinBlock *binBlock);
-	void MOV_R_M(X86BinBlock *binBlock);
-	void MOV_M_R(X86BinBlock *binBlock);
-	void MOV_R_R(X86BinBlock *binBlock);
 	void MOV_M_M(X86BinBlock *binBlock);
 	void MOV_MR_R(X86BinBlock *binBlock);
 	void MOV_R_MR(X86BinBlock *binBlock);
 	void MOV_MR_M(X86BinBlock *binBlock);
 	void MOV_M_MR(X86BinBlock *binBlock);
 	void MOV_MR_MR(X86BinBlock *binBlock);
-	void MOV_R_IMMI(X86BinBlock *binBlock);
-	void MOV_M_IMMI(X86BinBlock *binBlock);
 	void MOV_MR_IMMI(X86BinBlock *binBlock);
 
-	void ADD_R_R(X86BinBlock *binBlock);
-	void ADD_R_IMMI(X86BinBlock *binBlock);
-	
-	void SUB_R_R(X86BinBlock *binBlock);
-	void SUB_R_IMMI(X86BinBlock *binBlock);
-	
-	void MUL_R_R(X86BinBlock *binBlock);
-	void MUL_R_IMMI(X86BinBlock *binBlock);
-	
-	void DIV_R_R(X86BinBlock *binBlock);
-	void DIV_R_IMMI(X86BinBlock *binBlock);
-	
-	void MOD_R_R(X86BinBlock *binBlock);
-	void MOD_R_IMMI(X86BinBlock *binBlock);
-	
-	void AND_R_R(X86BinBlock *binBlock);
-	void AND_R_IMMI(X86BinBlock *binBlock);
-	
-	void OR_R_R(X86BinBlock *binBlock);
-	void OR_R_IMMI(X86BinBlock *binBlock);
-	
-	void XOR_R_R(X86BinBlock *binBlock);
-	void XOR_R_IMMI(X86BinBlock *binBlock);
-	
-	void SHL_R_IMMI8(X86BinBlock *binBlock);
-	void SHL_R_R(X86BinBlock *binBlock);
-	
-	void SHR_R_IMMI8(X86BinBlock *binBlock);
-	void SHR_R_R(X86BinBlock *binBlock);
-	
 	void NOP(X86BinBlock *binBlock);
 	
 	void MOVP_R_MR_IMMI(X86BinBlock *binBlock);
 	void MOVP_MR_IMMI_R(X86BinBlock *binBlock);
 	void MOVP_MR_IMMI_MR_IMMI(X86BinBlock *binBlock);
-	void MOVP_R_M(X86BinBlock *binBlock);
-	void MOVP_M_R(X86BinBlock *binBlock);
 	void MOVP_R_MR(X86BinBlock *binBlock);
 	void MOVP_MR_R(X86BinBlock *binBlock);
 
@@ -209,12 +254,6 @@ private:
 	void BMOV_MBR_IMMI8(X86BinBlock *binBlock);
 	void BMOV_BM_IMMI8(X86BinBlock *binBlock);
 
-	void CMPE_R_R(X86BinBlock *binBlock);
-	void CMPNE_R_R(X86BinBlock *binBlock);
-	void CMPG_R_R(X86BinBlock *binBlock);
-	void CMPL_R_R(X86BinBlock *binBlock);
-	void CMPGE_R_R(X86BinBlock *binBlock);
-	void CMPLE_R_R(X86BinBlock *binBlock);
 	void FCMPE_R_FR_FR(X86BinBlock *binBlock);
 	void FCMPNE_R_FR_FR(X86BinBlock *binBlock);
 	void FCMPG_R_FR_FR(X86BinBlock *binBlock);
@@ -234,35 +273,54 @@ private:
 	void FPUSH_FR(X86BinBlock *binBlock);
 	void FPOP_FR(X86BinBlock *binBlock);
 
-	void CMPE_R_IMMI(X86BinBlock *binBlock);
-	void CMPNE_R_IMMI(X86BinBlock *binBlock);
-	void CMPG_R_IMMI(X86BinBlock *binBlock);
-	void CMPGE_R_IMMI(X86BinBlock *binBlock);
-	void CMPL_R_IMMI(X86BinBlock *binBlock);
-	void CMPLE_R_IMMI(X86BinBlock *binBlock);
-
 	void TIME(X86BinBlock *binBlock);
 	void SLEEP(X86BinBlock *binBlock);
 
 	void RAND(X86BinBlock *binBlock);
 
-	//These instructions are interpreted
-	void JMP_IMMI();
-	void JMPR_IMMI();
-	void JC_R_IMMI();
-	void JCR_R_IMMI();
-	void CALL_IMMI();
-	void RET();
-	void JMP_R();
-	void JMPR_R();
-	void JC_R_R();
-	void JCR_R_R();
+	//These instructions end a block with direct exits
+	void JMP_IMMI(X86BinBlock *binBlock);
+	void JMPR_IMMI(X86BinBlock *binBlock);
+	void JC_R_IMMI(X86BinBlock *binBlock);
+	void JCR_R_IMMI(X86BinBlock *binBlock);
+	void CALL_IMMI(X86BinBlock *binBlock);
+	void RET(X86BinBlock *binBlock);
+	void JMP_R(X86BinBlock *binBlock);
+	void JMPR_R(X86BinBlock *binBlock);
+	void JC_R_R(X86BinBlock *binBlock);
+	void JCR_R_R(X86BinBlock *binBlock);
+
+	friend class X86CompileQueue;
 
 public:
-	X86DynaRecCore(uint8 *codePtr, uint8 *globalDataPtr, uint32 codeStartIndex, uint64 paramAddr, GPUCore *gpuCore, DespairHeader::ExecutableHeader *header, KeyboardManager *keyboardManager);
+	//sharedTranslation is used by this core and every thread the program creates, and may be 0
+	X86DynaRecCore(uint8 *codePtr, uint8 *globalDataPtr, uint32 codeStartIndex, uint64 paramAddr, GPUCore *gpuCore, DespairHeader::ExecutableHeader *header, KeyboardManager *keyboardManager,
+					X86SharedTranslation *sharedTranslation);
 	~X86DynaRecCore();
 
 	void startCPULoop();
+	int64 getRegister(uint8 reg);
+
+	//Times a block is interpreted before it is translated, 0 translates every block the first time
+	static void setJITThreshold(uint32 threshold);
+	//Every block translated from now on counts its entries and cycles in profiler, 0 stops it
+	static void setProfiler(X86BlockProfiler *profiler);
+	//Blocks and traces translated by every core so far, ahead of time and in the background included,
+	//and the nanoseconds it took them
+	static uint64 getTranslatedBlockCount();
+	static uint64 getTranslationTime();
+
+	//Puts the blocks saved at path in the block cache, before startCPULoop. Returns false if there is
+	//nothing to load.
+	bool loadTranslationCache(const std::string &path);
+	//Saves the blocks in the block cache if any were translated since they were loaded
+	bool saveTranslationCache(const std::string &path);
+
+	//Translates every block that can be reached from the start of the program with direct jumps, calls
+	//and the threads it creates with constant entry points, using threadCount threads. The blocks are
+	//put in image, which can be given to the constructor of the cores that run the program.
+	static void translateProgram(uint8 *codePtr, uint8 *globalDataPtr, GPUCore *gpuCore, DespairHeader::ExecutableHeader *header, KeyboardManager *keyboardManager,
+									uint32 threadCount, std::vector<uint8> *image);
 };
 
 #endif
\ No newline at end of file
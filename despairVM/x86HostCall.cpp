@@ -0,0 +1,105 @@
+/*
+	Written By Pradipna Nepal
+	www.pradsprojects.com
+
+	Copyright (C) 2013 Pradipna Nepal
+	Please read COPYING.txt included along with this source code for more detail.
+	If not included, see http://www.gnu.org/licenses/
+*/
+
+#include "x86HostCall.h"
+#include "x86RegAllocator.h"
+using namespace X86_64Emitter;
+
+#ifdef HOST_CALL_MICROSOFT_X64
+static const X86_64Register intArgRegs[HOST_CALL_INT_ARGS] = { rcx, rdx, r8, r9 };
+#else
+static const X86_64Register intArgRegs[HOST_CALL_INT_ARGS] = { rdi, rsi, rdx, rcx, r8, r9 };
+#endif
+static const X86_64Register floatArgRegs[HOST_CALL_FLOAT_ARGS] = {
+	xmm0, xmm1, xmm2, xmm3,
+#ifndef HOST_CALL_MICROSOFT_X64
+	xmm4, xmm5, xmm6, xmm7
+#endif
+};
+
+X86HostCall::X86HostCall(X86BinBlock *binBlock) {
+	this->binBlock = binBlock;
+	argCount = 0;
+	intArgCount = 0;
+	floatArgCount = 0;
+}
+
+X86_64Register X86HostCall::nextIntArg() {
+#ifdef HOST_CALL_MICROSOFT_X64
+	int index = argCount;
+#else
+	int index = intArgCount;
+#endif
+	++argCount;
+	++intArgCount;
+	return intArgRegs[index];
+}
+
+X86_64Register X86HostCall::nextFloatArg() {
+#ifdef HOST_CALL_MICROSOFT_X64
+	int index = argCount;
+#else
+	int index = floatArgCount;
+#endif
+	++argCount;
+	++floatArgCount;
+	return floatArgRegs[index];
+}
+
+void X86HostCall::argImmi(uint64 immi) {
+	X86_64Register reg = nextIntArg();
+
+	if (immi <= 0xFFFFFFFF) {
+		movReg32Immi32(binBlock, reg, (uint32)immi);	//mov arg, immi
+	} else {
+		movReg64Immi64(binBlock, reg, immi);	//mov arg, immi
+	}
+}
+
+void X86HostCall::argContextAddress(uint32 offset) {
+	X86_64Register reg = nextIntArg();
+
+	leaReg64MRegDisp(binBlock, reg, CONTEXT_REGISTER, offset);	//lea arg, (context + offset)
+}
+
+void X86HostCall::argContext(uint32 offset, int size) {
+	X86_64Register reg = nextIntArg();
+
+	switch (size) {
+		case 1:
+			movzxReg32MRegDisp8(binBlock, reg, CONTEXT_REGISTER, offset);	//movzx arg, byte (context + offset)
+			break;
+		case 2:
+			movzxReg32MRegDisp16(binBlock, reg, CONTEXT_REGISTER, offset);	//movzx arg, word (context + offset)
+			break;
+		case 4:
+			movReg32MRegDisp(binBlock, reg, CONTEXT_REGISTER, offset);	//mov arg, (context + offset)
+			break;
+		default:
+			movReg64MRegDisp(binBlock, reg, CONTEXT_REGISTER, offset);	//mov arg, (context + offset)
+			break;
+	}
+}
+
+void X86HostCall::argFloatContext(uint32 offset) {
+	X86_64Register xmm = nextFloatArg();
+
+	movssXMM_MRegDisp(binBlock, xmm, CONTEXT_REGISTER, offset);	//movss arg, (context + offset)
+}
+
+void X86HostCall::argIntAsFloatContext(uint32 offset) {
+	X86_64Register xmm = nextFloatArg();
+
+	cvtsi2ssXMM_MRegDisp32(binBlock, xmm, CONTEXT_REGISTER, offset);	//cvtsi2ss arg, (context + offset)
+}
+
+void X86HostCall::call(uint64 function) {
+	movReg64Immi64(binBlock, rax, function);	//mov rax, function
+	callReg64(binBlock, rax);	//call rax
+}
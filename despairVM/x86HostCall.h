@@ -0,0 +1,61 @@
+/*
+	Written By Pradipna Nepal
+	www.pradsprojects.com
+
+	Copyright (C) 2013 Pradipna Nepal
+	Please read COPYING.txt included along with this source code for more detail.
+	If not included, see http://www.gnu.org/licenses/
+*/
+
+#ifndef X86_HOST_CALL_H
+#define X86_HOST_CALL_H
+
+#include "build.h"
+#include "declarations.h"
+#include "x86BinBlock.h"
+#include "x86_64Emitter.h"
+
+//Calling convention of the host, Microsoft x64 on Windows and System V everywhere else
+#ifdef BUILD_FOR_WINDOWS
+#define HOST_CALL_MICROSOFT_X64
+#define HOST_CALL_SHADOW_SPACE		0x20	//Callee may spill its register arguments here
+#define HOST_CALL_INT_ARGS			4
+#define HOST_CALL_FLOAT_ARGS		4
+#else
+#define HOST_CALL_SHADOW_SPACE		0
+#define HOST_CALL_INT_ARGS			6
+#define HOST_CALL_FLOAT_ARGS		8
+#endif
+
+//Emits a call from translated code to a C++ function. Arguments are given from left to right and each
+//one is put in the register the host calling convention assigns to it: in the Microsoft ABI the
+//position of an argument picks both its integer and xmm register, in System V integer and float
+//arguments are numbered separately. Only register arguments are supported.
+//The dispatcher keeps rsp 16 byte aligned inside the blocks with HOST_CALL_SHADOW_SPACE reserved
+//below it, so nothing is pushed around the call. rax is used to load the function.
+class X86HostCall {
+private:
+	X86BinBlock *binBlock;
+	int argCount, intArgCount, floatArgCount;
+
+public:
+	X86HostCall(X86BinBlock *binBlock);
+
+	//Register of the next argument, for arguments the caller loads itself
+	X86_64Register nextIntArg();
+	X86_64Register nextFloatArg();
+
+	void argImmi(uint64 immi);
+	//Arguments that belong to the core are given by their offset from CONTEXT_REGISTER
+	void argContextAddress(uint32 offset);
+	//Zero extended size byte value at offset
+	void argContext(uint32 offset, int size);
+	void argFloatContext(uint32 offset);
+	//32 bit integer at offset converted to float
+	void argIntAsFloatContext(uint32 offset);
+
+	//Result is in rax or xmm0
+	void call(uint64 function);
+};
+
+#endif
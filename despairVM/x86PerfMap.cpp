@@ -0,0 +1,150 @@
+/*
+	Written By Pradipna Nepal
+	www.pradsprojects.com
+
+	Copyright (C) 2013 Pradipna Nepal
+	Please read COPYING.txt included along with this source code for more detail.
+	If not included, see http://www.gnu.org/licenses/
+*/
+
+#include "build.h"
+
+#ifdef BUILD_FOR_UNIX
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <time.h>
+#endif
+
+#include "x86PerfMap.h"
+using namespace std;
+
+//Layout of jitdump files, see tools/perf/Documentation/jitdump-specification.txt in the Linux sources
+#define JITDUMP_MAGIC				0x4A695444
+#define JITDUMP_VERSION				1
+#define JITDUMP_ELF_MACHINE			62	//EM_X86_64
+#define JITDUMP_CODE_LOAD			0
+#define JITDUMP_CODE_CLOSE			3
+
+struct JitdumpHeader {
+	uint32 magic;
+	uint32 version;
+	uint32 totalSize;
+	uint32 elfMachine;
+	uint32 pad;
+	uint32 pid;
+	uint64 timestamp;
+	uint64 flags;
+};
+
+struct JitdumpRecordHeader {
+	uint32 id;
+	uint32 totalSize;
+	uint64 timestamp;
+};
+
+//Followed by the name and the code
+struct JitdumpCodeLoad {
+	JitdumpRecordHeader header;
+	uint32 pid;
+	uint32 tid;
+	uint64 vma;
+	uint64 codeAddress;
+	uint64 codeSize;
+	uint64 codeIndex;
+};
+
+#ifdef BUILD_FOR_UNIX
+//perf record has to be run with -k mono for the timestamps to match its own
+static uint64 getTimestamp() {
+	timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (uint64)now.tv_sec * 1000000000 + now.tv_nsec;
+}
+#endif
+
+X86PerfMap::X86PerfMap(bool jitdump) {
+	mapFile = 0;
+	dumpFile = 0;
+	dumpMapping = 0;
+	codeIndex = 0;
+
+#ifdef BUILD_FOR_UNIX
+	char path[64];
+	sprintf(path, "/tmp/perf-%d.map", (int)getpid());
+	mapFile = fopen(path, "w");
+	if (!jitdump) return;
+
+	sprintf(path, "/tmp/jit-%d.dump", (int)getpid());
+	dumpFile = fopen(path, "w+");
+	if (!dumpFile) return;
+
+	JitdumpHeader header;
+	header.magic = JITDUMP_MAGIC;
+	header.version = JITDUMP_VERSION;
+	header.totalSize = sizeof(header);
+	header.elfMachine = JITDUMP_ELF_MACHINE;
+	header.pad = 0;
+	header.pid = (uint32)getpid();
+	header.timestamp = getTimestamp();
+	header.flags = 0;
+	fwrite(&header, sizeof(header), 1, dumpFile);
+	fflush(dumpFile);
+
+	//perf only looks at files the process mapped executable
+	void *mapping = mmap(0, sysconf(_SC_PAGESIZE), PROT_READ | PROT_EXEC, MAP_PRIVATE, fileno(dumpFile), 0);
+	if (mapping != MAP_FAILED) dumpMapping = mapping;
+#endif
+}
+
+X86PerfMap::~X86PerfMap() {
+	if (mapFile) fclose(mapFile);
+
+#ifdef BUILD_FOR_UNIX
+	if (dumpFile) {
+		JitdumpRecordHeader close;
+		close.id = JITDUMP_CODE_CLOSE;
+		close.totalSize = sizeof(close);
+		close.timestamp = getTimestamp();
+		fwrite(&close, sizeof(close), 1, dumpFile);
+		if (dumpMapping) munmap(dumpMapping, sysconf(_SC_PAGESIZE));
+		fclose(dumpFile);
+	}
+#endif
+}
+
+//Written right away, the process may not get to close the files
+void X86PerfMap::addCode(const uint8 *code, uint32 size, const string &name) {
+	if (mapFile) {
+		fprintf(mapFile, "%llx %x %s\n", (unsigned long long)code, size, name.c_str());
+		fflush(mapFile);
+	}
+	if (dumpFile) writeCodeLoad(code, size, name);
+}
+
+void X86PerfMap::addBlock(X86BinBlock *binBlock) {
+	char name[64];
+	sprintf(name, "despair%s 0x%08llx-0x%08llx", (binBlock->trace) ? " trace" : "", (unsigned long long)binBlock->startAddress,
+			(unsigned long long)binBlock->endAddress);
+	addCode(binBlock->getBinBuffer(), binBlock->getCounter(), name);
+}
+
+void X86PerfMap::writeCodeLoad(const uint8 *code, uint32 size, const string &name) {
+#ifdef BUILD_FOR_UNIX
+	JitdumpCodeLoad record;
+	record.header.id = JITDUMP_CODE_LOAD;
+	record.header.totalSize = (uint32)(sizeof(record) + name.size() + 1 + size);
+	record.header.timestamp = getTimestamp();
+	record.pid = (uint32)getpid();
+	record.tid = (uint32)syscall(SYS_gettid);
+	record.vma = (uint64)code;
+	record.codeAddress = (uint64)code;
+	record.codeSize = size;
+	record.codeIndex = codeIndex++;
+
+	fwrite(&record, sizeof(record), 1, dumpFile);
+	fwrite(name.c_str(), 1, name.size() + 1, dumpFile);
+	fwrite(code, 1, size, dumpFile);
+	fflush(dumpFile);
+#endif
+}
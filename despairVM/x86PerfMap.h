@@ -0,0 +1,42 @@
+/*
+	Written By Pradipna Nepal
+	www.pradsprojects.com
+
+	Copyright (C) 2013 Pradipna Nepal
+	Please read COPYING.txt included along with this source code for more detail.
+	If not included, see http://www.gnu.org/licenses/
+*/
+
+#ifndef X86_PERF_MAP_H
+#define X86_PERF_MAP_H
+
+#include <string>
+#include <cstdio>
+#include "build.h"
+#include "declarations.h"
+#include "x86BinBlock.h"
+
+//Tells Linux perf where the translated code is, so samples in it are named after the guest blocks.
+//Every block gets a line in /tmp/perf-<pid>.map, and with jitdump /tmp/jit-<pid>.dump gets the code
+//of the blocks as well, which "perf inject --jit" turns into symbols that can be annotated.
+//Nothing is written on other systems.
+//It is not locked, X86CodeCache serializes the threads that use it.
+class X86PerfMap {
+private:
+	FILE *mapFile;
+	FILE *dumpFile;	//0 unless jitdump is written
+	void *dumpMapping;	//perf finds the jitdump through this mapping of it
+	uint64 codeIndex;
+
+	void writeCodeLoad(const uint8 *code, uint32 size, const std::string &name);
+
+public:
+	X86PerfMap(bool jitdump);
+	~X86PerfMap();
+
+	void addCode(const uint8 *code, uint32 size, const std::string &name);
+	//Named after the guest addresses of the block
+	void addBlock(X86BinBlock *binBlock);
+};
+
+#endif
@@ -0,0 +1,245 @@
+/*
+	Written By Pradipna Nepal
+	www.pradsprojects.com
+
+	Copyright (C) 2013 Pradipna Nepal
+	Please read COPYING.txt included along with this source code for more detail.
+	If not included, see http://www.gnu.org/licenses/
+*/
+
+#include "x86RegAllocator.h"
+using namespace X86_64Emitter;
+
+//Callee saved in both the Microsoft and System V ABI, so they survive helper calls. r15 is the
+//context register.
+const X86_64Register X86RegAllocator::hostRegs[REG_ALLOCATOR_HOST_REGS] = { rbx, rbp, r12, r13, r14 };
+//Callee saved in the Microsoft ABI only, System V callers have to reload them
+const X86_64Register X86RegAllocator::hostFRegs[REG_ALLOCATOR_HOST_FREGS] = { xmm8, xmm9, xmm10, xmm11, xmm12, xmm13, xmm14, xmm15 };
+
+X86RegAllocator::X86RegAllocator(uint32 regsOffset, uint32 fRegsOffset) {
+	this->regsOffset = regsOffset;
+	this->fRegsOffset = fRegsOffset;
+	reset();
+	allocate();
+}
+
+void X86RegAllocator::reset() {
+	for (int i = 0; i < 256; ++i) {
+		regUses[i] = 0;
+		fRegUses[i] = 0;
+		regLiveIn[i] = false;
+		fRegLiveIn[i] = false;
+	}
+}
+
+void X86RegAllocator::countReg(uint8 reg, bool read) {
+	if (regUses[reg]++ == 0) {
+		regLiveIn[reg] = read;
+	}
+}
+
+void X86RegAllocator::countFReg(uint8 fReg, bool read) {
+	if (fRegUses[fReg]++ == 0) {
+		fRegLiveIn[fReg] = read;
+	}
+}
+
+void X86RegAllocator::pickRegisters(const uint32 *uses, int *pinned, int *guest, int count) {
+	for (int i = 0; i < 256; ++i) {
+		pinned[i] = -1;
+	}
+
+	//Most used registers first
+	for (int i = 0; i < count; ++i) {
+		int best = -1;
+
+		for (int j = 0; j < 256; ++j) {
+			if (pinned[j] == -1 && uses[j] >= REG_ALLOCATOR_MIN_USES && (best == -1 || uses[j] > uses[best])) {
+				best = j;
+			}
+		}
+		guest[i] = best;
+		if (best != -1) {
+			pinned[best] = i;
+		}
+	}
+}
+
+void X86RegAllocator::allocate() {
+	pickRegisters(regUses, pinnedReg, guestReg, REG_ALLOCATOR_HOST_REGS);
+	pickRegisters(fRegUses, pinnedFReg, guestFReg, REG_ALLOCATOR_HOST_FREGS);
+
+	for (int i = 0; i < REG_ALLOCATOR_HOST_REGS; ++i) {
+		dirty[i] = false;
+	}
+	for (int i = 0; i < REG_ALLOCATOR_HOST_FREGS; ++i) {
+		fDirty[i] = false;
+	}
+}
+
+uint32 X86RegAllocator::getRegDisp(uint8 reg) {
+	return regsOffset + (reg << 3);
+}
+
+uint32 X86RegAllocator::getFRegDisp(uint8 fReg) {
+	return fRegsOffset + (fReg << 2);
+}
+
+void X86RegAllocator::loadHostReg(X86BinBlock *binBlock, int index) {
+	movReg64MRegDisp(binBlock, hostRegs[index], CONTEXT_REGISTER, getRegDisp(guestReg[index]));	//mov hostReg, (regAddr)
+}
+
+void X86RegAllocator::loadHostFReg(X86BinBlock *binBlock, int index) {
+	movssXMM_MRegDisp(binBlock, hostFRegs[index], CONTEXT_REGISTER, getFRegDisp(guestFReg[index]));	//movss hostFReg, (fRegAddr)
+}
+
+void X86RegAllocator::loadAll(X86BinBlock *binBlock) {
+	//Registers that are written before they are read don't need to be loaded
+	for (int i = 0; i < REG_ALLOCATOR_HOST_REGS; ++i) {
+		if (guestReg[i] != -1 && regLiveIn[guestReg[i]]) {
+			loadHostReg(binBlock, i);
+		}
+	}
+	for (int i = 0; i < REG_ALLOCATOR_HOST_FREGS; ++i) {
+		if (guestFReg[i] != -1 && fRegLiveIn[guestFReg[i]]) {
+			loadHostFReg(binBlock, i);
+		}
+	}
+}
+
+void X86RegAllocator::storeDirty(X86BinBlock *binBlock) {
+	for (int i = 0; i < REG_ALLOCATOR_HOST_REGS; ++i) {
+		if (dirty[i]) {
+			movMRegDispReg64(binBlock, CONTEXT_REGISTER, getRegDisp(guestReg[i]), hostRegs[i]);	//mov (regAddr), hostReg
+			dirty[i] = false;
+		}
+	}
+	for (int i = 0; i < REG_ALLOCATOR_HOST_FREGS; ++i) {
+		if (fDirty[i]) {
+			movssMRegDispXMM(binBlock, CONTEXT_REGISTER, getFRegDisp(guestFReg[i]), hostFRegs[i]);	//movss (fRegAddr), hostFReg
+			fDirty[i] = false;
+		}
+	}
+}
+
+void X86RegAllocator::reload(X86BinBlock *binBlock, uint8 reg) {
+	if (pinnedReg[reg] != -1) {
+		loadHostReg(binBlock, pinnedReg[reg]);
+	}
+}
+
+void X86RegAllocator::reloadF(X86BinBlock *binBlock, uint8 fReg) {
+	if (pinnedFReg[fReg] != -1) {
+		loadHostFReg(binBlock, pinnedFReg[fReg]);
+	}
+}
+
+void X86RegAllocator::reloadAll(X86BinBlock *binBlock) {
+	for (int i = 0; i < REG_ALLOCATOR_HOST_REGS; ++i) {
+		if (guestReg[i] != -1) {
+			loadHostReg(binBlock, i);
+		}
+	}
+	reloadFloats(binBlock);
+}
+
+void X86RegAllocator::reloadFloats(X86BinBlock *binBlock) {
+	for (int i = 0; i < REG_ALLOCATOR_HOST_FREGS; ++i) {
+		if (guestFReg[i] != -1) {
+			loadHostFReg(binBlock, i);
+		}
+	}
+}
+
+void X86RegAllocator::markAllDirty() {
+	for (int i = 0; i < REG_ALLOCATOR_HOST_REGS; ++i) {
+		dirty[i] = (guestReg[i] != -1);
+	}
+	for (int i = 0; i < REG_ALLOCATOR_HOST_FREGS; ++i) {
+		fDirty[i] = (guestFReg[i] != -1);
+	}
+}
+
+void X86RegAllocator::saveState(X86RegAllocatorState *state) {
+	for (int i = 0; i < REG_ALLOCATOR_HOST_REGS; ++i) {
+		state->dirty[i] = dirty[i];
+	}
+	for (int i = 0; i < REG_ALLOCATOR_HOST_FREGS; ++i) {
+		state->fDirty[i] = fDirty[i];
+	}
+}
+
+void X86RegAllocator::restoreState(const X86RegAllocatorState &state) {
+	for (int i = 0; i < REG_ALLOCATOR_HOST_REGS; ++i) {
+		dirty[i] = state.dirty[i];
+	}
+	for (int i = 0; i < REG_ALLOCATOR_HOST_FREGS; ++i) {
+		fDirty[i] = state.fDirty[i];
+	}
+}
+
+X86_64Register X86RegAllocator::getReg(uint8 reg, X86_64Register scratch) {
+	if (pinnedReg[reg] != -1) {
+		return hostRegs[pinnedReg[reg]];
+	}
+	return scratch;
+}
+
+X86_64Register X86RegAllocator::useReg(X86BinBlock *binBlock, uint8 reg, X86_64Register scratch) {
+	if (pinnedReg[reg] != -1) {
+		return hostRegs[pinnedReg[reg]];
+	}
+
+	loadReg(binBlock, scratch, reg);
+	return scratch;
+}
+
+void X86RegAllocator::loadReg(X86BinBlock *binBlock, X86_64Register hostReg, uint8 reg) {
+	if (pinnedReg[reg] != -1) {
+		movReg64Reg64(binBlock, hostReg, hostRegs[pinnedReg[reg]]);	//mov hostReg, pinnedReg
+	} else {
+		movReg64MRegDisp(binBlock, hostReg, CONTEXT_REGISTER, getRegDisp(reg));	//mov hostReg, (regAddr)
+	}
+}
+
+void X86RegAllocator::storeReg(X86BinBlock *binBlock, uint8 reg, X86_64Register hostReg) {
+	if (pinnedReg[reg] != -1) {
+		int index = pinnedReg[reg];
+
+		if (hostRegs[index] != hostReg) {
+			movReg64Reg64(binBlock, hostRegs[index], hostReg);	//mov pinnedReg, hostReg
+		}
+		dirty[index] = true;
+	} else {
+		movMRegDispReg64(binBlock, CONTEXT_REGISTER, getRegDisp(reg), hostReg);	//mov (regAddr), hostReg
+	}
+}
+
+X86_64Register X86RegAllocator::getFReg(uint8 fReg, X86_64Register scratch) {
+	if (pinnedFReg[fReg] != -1) {
+		return hostFRegs[pinnedFReg[fReg]];
+	}
+	return scratch;
+}
+
+X86_64Register X86RegAllocator::useFReg(X86BinBlock *binBlock, uint8 fReg, X86_64Register scratch) {
+	if (pinnedFReg[fReg] != -1) {
+		return hostFRegs[pinnedFReg[fReg]];
+	}
+
+	movssXMM_MRegDisp(binBlock, scratch, CONTEXT_REGISTER, getFRegDisp(fReg));	//movss scratch, (fRegAddr)
+	return scratch;
+}
+
+void X86RegAllocator::storeFReg(X86BinBlock *binBlock, uint8 fReg, X86_64Register xmm) {
+	if (pinnedFReg[fReg] != -1) {
+		int index = pinnedFReg[fReg];
+
+		if (hostFRegs[index] != xmm) {
+			movssXMM_XMM(binBlock, hostFRegs[index], xmm);	//movss pinnedFReg, xmm
+		}
+		fDirty[index] = true;
+	} else {
+		movssMRegDispXMM(binBlock, CONTEXT_REGISTER, getFRegDisp(fReg), xmm);	//movss (fRegAddr), xmm
+	}
+}
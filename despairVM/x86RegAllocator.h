@@ -0,0 +1,89 @@
+/*
+	Written By Pradipna Nepal
+	www.pradsprojects.com
+
+	Copyright (C) 2013 Pradipna Nepal
+	Please read COPYING.txt included along with this source code for more detail.
+	If not included, see http://www.gnu.org/licenses/
+*/
+
+#ifndef X86_REG_ALLOCATOR_H
+#define X86_REG_ALLOCATOR_H
+
+#include "build.h"
+#include "declarations.h"
+#include "x86BinBlock.h"
+#include "x86_64Emitter.h"
+
+#define REG_ALLOCATOR_HOST_REGS			5
+#define REG_ALLOCATOR_HOST_FREGS		8
+#define REG_ALLOCATOR_MIN_USES			2	//Registers used less than this in a block stay in memory
+
+//Holds the X86DynaRecCore that runs the code. Everything that belongs to a core is addressed from it,
+//so the same code runs on every core.
+#define CONTEXT_REGISTER				r15
+//CONTEXT_REGISTER points this far into the core, so that disp8 reaches pC, sP and the first registers
+#define CONTEXT_REGISTER_BIAS			128
+
+//Which host registers hold values that are not in regs/fRegs yet
+struct X86RegAllocatorState {
+	bool dirty[REG_ALLOCATOR_HOST_REGS], fDirty[REG_ALLOCATOR_HOST_FREGS];
+};
+
+//Keeps the most used Despair registers of a block in host registers. Integer registers are pinned to
+//callee saved GPRs and float registers to xmm8 - xmm15, and written back to regs/fRegs only before
+//the block exits or an instruction that does not know about the allocator runs.
+class X86RegAllocator {
+private:
+	uint32 regsOffset, fRegsOffset;	//Where regs/fRegs are from CONTEXT_REGISTER
+	uint32 regUses[256], fRegUses[256];
+	bool regLiveIn[256], fRegLiveIn[256];	//First use in the block reads the value
+	int pinnedReg[256], pinnedFReg[256];	//Index into hostRegs/hostFRegs, -1 if in memory
+	int guestReg[REG_ALLOCATOR_HOST_REGS], guestFReg[REG_ALLOCATOR_HOST_FREGS];
+	bool dirty[REG_ALLOCATOR_HOST_REGS], fDirty[REG_ALLOCATOR_HOST_FREGS];
+
+	uint32 getRegDisp(uint8 reg);
+	uint32 getFRegDisp(uint8 fReg);
+	void pickRegisters(const uint32 *uses, int *pinned, int *guest, int count);
+	void loadHostReg(X86BinBlock *binBlock, int index);
+	void loadHostFReg(X86BinBlock *binBlock, int index);
+
+public:
+	static const X86_64Register hostRegs[REG_ALLOCATOR_HOST_REGS];
+	static const X86_64Register hostFRegs[REG_ALLOCATOR_HOST_FREGS];
+
+	X86RegAllocator(uint32 regsOffset, uint32 fRegsOffset);
+
+	//Counting pass over the instructions of a block, then allocate and load
+	void reset();
+	void countReg(uint8 reg, bool read);
+	void countFReg(uint8 fReg, bool read);
+	void allocate();
+	void loadAll(X86BinBlock *binBlock);
+
+	//Spill before the block exits or calls code that reads regs/fRegs, reload after it changed them
+	void storeDirty(X86BinBlock *binBlock);
+	void reload(X86BinBlock *binBlock, uint8 reg);
+	void reloadF(X86BinBlock *binBlock, uint8 fReg);
+	void reloadAll(X86BinBlock *binBlock);
+	void reloadFloats(X86BinBlock *binBlock);
+	//Code that is jumped to from several places has to assume every pinned register is dirty
+	void markAllDirty();
+	//For code that is put out of line, like the side exits of a trace
+	void saveState(X86RegAllocatorState *state);
+	void restoreState(const X86RegAllocatorState &state);
+
+	//Host register for a value that is about to be written, the scratch register if reg is not pinned
+	X86_64Register getReg(uint8 reg, X86_64Register scratch);
+	//Host register that holds the value of reg, loaded into scratch if it is not pinned
+	X86_64Register useReg(X86BinBlock *binBlock, uint8 reg, X86_64Register scratch);
+	//Copies the value of reg into hostReg
+	void loadReg(X86BinBlock *binBlock, X86_64Register hostReg, uint8 reg);
+	void storeReg(X86BinBlock *binBlock, uint8 reg, X86_64Register hostReg);
+
+	X86_64Register getFReg(uint8 fReg, X86_64Register scratch);
+	X86_64Register useFReg(X86BinBlock *binBlock, uint8 fReg, X86_64Register scratch);
+	void storeFReg(X86BinBlock *binBlock, uint8 fReg, X86_64Register xmm);
+};
+
+#endif
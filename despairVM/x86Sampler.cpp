@@ -0,0 +1,284 @@
+/*
+	Written By Pradipna Nepal
+	www.pradsprojects.com
+
+	Copyright (C) 2013 Pradipna Nepal
+	Please read COPYING.txt included along with this source code for more detail.
+	If not included, see http://www.gnu.org/licenses/
+*/
+
+#include "build.h"
+
+#ifdef BUILD_FOR_UNIX
+#include <sys/time.h>
+#include <ucontext.h>
+#endif
+
+#include <vector>
+#include <chrono>
+#include <cstdio>
+#include "x86Sampler.h"
+using namespace std;
+
+//Fields of profile.proto, see https://github.com/google/pprof/blob/main/proto/profile.proto
+#define PROFILE_SAMPLE_TYPE			1
+#define PROFILE_SAMPLE				2
+#define PROFILE_LOCATION			4
+#define PROFILE_FUNCTION			5
+#define PROFILE_STRING_TABLE		6
+#define PROFILE_TIME_NANOS			9
+#define PROFILE_DURATION_NANOS		10
+#define PROFILE_PERIOD_TYPE			11
+#define PROFILE_PERIOD				12
+#define VALUE_TYPE_TYPE				1
+#define VALUE_TYPE_UNIT				2
+#define SAMPLE_LOCATION_ID			1
+#define SAMPLE_VALUE				2
+#define LOCATION_ID					1
+#define LOCATION_ADDRESS			3
+#define LOCATION_LINE				4
+#define LINE_FUNCTION_ID			1
+#define FUNCTION_ID					1
+#define FUNCTION_NAME				2
+#define FUNCTION_SYSTEM_NAME		3
+
+#define PROTO_VARINT				0
+#define PROTO_BYTES					2
+
+atomic<X86Sampler*> X86Sampler::activeSampler(0);
+
+static void putVarint(vector<uint8> *message, uint64 value) {
+	while (value >= 0x80) {
+		message->push_back((uint8)(value | 0x80));
+		value >>= 7;
+	}
+	message->push_back((uint8)value);
+}
+
+static void putVarintField(vector<uint8> *message, uint32 field, uint64 value) {
+	putVarint(message, (field << 3) | PROTO_VARINT);
+	putVarint(message, value);
+}
+
+static void putBytesField(vector<uint8> *message, uint32 field, const void *data, size_t size) {
+	putVarint(message, (field << 3) | PROTO_BYTES);
+	putVarint(message, size);
+	message->insert(message->end(), (const uint8*)data, (const uint8*)data + size);
+}
+
+static void putMessageField(vector<uint8> *message, uint32 field, const vector<uint8> &embedded) {
+	putBytesField(message, field, embedded.data(), embedded.size());
+}
+
+//Strings of a profile are referred to by their index in its string table, which starts with ""
+struct ProfileStrings {
+	vector<string> strings;
+	map<string, uint64> indices;
+
+	ProfileStrings() {
+		getIndex("");
+	}
+
+	uint64 getIndex(const string &str) {
+		map<string, uint64>::iterator it = indices.find(str);
+		if (it != indices.end()) return it->second;
+
+		indices[str] = strings.size();
+		strings.push_back(str);
+		return strings.size() - 1;
+	}
+};
+
+static void putValueType(vector<uint8> *profile, uint32 field, ProfileStrings *strings, const string &type, const string &unit) {
+	vector<uint8> valueType;
+	putVarintField(&valueType, VALUE_TYPE_TYPE, strings->getIndex(type));
+	putVarintField(&valueType, VALUE_TYPE_UNIT, strings->getIndex(unit));
+	putMessageField(profile, field, valueType);
+}
+
+static void putFunction(vector<uint8> *profile, ProfileStrings *strings, uint64 functionId, const string &name) {
+	vector<uint8> function;
+	putVarintField(&function, FUNCTION_ID, functionId);
+	putVarintField(&function, FUNCTION_NAME, strings->getIndex(name));
+	putVarintField(&function, FUNCTION_SYSTEM_NAME, strings->getIndex(name));
+	putMessageField(profile, PROFILE_FUNCTION, function);
+}
+
+//A location of its own for every sample, with the number of samples and the time they stand for
+static void putSample(vector<uint8> *profile, uint64 locationId, uint64 functionId, uint64 address, uint64 count, uint64 period) {
+	vector<uint8> line, location, sample;
+
+	putVarintField(&line, LINE_FUNCTION_ID, functionId);
+	putVarintField(&location, LOCATION_ID, locationId);
+	putVarintField(&location, LOCATION_ADDRESS, address);
+	putMessageField(&location, LOCATION_LINE, line);
+	putMessageField(profile, PROFILE_LOCATION, location);
+
+	putVarintField(&sample, SAMPLE_LOCATION_ID, locationId);
+	putVarintField(&sample, SAMPLE_VALUE, count);
+	putVarintField(&sample, SAMPLE_VALUE, count * period);
+	putMessageField(profile, PROFILE_SAMPLE, sample);
+}
+
+static uint64 getTimeNanos() {
+	return chrono::duration_cast<chrono::nanoseconds>(chrono::system_clock::now().time_since_epoch()).count();
+}
+
+X86Sampler::X86Sampler(X86CodeCache *codeCache) {
+	this->codeCache = codeCache;
+	for (int i = 0; i < SAMPLER_BUFFER_SIZE; ++i) {
+		hostAddresses[i] = 0;
+	}
+	writeIndex = 0;
+	readIndex = 0;
+	untranslatedSamples = 0;
+	running = false;
+	resolver = 0;
+	startTime = 0;
+	duration = 0;
+}
+
+X86Sampler::~X86Sampler() {
+	stop();
+}
+
+#ifdef BUILD_FOR_UNIX
+//Runs on the interrupted thread, so it only does what is safe in a signal handler
+void X86Sampler::handleSignal(int, siginfo_t *, void *context) {
+	X86Sampler *sampler = activeSampler.load();
+	if (!sampler) return;
+
+	const ucontext_t *interrupted = (const ucontext_t*)context;
+#ifdef __APPLE__
+	uint64 hostAddress = interrupted->uc_mcontext->__ss.__rip;
+#else
+	uint64 hostAddress = interrupted->uc_mcontext.gregs[REG_RIP];
+#endif
+	//If the resolver fell behind by a whole buffer, the oldest sample is lost
+	sampler->hostAddresses[sampler->writeIndex.fetch_add(1) % SAMPLER_BUFFER_SIZE] = hostAddress;
+}
+#endif
+
+bool X86Sampler::start() {
+#ifdef BUILD_FOR_UNIX
+	X86Sampler *expected = 0;
+	if (!activeSampler.compare_exchange_strong(expected, this)) return false;
+
+	struct sigaction action;
+	action.sa_sigaction = handleSignal;
+	sigemptyset(&action.sa_mask);
+	//Interrupted system calls of the program carry on
+	action.sa_flags = SA_SIGINFO | SA_RESTART;
+	if (sigaction(SIGPROF, &action, 0) != 0) {
+		activeSampler = 0;
+		return false;
+	}
+
+	startTime = getTimeNanos();
+	running = true;
+	resolver = new thread(&X86Sampler::resolve, this);
+
+	itimerval timer;
+	timer.it_interval.tv_sec = 0;
+	timer.it_interval.tv_usec = 1000000 / SAMPLER_FREQUENCY;
+	timer.it_value = timer.it_interval;
+	if (setitimer(ITIMER_PROF, &timer, 0) != 0) {
+		stop();
+		return false;
+	}
+
+	return true;
+#else
+	return false;
+#endif
+}
+
+void X86Sampler::stop() {
+	if (!running) return;
+
+#ifdef BUILD_FOR_UNIX
+	itimerval timer = {};
+	setitimer(ITIMER_PROF, &timer, 0);
+	//Ignoring the signal discards one that is still pending, its default action ends the process
+	signal(SIGPROF, SIG_IGN);
+	activeSampler = 0;
+#endif
+	duration = getTimeNanos() - startTime;
+
+	running = false;
+	resolver->join();
+	delete resolver;
+	resolver = 0;
+	resolveSamples();
+}
+
+void X86Sampler::resolve() {
+	while (running) {
+		this_thread::sleep_for(chrono::milliseconds(SAMPLER_RESOLVE_INTERVAL));
+		resolveSamples();
+	}
+}
+
+//Stops at a slot that was taken but not written yet, it is read the next time
+void X86Sampler::resolveSamples() {
+	while (true) {
+		uint64 hostAddress = hostAddresses[readIndex % SAMPLER_BUFFER_SIZE].exchange(0);
+		if (hostAddress == 0) break;
+		++readIndex;
+
+		X86GuestLocation location;
+		bool translated = codeCache->findGuestLocation((const uint8*)hostAddress, &location);
+
+		lock_guard<mutex> guard(lock);
+		if (translated) {
+			++samples[make_pair(make_pair(location.blockAddress, location.trace), location.address)];
+		} else {
+			++untranslatedSamples;
+		}
+	}
+}
+
+bool X86Sampler::saveProfile(const string &path) {
+	ProfileStrings strings;
+	vector<uint8> profile;
+	const uint64 period = 1000000000 / SAMPLER_FREQUENCY;
+
+	putValueType(&profile, PROFILE_SAMPLE_TYPE, &strings, "samples", "count");
+	putValueType(&profile, PROFILE_SAMPLE_TYPE, &strings, "cpu", "nanoseconds");
+	{
+		lock_guard<mutex> guard(lock);
+		map<pair<int64, bool>, uint64> functionIds;
+		uint64 locationId = 0;
+
+		//Ids start at 1, a function is written along with the first sample in it
+		for (SampleMap::const_iterator it = samples.begin(); it != samples.end(); ++it) {
+			uint64 &functionId = functionIds[it->first.first];
+			if (functionId == 0) {
+				char name[64];
+				sprintf(name, "0x%08llx%s", (unsigned long long)it->first.first.first, (it->first.first.second) ? " [trace]" : "");
+				functionId = functionIds.size();
+				putFunction(&profile, &strings, functionId, name);
+			}
+			putSample(&profile, ++locationId, functionId, (uint64)it->first.second, it->second, period);
+		}
+		if (untranslatedSamples) {
+			putFunction(&profile, &strings, functionIds.size() + 1, "untranslated");
+			putSample(&profile, ++locationId, functionIds.size() + 1, 0, untranslatedSamples, period);
+		}
+	}
+	putVarintField(&profile, PROFILE_TIME_NANOS, startTime);
+	putVarintField(&profile, PROFILE_DURATION_NANOS, duration);
+	putValueType(&profile, PROFILE_PERIOD_TYPE, &strings, "cpu", "nanoseconds");
+	putVarintField(&profile, PROFILE_PERIOD, period);
+	//The string table comes last, after every string was added to it
+	for (size_t i = 0; i < strings.strings.size(); ++i) {
+		putBytesField(&profile, PROFILE_STRING_TABLE, strings.strings[i].data(), strings.strings[i].size());
+	}
+
+	FILE *profileFile = fopen(path.c_str(), "wb");
+	if (profileFile == 0) return false;
+
+	bool written = fwrite(profile.data(), 1, profile.size(), profileFile) == profile.size();
+	if (fclose(profileFile) != 0) written = false;
+	return written;
+}
@@ -0,0 +1,72 @@
+/*
+	Written By Pradipna Nepal
+	www.pradsprojects.com
+
+	Copyright (C) 2013 Pradipna Nepal
+	Please read COPYING.txt included along with this source code for more detail.
+	If not included, see http://www.gnu.org/licenses/
+*/
+
+#ifndef X86_SAMPLER_H
+#define X86_SAMPLER_H
+
+#include <map>
+#include <string>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include "build.h"
+#include "declarations.h"
+#include "x86CodeCache.h"
+#ifdef BUILD_FOR_UNIX
+#include <signal.h>
+#endif
+
+#define SAMPLER_FREQUENCY			100	//Samples per second of CPU time the process uses
+#define SAMPLER_BUFFER_SIZE			4096	//Samples taken but not resolved yet
+#define SAMPLER_RESOLVE_INTERVAL	10	//Milliseconds between the resolver emptying the buffer
+
+//Samples where the program spends its time without changing the translated code. SIGPROF interrupts
+//whichever thread is using the CPU, and the handler only puts the host address it was at into a buffer.
+//A resolver thread looks the addresses up in the code cache soon after, while the blocks they are in
+//are still there, and counts them per guest instruction. A block that was deleted and had its code
+//reused in the meantime is counted as the new one, which is rare enough not to matter for sampling.
+//Samples outside translated code (interpreting, translating, the dispatcher and host calls) are
+//counted as untranslated. Only one sampler can run at a time, and nothing is sampled on Windows.
+class X86Sampler {
+private:
+	typedef std::map<std::pair<std::pair<int64, bool>, int64>, uint64> SampleMap;	//((block, trace), guest address)
+
+	X86CodeCache *codeCache;
+	std::atomic<uint64> hostAddresses[SAMPLER_BUFFER_SIZE];	//0 while a slot is empty
+	std::atomic<uint64> writeIndex;
+	uint64 readIndex;
+	std::mutex lock;	//Of the counts
+	SampleMap samples;
+	uint64 untranslatedSamples;
+	std::atomic<bool> running;
+	std::thread *resolver;
+	uint64 startTime;	//Nanoseconds since the epoch
+	uint64 duration;	//Nanoseconds sampled, set by stop
+
+	static std::atomic<X86Sampler*> activeSampler;
+
+#ifdef BUILD_FOR_UNIX
+	static void handleSignal(int signal, siginfo_t *info, void *context);
+#endif
+	void resolve();
+	void resolveSamples();
+
+public:
+	X86Sampler(X86CodeCache *codeCache);
+	~X86Sampler();
+
+	//Returns false if another sampler is running or the timer could not be set
+	bool start();
+	void stop();
+	//Writes the samples in the format pprof reads, as an uncompressed profile.proto. Every guest
+	//instruction is a location of the function named after the block it was sampled in.
+	bool saveProfile(const std::string &path);
+};
+
+#endif
@@ -0,0 +1,33 @@
+/*
+	Written By Pradipna Nepal
+	www.pradsprojects.com
+
+	Copyright (C) 2013 Pradipna Nepal
+	Please read COPYING.txt included along with this source code for more detail.
+	If not included, see http://www.gnu.org/licenses/
+*/
+
+#ifndef X86_SHARED_TRANSLATION_H
+#define X86_SHARED_TRANSLATION_H
+
+#include <vector>
+#include "build.h"
+#include "declarations.h"
+
+class X86CompileQueue;
+class X86CodeCache;
+
+//Translation state of a program that every core running it uses. It is owned by DespairVM and handed
+//to every thread the program creates.
+struct X86SharedTranslation {
+	std::vector<uint8> image;	//Blocks translated ahead of time, loaded by every core
+	X86CompileQueue *compileQueue;	//Translates hot blocks in the background, 0 to translate them on the thread that runs them
+	X86CodeCache *codeCache;	//Blocks every core runs, 0 gives every core a cache of its own
+
+	X86SharedTranslation() {
+		compileQueue = 0;
+		codeCache = 0;
+	}
+};
+
+#endif
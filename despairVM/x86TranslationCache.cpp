@@ -0,0 +1,329 @@
+/*
+	Written By Pradipna Nepal
+	www.pradsprojects.com
+
+	Copyright (C) 2013 Pradipna Nepal
+	Please read COPYING.txt included along with this source code for more detail.
+	If not included, see http://www.gnu.org/licenses/
+*/
+
+#include <cstring>
+#include "x86TranslationCache.h"
+#include "sha256.h"
+using namespace std;
+using namespace SHA256;
+
+struct TranslationCacheHeader {
+	uint32 magic;
+	uint32 version;
+	uint32 codeVersion;
+	uint32 hostFunctionCount;
+	uint64 codeSize;	//Of the guest program
+	uint32 blockCount;
+	uint32 payloadHash[8];	//SHA-256 of everything after the header
+};
+
+//Followed by the exits, the relocations, the guest addresses and the code
+struct TranslationCacheBlock {
+	int64 startAddress, endAddress;
+	uint32 trace;
+	uint32 codeSize;
+	uint32 exitCount;
+	uint32 relocationCount;
+	uint32 guestAddressCount;
+};
+
+struct TranslationCacheExit {
+	int64 targetAddress;
+	uint32 patchIndex;
+	uint32 tailIndex;
+	uint32 compareIndex;	//The rest is 0 unless the exit is an entry of an inline cache
+	uint32 missIndex;
+	uint32 nextTailIndex;
+};
+
+struct TranslationCacheRelocation {
+	uint32 index;	//Of the 64 bit value in the code
+	uint32 base;
+	uint64 offset;
+};
+
+X86TranslationCache::X86TranslationCache(uint32 codeVersion, uint64 codeSize) {
+	this->codeVersion = codeVersion;
+	this->codeSize = codeSize;
+	for (int i = 0; i < RELOCATION_REGION_COUNT; ++i) {
+		regionAddress[i] = 0;
+		regionSize[i] = 0;
+	}
+}
+
+void X86TranslationCache::setRegion(X86RelocationBase base, const void *address, uint64 size) {
+	regionAddress[base] = (uint64)address;
+	regionSize[base] = size;
+}
+
+void X86TranslationCache::addHostFunction(uint64 function) {
+	hostFunctions.push_back(function);
+}
+
+bool X86TranslationCache::findRelocation(X86BinBlock *binBlock, uint64 value, uint32 *base, uint64 *offset) {
+	for (size_t i = 0; i < binBlock->exits.size(); ++i) {
+		if (value == (uint64)binBlock->exits[i]) {
+			*base = RELOCATION_EXIT;
+			*offset = i;
+			return true;
+		}
+	}
+
+	for (size_t i = 0; i < hostFunctions.size(); ++i) {
+		if (value == hostFunctions[i]) {
+			*base = RELOCATION_HOST_FUNCTION;
+			*offset = i;
+			return true;
+		}
+	}
+
+	//The end of a region is included, code may point just past global data
+	for (int i = 0; i < RELOCATION_REGION_COUNT; ++i) {
+		if (regionAddress[i] && value >= regionAddress[i] && value - regionAddress[i] <= regionSize[i]) {
+			*base = i;
+			*offset = value - regionAddress[i];
+			return true;
+		}
+	}
+
+	return false;
+}
+
+static void appendToImage(vector<uint8> *image, const void *data, size_t size) {
+	image->insert(image->end(), (const uint8*)data, (const uint8*)data + size);
+}
+
+//Returns false if the image ends before size bytes
+static bool readFromImage(const vector<uint8> &image, size_t *offset, void *data, size_t size) {
+	if (size > image.size() - *offset) return false;
+	if (size) memcpy(data, &image[*offset], size);
+	*offset += size;
+	return true;
+}
+
+bool X86TranslationCache::load(const vector<uint8> &image, X86CodeArena *codeArena, vector<X86BinBlock*> *binBlocks) {
+	TranslationCacheHeader header;
+	size_t offset = 0;
+
+	if (!readFromImage(image, &offset, &header, sizeof(header)) || header.magic != TRANSLATION_CACHE_MAGIC
+			|| header.version != TRANSLATION_CACHE_VERSION || header.codeVersion != codeVersion || header.codeSize != codeSize
+			|| header.hostFunctionCount != hostFunctions.size() || image.size() - offset > 0xFFFFFFFF) {
+		return false;
+	}
+
+	SHA_256_MessageDigest payloadHash = sha256(image.data() + offset, (uint32)(image.size() - offset));
+	if (memcmp(&payloadHash.h, &header.payloadHash, sizeof(header.payloadHash))) {
+		return false;
+	}
+
+	size_t firstBlock = binBlocks->size();
+	for (uint32 i = 0; i < header.blockCount; ++i) {
+		X86BinBlock *binBlock = loadBinBlock(image, &offset, codeArena);
+
+		if (!binBlock) {
+			for (size_t j = firstBlock; j < binBlocks->size(); ++j) {
+				delete binBlocks->at(j);
+			}
+			binBlocks->resize(firstBlock);
+			return false;
+		}
+		binBlocks->push_back(binBlock);
+	}
+
+	return true;
+}
+
+X86BinBlock *X86TranslationCache::loadBinBlock(const vector<uint8> &image, size_t *offset, X86CodeArena *codeArena) {
+	TranslationCacheBlock block;
+	if (!readFromImage(image, offset, &block, sizeof(block))) return 0;
+	//A trace ends with the last block of its path, which may be before its start
+	if (block.startAddress < 0 || (uint64)block.startAddress >= codeSize || block.endAddress <= 0
+			|| (uint64)block.endAddress > codeSize || block.codeSize == 0 || block.codeSize > CODE_ARENA_SIZE
+			|| block.exitCount > block.codeSize || block.relocationCount > block.codeSize || block.guestAddressCount > block.codeSize) {
+		return 0;
+	}
+
+	vector<TranslationCacheExit> exits(block.exitCount);
+	vector<TranslationCacheRelocation> relocations(block.relocationCount);
+	vector<X86GuestAddress> guestAddresses(block.guestAddressCount);
+	vector<uint8> code(block.codeSize);
+	if (!readFromImage(image, offset, exits.data(), exits.size() * sizeof(TranslationCacheExit))
+			|| !readFromImage(image, offset, relocations.data(), relocations.size() * sizeof(TranslationCacheRelocation))
+			|| !readFromImage(image, offset, guestAddresses.data(), guestAddresses.size() * sizeof(X86GuestAddress))
+			|| !readFromImage(image, offset, code.data(), code.size())) {
+		return 0;
+	}
+
+	X86BinBlock *binBlock = new X86BinBlock;
+	binBlock->startAddress = block.startAddress;
+	binBlock->endAddress = block.endAddress;
+	binBlock->trace = block.trace != 0;
+	binBlock->guestAddresses = guestAddresses;
+	for (uint32 i = 0; i < block.codeSize; ++i) {
+		binBlock->write<uint8>(code[i]);
+	}
+
+	for (uint32 i = 0; i < block.exitCount; ++i) {
+		if ((uint64)exits[i].patchIndex + BLOCK_EXIT_SIZE > block.codeSize || exits[i].tailIndex >= block.codeSize
+				|| (exits[i].compareIndex && ((uint64)exits[i].compareIndex + 4 > block.codeSize
+				|| (uint64)exits[i].missIndex + BLOCK_EXIT_SIZE > block.codeSize || exits[i].nextTailIndex >= block.codeSize))) {
+			delete binBlock;
+			return 0;
+		}
+
+		X86BinBlockExit *blockExit = new X86BinBlockExit(binBlock, exits[i].targetAddress);
+		blockExit->patchIndex = exits[i].patchIndex;
+		blockExit->tailIndex = exits[i].tailIndex;
+		blockExit->compareIndex = exits[i].compareIndex;
+		blockExit->missIndex = exits[i].missIndex;
+		blockExit->nextTailIndex = exits[i].nextTailIndex;
+		binBlock->exits.push_back(blockExit);
+	}
+
+	for (uint32 i = 0; i < block.relocationCount; ++i) {
+		const TranslationCacheRelocation &relocation = relocations[i];
+		uint64 value;
+
+		if ((uint64)relocation.index + 8 > block.codeSize) {
+			delete binBlock;
+			return 0;
+		}
+		if (relocation.base < RELOCATION_REGION_COUNT && relocation.offset <= regionSize[relocation.base]) {
+			value = regionAddress[relocation.base] + relocation.offset;
+		} else if (relocation.base == RELOCATION_HOST_FUNCTION && relocation.offset < hostFunctions.size()) {
+			value = hostFunctions[(size_t)relocation.offset];
+		} else if (relocation.base == RELOCATION_EXIT && relocation.offset < block.exitCount) {
+			value = (uint64)binBlock->exits[(size_t)relocation.offset];
+		} else {
+			delete binBlock;
+			return 0;
+		}
+
+		binBlock->writeAtIndex<uint64>(value, relocation.index);
+		binBlock->immi64Indices.push_back(relocation.index);
+	}
+
+	if (!binBlock->install(codeArena)) {
+		delete binBlock;
+		return 0;
+	}
+
+	return binBlock;
+}
+
+void X86TranslationCache::save(const vector<X86BinBlock*> &binBlocks, vector<uint8> *image) {
+	TranslationCacheHeader header;
+	memset(&header, 0, sizeof(header));
+	header.magic = TRANSLATION_CACHE_MAGIC;
+	header.version = TRANSLATION_CACHE_VERSION;
+	header.codeVersion = codeVersion;
+	header.codeSize = codeSize;
+	header.hostFunctionCount = (uint32)hostFunctions.size();
+	header.blockCount = 0;
+
+	//Blocks that start outside the code of the program are left out
+	for (size_t i = 0; i < binBlocks.size(); ++i) {
+		if ((uint64)binBlocks[i]->startAddress < codeSize) ++header.blockCount;
+	}
+
+	image->clear();
+	appendToImage(image, &header, sizeof(header));
+	for (size_t i = 0; i < binBlocks.size(); ++i) {
+		if ((uint64)binBlocks[i]->startAddress < codeSize) saveBinBlock(binBlocks[i], image);
+	}
+
+	SHA_256_MessageDigest payloadHash = sha256(image->data() + sizeof(header), (uint32)(image->size() - sizeof(header)));
+	memcpy(&((TranslationCacheHeader*)image->data())->payloadHash, &payloadHash.h, sizeof(header.payloadHash));
+}
+
+void X86TranslationCache::saveBinBlock(X86BinBlock *binBlock, vector<uint8> *image) {
+	uint8 *binBuffer = binBlock->getBinBuffer();
+	vector<uint8> code(binBuffer, binBuffer + binBlock->getCounter());
+	vector<TranslationCacheExit> exits;
+	vector<TranslationCacheRelocation> relocations;
+
+	for (size_t i = 0; i < binBlock->exits.size(); ++i) {
+		X86BinBlockExit *blockExit = binBlock->exits[i];
+		TranslationCacheExit exit;
+
+		memset(&exit, 0, sizeof(exit));
+		exit.targetAddress = blockExit->targetAddress;
+		exit.patchIndex = blockExit->patchIndex;
+		exit.tailIndex = blockExit->tailIndex;
+		exit.compareIndex = blockExit->compareIndex;
+		exit.missIndex = blockExit->missIndex;
+		exit.nextTailIndex = blockExit->nextTailIndex;
+
+		//Blocks it is linked to may not be loaded along with it, so every exit starts at its tail. An entry
+		//of an inline cache that still compares with its address goes to the tail to be filled again.
+		*(uint32*)&code[blockExit->patchIndex + 1] = blockExit->tailIndex - (blockExit->patchIndex + BLOCK_EXIT_SIZE);
+		exits.push_back(exit);
+	}
+
+	for (size_t i = 0; i < binBlock->immi64Indices.size(); ++i) {
+		TranslationCacheRelocation relocation;
+
+		relocation.index = binBlock->immi64Indices[i];
+		if (findRelocation(binBlock, *(uint64*)&code[relocation.index], &relocation.base, &relocation.offset)) {
+			*(uint64*)&code[relocation.index] = 0;
+			relocations.push_back(relocation);
+		}
+	}
+
+	TranslationCacheBlock block;
+	memset(&block, 0, sizeof(block));
+	block.startAddress = binBlock->startAddress;
+	block.endAddress = binBlock->endAddress;
+	block.trace = (binBlock->trace) ? 1 : 0;
+	block.codeSize = (uint32)code.size();
+	block.exitCount = (uint32)exits.size();
+	block.relocationCount = (uint32)relocations.size();
+	block.guestAddressCount = (uint32)binBlock->guestAddresses.size();
+
+	appendToImage(image, &block, sizeof(block));
+	appendToImage(image, exits.data(), exits.size() * sizeof(TranslationCacheExit));
+	appendToImage(image, relocations.data(), relocations.size() * sizeof(TranslationCacheRelocation));
+	appendToImage(image, binBlock->guestAddresses.data(), binBlock->guestAddresses.size() * sizeof(X86GuestAddress));
+	appendToImage(image, code.data(), code.size());
+}
+
+bool X86TranslationCache::loadFile(const string &path, X86CodeArena *codeArena, vector<X86BinBlock*> *binBlocks) {
+	FILE *cacheFile = fopen(path.c_str(), "rb");
+	if (cacheFile == 0) return false;
+
+	vector<uint8> image;
+	uint8 buffer[4096];
+	size_t readSize;
+	while ((readSize = fread(buffer, 1, sizeof(buffer), cacheFile)) > 0) {
+		image.insert(image.end(), buffer, buffer + readSize);
+	}
+	fclose(cacheFile);
+
+	return load(image, codeArena, binBlocks);
+}
+
+bool X86TranslationCache::saveFile(const string &path, const vector<X86BinBlock*> &binBlocks) {
+	vector<uint8> image;
+	save(binBlocks, &image);
+
+	//Written next to the old file and moved over it once complete, so a crash never leaves half a file
+	string tempPath = path + ".tmp";
+	FILE *cacheFile = fopen(tempPath.c_str(), "wb");
+	if (cacheFile == 0) return false;
+
+	bool written = fwrite(image.data(), 1, image.size(), cacheFile) == image.size();
+	if (fclose(cacheFile) != 0) written = false;
+	if (!written) {
+		remove(tempPath.c_str());
+		return false;
+	}
+
+	remove(path.c_str());
+	return rename(tempPath.c_str(), path.c_str()) == 0;
+}
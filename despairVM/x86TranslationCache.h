@@ -0,0 +1,72 @@
+/*
+	Written By Pradipna Nepal
+	www.pradsprojects.com
+
+	Copyright (C) 2013 Pradipna Nepal
+	Please read COPYING.txt included along with this source code for more detail.
+	If not included, see http://www.gnu.org/licenses/
+*/
+
+#ifndef X86_TRANSLATION_CACHE_H
+#define X86_TRANSLATION_CACHE_H
+
+#include <vector>
+#include <string>
+#include <cstdio>
+#include "build.h"
+#include "declarations.h"
+#include "x86BinBlock.h"
+#include "x86CodeArena.h"
+
+#define TRANSLATION_CACHE_MAGIC			0x43545044	//"DPTC"
+#define TRANSLATION_CACHE_VERSION		5	//Has to change whenever the layout of the file changes
+
+//Memory translated code refers to by its absolute address, which is somewhere else in every run
+enum X86RelocationBase {
+	RELOCATION_CORE,	//The X86DynaRecCore, with the guest registers, pC, sP and the port manager
+	RELOCATION_TIMER,
+	RELOCATION_STACK,
+	RELOCATION_GLOBAL_DATA,
+	RELOCATION_DISPATCHER,
+	RELOCATION_REGION_COUNT,
+	RELOCATION_HOST_FUNCTION = RELOCATION_REGION_COUNT,	//Offset is an index into the host functions
+	RELOCATION_EXIT	//Offset is an index into the exits of the block
+};
+
+//Turns translated blocks into an image that another X86DynaRecCore can load, in this run or through a
+//file in the next run of the same program, so that they do not have to be translated again. Blocks
+//are saved with their exits unlinked, and every 64 bit value in their code that is an address in one
+//of the regions, a host function or an exit of the block is saved as a relocation and patched with the
+//address it has in the core that loads the image.
+//Code depends on the VM that translated it, so images written with another code version are not loaded,
+//and neither are images whose blocks don't match the SHA-256 saved with them.
+class X86TranslationCache {
+private:
+	uint32 codeVersion;
+	uint64 codeSize;
+	uint64 regionAddress[RELOCATION_REGION_COUNT], regionSize[RELOCATION_REGION_COUNT];
+	std::vector<uint64> hostFunctions;
+
+	//Returns false if value is not an address that is different in every core
+	bool findRelocation(X86BinBlock *binBlock, uint64 value, uint32 *base, uint64 *offset);
+	X86BinBlock *loadBinBlock(const std::vector<uint8> &image, size_t *offset, X86CodeArena *codeArena);
+	void saveBinBlock(X86BinBlock *binBlock, std::vector<uint8> *image);
+
+public:
+	//codeVersion changes whenever the code translated for the same guest code does
+	X86TranslationCache(uint32 codeVersion, uint64 codeSize);
+
+	void setRegion(X86RelocationBase base, const void *address, uint64 size);
+	//Every function translated code calls has to be added, in the same order in every run
+	void addHostFunction(uint64 function);
+
+	//Blocks are installed in codeArena but not linked. Returns false and loads nothing if the image was
+	//written with another code version or is broken.
+	bool load(const std::vector<uint8> &image, X86CodeArena *codeArena, std::vector<X86BinBlock*> *binBlocks);
+	void save(const std::vector<X86BinBlock*> &binBlocks, std::vector<uint8> *image);
+	//Same as above with the image in a file, which may not exist yet
+	bool loadFile(const std::string &path, X86CodeArena *codeArena, std::vector<X86BinBlock*> *binBlocks);
+	bool saveFile(const std::string &path, const std::vector<X86BinBlock*> &binBlocks);
+};
+
+#endif
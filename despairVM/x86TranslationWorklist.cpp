@@ -0,0 +1,168 @@
+/*
+	Written By Pradipna Nepal
+	www.pradsprojects.com
+
+	Copyright (C) 2013 Pradipna Nepal
+	Please read COPYING.txt included along with this source code for more detail.
+	If not included, see http://www.gnu.org/licenses/
+*/
+
+#include <cstring>
+#include "x86TranslationWorklist.h"
+#include "instructionsSet.h"
+#include "instructionsInfo.h"
+#include "irBlock.h"
+#include "portAddress.h"
+using namespace std;
+
+//Value written to a port, cut to the size of the OUT
+static uint64 truncateToSize(uint64 value, int size) {
+	return (size == 8) ? value : value & ((1ULL << (size << 3)) - 1);
+}
+
+static uint64 readImmediate(const uint8 *operand, int size) {
+	uint64 immi = 0;
+	memcpy(&immi, operand, size);
+	return immi;
+}
+
+//Port and value of an OUT instruction, as far as they are known from the registers loaded with
+//immediates before it in the same block. Returns false if the instruction is not an OUT or either one
+//is not known.
+static bool getPortWrite(const uint8 *operands, uint16 opcode, const bool *known, const uint64 *value, uint32 *port, uint64 *portValue) {
+	switch (opcode) {
+		case _OUT_R_IMMI8:
+		case _OUT_R_IMMI16:
+		case _OUT_R_IMMI32:
+		case _OUT_R_IMMI64:
+			if (!known[operands[0]]) return false;
+			*port = (uint32)value[operands[0]];
+			*portValue = readImmediate(&operands[1], 1 << (opcode - _OUT_R_IMMI8));
+			return true;
+		case _OUT_IMMI_R8:
+		case _OUT_IMMI_R16:
+		case _OUT_IMMI_R32:
+		case _OUT_IMMI_R64:
+			if (!known[operands[0]]) return false;
+			*port = *(uint32*)&operands[1];
+			*portValue = truncateToSize(value[operands[0]], 1 << (opcode - _OUT_IMMI_R8));
+			return true;
+		case _OUT_R_R8:
+		case _OUT_R_R16:
+		case _OUT_R_R32:
+		case _OUT_R_R64:
+			if (!known[operands[0]] || !known[operands[1]]) return false;
+			*port = (uint32)value[operands[0]];
+			*portValue = truncateToSize(value[operands[1]], 1 << (opcode - _OUT_R_R8));
+			return true;
+		case _OUT_IMMI_IMMI8:
+		case _OUT_IMMI_IMMI16:
+		case _OUT_IMMI_IMMI32:
+		case _OUT_IMMI_IMMI64:
+			*port = *(uint32*)&operands[0];
+			*portValue = readImmediate(&operands[4], 1 << (opcode - _OUT_IMMI_IMMI8));
+			return true;
+		default:
+			return false;
+	}
+}
+
+X86TranslationWorklist::X86TranslationWorklist(const uint8 *codeSpace, uint64 codeSize) : queued((size_t)codeSize, false) {
+	this->codeSpace = codeSpace;
+	this->codeSize = codeSize;
+	busyThreads = 0;
+}
+
+void X86TranslationWorklist::push(int64 address) {
+	lock_guard<mutex> guard(lock);
+
+	if (address < 0 || (uint64)address >= codeSize || queued[(size_t)address]) return;
+	queued[(size_t)address] = true;
+	pending.push_back(address);
+	changed.notify_one();
+}
+
+bool X86TranslationWorklist::pop(int64 *address) {
+	unique_lock<mutex> guard(lock);
+
+	//Blocks that are being translated may still lead somewhere new
+	while (pending.empty() && busyThreads > 0) {
+		changed.wait(guard);
+	}
+	if (pending.empty()) return false;
+
+	*address = pending.back();
+	pending.pop_back();
+	++busyThreads;
+	return true;
+}
+
+void X86TranslationWorklist::finish(const vector<int64> &successors) {
+	lock_guard<mutex> guard(lock);
+
+	for (size_t i = 0; i < successors.size(); ++i) {
+		int64 address = successors[i];
+
+		if (address >= 0 && (uint64)address < codeSize && !queued[(size_t)address]) {
+			queued[(size_t)address] = true;
+			pending.push_back(address);
+		}
+	}
+	--busyThreads;
+	changed.notify_all();
+}
+
+bool X86TranslationWorklist::scanBlock(int64 address, vector<int64> *successors) const {
+	//IRBlock does not check where the code ends
+	for (int64 instructionAddress = address;;) {
+		if ((uint64)instructionAddress + 2 > codeSize) return false;
+		const InstructionInfo *instructionInfo = InstructionsInfo::getInstructionInfo(*(uint16*)&codeSpace[instructionAddress]);
+		if (!instructionInfo) return false;
+
+		instructionAddress += InstructionsInfo::getInstructionSize(instructionInfo);
+		if ((uint64)instructionAddress > codeSize) return false;
+		if (instructionInfo->flags & INSTRUCTION_BRANCH) break;
+	}
+
+	IRBlock irBlock(codeSpace);
+	bool known[256];
+	uint64 value[256];
+
+	irBlock.decode(address);
+	for (int i = 0; i < 256; ++i) {
+		known[i] = false;
+	}
+
+	for (size_t i = 0; i < irBlock.instructions.size(); ++i) {
+		const IRInstruction &instruction = irBlock.instructions[i];
+		uint32 port;
+		uint64 portValue;
+
+		if (instruction.opcode == IR_NATIVE && getPortWrite(&codeSpace[instruction.address + 2], instruction.despairOpcode, known, value, &port, &portValue)
+				&& port == PORT_THREAD_CREATE) {
+			successors->push_back((int64)(uint32)portValue);
+		}
+		if (instruction.despairOpcode == _CALL_IMMI) {
+			successors->push_back(irBlock.endAddress);
+		}
+
+		if (instruction.opcode == IR_MOV) {
+			known[instruction.dst] = instruction.srcImmi || known[instruction.src];
+			if (known[instruction.dst]) value[instruction.dst] = (instruction.srcImmi) ? instruction.immi : value[instruction.src];
+			continue;
+		}
+
+		IRRegisterUses uses;
+		irBlock.getRegisterUses(instruction, &uses);
+		if (uses.allRegs) {
+			for (int j = 0; j < 256; ++j) {
+				known[j] = false;
+			}
+		}
+		for (int j = 0; j < uses.writeCount; ++j) {
+			known[uses.writes[j]] = false;
+		}
+	}
+
+	return true;
+}
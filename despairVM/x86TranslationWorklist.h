@@ -0,0 +1,47 @@
+/*
+	Written By Pradipna Nepal
+	www.pradsprojects.com
+
+	Copyright (C) 2013 Pradipna Nepal
+	Please read COPYING.txt included along with this source code for more detail.
+	If not included, see http://www.gnu.org/licenses/
+*/
+
+#ifndef X86_TRANSLATION_WORKLIST_H
+#define X86_TRANSLATION_WORKLIST_H
+
+#include <vector>
+#include <mutex>
+#include <condition_variable>
+#include "build.h"
+#include "declarations.h"
+
+//Guest addresses that still have to be translated ahead of time, shared by the threads that translate
+//them. Every address is handed out once, and pop waits while other threads may still find new ones.
+class X86TranslationWorklist {
+private:
+	std::mutex lock;
+	std::condition_variable changed;
+	std::vector<int64> pending;
+	std::vector<bool> queued;	//For every byte of code
+	int busyThreads;
+	const uint8 *codeSpace;
+	uint64 codeSize;
+
+public:
+	X86TranslationWorklist(const uint8 *codeSpace, uint64 codeSize);
+
+	//Addresses outside the code and addresses that were pushed before are ignored
+	void push(int64 address);
+	//Returns false once every address has been handed out and translated
+	bool pop(int64 *address);
+	//Called after every successful pop with the addresses the block leads to
+	void finish(const std::vector<int64> &successors);
+
+	//Returns false if the block at address runs past the end of the code or has an instruction that
+	//does not exist. Adds the return addresses of its calls and the entry points of the threads it
+	//creates to successors, the targets of its branches are the exits of the translated block.
+	bool scanBlock(int64 address, std::vector<int64> *successors) const;
+};
+
+#endif
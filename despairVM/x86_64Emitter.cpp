@@ -17,6 +17,55 @@ uint8 sib(int scale, int index, int base) {
 	return ((scale << 6) | (index << 3) | base);
 }
 
+//Writes an instruction with a (base + disp) operand: prefix (0 for none), REX if it is needed, opcode
+//and the ModRM, SIB and displacement bytes. rex is 0x48 for 64 bit operands and 0x40 otherwise.
+//Returns the size without the immediate that may follow.
+static int putMRegDisp(X86BinBlock *binBlock, uint8 prefix, uint8 rex, uint32 opcode, int opcodeSize, int reg, X86_64Register base, uint32 disp) {
+	bool disp8 = ((int32)disp == (int8)disp);
+	int size = opcodeSize + 1 + ((disp8) ? 1 : 4);
+
+	if (reg > 7) {
+		rex |= 4;
+	}
+	if (base > 7) {
+		rex |= 1;
+	}
+	if (prefix) {
+		++size;
+	}
+	if (rex != 0x40) {
+		++size;
+	}
+	if ((base & 7) == rsp) {	//rsp and r12 need a SIB byte
+		++size;
+	}
+
+	if (binBlock) {
+		if (prefix) {
+			binBlock->write<uint8>(prefix);
+		}
+		if (rex != 0x40) {
+			binBlock->write<uint8>(rex);
+		}
+		for (int i = 0; i < opcodeSize; ++i) {
+			binBlock->write<uint8>((opcode >> (i << 3)) & 0xFF);
+		}
+		if ((base & 7) == rsp) {
+			binBlock->write<uint8>(modRM((disp8) ? 1 : 2, reg & 7, SIB_BYTE));
+			binBlock->write<uint8>(sib(0, rsp, rsp));
+		} else {
+			binBlock->write<uint8>(modRM((disp8) ? 1 : 2, reg & 7, base & 7));
+		}
+		if (disp8) {
+			binBlock->write<uint8>((uint8)disp);
+		} else {
+			binBlock->write<uint32>(disp);
+		}
+	}
+
+	return size;
+}
+
 int X86_64Emitter::addReg32Reg32(X86BinBlock *binBlock, X86_64Register reg1, X86_64Register reg2) {
 	int rex;
 	
@@ -296,6 +345,30 @@ int X86_64Emitter::addssXMM_Disp32(X86BinBlock *binBlock, X86_64Register xmm, ui
 	return (rex == 0x40) ? 8 : 9;
 }
 
+int X86_64Emitter::addssXMM_XMM(X86BinBlock *binBlock, X86_64Register xmm_1, X86_64Register xmm_2) {
+	int rex;
+
+	if (xmm_1 > 7) {
+		rex = 0x44;
+	} else {
+		rex = 0x40;
+	}
+	if (xmm_2 > 7) {
+		rex |= 1;
+	}
+
+	if (binBlock) {
+		binBlock->write<uint8>(0xF3);
+		if (rex != 0x40) {
+			binBlock->write<uint8>(rex);
+		}
+		binBlock->write<uint16>(0x580F);
+		binBlock->write<uint8>(modRM(3, xmm_1 & 7, xmm_2 & 7));
+	}
+
+	return (rex == 0x40) ? 4 : 5;
+}
+
 int X86_64Emitter::andReg32Reg32(X86BinBlock *binBlock, X86_64Register reg1, X86_64Register reg2) {
 	int rex;
 
@@ -359,6 +432,19 @@ int X86_64Emitter::andRAX_Immi32(X86BinBlock *binBlock, uint32 immi) {
 	return 6;
 }
 
+int X86_64Emitter::andReg32Immi32(X86BinBlock *binBlock, X86_64Register reg, uint32 immi) {
+	if (binBlock) {
+		if (reg > 7) {
+			binBlock->write<uint8>(0x41);
+		}
+		binBlock->write<uint8>(0x81);
+		binBlock->write<uint8>(modRM(3, 4, reg & 7));
+		binBlock->write<uint32>(immi);
+	}
+
+	return (reg > 7) ? 7 : 6;
+}
+
 int X86_64Emitter::andMReg32Reg32(X86BinBlock *binBlock, X86_64Register reg1, X86_64Register reg2) {
 	int rex;
 
@@ -516,6 +602,75 @@ int X86_64Emitter::cmpMReg64Reg64(X86BinBlock *binBlock, X86_64Register reg1, X8
 	return 3;
 }
 
+int X86_64Emitter::cmpReg32Immi32(X86BinBlock *binBlock, X86_64Register reg, uint32 immi) {
+	if (binBlock) {
+		if (reg > 7) {
+			binBlock->write<uint8>(0x41);
+		}
+		binBlock->write<uint8>(0x81);
+		binBlock->write<uint8>(modRM(3, 7, reg & 7));
+		binBlock->write<uint32>(immi);
+	}
+
+	return (reg > 7) ? 7 : 6;
+}
+
+//immi is sign extended
+int X86_64Emitter::cmpReg64Immi32(X86BinBlock *binBlock, X86_64Register reg, uint32 immi) {
+	if (binBlock) {
+		binBlock->write<uint8>((reg > 7) ? 0x49 : 0x48);
+		binBlock->write<uint8>(0x81);
+		binBlock->write<uint8>(modRM(3, 7, reg & 7));
+		binBlock->write<uint32>(immi);
+	}
+
+	return 7;
+}
+
+int X86_64Emitter::cmpReg32Reg32(X86BinBlock *binBlock, X86_64Register reg1, X86_64Register reg2) {
+	int rex;
+
+	if (reg1 > 7) {
+		rex = 0x41;
+	} else {
+		rex = 0x40;
+	}
+	if (reg2 > 7) {
+		rex |= 4;
+	}
+
+	if (binBlock) {
+		if (rex != 0x40) {
+			binBlock->write<uint8>(rex);
+		}
+		binBlock->write<uint8>(0x39);
+		binBlock->write<uint8>(modRM(3, reg2 & 7, reg1 & 7));
+	}
+
+	return (rex == 0x40) ? 2 : 3;
+}
+
+int X86_64Emitter::cmpReg64Reg64(X86BinBlock *binBlock, X86_64Register reg1, X86_64Register reg2) {
+	if (binBlock) {
+		int rex;
+
+		if (reg1 > 7) {
+			rex = 0x49;
+		} else {
+			rex = 0x48;
+		}
+		if (reg2 > 7) {
+			rex |= 4;
+		}
+
+		binBlock->write<uint8>(rex);
+		binBlock->write<uint8>(0x39);
+		binBlock->write<uint8>(modRM(3, reg2 & 7, reg1 & 7));
+	}
+
+	return 3;
+}
+
 int X86_64Emitter::cvtsi2ssXMM_MReg32(X86BinBlock *binBlock, X86_64Register xmm, X86_64Register reg) {
 	int rex;
 
@@ -639,7 +794,7 @@ int X86_64Emitter::cvtss2siReg32XMM(X86BinBlock *binBlock, X86_64Register reg, X
 	} else {
 		rex = 0x40;
 	}
-	if (xmm > 0) {
+	if (xmm > 7) {
 		rex |= 1;
 	}
 
@@ -799,6 +954,24 @@ int X86_64Emitter::imulRAX_Reg64(X86BinBlock *binBlock, X86_64Register reg) {
 	return 3;
 }
 
+int X86_64Emitter::mulRAX_Reg64(X86BinBlock *binBlock, X86_64Register reg) {
+	if (binBlock) {
+		int rex;
+
+		if (reg > 7) {
+			rex = 0x49;
+		} else {
+			rex = 0x48;
+		}
+
+		binBlock->write<uint8>(rex);
+		binBlock->write<uint8>(0xF7);
+		binBlock->write<uint8>(modRM(3, 4, reg & 7));
+	}
+
+	return 3;
+}
+
 int X86_64Emitter::imulReg32Reg32(X86BinBlock *binBlock, X86_64Register reg1, X86_64Register reg2) {
 	int rex;
 
@@ -1047,6 +1220,35 @@ int X86_64Emitter::jmpRel32(X86BinBlock *binBlock, uint32 rel) {
 	return 5;
 }
 
+int X86_64Emitter::jmpReg64(X86BinBlock *binBlock, X86_64Register reg) {
+	int rex;
+
+	if (reg > 7) {
+		rex = 0x41;
+	} else {
+		rex = 0x40;
+	}
+
+	if (binBlock) {
+		if (rex != 0x40) {
+			binBlock->write<uint8>(0x41);
+		}
+		binBlock->write<uint8>(0xFF);
+		binBlock->write<uint8>(modRM(3, 4, reg & 7));
+	}
+
+	return (rex == 0x40) ? 2 : 3;
+}
+
+int X86_64Emitter::jneRel32(X86BinBlock *binBlock, uint32 rel) {
+	if (binBlock) {
+		binBlock->write<uint16>(0x850F);
+		binBlock->write<uint32>(rel);
+	}
+
+	return 6;
+}
+
 int X86_64Emitter::movReg64Immi64(X86BinBlock *binBlock, X86_64Register reg, uint64 immi) {
 	if (binBlock) {
 		uint8 rex;
@@ -1172,6 +1374,37 @@ int X86_64Emitter::movReg64MReg64(X86BinBlock *binBlock, X86_64Register reg, int
 	return 4;
 }
 
+int X86_64Emitter::leaReg64MReg64(X86BinBlock *binBlock, X86_64Register reg, int scale, X86_64Register index, X86_64Register base) {
+	//rbp and r13 can only be a base with a displacement
+	bool disp8 = ((base & 7) == rbp);
+
+	if (binBlock) {
+		int rex;
+
+		if (reg > 7) {
+			rex = 0x4C;
+		} else {
+			rex = 0x48;
+		}
+		if (index > 7) {
+			rex |= 2;
+		}
+		if (base > 7) {
+			rex |= 1;
+		}
+
+		binBlock->write<uint8>(rex);
+		binBlock->write<uint8>(0x8D);
+		binBlock->write<uint8>(modRM((disp8) ? 1 : 0, reg & 7, SIB_BYTE));
+		binBlock->write<uint8>(sib(scale, index & 7, base & 7));
+		if (disp8) {
+			binBlock->write<uint8>(0);
+		}
+	}
+
+	return (disp8) ? 5 : 4;
+}
+
 int X86_64Emitter::movMReg64Reg64(X86BinBlock *binBlock, int scale, X86_64Register index, X86_64Register base, X86_64Register reg) {
 	if (binBlock) {
 		int rex;
@@ -1648,6 +1881,90 @@ int X86_64Emitter::movssXMM_MReg32(X86BinBlock *binBlock, X86_64Register xmm, X8
 	return (rex == 0x40) ? 4 : 5;
 }
 
+int X86_64Emitter::movssXMM_XMM(X86BinBlock *binBlock, X86_64Register xmm_1, X86_64Register xmm_2) {
+	int rex;
+
+	if (xmm_1 > 7) {
+		rex = 0x44;
+	} else {
+		rex = 0x40;
+	}
+	if (xmm_2 > 7) {
+		rex |= 1;
+	}
+
+	if (binBlock) {
+		binBlock->write<uint8>(0xF3);
+		if (rex != 0x40) {
+			binBlock->write<uint8>(rex);
+		}
+		binBlock->write<uint16>(0x100F);
+		binBlock->write<uint8>(modRM(3, xmm_1 & 7, xmm_2 & 7));
+	}
+
+	return (rex == 0x40) ? 4 : 5;
+}
+
+int X86_64Emitter::movupsMRegDisp8XMM(X86BinBlock *binBlock, X86_64Register reg, uint8 disp8, X86_64Register xmm) {
+	int rex, size;
+
+	if (xmm > 7) {
+		rex = 0x44;
+	} else {
+		rex = 0x40;
+	}
+	if (reg > 7) {
+		rex |= 1;
+	}
+	size = ((reg & 7) == rsp) ? 5 : 4;	//rsp and r12 need a SIB byte
+
+	if (binBlock) {
+		if (rex != 0x40) {
+			binBlock->write<uint8>(rex);
+		}
+		binBlock->write<uint16>(0x110F);
+		if ((reg & 7) == rsp) {
+			binBlock->write<uint8>(modRM(1, xmm & 7, SIB_BYTE));
+			binBlock->write<uint8>(sib(0, rsp, rsp));
+		} else {
+			binBlock->write<uint8>(modRM(1, xmm & 7, reg & 7));
+		}
+		binBlock->write<uint8>(disp8);
+	}
+
+	return (rex == 0x40) ? size : size + 1;
+}
+
+int X86_64Emitter::movupsXMM_MRegDisp8(X86BinBlock *binBlock, X86_64Register xmm, X86_64Register reg, uint8 disp8) {
+	int rex, size;
+
+	if (xmm > 7) {
+		rex = 0x44;
+	} else {
+		rex = 0x40;
+	}
+	if (reg > 7) {
+		rex |= 1;
+	}
+	size = ((reg & 7) == rsp) ? 5 : 4;	//rsp and r12 need a SIB byte
+
+	if (binBlock) {
+		if (rex != 0x40) {
+			binBlock->write<uint8>(rex);
+		}
+		binBlock->write<uint16>(0x100F);
+		if ((reg & 7) == rsp) {
+			binBlock->write<uint8>(modRM(1, xmm & 7, SIB_BYTE));
+			binBlock->write<uint8>(sib(0, rsp, rsp));
+		} else {
+			binBlock->write<uint8>(modRM(1, xmm & 7, reg & 7));
+		}
+		binBlock->write<uint8>(disp8);
+	}
+
+	return (rex == 0x40) ? size : size + 1;
+}
+
 int X86_64Emitter::mulssXMM_MReg32(X86BinBlock *binBlock, X86_64Register xmm, X86_64Register reg) {
 	int rex;
 
@@ -1694,6 +2011,30 @@ int X86_64Emitter::mulssXMM_Disp32(X86BinBlock *binBlock, X86_64Register xmm, ui
 	return (rex == 0x40) ? 8 : 9;
 }
 
+int X86_64Emitter::mulssXMM_XMM(X86BinBlock *binBlock, X86_64Register xmm_1, X86_64Register xmm_2) {
+	int rex;
+
+	if (xmm_1 > 7) {
+		rex = 0x44;
+	} else {
+		rex = 0x40;
+	}
+	if (xmm_2 > 7) {
+		rex |= 1;
+	}
+
+	if (binBlock) {
+		binBlock->write<uint8>(0xF3);
+		if (rex != 0x40) {
+			binBlock->write<uint8>(rex);
+		}
+		binBlock->write<uint16>(0x590F);
+		binBlock->write<uint8>(modRM(3, xmm_1 & 7, xmm_2 & 7));
+	}
+
+	return (rex == 0x40) ? 4 : 5;
+}
+
 int X86_64Emitter::nop(X86BinBlock *binBlock) {
 	if (binBlock) {
 		binBlock->write<uint8>(0x90);
@@ -1702,6 +2043,27 @@ int X86_64Emitter::nop(X86BinBlock *binBlock) {
 	return 1;
 }
 
+int X86_64Emitter::orReg64Reg64(X86BinBlock *binBlock, X86_64Register reg1, X86_64Register reg2) {
+	if (binBlock) {
+		int rex;
+
+		if (reg1 > 7) {
+			rex = 0x4C;
+		} else {
+			rex = 0x48;
+		}
+		if (reg2 > 7) {
+			rex |= 1;
+		}
+
+		binBlock->write<uint8>(rex);
+		binBlock->write<uint8>(0x0B);
+		binBlock->write<uint8>(modRM(3, reg1 & 7, reg2 & 7));
+	}
+
+	return 3;
+}
+
 int X86_64Emitter::orMReg32Reg32(X86BinBlock *binBlock, X86_64Register reg1, X86_64Register reg2) {
 	int rex;
 
@@ -1778,6 +2140,17 @@ int X86_64Emitter::popReg64(X86BinBlock *binBlock, X86_64Register reg) {
 	return (reg > 7) ? 2 : 1;
 }
 
+int X86_64Emitter::pushReg64(X86BinBlock *binBlock, X86_64Register reg) {
+	if (binBlock) {
+		if (reg > 7) {
+			binBlock->write<uint8>(0x41);
+		}
+		binBlock->write<uint8>(0x50 + (reg & 7));
+	}
+
+	return (reg > 7) ? 2 : 1;
+}
+
 int X86_64Emitter::pushf(X86BinBlock *binBlock) {
 	if (binBlock) {
 		binBlock->write<uint8>(0x9C);
@@ -1786,6 +2159,15 @@ int X86_64Emitter::pushf(X86BinBlock *binBlock) {
 	return 1;
 }
 
+int X86_64Emitter::rdtsc(X86BinBlock *binBlock) {
+	if (binBlock) {
+		binBlock->write<uint8>(0x0F);
+		binBlock->write<uint8>(0x31);
+	}
+
+	return 2;
+}
+
 int X86_64Emitter::repMovs64(X86BinBlock *binBlock) {
 	if (binBlock) {
 		binBlock->write<uint8>(0xF3);
@@ -1883,6 +2265,35 @@ int X86_64Emitter::shlMReg64Cl(X86BinBlock *binBlock, X86_64Register reg) {
 	return 3;
 }
 
+int X86_64Emitter::shlReg64Immi8(X86BinBlock *binBlock, X86_64Register reg, uint8 immi) {
+	if (binBlock) {
+		if (reg > 7) {
+			binBlock->write<uint8>(0x49);
+		} else {
+			binBlock->write<uint8>(0x48);
+		}
+		binBlock->write<uint8>(0xC1);
+		binBlock->write<uint8>(modRM(3, 4, reg & 7));
+		binBlock->write<uint8>(immi);
+	}
+
+	return 4;
+}
+
+int X86_64Emitter::shlReg64Cl(X86BinBlock *binBlock, X86_64Register reg) {
+	if (binBlock) {
+		if (reg > 7) {
+			binBlock->write<uint8>(0x49);
+		} else {
+			binBlock->write<uint8>(0x48);
+		}
+		binBlock->write<uint8>(0xD3);
+		binBlock->write<uint8>(modRM(3, 4, reg & 7));
+	}
+
+	return 3;
+}
+
 int X86_64Emitter::shrMReg32Immi8(X86BinBlock *binBlock, X86_64Register reg, uint8 immi) {
 	int rex;
 	
@@ -1953,6 +2364,35 @@ int X86_64Emitter::shrMReg64Cl(X86BinBlock *binBlock, X86_64Register reg) {
 	return 3;
 }
 
+int X86_64Emitter::shrReg64Immi8(X86BinBlock *binBlock, X86_64Register reg, uint8 immi) {
+	if (binBlock) {
+		if (reg > 7) {
+			binBlock->write<uint8>(0x49);
+		} else {
+			binBlock->write<uint8>(0x48);
+		}
+		binBlock->write<uint8>(0xC1);
+		binBlock->write<uint8>(modRM(3, 5, reg & 7));
+		binBlock->write<uint8>(immi);
+	}
+
+	return 4;
+}
+
+int X86_64Emitter::shrReg64Cl(X86BinBlock *binBlock, X86_64Register reg) {
+	if (binBlock) {
+		if (reg > 7) {
+			binBlock->write<uint8>(0x49);
+		} else {
+			binBlock->write<uint8>(0x48);
+		}
+		binBlock->write<uint8>(0xD3);
+		binBlock->write<uint8>(modRM(3, 5, reg & 7));
+	}
+
+	return 3;
+}
+
 int X86_64Emitter::subReg32Reg32(X86BinBlock *binBlock, X86_64Register reg1, X86_64Register reg2) {
 	int rex = 0x40;
 
@@ -2204,6 +2644,25 @@ int X86_64Emitter::subssXMM_XMM(X86BinBlock *binBlock, X86_64Register xmm_1, X86
 	return (rex == 0x40) ? 4 : 5;
 }
 
+int X86_64Emitter::testReg64Reg64(X86BinBlock *binBlock, X86_64Register reg1, X86_64Register reg2) {
+	if (binBlock) {
+		int rex = 0x48;
+
+		if (reg2 > 7) {
+			rex |= 4;
+		}
+		if (reg1 > 7) {
+			rex |= 1;
+		}
+
+		binBlock->write<uint8>(rex);
+		binBlock->write<uint8>(0x85);
+		binBlock->write<uint8>(modRM(3, reg2 & 7, reg1 & 7));
+	}
+
+	return 3;
+}
+
 int X86_64Emitter::ucomissXMM_MReg32(X86BinBlock *binBlock, X86_64Register xmm, X86_64Register reg) {
 	int rex;
 
@@ -2334,4 +2793,170 @@ int X86_64Emitter::xorMReg32Immi32(X86BinBlock *binBlock, X86_64Register reg, ui
 	}
 
 	return (rex == 0x40) ? 6 : 7;
+}
+
+int X86_64Emitter::leaReg64Disp32(X86BinBlock *binBlock, X86_64Register reg, uint32 disp32) {
+	if (binBlock) {
+		binBlock->write<uint8>((reg > 7) ? 0x4C : 0x48);
+		binBlock->write<uint8>(0x8D);
+		binBlock->write<uint8>(modRM(0, reg & 7, DISP32));
+		binBlock->write<uint32>(disp32);
+	}
+
+	return 7;
+}
+
+int X86_64Emitter::leaReg64MRegDisp(X86BinBlock *binBlock, X86_64Register reg, X86_64Register base, uint32 disp) {
+	return putMRegDisp(binBlock, 0, 0x48, 0x8D, 1, reg, base, disp);
+}
+
+int X86_64Emitter::movReg64MRegDisp(X86BinBlock *binBlock, X86_64Register reg, X86_64Register base, uint32 disp) {
+	return putMRegDisp(binBlock, 0, 0x48, 0x8B, 1, reg, base, disp);
+}
+
+int X86_64Emitter::movReg32MRegDisp(X86BinBlock *binBlock, X86_64Register reg, X86_64Register base, uint32 disp) {
+	return putMRegDisp(binBlock, 0, 0x40, 0x8B, 1, reg, base, disp);
+}
+
+int X86_64Emitter::movzxReg32MRegDisp8(X86BinBlock *binBlock, X86_64Register reg, X86_64Register base, uint32 disp) {
+	return putMRegDisp(binBlock, 0, 0x40, 0xB60F, 2, reg, base, disp);
+}
+
+int X86_64Emitter::movzxReg32MRegDisp16(X86BinBlock *binBlock, X86_64Register reg, X86_64Register base, uint32 disp) {
+	return putMRegDisp(binBlock, 0, 0x40, 0xB70F, 2, reg, base, disp);
+}
+
+int X86_64Emitter::movMRegDispReg64(X86BinBlock *binBlock, X86_64Register base, uint32 disp, X86_64Register reg) {
+	return putMRegDisp(binBlock, 0, 0x48, 0x89, 1, reg, base, disp);
+}
+
+int X86_64Emitter::movMRegDispReg32(X86BinBlock *binBlock, X86_64Register base, uint32 disp, X86_64Register reg) {
+	return putMRegDisp(binBlock, 0, 0x40, 0x89, 1, reg, base, disp);
+}
+
+int X86_64Emitter::movMRegDispReg16(X86BinBlock *binBlock, X86_64Register base, uint32 disp, X86_64Register reg) {
+	return putMRegDisp(binBlock, 0x66, 0x40, 0x89, 1, reg, base, disp);
+}
+
+int X86_64Emitter::movMRegDispReg8(X86BinBlock *binBlock, X86_64Register base, uint32 disp, X86_64Register reg) {
+	//spl, bpl, sil and dil need a REX prefix even when it has no bits set
+	uint8 prefix = (reg >= rsp && reg <= rdi && base <= rdi) ? 0x40 : 0;
+
+	return putMRegDisp(binBlock, prefix, 0x40, 0x88, 1, reg, base, disp);
+}
+
+int X86_64Emitter::movMRegDisp64Immi32(X86BinBlock *binBlock, X86_64Register base, uint32 disp, uint32 immi) {
+	int size = putMRegDisp(binBlock, 0, 0x48, 0xC7, 1, 0, base, disp);
+
+	if (binBlock) {
+		binBlock->write<uint32>(immi);
+	}
+
+	return size + 4;
+}
+
+int X86_64Emitter::movMRegDisp32Immi32(X86BinBlock *binBlock, X86_64Register base, uint32 disp, uint32 immi) {
+	int size = putMRegDisp(binBlock, 0, 0x40, 0xC7, 1, 0, base, disp);
+
+	if (binBlock) {
+		binBlock->write<uint32>(immi);
+	}
+
+	return size + 4;
+}
+
+int X86_64Emitter::cmpMRegDisp64Immi8(X86BinBlock *binBlock, X86_64Register base, uint32 disp, uint8 immi) {
+	int size = putMRegDisp(binBlock, 0, 0x48, 0x83, 1, 7, base, disp);
+
+	if (binBlock) {
+		binBlock->write<uint8>(immi);
+	}
+
+	return size + 1;
+}
+
+int X86_64Emitter::addMRegDisp32Immi8(X86BinBlock *binBlock, X86_64Register base, uint32 disp, uint8 immi) {
+	int size = putMRegDisp(binBlock, 0, 0x40, 0x83, 1, 0, base, disp);
+
+	if (binBlock) {
+		binBlock->write<uint8>(immi);
+	}
+
+	return size + 1;
+}
+
+int X86_64Emitter::addMRegDisp32Immi32(X86BinBlock *binBlock, X86_64Register base, uint32 disp, uint32 immi) {
+	int size = putMRegDisp(binBlock, 0, 0x40, 0x81, 1, 0, base, disp);
+
+	if (binBlock) {
+		binBlock->write<uint32>(immi);
+	}
+
+	return size + 4;
+}
+
+int X86_64Emitter::lockAddMRegDisp64Reg64(X86BinBlock *binBlock, X86_64Register base, uint32 disp, X86_64Register reg) {
+	return putMRegDisp(binBlock, 0xF0, 0x48, 0x01, 1, reg, base, disp);
+}
+
+int X86_64Emitter::lockAddMRegDisp64Immi32(X86BinBlock *binBlock, X86_64Register base, uint32 disp, uint32 immi) {
+	int size = putMRegDisp(binBlock, 0xF0, 0x48, 0x81, 1, 0, base, disp);
+
+	if (binBlock) {
+		binBlock->write<uint32>(immi);
+	}
+
+	return size + 4;
+}
+
+int X86_64Emitter::subMRegDisp32Immi8(X86BinBlock *binBlock, X86_64Register base, uint32 disp, uint8 immi) {
+	int size = putMRegDisp(binBlock, 0, 0x40, 0x83, 1, 5, base, disp);
+
+	if (binBlock) {
+		binBlock->write<uint8>(immi);
+	}
+
+	return size + 1;
+}
+
+int X86_64Emitter::subMRegDisp32Immi32(X86BinBlock *binBlock, X86_64Register base, uint32 disp, uint32 immi) {
+	int size = putMRegDisp(binBlock, 0, 0x40, 0x81, 1, 5, base, disp);
+
+	if (binBlock) {
+		binBlock->write<uint32>(immi);
+	}
+
+	return size + 4;
+}
+
+int X86_64Emitter::movssXMM_MRegDisp(X86BinBlock *binBlock, X86_64Register xmm, X86_64Register base, uint32 disp) {
+	return putMRegDisp(binBlock, 0xF3, 0x40, 0x100F, 2, xmm, base, disp);
+}
+
+int X86_64Emitter::movssMRegDispXMM(X86BinBlock *binBlock, X86_64Register base, uint32 disp, X86_64Register xmm) {
+	return putMRegDisp(binBlock, 0xF3, 0x40, 0x110F, 2, xmm, base, disp);
+}
+
+int X86_64Emitter::cvtsi2ssXMM_MRegDisp32(X86BinBlock *binBlock, X86_64Register xmm, X86_64Register base, uint32 disp) {
+	return putMRegDisp(binBlock, 0xF3, 0x40, 0x2A0F, 2, xmm, base, disp);
+}
+
+int X86_64Emitter::addssXMM_MRegDisp(X86BinBlock *binBlock, X86_64Register xmm, X86_64Register base, uint32 disp) {
+	return putMRegDisp(binBlock, 0xF3, 0x40, 0x580F, 2, xmm, base, disp);
+}
+
+int X86_64Emitter::subssXMM_MRegDisp(X86BinBlock *binBlock, X86_64Register xmm, X86_64Register base, uint32 disp) {
+	return putMRegDisp(binBlock, 0xF3, 0x40, 0x5C0F, 2, xmm, base, disp);
+}
+
+int X86_64Emitter::mulssXMM_MRegDisp(X86BinBlock *binBlock, X86_64Register xmm, X86_64Register base, uint32 disp) {
+	return putMRegDisp(binBlock, 0xF3, 0x40, 0x590F, 2, xmm, base, disp);
+}
+
+int X86_64Emitter::divssXMM_MRegDisp(X86BinBlock *binBlock, X86_64Register xmm, X86_64Register base, uint32 disp) {
+	return putMRegDisp(binBlock, 0xF3, 0x40, 0x5E0F, 2, xmm, base, disp);
+}
+
+int X86_64Emitter::ucomissXMM_MRegDisp(X86BinBlock *binBlock, X86_64Register xmm, X86_64Register base, uint32 disp) {
+	return putMRegDisp(binBlock, 0, 0x40, 0x2E0F, 2, xmm, base, disp);
 }
\ No newline at end of file
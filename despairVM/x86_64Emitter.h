@@ -107,6 +107,8 @@ namespace X86_64Emitter {
 	int addssXMM_MReg32(X86BinBlock *binBlock, X86_64Register xmm, X86_64Register reg);
 	//addss xmm, disp32
 	int addssXMM_Disp32(X86BinBlock *binBlock, X86_64Register xmm, uint32 disp32);
+	//addss xmm, xmm
+	int addssXMM_XMM(X86BinBlock *binBlock, X86_64Register xmm_1, X86_64Register xmm_2);
 
 	//and reg, reg
 	int andReg32Reg32(X86BinBlock *binBlock, X86_64Register reg1, X86_64Register reg2);
@@ -114,6 +116,7 @@ namespace X86_64Emitter {
 	//and rax, immi32
 	int andEAX_Immi32(X86BinBlock *binBlock, uint32 immi);
 	int andRAX_Immi32(X86BinBlock *binBlock, uint32 immi);
+	int andReg32Immi32(X86BinBlock *binBlock, X86_64Register reg, uint32 immi);
 	//and (reg), reg
 	int andMReg32Reg32(X86BinBlock *binBlock, X86_64Register reg1, X86_64Register reg2);
 	int andMReg64Reg64(X86BinBlock *binBlock, X86_64Register reg1, X86_64Register reg2);
@@ -129,6 +132,12 @@ namespace X86_64Emitter {
 	//cmp (reg), reg
 	int cmpMReg64Reg64(X86BinBlock *binBlock, X86_64Register reg1, X86_64Register reg2);
 	int cmpMReg32Reg32(X86BinBlock *binBlock, X86_64Register reg1, X86_64Register reg2);
+	//cmp reg, immi
+	int cmpReg32Immi32(X86BinBlock *binBlock, X86_64Register reg, uint32 immi);
+	int cmpReg64Immi32(X86BinBlock *binBlock, X86_64Register reg, uint32 immi);
+	//cmp reg, reg
+	int cmpReg32Reg32(X86BinBlock *binBlock, X86_64Register reg1, X86_64Register reg2);
+	int cmpReg64Reg64(X86BinBlock *binBlock, X86_64Register reg1, X86_64Register reg2);
 
 	//cvtsi2ss xmm, (reg)
 	int cvtsi2ssXMM_MReg32(X86BinBlock *binBlock, X86_64Register xmm, X86_64Register reg);
@@ -157,6 +166,8 @@ namespace X86_64Emitter {
 	//imul RAX, reg
 	int imulEAX_Reg32(X86BinBlock *binBlock, X86_64Register reg);
 	int imulRAX_Reg64(X86BinBlock *binBlock, X86_64Register reg);
+	//mul RAX, reg, the high half of the unsigned product goes to RDX
+	int mulRAX_Reg64(X86BinBlock *binBlock, X86_64Register reg);
 	//imul reg, reg
 	int imulReg32Reg32(X86BinBlock *binBlock, X86_64Register reg1, X86_64Register reg2);
 	int imulReg64Reg64(X86BinBlock *binBlock, X86_64Register reg1, X86_64Register reg2);
@@ -189,6 +200,10 @@ namespace X86_64Emitter {
 	int jleRel32(X86BinBlock *binBlock, uint32 rel);
 	//jmp rel
 	int jmpRel32(X86BinBlock *binBlock, uint32 rel);
+	//jmp reg
+	int jmpReg64(X86BinBlock *binBlock, X86_64Register reg);
+	//jne rel
+	int jneRel32(X86BinBlock *binBlock, uint32 rel);
 
 	//mov reg, immi
 	int movReg64Immi64(X86BinBlock *binBlock, X86_64Register reg, uint64 immi);
@@ -233,14 +248,24 @@ namespace X86_64Emitter {
 	int movssMReg32XMM(X86BinBlock *binBlock, X86_64Register reg, X86_64Register xmm);
 	//movss xmm, (reg)
 	int movssXMM_MReg32(X86BinBlock *binBlock, X86_64Register xmm, X86_64Register reg);
+	//movss xmm, xmm
+	int movssXMM_XMM(X86BinBlock *binBlock, X86_64Register xmm_1, X86_64Register xmm_2);
+	//movups (reg + disp8), xmm
+	int movupsMRegDisp8XMM(X86BinBlock *binBlock, X86_64Register reg, uint8 disp8, X86_64Register xmm);
+	//movups xmm, (reg + disp8)
+	int movupsXMM_MRegDisp8(X86BinBlock *binBlock, X86_64Register xmm, X86_64Register reg, uint8 disp8);
 
 	//mulss xmm, (reg)
 	int mulssXMM_MReg32(X86BinBlock *binBlock, X86_64Register xmm, X86_64Register reg);
 	//mulss xmm, disp32
 	int mulssXMM_Disp32(X86BinBlock *binBlock, X86_64Register xmm, uint32 disp32);
+	//mulss xmm, xmm
+	int mulssXMM_XMM(X86BinBlock *binBlock, X86_64Register xmm_1, X86_64Register xmm_2);
 
 	//nop
 	int nop(X86BinBlock *binBlock);
+	//or reg, reg
+	int orReg64Reg64(X86BinBlock *binBlock, X86_64Register reg1, X86_64Register reg2);
 
 	//or (reg), reg
 	int orMReg32Reg32(X86BinBlock *binBlock, X86_64Register reg1, X86_64Register reg2);
@@ -251,9 +276,15 @@ namespace X86_64Emitter {
 	//pop reg
 	int popReg64(X86BinBlock *binBlock, X86_64Register reg);
 
+	//push reg
+	int pushReg64(X86BinBlock *binBlock, X86_64Register reg);
+
 	//pushf
 	int pushf(X86BinBlock *binBlock);
 
+	//rdtsc
+	int rdtsc(X86BinBlock *binBlock);
+
 	//repMovs
 	int repMovs64(X86BinBlock *binBlock);
 	int repMovs32(X86BinBlock *binBlock);
@@ -267,6 +298,10 @@ namespace X86_64Emitter {
 	//shl (reg), cl
 	int shlMReg32Cl(X86BinBlock *binBlock, X86_64Register reg);
 	int shlMReg64Cl(X86BinBlock *binBlock, X86_64Register reg);
+	//shl reg, immi
+	int shlReg64Immi8(X86BinBlock *binBlock, X86_64Register reg, uint8 immi);
+	//shl reg, cl
+	int shlReg64Cl(X86BinBlock *binBlock, X86_64Register reg);
 
 	//shr (reg), immi
 	int shrMReg32Immi8(X86BinBlock *binBlock, X86_64Register reg, uint8 immi);
@@ -274,6 +309,10 @@ namespace X86_64Emitter {
 	//shr (reg), cl
 	int shrMReg32Cl(X86BinBlock *binBlock, X86_64Register reg);
 	int shrMReg64Cl(X86BinBlock *binBlock, X86_64Register reg);
+	//shr reg, immi
+	int shrReg64Immi8(X86BinBlock *binBlock, X86_64Register reg, uint8 immi);
+	//shr reg, cl
+	int shrReg64Cl(X86BinBlock *binBlock, X86_64Register reg);
 
 	//sub reg, reg
 	int subReg32Reg32(X86BinBlock *binBlock, X86_64Register reg1, X86_64Register reg2);
@@ -298,6 +337,9 @@ namespace X86_64Emitter {
 	//subss xmm, xmm
 	int subssXMM_XMM(X86BinBlock *binBlock, X86_64Register xmm_1, X86_64Register xmm_2);
 	
+	//test reg, reg
+	int testReg64Reg64(X86BinBlock *binBlock, X86_64Register reg1, X86_64Register reg2);
+
 	//comiss xmm, (reg)
 	int ucomissXMM_MReg32(X86BinBlock *binBlock, X86_64Register xmm, X86_64Register reg);
 
@@ -309,6 +351,53 @@ namespace X86_64Emitter {
 	int xorMReg64Reg64(X86BinBlock *binBlock, X86_64Register reg1, X86_64Register reg2);
 	//xor (reg), immi
 	int xorMReg32Immi32(X86BinBlock *binBlock, X86_64Register reg, uint32 immi);
+
+	//lea reg, (rip + disp32)
+	int leaReg64Disp32(X86BinBlock *binBlock, X86_64Register reg, uint32 disp32);
+	//lea reg, (base + index * (1 << scale))
+	int leaReg64MReg64(X86BinBlock *binBlock, X86_64Register reg, int scale, X86_64Register index, X86_64Register base);
+
+	//Instructions with a (base + disp) operand, disp8 is used when disp fits in it
+	//lea reg, (base + disp)
+	int leaReg64MRegDisp(X86BinBlock *binBlock, X86_64Register reg, X86_64Register base, uint32 disp);
+	//mov reg, (base + disp)
+	int movReg64MRegDisp(X86BinBlock *binBlock, X86_64Register reg, X86_64Register base, uint32 disp);
+	int movReg32MRegDisp(X86BinBlock *binBlock, X86_64Register reg, X86_64Register base, uint32 disp);
+	//movzx reg, (base + disp)
+	int movzxReg32MRegDisp8(X86BinBlock *binBlock, X86_64Register reg, X86_64Register base, uint32 disp);
+	int movzxReg32MRegDisp16(X86BinBlock *binBlock, X86_64Register reg, X86_64Register base, uint32 disp);
+	//mov (base + disp), reg
+	int movMRegDispReg64(X86BinBlock *binBlock, X86_64Register base, uint32 disp, X86_64Register reg);
+	int movMRegDispReg32(X86BinBlock *binBlock, X86_64Register base, uint32 disp, X86_64Register reg);
+	int movMRegDispReg16(X86BinBlock *binBlock, X86_64Register base, uint32 disp, X86_64Register reg);
+	int movMRegDispReg8(X86BinBlock *binBlock, X86_64Register base, uint32 disp, X86_64Register reg);
+	//mov (base + disp), immi
+	int movMRegDisp64Immi32(X86BinBlock *binBlock, X86_64Register base, uint32 disp, uint32 immi);
+	int movMRegDisp32Immi32(X86BinBlock *binBlock, X86_64Register base, uint32 disp, uint32 immi);
+	//cmp (base + disp), immi
+	int cmpMRegDisp64Immi8(X86BinBlock *binBlock, X86_64Register base, uint32 disp, uint8 immi);
+	//add (base + disp), immi
+	int addMRegDisp32Immi8(X86BinBlock *binBlock, X86_64Register base, uint32 disp, uint8 immi);
+	int addMRegDisp32Immi32(X86BinBlock *binBlock, X86_64Register base, uint32 disp, uint32 immi);
+	//lock add (base + disp), reg/immi
+	int lockAddMRegDisp64Reg64(X86BinBlock *binBlock, X86_64Register base, uint32 disp, X86_64Register reg);
+	int lockAddMRegDisp64Immi32(X86BinBlock *binBlock, X86_64Register base, uint32 disp, uint32 immi);
+	//sub (base + disp), immi
+	int subMRegDisp32Immi8(X86BinBlock *binBlock, X86_64Register base, uint32 disp, uint8 immi);
+	int subMRegDisp32Immi32(X86BinBlock *binBlock, X86_64Register base, uint32 disp, uint32 immi);
+	//movss xmm, (base + disp)
+	int movssXMM_MRegDisp(X86BinBlock *binBlock, X86_64Register xmm, X86_64Register base, uint32 disp);
+	//movss (base + disp), xmm
+	int movssMRegDispXMM(X86BinBlock *binBlock, X86_64Register base, uint32 disp, X86_64Register xmm);
+	//cvtsi2ss xmm, (base + disp)
+	int cvtsi2ssXMM_MRegDisp32(X86BinBlock *binBlock, X86_64Register xmm, X86_64Register base, uint32 disp);
+	//addss, subss, mulss, divss xmm, (base + disp)
+	int addssXMM_MRegDisp(X86BinBlock *binBlock, X86_64Register xmm, X86_64Register base, uint32 disp);
+	int subssXMM_MRegDisp(X86BinBlock *binBlock, X86_64Register xmm, X86_64Register base, uint32 disp);
+	int mulssXMM_MRegDisp(X86BinBlock *binBlock, X86_64Register xmm, X86_64Register base, uint32 disp);
+	int divssXMM_MRegDisp(X86BinBlock *binBlock, X86_64Register xmm, X86_64Register base, uint32 disp);
+	//ucomiss xmm, (base + disp)
+	int ucomissXMM_MRegDisp(X86BinBlock *binBlock, X86_64Register xmm, X86_64Register base, uint32 disp);
 }
 
 #endif
\ No newline at end of file